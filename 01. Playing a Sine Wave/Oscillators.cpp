@@ -0,0 +1,164 @@
+#include "Oscillators.h"
+
+#include <assert.h>
+#include <string.h>
+#include <emmintrin.h> // SSE2
+
+// References:
+// https://www.martin-finke.de/articles/audio-plugins-018-polyblep-oscillator/
+// Valimaki & Huovilainen, "Antialiasing Oscillators in Subtractive Synthesis"
+
+void oscillatorBankInit(OscillatorBank* bank, Waveform waveform, uint32_t sampleRate)
+{
+    memset(bank, 0, sizeof(*bank));
+    bank->waveform = waveform;
+    bank->sampleRate = sampleRate;
+}
+
+int oscillatorBankAdd(OscillatorBank* bank, float frequency, float amplitude)
+{
+    if(bank->numOscillators == OSCILLATOR_BANK_MAX_OSCILLATORS)
+        return -1;
+    int index = (int)bank->numOscillators++;
+    bank->phases[index] = 0;
+    oscillatorBankSetFrequency(bank, index, frequency);
+    oscillatorBankSetAmplitude(bank, index, amplitude);
+    return index;
+}
+
+void oscillatorBankSetFrequency(OscillatorBank* bank, int index, float frequency)
+{
+    assert(index >= 0 && (uint32_t)index < bank->numOscillators);
+    assert(frequency >= 0 && frequency < bank->sampleRate / 2);
+    double cyclesPerFrame = (double)frequency / bank->sampleRate;
+    // Round to nearest, so the frequency is never more than half a step out
+    bank->phaseIncrements[index] = (uint32_t)(cyclesPerFrame * 4294967296.0 + 0.5);
+    bank->phaseIncrementsFloat[index] = (float)cyclesPerFrame;
+}
+
+void oscillatorBankSetAmplitude(OscillatorBank* bank, int index, float amplitude)
+{
+    assert(index >= 0 && (uint32_t)index < bank->numOscillators);
+    bank->amplitudes[index] = amplitude;
+}
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// sin(2*pi*t) for t in [0, 1), accurate to about 4e-6
+static inline __m128 sinCycle(__m128 t)
+{
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    // sin(2*pi*t) = -sin(2*pi*(t - 0.5)), with t - 0.5 in [-0.5, 0.5)
+    __m128 u = _mm_sub_ps(t, half);
+    // Fold into [-0.25, 0.25] using sin(pi - x) = sin(x)
+    u = select(_mm_cmpgt_ps(u, quarter), _mm_sub_ps(half, u), u);
+    u = select(_mm_cmplt_ps(u, _mm_set1_ps(-0.25f)), _mm_sub_ps(_mm_set1_ps(-0.5f), u), u);
+    // Taylor series is plenty accurate over [-pi/2, pi/2]
+    __m128 x = _mm_mul_ps(u, _mm_set1_ps(6.28318530718f));
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_set1_ps(1.f / 362880.f);
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.f / 5040.f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.f / 120.f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.f / 6.f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.f));
+    return _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(p, x));
+}
+
+// Polynomial correction which smooths out a jump of -2 at t = 0, so
+// that waveforms with hard edges don't alias. dt is the phase increment
+static inline __m128 polyBlep(__m128 t, __m128 dt, __m128 invDt)
+{
+    const __m128 one = _mm_set1_ps(1.f);
+    // Just after the jump: x = t/dt, correction is 2x - x^2 - 1
+    __m128 x = _mm_mul_ps(t, invDt);
+    __m128 after = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(x, x), _mm_mul_ps(x, x)), one);
+    // Just before the jump: x = (t-1)/dt, correction is x^2 + 2x + 1
+    __m128 y = _mm_mul_ps(_mm_sub_ps(t, one), invDt);
+    __m128 before = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, y), _mm_add_ps(y, y)), one);
+
+    __m128 result = _mm_and_ps(_mm_cmplt_ps(t, dt), after);
+    return _mm_or_ps(result, _mm_and_ps(_mm_cmpgt_ps(t, _mm_sub_ps(one, dt)), before));
+}
+
+// Number of frames we accumulate per pass before summing across oscillators
+#define OSCILLATOR_FRAMES_PER_PASS 64
+
+void oscillatorBankRender(OscillatorBank* bank, float* output, uint32_t numFrames)
+{
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 phaseToFloat = _mm_set1_ps(1.f / 16777216.f);
+    // Round up so the spare lanes in the last group are just silent oscillators
+    const uint32_t numOscillators = (bank->numOscillators + 3) & ~3u;
+
+    while(numFrames > 0)
+    {
+        uint32_t numFramesThisPass = numFrames < OSCILLATOR_FRAMES_PER_PASS ? numFrames : OSCILLATOR_FRAMES_PER_PASS;
+        __m128 sums[OSCILLATOR_FRAMES_PER_PASS];
+        for(uint32_t frame = 0; frame < numFramesThisPass; ++frame)
+            sums[frame] = _mm_setzero_ps();
+
+        for(uint32_t osc = 0; osc < numOscillators; osc += 4)
+        {
+            __m128i phase = _mm_load_si128((__m128i*)(bank->phases + osc));
+            __m128i increment = _mm_load_si128((__m128i*)(bank->phaseIncrements + osc));
+            __m128 amplitude = _mm_load_ps(bank->amplitudes + osc);
+            __m128 dt = _mm_load_ps(bank->phaseIncrementsFloat + osc);
+            // Avoid dividing by zero for oscillators at 0Hz
+            __m128 invDt = _mm_div_ps(one, _mm_max_ps(dt, _mm_set1_ps(1e-9f)));
+
+            for(uint32_t frame = 0; frame < numFramesThisPass; ++frame)
+            {
+                // Top 24 bits of the phase fit exactly in a float's mantissa
+                __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(phase, 8)), phaseToFloat);
+                __m128 sample;
+                switch(bank->waveform)
+                {
+                    case WAVEFORM_SINE:
+                        sample = sinCycle(t);
+                        break;
+                    case WAVEFORM_SAW:
+                        sample = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(two, t), one), polyBlep(t, dt, invDt));
+                        break;
+                    case WAVEFORM_SQUARE:
+                    {
+                        // Jumps down at t = 0.5 and up at t = 0
+                        __m128 naive = select(_mm_cmplt_ps(t, half), one, _mm_sub_ps(_mm_setzero_ps(), one));
+                        __m128 halfCycleLater = _mm_sub_ps(_mm_add_ps(t, half), _mm_and_ps(_mm_cmpge_ps(t, half), one));
+                        sample = _mm_sub_ps(_mm_add_ps(naive, polyBlep(t, dt, invDt)), polyBlep(halfCycleLater, dt, invDt));
+                        break;
+                    }
+                    case WAVEFORM_TRIANGLE:
+                    default:
+                    {
+                        // Triangle harmonics drop off fast enough that aliasing
+                        // is hard to hear, so we don't bother band-limiting it
+                        __m128 saw = _mm_sub_ps(_mm_mul_ps(two, t), one);
+                        __m128 absSaw = _mm_andnot_ps(_mm_set1_ps(-0.f), saw);
+                        sample = _mm_sub_ps(one, _mm_mul_ps(two, absSaw));
+                        break;
+                    }
+                }
+                sums[frame] = _mm_add_ps(sums[frame], _mm_mul_ps(sample, amplitude));
+                // Integer add wraps around at the end of each cycle
+                phase = _mm_add_epi32(phase, increment);
+            }
+            _mm_store_si128((__m128i*)(bank->phases + osc), phase);
+        }
+
+        // Sum the 4 lanes of each frame
+        for(uint32_t frame = 0; frame < numFramesThisPass; ++frame)
+        {
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, sums[frame]);
+            output[frame] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+        output += numFramesThisPass;
+        numFrames -= numFramesThisPass;
+    }
+}
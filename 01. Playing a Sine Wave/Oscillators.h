@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+// Must be a multiple of 4
+#define OSCILLATOR_BANK_MAX_OSCILLATORS 256
+
+enum Waveform {
+    WAVEFORM_SINE,
+    WAVEFORM_SAW,
+    WAVEFORM_SQUARE,
+    WAVEFORM_TRIANGLE,
+};
+
+// A group of oscillators that all share the same waveform, stored as
+// arrays so we can run 4 oscillators at once with SSE.
+// Each oscillator's phase is a 32-bit fixed-point fraction of a cycle,
+// which wraps around for free when it overflows. Unlike adding up a
+// floating point time, it never loses precision however long it runs
+struct OscillatorBank {
+    Waveform waveform;
+    uint32_t sampleRate;
+    uint32_t numOscillators;
+    alignas(16) uint32_t phases[OSCILLATOR_BANK_MAX_OSCILLATORS];
+    alignas(16) uint32_t phaseIncrements[OSCILLATOR_BANK_MAX_OSCILLATORS];
+    // Phase increment as a fraction of a cycle, for band-limiting
+    alignas(16) float phaseIncrementsFloat[OSCILLATOR_BANK_MAX_OSCILLATORS];
+    alignas(16) float amplitudes[OSCILLATOR_BANK_MAX_OSCILLATORS];
+};
+
+void oscillatorBankInit(OscillatorBank* bank, Waveform waveform, uint32_t sampleRate);
+// Returns the new oscillator's index, or -1 if the bank is full
+int oscillatorBankAdd(OscillatorBank* bank, float frequency, float amplitude);
+void oscillatorBankSetFrequency(OscillatorBank* bank, int index, float frequency);
+void oscillatorBankSetAmplitude(OscillatorBank* bank, int index, float amplitude);
+// Adds the sum of every oscillator in the bank into output (mono)
+void oscillatorBankRender(OscillatorBank* bank, float* output, uint32_t numFrames);
@@ -0,0 +1,117 @@
+// Measures how many oscillators of each waveform one core can run in real time at
+// 48kHz, rendering 10ms buffers like the sample does. A full bank is timed and the
+// cost of an empty one taken off, so the count is what each extra oscillator costs.
+// Calling sinf() on each oscillator's phase every sample is shown for comparison.
+// Usage: BenchmarkOscillators
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "../Oscillators.h"
+
+// Time each bank for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define SAMPLE_RATE 48000
+// What the device asks for at once, 10ms
+#define FRAMES_PER_BUFFER (SAMPLE_RATE / 100)
+
+static OscillatorBank bank;
+alignas(16) static float output[FRAMES_PER_BUFFER];
+
+// Somewhere between 50Hz and 5kHz, the same every run
+static float randomFrequency(uint32_t* random)
+{
+    *random = *random * 1664525 + 1013904223;
+    return 50.f * powf(100.f, (*random >> 8) / 16777216.f);
+}
+
+// Returns seconds per buffer
+static double timeBank(Waveform waveform, uint32_t numOscillators)
+{
+    typedef std::chrono::steady_clock Clock;
+    oscillatorBankInit(&bank, waveform, SAMPLE_RATE);
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < numOscillators; ++i)
+        oscillatorBankAdd(&bank, randomFrequency(&random), 1.f / OSCILLATOR_BANK_MAX_OSCILLATORS);
+
+    uint32_t numBuffers = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        memset(output, 0, sizeof(output));
+        oscillatorBankRender(&bank, output, FRAMES_PER_BUFFER);
+        ++numBuffers;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds / numBuffers;
+}
+
+// The obvious way, one oscillator and one sinf() at a time
+static double timeSinf(uint32_t numOscillators)
+{
+    typedef std::chrono::steady_clock Clock;
+    static float phases[OSCILLATOR_BANK_MAX_OSCILLATORS];
+    static float increments[OSCILLATOR_BANK_MAX_OSCILLATORS];
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < numOscillators; ++i)
+    {
+        phases[i] = 0.f;
+        increments[i] = randomFrequency(&random) / SAMPLE_RATE;
+    }
+
+    uint32_t numBuffers = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        memset(output, 0, sizeof(output));
+        for(uint32_t i = 0; i < numOscillators; ++i)
+        {
+            float phase = phases[i];
+            for(uint32_t frame = 0; frame < FRAMES_PER_BUFFER; ++frame)
+            {
+                output[frame] += sinf(phase * 6.28318530718f) * (1.f / OSCILLATOR_BANK_MAX_OSCILLATORS);
+                phase += increments[i];
+                phase -= (float)(phase >= 1.f);
+            }
+            phases[i] = phase;
+        }
+        ++numBuffers;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds / numBuffers;
+}
+
+static void printRow(const char* name, double emptySeconds, double fullSeconds)
+{
+    double secondsPerOscillator = (fullSeconds - emptySeconds) / OSCILLATOR_BANK_MAX_OSCILLATORS;
+    double nsPerSample = secondsPerOscillator / FRAMES_PER_BUFFER * 1e9;
+    // A buffer's worth of CPU time per buffer is one whole core
+    double oscillatorsPerCore = FRAMES_PER_BUFFER / (double)SAMPLE_RATE / secondsPerOscillator;
+    printf("%-10s %14.2f %14.0f\n", name, nsPerSample, oscillatorsPerCore);
+}
+
+int main()
+{
+    struct Bank {
+        const char* name;
+        Waveform waveform;
+    };
+    const Bank banks[] = {
+        { "sine",     WAVEFORM_SINE },
+        { "saw",      WAVEFORM_SAW },
+        { "square",   WAVEFORM_SQUARE },
+        { "triangle", WAVEFORM_TRIANGLE },
+    };
+
+    printf("%u oscillators, %u frame buffers at %uHz\n", OSCILLATOR_BANK_MAX_OSCILLATORS, FRAMES_PER_BUFFER, SAMPLE_RATE);
+    printf("%-10s %14s %14s\n", "", "ns per sample", "per core");
+    for(const Bank& b : banks)
+        printRow(b.name, timeBank(b.waveform, 0), timeBank(b.waveform, OSCILLATOR_BANK_MAX_OSCILLATORS));
+    printRow("sinf()", timeSinf(0), timeSinf(OSCILLATOR_BANK_MAX_OSCILLATORS));
+    return 0;
+}
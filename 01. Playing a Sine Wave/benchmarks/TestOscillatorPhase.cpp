@@ -0,0 +1,127 @@
+// Runs sine oscillators for hours of audio and checks they haven't drifted. Every
+// so often each oscillator's output is compared to sin() of where its phase should
+// be, worked out from scratch in double precision from the number of frames so far,
+// so any error that builds up from sample to sample shows up. Also checks the
+// oscillators' frequencies are as close to what was asked for as the fixed-point
+// phase allows, and how close the polynomial sine gets to the real thing.
+// Usage: TestOscillatorPhase [hours]
+// Returns 1 if any check fails.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../Oscillators.h"
+
+#define SAMPLE_RATE 48000
+#define FRAMES_PER_BUFFER (SAMPLE_RATE / 100)
+// Check every minute of audio
+#define FRAMES_PER_CHECK (SAMPLE_RATE * 60)
+// The sine is accurate to about 4e-6, and its phase is rounded to 24 bits
+#define MAX_SAMPLE_ERROR 1e-5
+#define NUM_TEST_OSCILLATORS 4
+
+static OscillatorBank banks[NUM_TEST_OSCILLATORS];
+alignas(16) static float output[FRAMES_PER_BUFFER];
+
+// Where oscillator i should be after numFrames, straight from the frame count
+static double expectedSample(const OscillatorBank* bank, uint64_t numFrames)
+{
+    uint64_t phase = (numFrames * bank->phaseIncrements[0]) & 0xFFFFFFFFull;
+    return sin(2.0 * M_PI * phase / 4294967296.0) * bank->amplitudes[0];
+}
+
+int main(int argc, char** argv)
+{
+    double hours = argc > 1 ? atof(argv[1]) : 1.0;
+    if(hours <= 0.0)
+    {
+        printf("Usage: TestOscillatorPhase [hours]\n");
+        return 1;
+    }
+    const uint64_t numFrames = (uint64_t)(hours * 3600.0 * SAMPLE_RATE) / FRAMES_PER_BUFFER * FRAMES_PER_BUFFER;
+    bool passed = true;
+
+    // The sine on its own, over a whole cycle
+    {
+        OscillatorBank* bank = &banks[0];
+        oscillatorBankInit(bank, WAVEFORM_SINE, SAMPLE_RATE);
+        oscillatorBankAdd(bank, 1.f, 1.f);
+        const uint32_t NUM_STEPS = 1 << 20;
+        bank->phaseIncrements[0] = 1u << 12;
+        double maxError = 0.0;
+        for(uint32_t i = 0; i < NUM_STEPS; i += FRAMES_PER_BUFFER)
+        {
+            uint32_t numFramesThisTime = NUM_STEPS - i < FRAMES_PER_BUFFER ? NUM_STEPS - i : FRAMES_PER_BUFFER;
+            memset(output, 0, sizeof(output));
+            oscillatorBankRender(bank, output, numFramesThisTime);
+            for(uint32_t frame = 0; frame < numFramesThisTime; ++frame)
+            {
+                double error = fabs(output[frame] - expectedSample(bank, i + frame));
+                if(error > maxError)
+                    maxError = error;
+            }
+        }
+        printf("Sine error over a cycle: %.2g\n", maxError);
+        if(maxError > MAX_SAMPLE_ERROR)
+        {
+            printf("FAILED: sine error over %.2g\n", MAX_SAMPLE_ERROR);
+            passed = false;
+        }
+    }
+
+    // One oscillator per bank so each one's output can be checked on its own
+    const float frequencies[NUM_TEST_OSCILLATORS] = { 440.f, 1000.5f, 12345.67f, 20000.f };
+    for(uint32_t i = 0; i < NUM_TEST_OSCILLATORS; ++i)
+    {
+        oscillatorBankInit(&banks[i], WAVEFORM_SINE, SAMPLE_RATE);
+        oscillatorBankAdd(&banks[i], frequencies[i], 0.5f);
+
+        // The phase increment can only be a whole number of 2^-32 cycles, so the
+        // frequency can be off by up to half of one of those a frame
+        double actualFrequency = banks[i].phaseIncrements[0] / 4294967296.0 * SAMPLE_RATE;
+        double cyclesOffPerHour = fabs(actualFrequency - frequencies[i]) * 3600.0;
+        double maxCyclesOffPerHour = 0.5 / 4294967296.0 * SAMPLE_RATE * 3600.0;
+        // What it's compared against is the float frequency it was asked for
+        printf("%9.2fHz: %.3g cycles an hour from the exact frequency\n", frequencies[i], cyclesOffPerHour);
+        if(cyclesOffPerHour > maxCyclesOffPerHour * 1.001)
+        {
+            printf("FAILED: %.2fHz is further off than the phase's precision\n", frequencies[i]);
+            passed = false;
+        }
+    }
+
+    printf("Running for %.1f hours of audio\n", numFrames / (3600.0 * SAMPLE_RATE));
+    double maxError = 0.0;
+    for(uint64_t frame = 0; frame < numFrames; frame += FRAMES_PER_BUFFER)
+    {
+        bool isCheck = (frame + FRAMES_PER_BUFFER) % FRAMES_PER_CHECK < FRAMES_PER_BUFFER || frame + FRAMES_PER_BUFFER == numFrames;
+        for(uint32_t i = 0; i < NUM_TEST_OSCILLATORS; ++i)
+        {
+            if(!isCheck)
+            {
+                // Nothing to look at, just keep the phase going
+                oscillatorBankRender(&banks[i], output, FRAMES_PER_BUFFER);
+                continue;
+            }
+            memset(output, 0, sizeof(output));
+            oscillatorBankRender(&banks[i], output, FRAMES_PER_BUFFER);
+            for(uint32_t j = 0; j < FRAMES_PER_BUFFER; ++j)
+            {
+                double error = fabs(output[j] - expectedSample(&banks[i], frame + j));
+                if(error > maxError)
+                    maxError = error;
+            }
+        }
+    }
+    printf("Largest error after up to %.1f hours: %.2g\n", numFrames / (3600.0 * SAMPLE_RATE), maxError);
+    if(maxError > MAX_SAMPLE_ERROR)
+    {
+        printf("FAILED: the oscillators drifted\n");
+        passed = false;
+    }
+    printf(passed ? "All checks passed\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
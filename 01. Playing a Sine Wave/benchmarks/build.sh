@@ -0,0 +1,10 @@
+#!/bin/sh
+# Builds the benchmarks on Linux
+set -e
+cd "$(dirname "$0")"
+mkdir -p build
+
+echo Building...
+c++ -O2 -DNDEBUG -Wall -Wextra BenchmarkOscillators.cpp ../Oscillators.cpp -o build/BenchmarkOscillators
+c++ -O2 -DNDEBUG -Wall -Wextra TestOscillatorPhase.cpp ../Oscillators.cpp -o build/TestOscillatorPhase
+echo Done
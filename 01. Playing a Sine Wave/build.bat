@@ -8,7 +8,7 @@ set RELEASE_FLAGS =/O2 /DNDEBUG
 set COMPILER_FLAGS=%COMMON_COMPILER_FLAGS% %DEBUG_FLAGS%
 REM set COMPILER_FLAGS=%COMMON_COMPILER_FLAGS% %RELEASE_FLAGS%
 
-set SRC_FILES=../main.cpp
+set SRC_FILES=../main.cpp ../Oscillators.cpp
 
 set LINKER_FLAGS=/INCREMENTAL:NO /opt:ref
 set SYSTEM_LIBS=ole32.lib
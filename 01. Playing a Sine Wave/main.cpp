@@ -4,10 +4,12 @@
 #include <audioclient.h>
 
 #include <assert.h>
-#define _USE_MATH_DEFINES
-#include <math.h> // for sin()
 #include <stdint.h>
 
+#include "Oscillators.h"
+
+static OscillatorBank oscillatorBank;
+
 int main()
 {
     HRESULT hr = CoInitializeEx(nullptr, COINIT_SPEED_OVER_MEMORY);
@@ -63,9 +65,11 @@ int main()
     hr = audioClient->Start();
     assert(hr == S_OK);
 
-    double playbackTime = 0.0;
+    // Try WAVEFORM_SAW, WAVEFORM_SQUARE or WAVEFORM_TRIANGLE too!
     const float TONE_HZ = 440;
     const int16_t TONE_VOLUME = 3000;
+    oscillatorBankInit(&oscillatorBank, WAVEFORM_SINE, mixFormat.nSamplesPerSec);
+    oscillatorBankAdd(&oscillatorBank, TONE_HZ, TONE_VOLUME / 32768.f);
     while (true)
     {
         // Padding is how much valid data is queued up in the sound buffer
@@ -87,15 +91,20 @@ int main()
         hr = audioRenderClient->GetBuffer(numFramesToWrite, (BYTE**)(&buffer));
         assert(hr == S_OK);
 
-        for (UINT32 frameIndex = 0; frameIndex < numFramesToWrite; ++frameIndex)
+        // Generate the tone a chunk at a time, then convert to 16-bit
+        for (UINT32 chunkStart = 0; chunkStart < numFramesToWrite; chunkStart += 256)
         {
-            float amplitude = (float)sin(playbackTime*2*M_PI*TONE_HZ);
-            int16_t y = (int16_t)(TONE_VOLUME * amplitude);
+            float tone[256] = {};
+            UINT32 numFramesInChunk = min(numFramesToWrite - chunkStart, 256u);
+            oscillatorBankRender(&oscillatorBank, tone, numFramesInChunk);
 
-            *buffer++ = y; // left
-            *buffer++ = y; // right
+            for (UINT32 frameIndex = 0; frameIndex < numFramesInChunk; ++frameIndex)
+            {
+                int16_t y = (int16_t)(32767 * tone[frameIndex]);
 
-            playbackTime += 1.f / mixFormat.nSamplesPerSec;
+                *buffer++ = y; // left
+                *buffer++ = y; // right
+            }
         }
         hr = audioRenderClient->ReleaseBuffer(numFramesToWrite, 0);
         assert(hr == S_OK);
@@ -1,6 +1,12 @@
 #include <stdint.h>
 
+enum SampleFormat {
+    SAMPLE_FORMAT_PCM,   // Integer, 8-bit is unsigned and the rest are signed
+    SAMPLE_FORMAT_FLOAT, // 32-bit float
+};
+
 struct AudioClip {
+    SampleFormat sampleFormat;
     uint32_t numChannels;
     uint32_t numBitsPerSample;
     uint32_t sampleRate;
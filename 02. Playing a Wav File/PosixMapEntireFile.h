@@ -0,0 +1,6 @@
+#include <stdint.h>
+
+// Same as win32MapEntireFile, for tools and tests built on Linux or other POSIX systems.
+// Unmapping needs the size the file was mapped with
+bool posixMapEntireFile(const char* filename, void** data, uint32_t* fileSize);
+void posixUnmapFileData(void* data, uint32_t fileSize);
@@ -13,7 +13,8 @@ int main()
     const char* wavFilename = "HelloWorld.wav";
     void* fileBytes;
     uint32_t fileSize;
-    bool result = win32LoadEntireFile(wavFilename, &fileBytes, &fileSize);
+    // The clip's samples point straight into the mapping, so the file is never copied
+    bool result = win32MapEntireFile(wavFilename, &fileBytes, &fileSize);
     assert(result);
 
     AudioClip clip = parseWavFile((uint8_t*)fileBytes, fileSize);
@@ -112,7 +113,7 @@ int main()
     audioClient->Release();
     audioRenderClient->Release();
 
-    Win32FreeFileData(fileBytes);
+    Win32UnmapFileData(fileBytes);
 
     return 0;
 }
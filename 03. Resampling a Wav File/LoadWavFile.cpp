@@ -3,6 +3,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <mmsystem.h>
+#include <mmreg.h>
 #include <aviriff.h>
 #include <assert.h>
 
@@ -32,13 +33,39 @@ AudioClip parseWavFile(uint8_t* fileBytes, uint32_t fileSize)
     {
         if(chunk->fcc == FCC('fmt ')) {
             WAVEFORMATEX* fmt = (WAVEFORMATEX*)(chunk+1);
-            
-            if(fmt->wFormatTag != WAVE_FORMAT_PCM)
+            assert(chunk->cb >= 16);
+
+            uint32_t formatTag = fmt->wFormatTag;
+            if(formatTag == WAVE_FORMAT_EXTENSIBLE)
+            {
+                // The real format is in SubFormat. The GUIDs for the basic formats
+                // (KSDATAFORMAT_SUBTYPE_PCM etc.) are their WAVE_FORMAT_ tag followed
+                // by the same base GUID, and any other GUID is a format we don't know
+                assert(chunk->cb >= sizeof(WAVEFORMATEXTENSIBLE));
+                const GUID& subFormat = ((WAVEFORMATEXTENSIBLE*)fmt)->SubFormat;
+                const GUID baseFormat = { subFormat.Data1, 0x0000, 0x0010, { 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } };
+                formatTag = IsEqualGUID(subFormat, baseFormat) ? subFormat.Data1 : WAVE_FORMAT_UNKNOWN;
+            }
+
+            if(formatTag == WAVE_FORMAT_PCM)
+            {
+                uint32_t bits = fmt->wBitsPerSample;
+                if(bits != 8 && bits != 16 && bits != 24 && bits != 32)
+                {
+                    assert(!"Unsupported PCM bit depth");
+                    return result;
+                }
+                result.sampleFormat = SAMPLE_FORMAT_PCM;
+            }
+            else if(formatTag == WAVE_FORMAT_IEEE_FLOAT && fmt->wBitsPerSample == 32)
             {
-                assert(!"Unsupported format - PCM only");
+                result.sampleFormat = SAMPLE_FORMAT_FLOAT;
+            }
+            else
+            {
+                assert(!"Unsupported format - PCM or 32-bit float only");
                 return result;
             }
-            assert(chunk->cb == 16 || chunk->cb == 18); 
             assert(fmt->nBlockAlign == fmt->nChannels * fmt->wBitsPerSample/8);
             assert(fmt->nAvgBytesPerSec == fmt->nSamplesPerSec * fmt->nBlockAlign);
 
@@ -47,7 +74,12 @@ AudioClip parseWavFile(uint8_t* fileBytes, uint32_t fileSize)
             result.numBitsPerSample = fmt->wBitsPerSample;
         }
         else if(chunk->fcc == FCC('data')) {
-            result.numSamples = chunk->cb / sizeof(uint16_t);
+            if(!result.numBitsPerSample)
+            {
+                assert(!"fmt chunk must come before data chunk");
+                return result;
+            }
+            result.numSamples = chunk->cb / (result.numBitsPerSample / 8);
             result.samples = ((uint8_t*)chunk + sizeof(RIFFCHUNK));
             assert((uint8_t*)result.samples + chunk->cb - 1 < endOfFile);
         }
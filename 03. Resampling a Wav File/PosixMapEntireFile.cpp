@@ -0,0 +1,41 @@
+#include "PosixMapEntireFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Maps the file read-only, like win32MapEntireFile. Pages are read in as
+// they're touched and shared with the OS file cache. The data is read-only!
+bool posixMapEntireFile(const char* filename, void** data, uint32_t* fileSize)
+{
+    int file = open(filename, O_RDONLY);
+    if(file < 0) return false;
+
+    struct stat fileInfo;
+    if(fstat(file, &fileInfo) != 0 || fileInfo.st_size <= 0 || fileInfo.st_size > UINT32_MAX)
+    {
+        close(file);
+        return false;
+    }
+    uint32_t size = (uint32_t)fileInfo.st_size;
+    void* mapping = mmap(0, size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file
+    close(file);
+    if(mapping == MAP_FAILED) return false;
+
+    // We're going to read the file from start to end, so ask for aggressive
+    // read-ahead and for the OS to start paging it in before we get to it.
+    // The advice values aren't flags, so it takes one call each
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    madvise(mapping, size, MADV_WILLNEED);
+
+    *data = mapping;
+    *fileSize = size;
+    return true;
+}
+
+void posixUnmapFileData(void* data, uint32_t fileSize)
+{
+    munmap(data, fileSize);
+}
@@ -0,0 +1,260 @@
+#include "Resampler.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <assert.h>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define RESAMPLER_HAS_NEON
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RESAMPLER_HAS_X86
+#include <immintrin.h> // SSE2, AVX2 and FMA
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Polyphase windowed-sinc resampler with a kernel per instruction set
+// For illustrative purposes only, no warranty is implied
+// References:
+// https://ccrma.stanford.edu/~jos/resample/
+// https://en.wikipedia.org/wiki/Kaiser_window
+
+// MSVC compiles AVX2 intrinsics anywhere, GCC and Clang only in functions that ask for them
+#if defined(RESAMPLER_HAS_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TARGET_AVX2
+#endif
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for(int k = 1; k < 32; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// The kernels all work out each output frame the same way: the dot product of
+// the taps around its position with the two nearest phases' filters, then lerp
+// between the two by how far between the phases the position is.
+// The top 8 bits of the position's fraction pick the phase, the other 24 are the lerp
+
+static inline const float* firstTap(const float* input, uint64_t position)
+{
+    return input + (int64_t)(position >> 32) - (RESAMPLER_NUM_TAPS / 2 - 1);
+}
+
+static inline uint32_t phaseIndex(uint64_t position)
+{
+    return (uint32_t)position >> 24;
+}
+
+static inline float phaseLerp(uint64_t position)
+{
+    return ((uint32_t)position & 0xFFFFFF) * (1.f / 16777216.f);
+}
+
+static void resampleScalar(const float (*filters)[RESAMPLER_NUM_TAPS], const float* input,
+                           uint64_t position, uint64_t step, float* output, uint32_t numOutputFrames)
+{
+    for(uint32_t i = 0; i < numOutputFrames; ++i, position += step)
+    {
+        const float* taps = firstTap(input, position);
+        const float* filterA = filters[phaseIndex(position)];
+        const float* filterB = filterA + RESAMPLER_NUM_TAPS;
+        float sumA = 0.f;
+        float sumB = 0.f;
+        for(int tap = 0; tap < RESAMPLER_NUM_TAPS; ++tap)
+        {
+            sumA += taps[tap] * filterA[tap];
+            sumB += taps[tap] * filterB[tap];
+        }
+        output[i] = sumA + (sumB - sumA) * phaseLerp(position);
+    }
+}
+
+#if defined(RESAMPLER_HAS_X86)
+static void resampleSse2(const float (*filters)[RESAMPLER_NUM_TAPS], const float* input,
+                         uint64_t position, uint64_t step, float* output, uint32_t numOutputFrames)
+{
+    for(uint32_t i = 0; i < numOutputFrames; ++i, position += step)
+    {
+        const float* taps = firstTap(input, position);
+        const float* filterA = filters[phaseIndex(position)];
+        const float* filterB = filterA + RESAMPLER_NUM_TAPS;
+        __m128 sumA = _mm_setzero_ps();
+        __m128 sumB = _mm_setzero_ps();
+        for(int tap = 0; tap < RESAMPLER_NUM_TAPS; tap += 4)
+        {
+            // The input isn't aligned, it starts wherever the position is
+            __m128 x = _mm_loadu_ps(taps + tap);
+            sumA = _mm_add_ps(sumA, _mm_mul_ps(x, _mm_load_ps(filterA + tap)));
+            sumB = _mm_add_ps(sumB, _mm_mul_ps(x, _mm_load_ps(filterB + tap)));
+        }
+        // Lerping the 4 partial sums then adding them up is the same as the other way round
+        __m128 sum = _mm_add_ps(sumA, _mm_mul_ps(_mm_sub_ps(sumB, sumA), _mm_set1_ps(phaseLerp(position))));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        output[i] = _mm_cvtss_f32(sum);
+    }
+}
+
+TARGET_AVX2
+static void resampleAvx2(const float (*filters)[RESAMPLER_NUM_TAPS], const float* input,
+                         uint64_t position, uint64_t step, float* output, uint32_t numOutputFrames)
+{
+    for(uint32_t i = 0; i < numOutputFrames; ++i, position += step)
+    {
+        const float* taps = firstTap(input, position);
+        const float* filterA = filters[phaseIndex(position)];
+        const float* filterB = filterA + RESAMPLER_NUM_TAPS;
+        __m256 sumA = _mm256_setzero_ps();
+        __m256 sumB = _mm256_setzero_ps();
+        for(int tap = 0; tap < RESAMPLER_NUM_TAPS; tap += 8)
+        {
+            __m256 x = _mm256_loadu_ps(taps + tap);
+            sumA = _mm256_fmadd_ps(x, _mm256_load_ps(filterA + tap), sumA);
+            sumB = _mm256_fmadd_ps(x, _mm256_load_ps(filterB + tap), sumB);
+        }
+        __m256 sum8 = _mm256_fmadd_ps(_mm256_sub_ps(sumB, sumA), _mm256_set1_ps(phaseLerp(position)), sumA);
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        output[i] = _mm_cvtss_f32(sum);
+    }
+}
+
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    // The OS also has to save the AVX registers on a context switch
+    bool hasAvx = (info[2] & (1 << 28)) && (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    bool hasFma = info[2] & (1 << 12);
+    __cpuidex(info, 7, 0);
+    return hasAvx && hasFma && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif
+
+#if defined(RESAMPLER_HAS_NEON)
+static void resampleNeon(const float (*filters)[RESAMPLER_NUM_TAPS], const float* input,
+                         uint64_t position, uint64_t step, float* output, uint32_t numOutputFrames)
+{
+    for(uint32_t i = 0; i < numOutputFrames; ++i, position += step)
+    {
+        const float* taps = firstTap(input, position);
+        const float* filterA = filters[phaseIndex(position)];
+        const float* filterB = filterA + RESAMPLER_NUM_TAPS;
+        float32x4_t sumA = vdupq_n_f32(0.f);
+        float32x4_t sumB = vdupq_n_f32(0.f);
+        for(int tap = 0; tap < RESAMPLER_NUM_TAPS; tap += 4)
+        {
+            float32x4_t x = vld1q_f32(taps + tap);
+            sumA = vfmaq_f32(sumA, x, vld1q_f32(filterA + tap));
+            sumB = vfmaq_f32(sumB, x, vld1q_f32(filterB + tap));
+        }
+        float32x4_t sum = vfmaq_n_f32(sumA, vsubq_f32(sumB, sumA), phaseLerp(position));
+        output[i] = vaddvq_f32(sum);
+    }
+}
+#endif
+
+ResamplerKernel resamplerGetKernel(ResamplerKernelType type)
+{
+    switch(type)
+    {
+        case RESAMPLER_KERNEL_SCALAR: return resampleScalar;
+#if defined(RESAMPLER_HAS_X86)
+        case RESAMPLER_KERNEL_SSE2: return resampleSse2;
+        case RESAMPLER_KERNEL_AVX2: return cpuHasAvx2() ? resampleAvx2 : nullptr;
+#endif
+#if defined(RESAMPLER_HAS_NEON)
+        case RESAMPLER_KERNEL_NEON: return resampleNeon;
+#endif
+        default: return nullptr;
+    }
+}
+
+const char* resamplerKernelName(ResamplerKernelType type)
+{
+    static const char* names[RESAMPLER_KERNEL_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+    assert(type < RESAMPLER_KERNEL_COUNT);
+    return names[type];
+}
+
+void resamplerInit(Resampler* resampler, uint32_t inputSampleRate, uint32_t outputSampleRate, float speed)
+{
+    assert(speed > 0.f);
+    double inputFramesPerOutputFrame = speed * (double)inputSampleRate / outputSampleRate;
+    // The kernels read the input a frame at a time, so skipping more than
+    // that would need more taps to cover the gap
+    assert(inputFramesPerOutputFrame < RESAMPLER_NUM_TAPS / 2);
+    resampler->step = (uint64_t)(inputFramesPerOutputFrame * 4294967296.0);
+    resampler->position = 0;
+
+    // Each kernel is a drop-in replacement for the others, so take the fastest one there is
+    resampler->kernel = nullptr;
+    for(int type = RESAMPLER_KERNEL_COUNT - 1; !resampler->kernel; --type)
+        resampler->kernel = resamplerGetKernel((ResamplerKernelType)type);
+
+    // When we're stepping through the input faster than one frame at a time, lower
+    // the cutoff to the output's Nyquist frequency so anything above it gets filtered
+    // out instead of aliasing. Leave room for the filter's transition band either way
+    double cutoff = 0.9;
+    if(inputFramesPerOutputFrame > 1.0)
+        cutoff /= inputFramesPerOutputFrame;
+
+    // With only 16 taps the window decides how much each phase's response differs
+    // from the next, which comes out as distortion. Smaller betas give a sharper
+    // cutoff but distort a lot more: 7 is about 20dB worse than this
+    const double KAISER_BETA = 10.0;
+    const double halfWidth = RESAMPLER_NUM_TAPS / 2;
+    for(int phase = 0; phase <= RESAMPLER_NUM_PHASES; ++phase)
+    {
+        double fraction = (double)phase / RESAMPLER_NUM_PHASES;
+        double coefficients[RESAMPLER_NUM_TAPS];
+        double sum = 0.0;
+        for(int tap = 0; tap < RESAMPLER_NUM_TAPS; ++tap)
+        {
+            // Distance from the output position to this tap's input frame
+            double x = (RESAMPLER_NUM_TAPS / 2 - 1 - tap) + fraction;
+            double sinc = (x == 0.0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double r = x / halfWidth;
+            double window = (r * r < 1.0) ? besselI0(KAISER_BETA * sqrt(1.0 - r * r)) / besselI0(KAISER_BETA) : 0.0;
+            coefficients[tap] = sinc * window;
+            sum += coefficients[tap];
+        }
+        // Normalise so a constant signal comes out at the same level
+        for(int tap = 0; tap < RESAMPLER_NUM_TAPS; ++tap)
+            resampler->filters[phase][tap] = (float)(coefficients[tap] / sum);
+    }
+}
+
+uint32_t resamplerNumFramesUntil(const Resampler* resampler, uint32_t endFrame)
+{
+    uint64_t endPosition = (uint64_t)endFrame << 32;
+    if(resampler->position >= endPosition)
+        return 0;
+    // Round up, the last frame before the end counts too
+    return (uint32_t)((endPosition - resampler->position + resampler->step - 1) / resampler->step);
+}
+
+void resamplerProcess(Resampler* resampler, const float* const* inputs, float* const* outputs,
+                      uint32_t numChannels, uint32_t numOutputFrames)
+{
+    for(uint32_t channel = 0; channel < numChannels; ++channel)
+        resampler->kernel(resampler->filters, inputs[channel], resampler->position, resampler->step,
+                          outputs[channel], numOutputFrames);
+    resampler->position += numOutputFrames * resampler->step;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// Number of input frames that contribute to each output frame. Must be a multiple of 8
+#define RESAMPLER_NUM_TAPS 16
+// Number of fractional positions we precompute filters for.
+// We interpolate between the two nearest ones
+#define RESAMPLER_NUM_PHASES 256
+// How many frames the kernels read before and after the position
+// they're at, which the input has to have room for
+#define RESAMPLER_PADDING_FRAMES (RESAMPLER_NUM_TAPS / 2)
+
+// Works out one channel's output frames from a 32.32 fixed-point input position
+// that goes up by step every frame. input[-RESAMPLER_PADDING_FRAMES] up to
+// input[(position >> 32) + RESAMPLER_PADDING_FRAMES] have to be readable
+typedef void (*ResamplerKernel)(const float (*filters)[RESAMPLER_NUM_TAPS], const float* input,
+                                uint64_t position, uint64_t step, float* output, uint32_t numOutputFrames);
+
+enum ResamplerKernelType {
+    RESAMPLER_KERNEL_SCALAR,
+    RESAMPLER_KERNEL_SSE2,
+    RESAMPLER_KERNEL_AVX2,
+    RESAMPLER_KERNEL_NEON,
+    RESAMPLER_KERNEL_COUNT
+};
+
+// Windowed-sinc polyphase resampler for real-time playback. The filter table
+// only depends on how fast we step through the input, so changing the pitch
+// means calling resamplerInit again. The position is a 32.32 fixed-point
+// frame index, which unlike adding up a float time never drifts however
+// long the clip plays
+struct Resampler {
+    uint64_t step;     // Input frames per output frame, 32.32 fixed-point
+    uint64_t position; // 32.32 fixed-point input frame
+    ResamplerKernel kernel;
+    // One extra phase so we can always interpolate to phase+1
+    alignas(32) float filters[RESAMPLER_NUM_PHASES + 1][RESAMPLER_NUM_TAPS];
+};
+
+// Plays the input at speed (1 is normal) and picks the fastest kernel this CPU has
+void resamplerInit(Resampler* resampler, uint32_t inputSampleRate, uint32_t outputSampleRate, float speed);
+// Null if the kernel wasn't built for this CPU
+ResamplerKernel resamplerGetKernel(ResamplerKernelType type);
+const char* resamplerKernelName(ResamplerKernelType type);
+// How many output frames there are before the position reaches endFrame
+uint32_t resamplerNumFramesUntil(const Resampler* resampler, uint32_t endFrame);
+// Writes numOutputFrames of each channel, starting at the resampler's position,
+// then moves the position on. Each input channel is a separate array, and the
+// RESAMPLER_PADDING_FRAMES before and after it have to be readable too
+void resamplerProcess(Resampler* resampler, const float* const* inputs, float* const* outputs,
+                      uint32_t numChannels, uint32_t numOutputFrames);
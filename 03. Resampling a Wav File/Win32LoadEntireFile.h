@@ -3,3 +3,5 @@
 
 bool win32LoadEntireFile(const char* filename, void** data, uint32_t* numBytesRead);
 void Win32FreeFileData(void *data);
+bool win32MapEntireFile(const char* filename, void** data, uint32_t* fileSize);
+void Win32UnmapFileData(void *data);
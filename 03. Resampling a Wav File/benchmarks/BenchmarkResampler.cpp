@@ -0,0 +1,125 @@
+// Measures how many output frames per second each resampler kernel this CPU has
+// can make, for a few common rate conversions of a stereo clip. For comparison
+// it also times the linear interpolation main.cpp used to do.
+// Usage: BenchmarkResampler
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "../Resampler.h"
+
+// Time each kernel for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define NUM_INPUT_FRAMES 48000
+// Frames per resamplerProcess call, like one pass of main.cpp's loop
+#define FRAMES_PER_BLOCK 512
+#define NUM_CHANNELS 2
+
+struct Conversion {
+    uint32_t inputSampleRate;
+    uint32_t outputSampleRate;
+    float speed;
+};
+
+static const Conversion conversions[] = {
+    { 48000, 44100, 1.0f },
+    { 44100, 48000, 1.0f },
+    { 44100, 44100, 1.5f },
+};
+
+static float inputBuffer[NUM_CHANNELS][RESAMPLER_PADDING_FRAMES + NUM_INPUT_FRAMES + RESAMPLER_PADDING_FRAMES];
+static float outputBuffer[NUM_CHANNELS][FRAMES_PER_BLOCK];
+static Resampler resampler;
+// So the compiler can't tell the output is never used
+static volatile float sink;
+
+static void makeInput()
+{
+    uint32_t random = 1;
+    for(uint32_t channel = 0; channel < NUM_CHANNELS; ++channel)
+        for(uint32_t i = 0; i < RESAMPLER_PADDING_FRAMES + NUM_INPUT_FRAMES + RESAMPLER_PADDING_FRAMES; ++i)
+        {
+            random = random * 1664525 + 1013904223;
+            inputBuffer[channel][i] = (float)sin(0.01 * i * (channel + 1)) * 0.5f + (int32_t)random / 2147483648.f * 0.1f;
+        }
+}
+
+// What main.cpp used to do: lerp between the two nearest frames
+static void resampleLinear(const float (*)[RESAMPLER_NUM_TAPS], const float* input,
+                           uint64_t position, uint64_t step, float* output, uint32_t numOutputFrames)
+{
+    for(uint32_t i = 0; i < numOutputFrames; ++i, position += step)
+    {
+        uint32_t frame = (uint32_t)(position >> 32);
+        float t = (uint32_t)position * (1.f / 4294967296.f);
+        output[i] = input[frame] + (input[frame + 1] - input[frame]) * t;
+    }
+}
+
+// Returns output frames per second, going round and round the input a block at a time
+static double timeKernel(ResamplerKernel kernel)
+{
+    typedef std::chrono::steady_clock Clock;
+    const float* inputs[NUM_CHANNELS];
+    float* outputs[NUM_CHANNELS];
+    for(uint32_t channel = 0; channel < NUM_CHANNELS; ++channel)
+    {
+        inputs[channel] = inputBuffer[channel] + RESAMPLER_PADDING_FRAMES;
+        outputs[channel] = outputBuffer[channel];
+    }
+    resampler.kernel = kernel;
+    resampler.position = 0;
+
+    uint64_t numFrames = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        for(int block = 0; block < 64; ++block)
+        {
+            uint32_t numBlockFrames = resamplerNumFramesUntil(&resampler, NUM_INPUT_FRAMES);
+            if(numBlockFrames > FRAMES_PER_BLOCK)
+                numBlockFrames = FRAMES_PER_BLOCK;
+            resamplerProcess(&resampler, inputs, outputs, NUM_CHANNELS, numBlockFrames);
+            sink = outputBuffer[0][0] + outputBuffer[1][0];
+            numFrames += numBlockFrames;
+            if(resampler.position >= (uint64_t)NUM_INPUT_FRAMES << 32)
+                resampler.position -= (uint64_t)NUM_INPUT_FRAMES << 32;
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return numFrames / seconds;
+}
+
+int main()
+{
+    makeInput();
+    printf("Millions of stereo output frames per second (x real time at the output rate)\n");
+    printf("%8s %8s %6s", "input", "output", "speed");
+    printf(" %20s", "linear");
+    for(int type = 0; type < RESAMPLER_KERNEL_COUNT; ++type)
+        if(resamplerGetKernel((ResamplerKernelType)type))
+            printf(" %20s", resamplerKernelName((ResamplerKernelType)type));
+    printf("\n");
+
+    for(const Conversion& conversion : conversions)
+    {
+        resamplerInit(&resampler, conversion.inputSampleRate, conversion.outputSampleRate, conversion.speed);
+        printf("%8u %8u %6.2f", conversion.inputSampleRate, conversion.outputSampleRate, conversion.speed);
+        double framesPerSecond = timeKernel(resampleLinear);
+        printf(" %10.1f (%6.0fx)", framesPerSecond / 1e6, framesPerSecond / conversion.outputSampleRate);
+        for(int type = 0; type < RESAMPLER_KERNEL_COUNT; ++type)
+        {
+            ResamplerKernel kernel = resamplerGetKernel((ResamplerKernelType)type);
+            if(!kernel)
+                continue;
+            framesPerSecond = timeKernel(kernel);
+            printf(" %10.1f (%6.0fx)", framesPerSecond / 1e6, framesPerSecond / conversion.outputSampleRate);
+        }
+        printf("\n");
+    }
+    return 0;
+}
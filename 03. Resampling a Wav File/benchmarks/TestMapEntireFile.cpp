@@ -0,0 +1,118 @@
+// Checks posixMapEntireFile gives exactly the bytes reading the file does, and
+// fails cleanly on files it can't map, then times mapping and reading the
+// whole file against reading it into memory with fread.
+// Usage: TestMapEntireFile [wavFile]
+// Returns 1 if any check fails.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "../PosixMapEntireFile.h"
+
+// Time each case for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+
+// So the compiler can't tell the sums are never used
+static volatile uint32_t sink;
+
+static bool readEntireFile(const char* filename, uint8_t** data, uint32_t* fileSize)
+{
+    FILE* f = fopen(filename, "rb");
+    if(!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    *data = (uint8_t*)malloc(size > 0 ? size : 1);
+    bool result = *data && size > 0 && fread(*data, 1, size, f) == (size_t)size;
+    fclose(f);
+    *fileSize = (uint32_t)size;
+    return result;
+}
+
+// Touches every page, as playing the file through would
+static uint32_t sumBytes(const uint8_t* bytes, uint32_t numBytes)
+{
+    uint32_t sum = 0;
+    for(uint32_t i = 0; i < numBytes; i += 64)
+        sum += bytes[i];
+    return sum;
+}
+
+// Returns microseconds to get the file into memory and read it, mapped or with fread
+static double timeLoad(const char* filename, bool isMapped)
+{
+    typedef std::chrono::steady_clock Clock;
+    uint32_t numRuns = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        void* data;
+        uint32_t fileSize;
+        if(isMapped && posixMapEntireFile(filename, &data, &fileSize))
+        {
+            sink = sumBytes((const uint8_t*)data, fileSize);
+            posixUnmapFileData(data, fileSize);
+        }
+        else if(!isMapped && readEntireFile(filename, (uint8_t**)&data, &fileSize))
+        {
+            sink = sumBytes((const uint8_t*)data, fileSize);
+            free(data);
+        }
+        ++numRuns;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds * 1e6 / numRuns;
+}
+
+int main(int argc, char** argv)
+{
+    const char* filename = argc > 1 ? argv[1] : "../Testing48kHz.wav";
+    bool passed = true;
+
+    uint8_t* expected;
+    uint32_t expectedSize;
+    void* mapped;
+    uint32_t mappedSize;
+    if(!readEntireFile(filename, &expected, &expectedSize))
+    {
+        printf("Failed to read %s\n", filename);
+        return 1;
+    }
+    if(!posixMapEntireFile(filename, &mapped, &mappedSize))
+    {
+        printf("FAILED: couldn't map %s\n", filename);
+        passed = false;
+    }
+    else
+    {
+        if(mappedSize != expectedSize || memcmp(mapped, expected, expectedSize) != 0)
+        {
+            printf("FAILED: the mapped bytes aren't the file's\n");
+            passed = false;
+        }
+        posixUnmapFileData(mapped, mappedSize);
+    }
+    free(expected);
+
+    // An empty file can't be mapped, so it fails like in win32MapEntireFile
+    const char* emptyFilename = "build/Empty.wav";
+    FILE* empty = fopen(emptyFilename, "wb");
+    if(empty)
+        fclose(empty);
+    if(posixMapEntireFile(emptyFilename, &mapped, &mappedSize) || posixMapEntireFile("build/Missing.wav", &mapped, &mappedSize))
+    {
+        printf("FAILED: mapped an empty or missing file\n");
+        passed = false;
+    }
+    remove(emptyFilename);
+
+    printf("%s, %u bytes, microseconds to load and read through\n", filename, expectedSize);
+    printf("%-12s %14.1f\n", "fread", timeLoad(filename, false));
+    printf("%-12s %14.1f\n", "mmap", timeLoad(filename, true));
+    printf(passed ? "All checks passed\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Checks the resampler's quality: resamples a sine between the common rates and
+// measures THD+N, everything in the output that isn't the sine, relative to the
+// sine. Also checks every kernel this CPU has gives the same output as the
+// scalar one. For comparison it measures the linear interpolation main.cpp used to do.
+// Usage: TestResamplerQuality
+// Returns 1 if anything is worse than it should be.
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../Resampler.h"
+
+#define NUM_INPUT_FRAMES 48000
+#define MAX_OUTPUT_FRAMES 96000
+// Leave out the start and end, where the filter runs into the silence past the input
+#define SKIP_FRAMES 64
+#define AMPLITUDE 0.5
+// Any kernel has to be this close to the scalar one, which only adds its taps up in another order
+#define MAX_KERNEL_DIFFERENCE 1e-6f
+
+struct TestCase {
+    uint32_t inputSampleRate;
+    uint32_t outputSampleRate;
+    float speed;
+    double toneHz;
+    double maxThdNDb;
+};
+
+// The tones are in the passband, which goes up to 90% of the lower Nyquist frequency
+static const TestCase testCases[] = {
+    { 48000, 44100, 1.0f, 1000.0, -95.0 },
+    { 48000, 44100, 1.0f, 10000.0, -95.0 },
+    { 44100, 48000, 1.0f, 1000.0, -95.0 },
+    { 44100, 48000, 1.0f, 15000.0, -90.0 },
+    { 22050, 48000, 1.0f, 5000.0, -95.0 },
+    { 44100, 44100, 1.5f, 1000.0, -95.0 },
+    { 44100, 44100, 0.5f, 1000.0, -95.0 },
+};
+
+static float inputBuffer[RESAMPLER_PADDING_FRAMES + NUM_INPUT_FRAMES + RESAMPLER_PADDING_FRAMES];
+static float* input = inputBuffer + RESAMPLER_PADDING_FRAMES;
+static float output[MAX_OUTPUT_FRAMES];
+static float reference[MAX_OUTPUT_FRAMES];
+static Resampler resampler;
+
+// Least squares fit of a sine at frequency (cycles per frame) to the signal,
+// then the energy of what's left over relative to the sine's, in dB
+static double measureThdN(const float* signal, uint32_t numFrames, double frequency)
+{
+    double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+    for(uint32_t i = 0; i < numFrames; ++i)
+    {
+        double s = sin(2 * M_PI * frequency * i);
+        double c = cos(2 * M_PI * frequency * i);
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        ys += signal[i] * s;
+        yc += signal[i] * c;
+    }
+    double determinant = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / determinant;
+    double b = (yc * ss - ys * sc) / determinant;
+    double sineEnergy = 0.0;
+    double residualEnergy = 0.0;
+    for(uint32_t i = 0; i < numFrames; ++i)
+    {
+        double fit = a * sin(2 * M_PI * frequency * i) + b * cos(2 * M_PI * frequency * i);
+        sineEnergy += fit * fit;
+        residualEnergy += (signal[i] - fit) * (signal[i] - fit);
+    }
+    return 10.0 * log10(residualEnergy / sineEnergy + 1e-30);
+}
+
+// What main.cpp used to do: lerp between the two nearest frames
+static void resampleLinear(const float* samples, uint64_t position, uint64_t step, float* out, uint32_t numOutputFrames)
+{
+    for(uint32_t i = 0; i < numOutputFrames; ++i, position += step)
+    {
+        uint32_t frame = (uint32_t)(position >> 32);
+        float t = (uint32_t)position * (1.f / 4294967296.f);
+        out[i] = samples[frame] + (samples[frame + 1] - samples[frame]) * t;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    printf("%8s %8s %6s %8s %12s %12s %12s", "input", "output", "speed", "tone", "THD+N dB", "limit dB", "linear dB");
+    for(int type = 0; type < RESAMPLER_KERNEL_COUNT; ++type)
+        if(resamplerGetKernel((ResamplerKernelType)type))
+            printf(" %8s", resamplerKernelName((ResamplerKernelType)type));
+    printf("\n");
+
+    for(const TestCase& test : testCases)
+    {
+        // The sine carries on into the padding, so there's no edge to ring on
+        const double inputFrequency = test.toneHz / test.inputSampleRate;
+        for(int32_t i = -RESAMPLER_PADDING_FRAMES; i < NUM_INPUT_FRAMES + RESAMPLER_PADDING_FRAMES; ++i)
+            input[i] = (float)(AMPLITUDE * sin(2 * M_PI * inputFrequency * i));
+
+        resamplerInit(&resampler, test.inputSampleRate, test.outputSampleRate, test.speed);
+        uint32_t numOutputFrames = resamplerNumFramesUntil(&resampler, NUM_INPUT_FRAMES);
+        if(numOutputFrames > MAX_OUTPUT_FRAMES)
+            numOutputFrames = MAX_OUTPUT_FRAMES;
+        const uint32_t numMeasuredFrames = numOutputFrames - 2 * SKIP_FRAMES;
+        // The tone's frequency once it's been resampled
+        const double outputFrequency = test.toneHz * test.speed / test.outputSampleRate;
+
+        const float* inputs[1] = { input };
+        float* outputs[1] = { reference };
+        resamplerProcess(&resampler, inputs, outputs, 1, numOutputFrames);
+        double thdN = measureThdN(reference + SKIP_FRAMES, numMeasuredFrames, outputFrequency);
+        // The fit starts at the first measured frame, which is a whole number of output frames in
+        resampleLinear(input, 0, resampler.step, output, numOutputFrames);
+        double linearThdN = measureThdN(output + SKIP_FRAMES, numMeasuredFrames, outputFrequency);
+        bool isGoodEnough = thdN <= test.maxThdNDb;
+        printf("%8u %8u %6.2f %8.0f %12.1f %12.1f %12.1f", test.inputSampleRate, test.outputSampleRate, test.speed,
+               test.toneHz, thdN, test.maxThdNDb, linearThdN);
+
+        for(int type = 0; type < RESAMPLER_KERNEL_COUNT; ++type)
+        {
+            ResamplerKernel kernel = resamplerGetKernel((ResamplerKernelType)type);
+            if(!kernel)
+                continue;
+            kernel(resampler.filters, input, 0, resampler.step, output, numOutputFrames);
+            float maxDifference = 0.f;
+            for(uint32_t i = 0; i < numOutputFrames; ++i)
+                maxDifference = fmaxf(maxDifference, fabsf(output[i] - reference[i]));
+            bool matches = maxDifference <= MAX_KERNEL_DIFFERENCE;
+            printf(" %8s", matches ? "ok" : "FAIL");
+            passed = passed && matches;
+        }
+        printf("%s\n", isGoodEnough ? "" : "  FAIL");
+        passed = passed && isGoodEnough;
+    }
+    printf(passed ? "Passed\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#!/bin/sh
+# Builds the resampler benchmark and quality test, and the file mapping test, on Linux
+set -e
+cd "$(dirname "$0")"
+mkdir -p build
+
+echo Building...
+c++ -O2 -DNDEBUG -Wall -Wextra BenchmarkResampler.cpp ../Resampler.cpp -o build/BenchmarkResampler
+c++ -O2 -Wall -Wextra TestResamplerQuality.cpp ../Resampler.cpp -o build/TestResamplerQuality
+c++ -O2 -Wall -Wextra TestMapEntireFile.cpp ../PosixMapEntireFile.cpp -o build/TestMapEntireFile
+echo Done
@@ -9,20 +9,18 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "LoadWavFile.h"
+#include "Resampler.h"
 #include "Win32LoadEntireFile.h"
 
-inline float lerp(float a, float b, float t){
-    return a + (b-a)*t;
-}
-
 int main()
 {
     const char* wavFilename = "Testing48kHz.wav";
     void* fileBytes;
     uint32_t fileSize;
-    bool result = win32LoadEntireFile(wavFilename, &fileBytes, &fileSize);
+    bool result = win32MapEntireFile(wavFilename, &fileBytes, &fileSize);
     assert(result);
 
     AudioClip clip = parseWavFile((uint8_t*)fileBytes, fileSize);
@@ -87,10 +85,54 @@ int main()
     hr = audioClient->Start();
     assert(hr == S_OK);
 
-    float wavPlaybackTime = 0.0f;
-    float wavPlaybackSpeed = 1.0f; // change this to speed up/slow down playback!
-    const float wavDurationSecs = (float)clip.numSamples/(clip.sampleRate * clip.numChannels);
+    // Convert the clip to one float array per channel, so the resampler can work
+    // on runs of contiguous samples. Each one has room either side for the
+    // resampler's filter to read past the ends: silence for a clip that plays
+    // once, or the other end of the clip for one that loops, so the loop point
+    // gets filtered like everywhere else
+    const uint32_t clipNumFrames = clip.numSamples / clip.numChannels;
     bool playLooping = true;
+    assert(clipNumFrames >= RESAMPLER_PADDING_FRAMES);
+    const uint32_t planeStride = RESAMPLER_PADDING_FRAMES + clipNumFrames + RESAMPLER_PADDING_FRAMES;
+    float* planes = (float*)malloc(planeStride * clip.numChannels * sizeof(float));
+    assert(planes);
+    const float* inputs[2];
+    {
+        // Wav PCM data is signed 16-bit
+        const int16_t* samples = (int16_t*)clip.samples;
+        for(uint32_t channel = 0; channel < clip.numChannels; ++channel)
+        {
+            float* plane = planes + channel * planeStride + RESAMPLER_PADDING_FRAMES;
+            for(uint32_t i = 0; i < clipNumFrames; ++i)
+                plane[i] = samples[i * clip.numChannels + channel] * (1.f / 32768.f);
+            for(int32_t i = 1; i <= RESAMPLER_PADDING_FRAMES; ++i)
+            {
+                plane[-i] = playLooping ? plane[clipNumFrames - i] : 0.f;
+                plane[clipNumFrames - 1 + i] = playLooping ? plane[i - 1] : 0.f;
+            }
+            inputs[channel] = plane;
+        }
+    }
+    // The planes are a copy, so the mapping was only so the file didn't have
+    // to be read onto the heap first. Nothing reads it from here on
+    Win32UnmapFileData(fileBytes);
+
+    // The resampler keeps a 32.32 fixed-point frame index into the clip.
+    // Accumulating a float time in seconds instead loses precision (and drifts)
+    // the longer the clip plays, whereas this stays exact for any clip length
+    float wavPlaybackSpeed = 1.0f; // change this to speed up/slow down playback!
+    Resampler resampler;
+    resamplerInit(&resampler, clip.sampleRate, OUTPUT_SAMPLE_RATE, wavPlaybackSpeed);
+    const uint64_t wavEndPos = (uint64_t)clipNumFrames << 32;
+
+    // The resampler writes a block of each channel at a time into these,
+    // then we interleave them into the sound buffer
+    const uint32_t MAX_BLOCK_FRAMES = 1024;
+    static float resampledLeft[MAX_BLOCK_FRAMES];
+    static float resampledRight[MAX_BLOCK_FRAMES];
+    float* outputs[2] = { resampledLeft, resampledRight };
+    // Mono clips play the same thing out of both speakers
+    const float* rightOutput = outputs[clip.numChannels - 1];
 
     bool isRunning = true;
     while (isRunning)
@@ -115,37 +157,39 @@ int main()
         hr = audioRenderClient->GetBuffer(numFramesToWrite, (BYTE**)(&buffer));
         assert(hr == S_OK);
 
-        for (UINT32 frameIndex = 0; frameIndex < numFramesToWrite; ++frameIndex)
+        UINT32 frameIndex = 0;
+        while(frameIndex < numFramesToWrite)
         {
-            float currFrameIndex = wavPlaybackTime * clip.sampleRate;
-            int prevFrameIndex = (int)currFrameIndex;
-            int nextFrameIndex = (prevFrameIndex + 1) % (clip.numSamples * clip.numChannels);
-
-            int prevLeftSampleIndex = clip.numChannels * prevFrameIndex;
-            int nextLeftSampleIndex = clip.numChannels * nextFrameIndex;
-            int prevRightSampleIndex = prevLeftSampleIndex + clip.numChannels - 1;
-            int nextRightSampleIndex = nextLeftSampleIndex + clip.numChannels - 1;
-
-            uint16_t* samples = (uint16_t*)clip.samples;
-            float prevLeftSample = (float)(samples[prevLeftSampleIndex]);
-            float nextLeftSample = (float)(samples[nextLeftSampleIndex]);
-            float prevRightSample = (float)(samples[prevRightSampleIndex]);
-            float nextRightSample = (float)(samples[nextRightSampleIndex]);
-
-            float lerpT = (currFrameIndex - prevFrameIndex) / clip.sampleRate;
-            uint16_t leftSample = (uint16_t)lerp(prevLeftSample, nextLeftSample, lerpT);
-            uint16_t rightSample = (uint16_t)lerp(prevRightSample, nextRightSample, lerpT);
-            *buffer++ = leftSample;
-            *buffer++ = rightSample;
-
-            wavPlaybackTime += wavPlaybackSpeed / OUTPUT_SAMPLE_RATE;
-            
-            if(wavPlaybackTime >= wavDurationSecs){
+            // Stop each block at the end of the clip, so we can loop or stop there
+            uint32_t numFrames = numFramesToWrite - frameIndex;
+            if(numFrames > MAX_BLOCK_FRAMES)
+                numFrames = MAX_BLOCK_FRAMES;
+            uint32_t numFramesUntilEnd = resamplerNumFramesUntil(&resampler, clipNumFrames);
+            if(numFrames > numFramesUntilEnd)
+                numFrames = numFramesUntilEnd;
+
+            resamplerProcess(&resampler, inputs, outputs, clip.numChannels, numFrames);
+            for(uint32_t i = 0; i < numFrames; ++i)
+            {
+                float left = resampledLeft[i];
+                float right = rightOutput[i];
+                left = left > 1.f ? 1.f : (left < -1.f ? -1.f : left);
+                right = right > 1.f ? 1.f : (right < -1.f ? -1.f : right);
+                *buffer++ = (int16_t)(left * 32767.f);
+                *buffer++ = (int16_t)(right * 32767.f);
+            }
+            frameIndex += numFrames;
+
+            if(resampler.position >= wavEndPos){
                 // Reached end of sound. Can choose to loop or stop
-                wavPlaybackTime -= wavDurationSecs;
+                resampler.position -= wavEndPos;
                 if(!playLooping) {
+                    // Write silence for the rest of the buffer
+                    for(; frameIndex < numFramesToWrite; ++frameIndex) {
+                        *buffer++ = 0;
+                        *buffer++ = 0;
+                    }
                     isRunning = false;
-                    break;
                 }
             }
         }
@@ -168,7 +212,7 @@ int main()
     audioRenderClient->Release();
     // audioClock->Release();
 
-    Win32FreeFileData(fileBytes);
+    free(planes);
 
     return 0;
 }
@@ -0,0 +1,39 @@
+#include "ByteSource.h"
+
+#include <assert.h>
+#include <string.h>
+
+bool byteSourceRead(ByteSource* source, uint32_t slot, uint64_t offset, void* dest, uint32_t numBytes)
+{
+    if(!source->startRead(source, slot, offset, dest, numBytes))
+        return false;
+    return source->waitForRead(source, slot) == numBytes;
+}
+
+static bool memoryStartRead(ByteSource* source, uint32_t slot, uint64_t offset, void* dest, uint32_t numBytes)
+{
+    MemoryByteSource* memorySource = (MemoryByteSource*)source;
+    assert(slot < BYTE_SOURCE_MAX_READS);
+    // Like a file, reading past the end gives back less
+    uint64_t numBytesLeft = offset < source->size ? source->size - offset : 0;
+    if(numBytes > numBytesLeft)
+        numBytes = (uint32_t)numBytesLeft;
+    memcpy(dest, memorySource->bytes + offset, numBytes);
+    memorySource->numBytesRead[slot] = numBytes;
+    return true;
+}
+
+static uint32_t memoryWaitForRead(ByteSource* source, uint32_t slot)
+{
+    assert(slot < BYTE_SOURCE_MAX_READS);
+    return ((MemoryByteSource*)source)->numBytesRead[slot];
+}
+
+void memoryByteSourceInit(MemoryByteSource* memorySource, const void* bytes, uint64_t size)
+{
+    memorySource->source.size = size;
+    memorySource->source.startRead = memoryStartRead;
+    memorySource->source.waitForRead = memoryWaitForRead;
+    memorySource->bytes = (const uint8_t*)bytes;
+    memset(memorySource->numBytesRead, 0, sizeof(memorySource->numBytesRead));
+}
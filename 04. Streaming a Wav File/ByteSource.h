@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// Most reads a ByteSource can have in flight at once
+#define BYTE_SOURCE_MAX_READS 4
+
+// Somewhere a WavStream reads its bytes from: a file, memory, or anything else
+// that can read a range of bytes. Reads can carry on in the background. Each one
+// goes in a numbered slot, and nothing can touch its destination until
+// waitForRead says it's finished
+struct ByteSource {
+    uint64_t size;
+    // Starts reading numBytes from offset into dest. Returns false if the read couldn't be started
+    bool (*startRead)(ByteSource* source, uint32_t slot, uint64_t offset, void* dest, uint32_t numBytes);
+    // Waits for the read in slot to finish, returns the number of bytes read
+    uint32_t (*waitForRead)(ByteSource* source, uint32_t slot);
+};
+
+// Reads and waits, for small things like chunk headers.
+// Returns false unless all numBytes were read
+bool byteSourceRead(ByteSource* source, uint32_t slot, uint64_t offset, void* dest, uint32_t numBytes);
+
+// Reads out of memory the caller owns, e.g. an archive that's already
+// loaded or mapped. Every read finishes straight away
+struct MemoryByteSource {
+    ByteSource source;
+    const uint8_t* bytes;
+    uint32_t numBytesRead[BYTE_SOURCE_MAX_READS];
+};
+
+void memoryByteSourceInit(MemoryByteSource* memorySource, const void* bytes, uint64_t size);
@@ -0,0 +1,154 @@
+#include "WavStream.h"
+
+#include <assert.h>
+#include <string.h>
+
+// Streams a wav file in fixed-size blocks instead of loading it all up front.
+// Only the chunk headers are read when opening, so playback can start as soon as the
+// first block arrives, and memory use stays the same however long the file is.
+// Where the bytes come from is up to the ByteSource, e.g. a file or memory
+// For illustrative purposes only, no warranty is implied
+// References:
+// https://www.mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+
+// Same value as WAVE_FORMAT_PCM in mmreg.h
+#define WAVE_FORMAT_TAG_PCM 0x0001
+
+static uint16_t readU16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+// Kick off a background read of the next part of the data chunk into block
+static void requestBlock(WavStream* stream, uint32_t blockIndex)
+{
+    WavStreamBlock* block = &stream->blocks[blockIndex];
+    assert(!block->readPending);
+    if(stream->nextReadPos == stream->dataSize && stream->loop)
+        stream->nextReadPos = 0;
+
+    uint32_t numBytesLeft = stream->dataSize - stream->nextReadPos;
+    uint32_t numBytesToRead = numBytesLeft < WAV_STREAM_BLOCK_SIZE ? numBytesLeft : WAV_STREAM_BLOCK_SIZE;
+    block->numBytes = 0;
+    if(numBytesToRead == 0)
+        return;
+
+    if(!stream->source->startRead(stream->source, blockIndex, stream->dataOffset + stream->nextReadPos,
+                                  block->bytes, numBytesToRead))
+    {
+        assert(!"Failed to read wav stream block");
+        return;
+    }
+    block->readPending = true;
+    stream->nextReadPos += numBytesToRead;
+}
+
+static void waitForBlock(WavStream* stream, uint32_t blockIndex)
+{
+    WavStreamBlock* block = &stream->blocks[blockIndex];
+    if(!block->readPending)
+        return;
+    block->numBytes = stream->source->waitForRead(stream->source, blockIndex);
+    block->readPending = false;
+}
+
+bool wavStreamOpen(WavStream* stream, ByteSource* source, bool loop)
+{
+    *stream = {};
+    stream->source = source;
+    stream->loop = loop;
+    uint64_t sourceSize = source->size < UINT32_MAX ? source->size : UINT32_MAX;
+
+    uint8_t header[12];
+    if(!byteSourceRead(source, WAV_STREAM_HEADER_SLOT, 0, header, sizeof(header))
+       || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        return false;
+
+    // Walk the chunk headers without reading anything else
+    bool foundFmt = false;
+    uint64_t chunkOffset = sizeof(header);
+    while(chunkOffset + 8 <= sourceSize)
+    {
+        uint8_t chunk[8];
+        if(!byteSourceRead(source, WAV_STREAM_HEADER_SLOT, chunkOffset, chunk, sizeof(chunk)))
+            break;
+        uint32_t chunkSize = readU32(chunk + 4);
+
+        if(memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+            uint8_t fmt[16];
+            if(!byteSourceRead(source, WAV_STREAM_HEADER_SLOT, chunkOffset + 8, fmt, sizeof(fmt)))
+                break;
+            if(readU16(fmt) != WAVE_FORMAT_TAG_PCM)
+                break;
+            stream->numChannels = readU16(fmt + 2);
+            stream->sampleRate = readU32(fmt + 4);
+            stream->bytesPerFrame = readU16(fmt + 12);
+            stream->numBitsPerSample = readU16(fmt + 14);
+            foundFmt = true;
+        }
+        else if(memcmp(chunk, "data", 4) == 0) {
+            stream->dataOffset = (uint32_t)(chunkOffset + 8);
+            stream->dataSize = (uint32_t)(sourceSize - stream->dataOffset);
+            if(chunkSize < stream->dataSize)
+                stream->dataSize = chunkSize;
+            break;
+        }
+        // Chunks are padded to an even number of bytes
+        chunkOffset += 8 + (((uint64_t)chunkSize + 1) & ~1ull);
+    }
+
+    if(!foundFmt || stream->dataSize == 0 || stream->bytesPerFrame == 0)
+        return false;
+
+    for(uint32_t blockIndex = 0; blockIndex < WAV_STREAM_NUM_BLOCKS; ++blockIndex)
+        requestBlock(stream, blockIndex);
+    return true;
+}
+
+uint32_t wavStreamRead(WavStream* stream, void* dest, uint32_t numFrames)
+{
+    uint8_t* destBytes = (uint8_t*)dest;
+    uint32_t numBytesWanted = numFrames * stream->bytesPerFrame;
+    uint32_t numBytesCopied = 0;
+    while(numBytesCopied < numBytesWanted)
+    {
+        WavStreamBlock* block = &stream->blocks[stream->currBlock];
+        waitForBlock(stream, stream->currBlock);
+
+        uint32_t numBytesAvailable = block->numBytes - stream->currBlockReadPos;
+        if(numBytesAvailable == 0)
+        {
+            if(block->numBytes == 0)
+                break; // Reached the end of a non-looping stream
+
+            // Finished with this block, refill it in the background
+            // and move on to the next one
+            requestBlock(stream, stream->currBlock);
+            stream->currBlock = (stream->currBlock + 1) % WAV_STREAM_NUM_BLOCKS;
+            stream->currBlockReadPos = 0;
+            continue;
+        }
+
+        uint32_t numBytesToCopy = numBytesWanted - numBytesCopied;
+        if(numBytesToCopy > numBytesAvailable)
+            numBytesToCopy = numBytesAvailable;
+        memcpy(destBytes + numBytesCopied, block->bytes + stream->currBlockReadPos, numBytesToCopy);
+        numBytesCopied += numBytesToCopy;
+        stream->currBlockReadPos += numBytesToCopy;
+    }
+    return numBytesCopied / stream->bytesPerFrame;
+}
+
+void wavStreamClose(WavStream* stream)
+{
+    if(!stream->source)
+        return;
+    for(uint32_t blockIndex = 0; blockIndex < WAV_STREAM_NUM_BLOCKS; ++blockIndex)
+        waitForBlock(stream, blockIndex);
+    stream->source = nullptr;
+}
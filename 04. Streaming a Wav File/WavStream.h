@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ByteSource.h"
+
+// Size of each block we read from the source. The stream only ever holds
+// WAV_STREAM_NUM_BLOCKS of these in memory, no matter how long the wav file is
+#define WAV_STREAM_BLOCK_SIZE (64 * 1024)
+// Double buffered: we play out of one block while the next one is being read
+// in the background. Make it 3 if the source is slow to get going
+#define WAV_STREAM_NUM_BLOCKS 2
+// The source slot for reading chunk headers, after the ones the blocks use
+#define WAV_STREAM_HEADER_SLOT WAV_STREAM_NUM_BLOCKS
+
+static_assert(WAV_STREAM_NUM_BLOCKS + 1 <= BYTE_SOURCE_MAX_READS, "Not enough ByteSource slots");
+
+struct WavStreamBlock {
+    uint8_t bytes[WAV_STREAM_BLOCK_SIZE];
+    uint32_t numBytes;
+    bool readPending;
+};
+
+struct WavStream {
+    ByteSource* source;
+    uint32_t numChannels;
+    uint32_t numBitsPerSample;
+    uint32_t sampleRate;
+    uint32_t bytesPerFrame;
+
+    uint32_t dataOffset; // Position of the first sample in the source
+    uint32_t dataSize;
+    uint32_t nextReadPos; // Position in the data chunk of the next block read
+    bool loop;
+
+    WavStreamBlock blocks[WAV_STREAM_NUM_BLOCKS];
+    uint32_t currBlock;
+    uint32_t currBlockReadPos;
+};
+
+// Only reads the chunk headers, then starts reading the first blocks in the background
+bool wavStreamOpen(WavStream* stream, ByteSource* source, bool loop);
+// Copies up to numFrames frames into dest, returns the number of frames copied.
+// Returns less than numFrames once a non-looping stream reaches the end
+uint32_t wavStreamRead(WavStream* stream, void* dest, uint32_t numFrames);
+// Waits for any reads that are still going. The source is the caller's to close
+void wavStreamClose(WavStream* stream);
@@ -0,0 +1,81 @@
+#include "Win32FileByteSource.h"
+
+#include <assert.h>
+
+static bool fileStartRead(ByteSource* source, uint32_t slot, uint64_t offset, void* dest, uint32_t numBytes)
+{
+    Win32FileByteSource* fileSource = (Win32FileByteSource*)source;
+    assert(slot < BYTE_SOURCE_MAX_READS && !fileSource->readPending[slot]);
+    OVERLAPPED* overlapped = &fileSource->reads[slot];
+    *overlapped = {};
+    // ReadFile resets it when the read starts
+    overlapped->hEvent = fileSource->readEvents[slot];
+    overlapped->Offset = (DWORD)offset;
+    overlapped->OffsetHigh = (DWORD)(offset >> 32);
+    if(!ReadFile(fileSource->file, dest, numBytes, 0, overlapped) && GetLastError() != ERROR_IO_PENDING)
+        return false;
+    fileSource->readPending[slot] = true;
+    return true;
+}
+
+static uint32_t fileWaitForRead(ByteSource* source, uint32_t slot)
+{
+    Win32FileByteSource* fileSource = (Win32FileByteSource*)source;
+    assert(slot < BYTE_SOURCE_MAX_READS);
+    if(!fileSource->readPending[slot])
+        return 0;
+    fileSource->readPending[slot] = false;
+    DWORD numBytesRead = 0;
+    if(!GetOverlappedResult(fileSource->file, &fileSource->reads[slot], &numBytesRead, TRUE))
+        return 0;
+    return numBytesRead;
+}
+
+static void closeReadEvents(Win32FileByteSource* fileSource)
+{
+    for(uint32_t slot = 0; slot < BYTE_SOURCE_MAX_READS; ++slot)
+    {
+        if(fileSource->readEvents[slot])
+            CloseHandle(fileSource->readEvents[slot]);
+        fileSource->readEvents[slot] = 0;
+    }
+}
+
+bool win32FileByteSourceOpen(Win32FileByteSource* fileSource, const char* filename)
+{
+    *fileSource = {};
+    fileSource->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                                   FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if(fileSource->file == INVALID_HANDLE_VALUE)
+        return false;
+    bool isOpen = true;
+    for(uint32_t slot = 0; slot < BYTE_SOURCE_MAX_READS; ++slot)
+    {
+        fileSource->readEvents[slot] = CreateEventA(0, TRUE, FALSE, 0);
+        isOpen = isOpen && fileSource->readEvents[slot];
+    }
+    LARGE_INTEGER fileSize;
+    if(!isOpen || !GetFileSizeEx(fileSource->file, &fileSize))
+    {
+        closeReadEvents(fileSource);
+        CloseHandle(fileSource->file);
+        fileSource->file = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    fileSource->source.size = (uint64_t)fileSize.QuadPart;
+    fileSource->source.startRead = fileStartRead;
+    fileSource->source.waitForRead = fileWaitForRead;
+    return true;
+}
+
+void win32FileByteSourceClose(Win32FileByteSource* fileSource)
+{
+    if(fileSource->file == INVALID_HANDLE_VALUE || !fileSource->file)
+        return;
+    // The OS is still writing into the destinations of any reads in flight
+    for(uint32_t slot = 0; slot < BYTE_SOURCE_MAX_READS; ++slot)
+        fileWaitForRead(&fileSource->source, slot);
+    closeReadEvents(fileSource);
+    CloseHandle(fileSource->file);
+    fileSource->file = INVALID_HANDLE_VALUE;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <windows.h>
+#include <stdint.h>
+
+#include "ByteSource.h"
+
+// Reads a file with overlapped IO, so a read carries on in the background
+// until the stream needs what it read
+struct Win32FileByteSource {
+    ByteSource source;
+    HANDLE file;
+    OVERLAPPED reads[BYTE_SOURCE_MAX_READS];
+    // A manual-reset event for each slot. Without one GetOverlappedResult waits on the
+    // file handle, which any of the reads in flight finishing would signal
+    HANDLE readEvents[BYTE_SOURCE_MAX_READS];
+    bool readPending[BYTE_SOURCE_MAX_READS];
+};
+
+bool win32FileByteSourceOpen(Win32FileByteSource* fileSource, const char* filename);
+// Waits for any reads that are still going, then closes the file
+void win32FileByteSourceClose(Win32FileByteSource* fileSource);
@@ -0,0 +1,225 @@
+// Measures how long it takes until the first block of a long wav file can be
+// played, streaming it versus loading the whole thing first, and how much memory
+// each one holds on to. The file is made up in memory and read through a
+// simulated disk with a fixed latency and throughput, so the numbers don't
+// depend on what's in the OS's file cache. Also checks the streamed samples
+// come out exactly as they are in the file, looping or not.
+// Usage: BenchmarkWavStream [megabytes per second] [read latency in ms]
+// Returns 1 if the streamed samples are wrong.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "../WavStream.h"
+
+#define SAMPLE_RATE 48000
+#define NUM_CHANNELS 2
+#define FILE_MINUTES 10
+#define NUM_FILE_FRAMES ((uint32_t)SAMPLE_RATE * 60 * FILE_MINUTES)
+// How much the device asks for at once, 10ms
+#define FRAMES_PER_PERIOD (SAMPLE_RATE / 100)
+
+typedef std::chrono::steady_clock Clock;
+
+// Reads out of memory, but each read takes as long as it would from a disk with
+// this latency and throughput. Reads queue up behind each other like on a real
+// disk, and carry on in the "background" until waitForRead
+struct SimulatedDiskByteSource {
+    ByteSource source;
+    MemoryByteSource memory;
+    double latencySeconds;
+    double bytesPerSecond;
+    Clock::time_point diskFreeTime; // When the disk finishes everything asked of it so far
+    Clock::time_point readDoneTime[BYTE_SOURCE_MAX_READS];
+    uint32_t numBytesRead[BYTE_SOURCE_MAX_READS];
+};
+
+static bool diskStartRead(ByteSource* source, uint32_t slot, uint64_t offset, void* dest, uint32_t numBytes)
+{
+    SimulatedDiskByteSource* disk = (SimulatedDiskByteSource*)source;
+    Clock::time_point now = Clock::now();
+    Clock::time_point startTime = disk->diskFreeTime > now ? disk->diskFreeTime : now;
+    double seconds = disk->latencySeconds + numBytes / disk->bytesPerSecond;
+    disk->readDoneTime[slot] = startTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    disk->diskFreeTime = disk->readDoneTime[slot];
+    // Copying now rather than when the read is done is fine, nothing looks at dest until then
+    if(!disk->memory.source.startRead(&disk->memory.source, slot, offset, dest, numBytes))
+        return false;
+    disk->numBytesRead[slot] = disk->memory.source.waitForRead(&disk->memory.source, slot);
+    return true;
+}
+
+static uint32_t diskWaitForRead(ByteSource* source, uint32_t slot)
+{
+    SimulatedDiskByteSource* disk = (SimulatedDiskByteSource*)source;
+    std::this_thread::sleep_until(disk->readDoneTime[slot]);
+    return disk->numBytesRead[slot];
+}
+
+static void simulatedDiskInit(SimulatedDiskByteSource* disk, const void* bytes, uint64_t size,
+                              double bytesPerSecond, double latencySeconds)
+{
+    memoryByteSourceInit(&disk->memory, bytes, size);
+    disk->source.size = size;
+    disk->source.startRead = diskStartRead;
+    disk->source.waitForRead = diskWaitForRead;
+    disk->bytesPerSecond = bytesPerSecond;
+    disk->latencySeconds = latencySeconds;
+    disk->diskFreeTime = Clock::now();
+}
+
+static void writeU16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+static void writeU32(uint8_t* bytes, uint32_t value)
+{
+    writeU16(bytes, (uint16_t)value);
+    writeU16(bytes + 2, (uint16_t)(value >> 16));
+}
+
+// What sample i of the file is, so the stream's output can be checked without keeping a copy
+static int16_t expectedSample(uint32_t i)
+{
+    return (int16_t)(i * 2654435761u >> 16);
+}
+
+// A 16-bit wav with an odd-sized JUNK chunk before the data, so the stream
+// has to skip over something, padding byte and all, to find it
+static uint8_t* makeWavFile(uint32_t numFrames, uint32_t* fileSize)
+{
+    const uint32_t JUNK_SIZE = 27;
+    const uint32_t dataSize = numFrames * NUM_CHANNELS * sizeof(int16_t);
+    *fileSize = 12 + 8 + 16 + 8 + JUNK_SIZE + 1 + 8 + dataSize;
+    uint8_t* bytes = (uint8_t*)calloc(*fileSize, 1);
+    if(!bytes)
+        return nullptr;
+    uint8_t* p = bytes;
+    memcpy(p, "RIFF", 4);
+    writeU32(p + 4, *fileSize - 8);
+    memcpy(p + 8, "WAVE", 4);
+    p += 12;
+    memcpy(p, "fmt ", 4);
+    writeU32(p + 4, 16);
+    writeU16(p + 8, 1); // PCM
+    writeU16(p + 10, NUM_CHANNELS);
+    writeU32(p + 12, SAMPLE_RATE);
+    writeU32(p + 16, SAMPLE_RATE * NUM_CHANNELS * sizeof(int16_t));
+    writeU16(p + 20, NUM_CHANNELS * sizeof(int16_t));
+    writeU16(p + 22, 16);
+    p += 8 + 16;
+    memcpy(p, "JUNK", 4);
+    writeU32(p + 4, JUNK_SIZE);
+    p += 8 + JUNK_SIZE + 1;
+    memcpy(p, "data", 4);
+    writeU32(p + 4, dataSize);
+    p += 8;
+    for(uint32_t i = 0; i < numFrames * NUM_CHANNELS; ++i, p += 2)
+        writeU16(p, (uint16_t)expectedSample(i));
+    return bytes;
+}
+
+// Reads the stream a period at a time until it's played numFrames, checking every sample
+static bool checkStream(ByteSource* source, uint32_t numFileFrames, uint32_t numFrames, bool loop)
+{
+    static WavStream stream;
+    if(!wavStreamOpen(&stream, source, loop) || stream.numChannels != NUM_CHANNELS || stream.sampleRate != SAMPLE_RATE)
+        return false;
+    int16_t period[FRAMES_PER_PERIOD * NUM_CHANNELS];
+    uint32_t frame = 0;
+    bool isCorrect = true;
+    while(frame < numFrames && isCorrect)
+    {
+        uint32_t numFramesRead = wavStreamRead(&stream, period, FRAMES_PER_PERIOD);
+        for(uint32_t i = 0; i < numFramesRead * NUM_CHANNELS; ++i)
+        {
+            uint32_t fileFrame = (frame + i / NUM_CHANNELS) % numFileFrames;
+            isCorrect = isCorrect && period[i] == expectedSample(fileFrame * NUM_CHANNELS + i % NUM_CHANNELS);
+        }
+        frame += numFramesRead;
+        if(numFramesRead < FRAMES_PER_PERIOD)
+            break;
+    }
+    wavStreamClose(&stream);
+    // Played once it should stop exactly at the end, looping it should never stop
+    uint32_t expectedFrames = loop ? numFrames : (numFrames < numFileFrames ? numFrames : numFileFrames);
+    return isCorrect && frame >= expectedFrames && (loop || frame == expectedFrames);
+}
+
+int main(int argc, char** argv)
+{
+    double megabytesPerSecond = argc > 1 ? atof(argv[1]) : 200.0;
+    double latencyMs = argc > 2 ? atof(argv[2]) : 0.1;
+    if(megabytesPerSecond <= 0.0 || latencyMs < 0.0)
+    {
+        printf("Usage: BenchmarkWavStream [megabytes per second] [read latency in ms]\n");
+        return 1;
+    }
+
+    uint32_t fileSize;
+    uint8_t* fileBytes = makeWavFile(NUM_FILE_FRAMES, &fileSize);
+    if(!fileBytes)
+        return 1;
+    printf("%u minute wav, %.1f MB, read at %.0f MB/s with %.2f ms latency per read\n", FILE_MINUTES,
+           fileSize / 1e6, megabytesPerSecond, latencyMs);
+
+    // Load everything then play: nothing can play until the whole file's in memory
+    static SimulatedDiskByteSource disk;
+    simulatedDiskInit(&disk, fileBytes, fileSize, megabytesPerSecond * 1e6, latencyMs / 1000.0);
+    Clock::time_point startTime = Clock::now();
+    uint8_t* loadedFile = (uint8_t*)malloc(fileSize);
+    bool result = loadedFile && byteSourceRead(&disk.source, 0, 0, loadedFile, fileSize);
+    double loadAllSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    free(loadedFile);
+    if(!result)
+        return 1;
+
+    // Stream: read the headers and the first period
+    static WavStream stream;
+    simulatedDiskInit(&disk, fileBytes, fileSize, megabytesPerSecond * 1e6, latencyMs / 1000.0);
+    int16_t period[FRAMES_PER_PERIOD * NUM_CHANNELS];
+    startTime = Clock::now();
+    result = wavStreamOpen(&stream, &disk.source, false)
+             && wavStreamRead(&stream, period, FRAMES_PER_PERIOD) == FRAMES_PER_PERIOD;
+    double streamSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    wavStreamClose(&stream);
+    if(!result)
+        return 1;
+
+    printf("%-28s %14s %14s\n", "", "first block ms", "memory KB");
+    printf("%-28s %14.2f %14.0f\n", "load whole file", loadAllSeconds * 1000.0, fileSize / 1024.0);
+    printf("%-28s %14.2f %14.0f\n", "stream", streamSeconds * 1000.0, sizeof(WavStream) / 1024.0);
+
+    // How fast the stream can go when the bytes are already in memory, i.e. its own overhead
+    static MemoryByteSource memory;
+    memoryByteSourceInit(&memory, fileBytes, fileSize);
+    wavStreamOpen(&stream, &memory.source, false);
+    startTime = Clock::now();
+    uint64_t numFramesRead = 0;
+    uint32_t numPeriodFrames;
+    while((numPeriodFrames = wavStreamRead(&stream, period, FRAMES_PER_PERIOD)) > 0)
+        numFramesRead += numPeriodFrames;
+    double memorySeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    wavStreamClose(&stream);
+    printf("Streaming from memory: %.0f MB/s, %.0fx real time\n", numFramesRead * NUM_CHANNELS * sizeof(int16_t) / memorySeconds / 1e6,
+           numFramesRead / (double)SAMPLE_RATE / memorySeconds);
+
+    // The whole file, then a short file looped a few times round with a period
+    // that doesn't divide into it, so the loop point lands mid-period
+    bool passed = checkStream(&memory.source, NUM_FILE_FRAMES, NUM_FILE_FRAMES, false);
+    free(fileBytes);
+    const uint32_t NUM_SHORT_FRAMES = 70001;
+    fileBytes = makeWavFile(NUM_SHORT_FRAMES, &fileSize);
+    memoryByteSourceInit(&memory, fileBytes, fileSize);
+    passed = passed && checkStream(&memory.source, NUM_SHORT_FRAMES, NUM_SHORT_FRAMES * 3, true);
+    passed = passed && checkStream(&memory.source, NUM_SHORT_FRAMES, NUM_SHORT_FRAMES * 3, false);
+    free(fileBytes);
+    printf(passed ? "Streamed samples match\n" : "FAILED: streamed samples don't match the file\n");
+    return passed ? 0 : 1;
+}
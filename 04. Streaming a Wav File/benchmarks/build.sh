@@ -0,0 +1,9 @@
+#!/bin/sh
+# Builds the wav stream benchmark on Linux
+set -e
+cd "$(dirname "$0")"
+mkdir -p build
+
+echo Building...
+c++ -O2 -DNDEBUG -pthread BenchmarkWavStream.cpp ../ByteSource.cpp ../WavStream.cpp -o build/BenchmarkWavStream
+echo Done
@@ -0,0 +1,52 @@
+#include "AdaptiveLatency.h"
+
+#include <assert.h>
+
+// How many updates in a row without an underrun before
+// we try lowering the latency again
+#define ADAPTIVE_LATENCY_UPDATES_BEFORE_SHRINKING 1000
+
+void adaptiveLatencyInit(AdaptiveLatency* latency, uint32_t periodInFrames, uint32_t bufferSizeInFrames)
+{
+    assert(periodInFrames > 0 && periodInFrames <= bufferSizeInFrames);
+    *latency = {};
+    latency->periodInFrames = periodInFrames;
+    // We get woken up once a period, so we need at least a period's worth queued
+    // up to last until next time. Exactly a period would be empty right as we
+    // wake up even when we're on time, so keep one shrink step on top
+    latency->minTargetPadding = periodInFrames + periodInFrames / 4;
+    latency->maxTargetPadding = bufferSizeInFrames;
+    if(latency->minTargetPadding > latency->maxTargetPadding)
+        latency->minTargetPadding = latency->maxTargetPadding;
+    latency->targetPadding = 2 * periodInFrames;
+    if(latency->targetPadding > latency->maxTargetPadding)
+        latency->targetPadding = latency->maxTargetPadding;
+}
+
+uint32_t adaptiveLatencyUpdate(AdaptiveLatency* latency, uint32_t bufferPadding)
+{
+    // The buffer is empty before we've written anything, which isn't an underrun
+    bool isUnderrun = latency->hasStarted && bufferPadding == 0;
+    latency->hasStarted = true;
+
+    if(isUnderrun)
+    {
+        ++latency->numUnderruns;
+        latency->numUpdatesSinceUnderrun = 0;
+        latency->targetPadding += latency->periodInFrames;
+        if(latency->targetPadding > latency->maxTargetPadding)
+            latency->targetPadding = latency->maxTargetPadding;
+    }
+    else if(++latency->numUpdatesSinceUnderrun >= ADAPTIVE_LATENCY_UPDATES_BEFORE_SHRINKING)
+    {
+        // Been fine for a while, try shaving a bit off. Shrink more
+        // gently than we grow so we don't bounce back and forth
+        latency->numUpdatesSinceUnderrun = 0;
+        uint32_t step = latency->periodInFrames / 4;
+        if(latency->targetPadding >= latency->minTargetPadding + step)
+            latency->targetPadding -= step;
+        else
+            latency->targetPadding = latency->minTargetPadding;
+    }
+    return latency->targetPadding;
+}
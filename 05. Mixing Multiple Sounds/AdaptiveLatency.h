@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+// Picks how far ahead of the audio device we keep the buffer filled.
+// Starts low and backs off a period at a time whenever the device
+// runs dry, then creeps back down again once things have been stable
+// for a while. Doesn't touch any audio APIs, just does the bookkeeping
+struct AdaptiveLatency {
+    uint32_t periodInFrames;
+    uint32_t minTargetPadding;
+    uint32_t maxTargetPadding;
+    uint32_t targetPadding;
+    uint32_t numUnderruns;
+    uint32_t numUpdatesSinceUnderrun;
+    bool hasStarted;
+};
+
+void adaptiveLatencyInit(AdaptiveLatency* latency, uint32_t periodInFrames, uint32_t bufferSizeInFrames);
+// Call each time the audio thread wakes up with the buffer padding at that point.
+// Returns how much padding the buffer should have after this update
+uint32_t adaptiveLatencyUpdate(AdaptiveLatency* latency, uint32_t bufferPadding);
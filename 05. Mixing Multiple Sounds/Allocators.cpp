@@ -0,0 +1,278 @@
+#include "Allocators.h"
+
+#include <assert.h>
+#include <atomic>
+#ifdef _WIN32
+#include <windows.h>
+#include <crtdbg.h>
+#include <malloc.h>
+#else
+// Just enough to build the mixer on Linux for the benchmarks
+#include <errno.h>
+#include <stdlib.h>
+#define _aligned_malloc(size, alignment) aligned_alloc(alignment, ((size) + (alignment) - 1) & ~((size_t)(alignment) - 1))
+#define _aligned_free free
+#define IsDebuggerPresent() false
+#define __debugbreak() __builtin_trap()
+#endif
+
+// Allocators for the audio engine. The audio thread has to finish every pass
+// before the device runs out of data, and the system heap can take a lock or
+// go to the OS at any time, so anything the audio thread needs comes out of
+// memory that was set aside up front
+// For illustrative purposes only, no warranty is implied
+
+void arenaInit(MemoryArena* arena, void* memory, size_t size)
+{
+    arena->base = (uint8_t*)memory;
+    arena->size = size;
+    arena->used = 0;
+    arena->highWaterMark = 0;
+}
+
+void* arenaPush(MemoryArena* arena, size_t size, size_t alignment)
+{
+    assert((alignment & (alignment - 1)) == 0);
+    size_t start = ((size_t)arena->base + arena->used + alignment - 1) & ~(alignment - 1);
+    size_t offset = start - (size_t)arena->base;
+    if(offset + size > arena->size)
+    {
+        assert(!"Arena is full");
+        return nullptr;
+    }
+    arena->used = offset + size;
+    if(arena->used > arena->highWaterMark)
+        arena->highWaterMark = arena->used;
+    return arena->base + offset;
+}
+
+void poolInit(MemoryPool* pool, void* memory, size_t blockSize, uint32_t numBlocks)
+{
+    assert(blockSize >= sizeof(void*));
+    pool->base = (uint8_t*)memory;
+    pool->blockSize = blockSize;
+    pool->numBlocks = numBlocks;
+    pool->numUsed = 0;
+    pool->highWaterMark = 0;
+    // Link in reverse so the first block is handed out first
+    pool->freeList = nullptr;
+    for(uint32_t i = numBlocks; i > 0; --i)
+    {
+        void* block = pool->base + (size_t)(i - 1) * blockSize;
+        *(void**)block = pool->freeList;
+        pool->freeList = block;
+    }
+}
+
+void* poolAlloc(MemoryPool* pool)
+{
+    void* block = pool->freeList;
+    if(!block)
+        return nullptr;
+    pool->freeList = *(void**)block;
+    if(++pool->numUsed > pool->highWaterMark)
+        pool->highWaterMark = pool->numUsed;
+    return block;
+}
+
+void poolFree(MemoryPool* pool, void* block)
+{
+    assert((uint8_t*)block >= pool->base && (uint8_t*)block < pool->base + pool->numBlocks * pool->blockSize);
+    assert(((uint8_t*)block - pool->base) % pool->blockSize == 0);
+    *(void**)block = pool->freeList;
+    pool->freeList = block;
+    --pool->numUsed;
+}
+
+// Every tracked allocation starts with this, padded out to the max alignment
+struct TrackedAllocHeader {
+    size_t size;
+    AllocationTag tag;
+};
+#define TRACKED_ALLOC_HEADER_SIZE 64
+static_assert(sizeof(TrackedAllocHeader) <= TRACKED_ALLOC_HEADER_SIZE, "Header doesn't fit");
+
+static std::atomic<uint64_t> trackedNumBytes[ALLOCATION_TAG_COUNT];
+static std::atomic<uint64_t> trackedHighWaterMarks[ALLOCATION_TAG_COUNT];
+static std::atomic<uint32_t> numAudioThreadAllocations;
+static thread_local bool isAudioThread;
+
+#ifdef DEBUG_BUILD
+static void trapAudioThreadAllocation()
+{
+    numAudioThreadAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(IsDebuggerPresent())
+        __debugbreak();
+}
+#endif
+
+void* trackedAlloc(size_t size, AllocationTag tag, size_t alignment)
+{
+    assert(alignment <= TRACKED_ALLOC_HEADER_SIZE && tag < ALLOCATION_TAG_COUNT);
+    (void)alignment;
+#ifdef DEBUG_BUILD
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+#endif
+    uint8_t* memory = (uint8_t*)_aligned_malloc(TRACKED_ALLOC_HEADER_SIZE + size, TRACKED_ALLOC_HEADER_SIZE);
+    if(!memory)
+        return nullptr;
+    TrackedAllocHeader* header = (TrackedAllocHeader*)memory;
+    header->size = size;
+    header->tag = tag;
+
+    uint64_t numBytes = trackedNumBytes[tag].fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t highWaterMark = trackedHighWaterMarks[tag].load(std::memory_order_relaxed);
+    while(numBytes > highWaterMark
+          && !trackedHighWaterMarks[tag].compare_exchange_weak(highWaterMark, numBytes, std::memory_order_relaxed))
+    {
+    }
+    return memory + TRACKED_ALLOC_HEADER_SIZE;
+}
+
+void trackedFree(void* memory)
+{
+    if(!memory)
+        return;
+#ifdef DEBUG_BUILD
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+#endif
+    TrackedAllocHeader* header = (TrackedAllocHeader*)((uint8_t*)memory - TRACKED_ALLOC_HEADER_SIZE);
+    trackedNumBytes[header->tag].fetch_sub(header->size, std::memory_order_relaxed);
+    _aligned_free(header);
+}
+
+uint64_t trackedAllocNumBytes(AllocationTag tag)
+{
+    return trackedNumBytes[tag].load(std::memory_order_relaxed);
+}
+
+uint64_t trackedAllocHighWaterMark(AllocationTag tag)
+{
+    return trackedHighWaterMarks[tag].load(std::memory_order_relaxed);
+}
+
+const char* allocationTagName(AllocationTag tag)
+{
+    switch(tag)
+    {
+        case ALLOCATION_TAG_CLIPS: return "clips";
+        case ALLOCATION_TAG_FILES: return "files";
+        case ALLOCATION_TAG_OTHER: return "other";
+        case ALLOCATION_TAG_COUNT: break;
+    }
+    return "unknown";
+}
+
+#if defined(DEBUG_BUILD) && defined(_WIN32)
+// Called by the debug C runtime for every malloc, realloc and free
+static int audioThreadAllocHook(int, void*, size_t, int blockType, long, const unsigned char*, int)
+{
+    // _CRT_BLOCKs are the runtime's own, e.g. for thread-local storage
+    if(isAudioThread && blockType != _CRT_BLOCK)
+        trapAudioThreadAllocation();
+    return TRUE;
+}
+#elif defined(DEBUG_BUILD) && defined(ALLOCATOR_REPLACE_LIBC_MALLOC) && defined(__GLIBC__)
+// glibc has no allocation hooks any more, but a program's own malloc and friends
+// replace the C library's everywhere, new and delete included. These check
+// for the audio thread then hand over to glibc's, so it's all still one heap
+// and malloc_usable_size and the like keep working.
+// Opt-in with -DALLOCATOR_REPLACE_LIBC_MALLOC, since it takes over the process's
+// malloc: don't use it with ASan or anything else that replaces malloc itself.
+// Without it only trackedAlloc traps on Linux
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* memory, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void __libc_free(void* memory);
+
+void* malloc(size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_realloc(memory, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memory, size_t alignment, size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0)
+        return EINVAL;
+    void* result = __libc_memalign(alignment, size);
+    if(!result)
+        return ENOMEM;
+    *memory = result;
+    return 0;
+}
+
+void* valloc(size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size)
+{
+    if(isAudioThread)
+        trapAudioThreadAllocation();
+    return __libc_pvalloc(size);
+}
+
+void free(void* memory)
+{
+    if(isAudioThread && memory)
+        trapAudioThreadAllocation();
+    __libc_free(memory);
+}
+}
+#endif
+
+void allocatorMarkAudioThread()
+{
+    isAudioThread = true;
+#if defined(DEBUG_BUILD) && defined(_WIN32)
+    static std::atomic<bool> isHookInstalled;
+    if(!isHookInstalled.exchange(true))
+        _CrtSetAllocHook(audioThreadAllocHook);
+#endif
+}
+
+uint32_t allocatorNumAudioThreadAllocations()
+{
+    return numAudioThreadAllocations.load(std::memory_order_relaxed);
+}
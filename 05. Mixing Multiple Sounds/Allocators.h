@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The three ways the engine gets memory, none of which touch the system heap
+// from the audio thread:
+// - MemoryArena: scratch memory for one render pass, freed all at once
+// - MemoryPool: fixed-size blocks, e.g. one per voice that needs one
+// - trackedAlloc: the system heap, for loading. Counts what each part of the
+//   engine uses, and in debug builds traps if it's called from the audio thread
+
+// Linear allocator over a fixed block of memory. Pushing just bumps an offset
+// and everything is freed at once by resetting it
+struct MemoryArena {
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    size_t highWaterMark;
+};
+
+void arenaInit(MemoryArena* arena, void* memory, size_t size);
+// Returns null if the arena is full. alignment must be a power of two
+void* arenaPush(MemoryArena* arena, size_t size, size_t alignment = 16);
+#define ARENA_PUSH_ARRAY(arena, Type, count) ((Type*)arenaPush((arena), sizeof(Type) * (count), alignof(Type)))
+inline void arenaReset(MemoryArena* arena)
+{
+    arena->used = 0;
+}
+
+// Hands out blocks of blockSize from a free list threaded through the unused
+// blocks themselves. Not thread-safe, each pool belongs to one thread
+struct MemoryPool {
+    uint8_t* base;
+    size_t blockSize;
+    uint32_t numBlocks;
+    void* freeList;
+    uint32_t numUsed;
+    uint32_t highWaterMark;
+};
+
+// memory must hold numBlocks blocks of blockSize, which must be
+// big enough for a pointer and a multiple of the alignment wanted
+void poolInit(MemoryPool* pool, void* memory, size_t blockSize, uint32_t numBlocks);
+// Returns null if every block is in use
+void* poolAlloc(MemoryPool* pool);
+void poolFree(MemoryPool* pool, void* block);
+
+enum AllocationTag {
+    ALLOCATION_TAG_CLIPS, // Converted clip samples
+    ALLOCATION_TAG_FILES, // Files loaded with win32LoadEntireFile
+    ALLOCATION_TAG_OTHER,
+    ALLOCATION_TAG_COUNT,
+};
+
+// Thread-safe wrappers around the system heap. alignment can be up to 64
+void* trackedAlloc(size_t size, AllocationTag tag, size_t alignment = 16);
+void trackedFree(void* memory);
+// Bytes currently allocated with tag, and the most there's ever been
+uint64_t trackedAllocNumBytes(AllocationTag tag);
+uint64_t trackedAllocHighWaterMark(AllocationTag tag);
+const char* allocationTagName(AllocationTag tag);
+
+// Call at the start of the audio thread. In debug builds any heap allocation
+// or free made from it after that, through trackedAlloc or the C runtime
+// (malloc, new), breaks into the debugger and gets counted. On Linux the C
+// runtime is only checked with -DALLOCATOR_REPLACE_LIBC_MALLOC too, see Allocators.cpp
+void allocatorMarkAudioThread();
+uint32_t allocatorNumAudioThreadAllocations();
@@ -0,0 +1,27 @@
+#include "AudioCommandQueue.h"
+
+bool pushAudioCommand(AudioCommandQueue* queue, const AudioCommand* command)
+{
+    uint32_t writeIndex = queue->writeIndex.load(std::memory_order_relaxed);
+    uint32_t readIndex = queue->readIndex.load(std::memory_order_acquire);
+    if(writeIndex - readIndex == AUDIO_COMMAND_QUEUE_SIZE)
+        return false;
+
+    queue->commands[writeIndex & (AUDIO_COMMAND_QUEUE_SIZE - 1)] = *command;
+    // Release so the consumer sees the command before it sees the new index
+    queue->writeIndex.store(writeIndex + 1, std::memory_order_release);
+    return true;
+}
+
+bool popAudioCommand(AudioCommandQueue* queue, AudioCommand* command)
+{
+    uint32_t readIndex = queue->readIndex.load(std::memory_order_relaxed);
+    uint32_t writeIndex = queue->writeIndex.load(std::memory_order_acquire);
+    if(readIndex == writeIndex)
+        return false;
+
+    *command = queue->commands[readIndex & (AUDIO_COMMAND_QUEUE_SIZE - 1)];
+    // Release so the producer doesn't overwrite the slot until we've copied it out
+    queue->readIndex.store(readIndex + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#include "Effects.h"
+#include "LoadWavFile.h"
+#include "Spatial.h"
+
+// Must be a power of two
+#define AUDIO_COMMAND_QUEUE_SIZE 1024
+
+enum AudioCommandType {
+    AUDIO_COMMAND_PLAY,
+    AUDIO_COMMAND_STOP,
+    AUDIO_COMMAND_RELEASE,
+    AUDIO_COMMAND_QUEUE_CLIP,
+    AUDIO_COMMAND_SET_GAIN,
+    AUDIO_COMMAND_RAMP_GAIN,
+    AUDIO_COMMAND_SET_PAN,
+    AUDIO_COMMAND_SET_PITCH,
+    AUDIO_COMMAND_SET_TEMPO,
+    AUDIO_COMMAND_SET_EFFECT,
+    AUDIO_COMMAND_SET_REVERB_SEND,
+    AUDIO_COMMAND_SET_POSITION,
+    AUDIO_COMMAND_SET_ATTENUATION,
+    AUDIO_COMMAND_SET_MASTER_EFFECT, // Doesn't use sound
+    AUDIO_COMMAND_SET_LISTENER, // Doesn't use sound
+};
+
+// Sounds are referred to by a handle the game picks when it sends
+// AUDIO_COMMAND_PLAY, since it can't wait around for the audio thread
+// to tell it which voice it got
+typedef uint32_t SoundHandle;
+
+struct AudioCommand {
+    AudioCommandType type;
+    SoundHandle sound;
+    // Mixer frame (see Mixer::numFramesRendered) to apply the command at.
+    // Anything at or before the current frame is applied straight away
+    uint64_t frame;
+    // Only used by AUDIO_COMMAND_PLAY, and clip to looping by AUDIO_COMMAND_QUEUE_CLIP too
+    const AudioClip* clip;
+    std::atomic<uint32_t>* clipUseCount; // See mixerPlay()
+    bool looping;
+    float gain; // Target gain for AUDIO_COMMAND_RAMP_GAIN
+    float pan;
+    float pitch;
+    float tempo; // Only used by AUDIO_COMMAND_SET_TEMPO
+    // Only used by AUDIO_COMMAND_RAMP_GAIN
+    uint32_t numRampFrames;
+    // Only used by AUDIO_COMMAND_SET_EFFECT and AUDIO_COMMAND_SET_MASTER_EFFECT
+    uint32_t effectSlot;
+    EffectParams effect;
+    // Only used by AUDIO_COMMAND_SET_REVERB_SEND
+    float reverbSend;
+    // Only used by AUDIO_COMMAND_SET_POSITION
+    float position[3];
+    // Only used by AUDIO_COMMAND_SET_ATTENUATION
+    AttenuationCurve attenuationCurve;
+    float minDistance;
+    float maxDistance;
+    float rolloff;
+    // Only used by AUDIO_COMMAND_SET_LISTENER
+    SpatialListener listener;
+};
+
+// Wait-free single producer single consumer ring buffer.
+// One thread (the game) pushes, another (the audio thread) pops,
+// and neither ever has to block on or allocate for the other.
+// The indices only ever increase and wrap around naturally
+struct AudioCommandQueue {
+    AudioCommand commands[AUDIO_COMMAND_QUEUE_SIZE];
+    // Keep the indices on separate cache lines so the two
+    // threads don't fight over the same line
+    alignas(64) std::atomic<uint32_t> writeIndex;
+    alignas(64) std::atomic<uint32_t> readIndex;
+};
+
+// Producer thread only. Returns false if the queue is full
+bool pushAudioCommand(AudioCommandQueue* queue, const AudioCommand* command);
+// Consumer thread only. Returns false if the queue is empty
+bool popAudioCommand(AudioCommandQueue* queue, AudioCommand* command);
@@ -0,0 +1,106 @@
+#define _CRT_SECURE_NO_WARNINGS // fopen
+#include "AudioOutput.h"
+
+#include <assert.h>
+
+static uint32_t offlineGetCurrentPadding(AudioOutput*)
+{
+    // Offline outputs consume everything as soon as it's released
+    return 0;
+}
+
+static void* nullGetBuffer(AudioOutput* output, uint32_t numFrames)
+{
+    assert(numFrames <= OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES);
+    (void)numFrames;
+    return ((NullAudioOutput*)output)->buffer;
+}
+
+static void nullReleaseBuffer(AudioOutput* output, uint32_t numFrames)
+{
+    ((NullAudioOutput*)output)->numFramesPlayed += numFrames;
+}
+
+void nullAudioOutputInit(NullAudioOutput* nullOutput, const AudioOutputFormat* format)
+{
+    assert(format->numBytesPerFrame <= OUTPUT_MAX_CHANNELS * sizeof(float));
+    nullOutput->output.format = *format;
+    nullOutput->output.bufferSizeInFrames = OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES;
+    nullOutput->output.getCurrentPadding = offlineGetCurrentPadding;
+    nullOutput->output.getBuffer = nullGetBuffer;
+    nullOutput->output.releaseBuffer = nullReleaseBuffer;
+    nullOutput->numFramesPlayed = 0;
+}
+
+static void* wavFileGetBuffer(AudioOutput* output, uint32_t numFrames)
+{
+    assert(numFrames <= OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES);
+    (void)numFrames;
+    return ((WavFileAudioOutput*)output)->buffer;
+}
+
+static void wavFileReleaseBuffer(AudioOutput* output, uint32_t numFrames)
+{
+    WavFileAudioOutput* wavOutput = (WavFileAudioOutput*)output;
+    size_t numBytes = numFrames * 2 * sizeof(int16_t);
+    fwrite(wavOutput->buffer, 1, numBytes, wavOutput->file);
+    wavOutput->numDataBytes += (uint32_t)numBytes;
+}
+
+static void writeU32(FILE* file, uint32_t value)
+{
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    fwrite(bytes, 1, 4, file);
+}
+
+static void writeU16(FILE* file, uint16_t value)
+{
+    uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+    fwrite(bytes, 1, 2, file);
+}
+
+// Canonical 44 byte header for a PCM wav file
+static void writeWavHeader(FILE* file, uint32_t sampleRate, uint32_t numDataBytes)
+{
+    const uint16_t numChannels = 2;
+    const uint16_t numBitsPerSample = 16;
+    const uint16_t blockAlign = numChannels * numBitsPerSample / 8;
+    fwrite("RIFF", 1, 4, file);
+    writeU32(file, 36 + numDataBytes);
+    fwrite("WAVE", 1, 4, file);
+    fwrite("fmt ", 1, 4, file);
+    writeU32(file, 16);
+    writeU16(file, 1); // WAVE_FORMAT_PCM
+    writeU16(file, numChannels);
+    writeU32(file, sampleRate);
+    writeU32(file, sampleRate * blockAlign);
+    writeU16(file, blockAlign);
+    writeU16(file, numBitsPerSample);
+    fwrite("data", 1, 4, file);
+    writeU32(file, numDataBytes);
+}
+
+bool wavFileAudioOutputOpen(WavFileAudioOutput* wavOutput, const char* filename, uint32_t sampleRate)
+{
+    wavOutput->file = fopen(filename, "wb");
+    if(!wavOutput->file)
+        return false;
+    // Sizes aren't known yet, they get filled in when we close the file
+    writeWavHeader(wavOutput->file, sampleRate, 0);
+    wavOutput->numDataBytes = 0;
+
+    wavOutput->output.format = audioOutputFormatInt16Stereo(sampleRate);
+    wavOutput->output.bufferSizeInFrames = OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES;
+    wavOutput->output.getCurrentPadding = offlineGetCurrentPadding;
+    wavOutput->output.getBuffer = wavFileGetBuffer;
+    wavOutput->output.releaseBuffer = wavFileReleaseBuffer;
+    return true;
+}
+
+void wavFileAudioOutputClose(WavFileAudioOutput* wavOutput)
+{
+    fseek(wavOutput->file, 0, SEEK_SET);
+    writeWavHeader(wavOutput->file, wavOutput->output.format.sampleRate, wavOutput->numDataBytes);
+    fclose(wavOutput->file);
+    wavOutput->file = nullptr;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "OutputFormat.h"
+
+// Somewhere to send the mixed audio. Has the same get-buffer/release-buffer
+// shape as IAudioRenderClient, so the render loop doesn't need to care
+// whether it's writing to a real audio device, a file or nowhere at all.
+// Buffers are in the output's format, see mixerSetOutputFormat()
+struct AudioOutput {
+    AudioOutputFormat format;
+    uint32_t bufferSizeInFrames;
+    // How many frames are written but not yet played
+    uint32_t (*getCurrentPadding)(AudioOutput* output);
+    void* (*getBuffer)(AudioOutput* output, uint32_t numFrames);
+    void (*releaseBuffer)(AudioOutput* output, uint32_t numFrames);
+};
+
+#define OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES 4096
+
+// Throws everything away, in any format the mixer can write. Its simulated device "plays"
+// whatever is written to it instantly, so the mixer can run as fast as the CPU allows.
+// What was last released stays in buffer until the next getBuffer, for tests to look at
+struct NullAudioOutput {
+    AudioOutput output;
+    uint64_t numFramesPlayed; // Simulated device clock
+    alignas(16) uint8_t buffer[OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES * OUTPUT_MAX_CHANNELS * sizeof(float)];
+};
+
+void nullAudioOutputInit(NullAudioOutput* nullOutput, const AudioOutputFormat* format);
+
+// Writes everything to a 16-bit stereo wav file, as fast as the CPU allows
+struct WavFileAudioOutput {
+    AudioOutput output;
+    FILE* file;
+    uint32_t numDataBytes;
+    int16_t buffer[2 * OFFLINE_AUDIO_OUTPUT_BUFFER_SIZE_IN_FRAMES];
+};
+
+bool wavFileAudioOutputOpen(WavFileAudioOutput* wavOutput, const char* filename, uint32_t sampleRate);
+// Fills in the sizes in the wav header and closes the file
+void wavFileAudioOutputClose(WavFileAudioOutput* wavOutput);
@@ -0,0 +1,85 @@
+#include "AudioRenderer.h"
+
+void audioRendererInit(AudioRenderer* renderer, uint32_t outputSampleRate)
+{
+    mixerInit(&renderer->mixer, outputSampleRate);
+    audioSchedulerInit(&renderer->scheduler);
+    for(uint32_t i = 0; i < MAX_SOUND_HANDLES; ++i)
+        renderer->soundVoices[i] = INVALID_VOICE_ID;
+}
+
+void audioRendererApplyCommand(AudioRenderer* renderer, const AudioCommand* command)
+{
+    Mixer* mixer = &renderer->mixer;
+    VoiceId* voice = &renderer->soundVoices[command->sound & (MAX_SOUND_HANDLES - 1)];
+    switch(command->type)
+    {
+        case AUDIO_COMMAND_PLAY:
+            *voice = mixerPlay(mixer, command->clip, command->gain, command->pan, command->pitch, command->looping,
+                               command->clipUseCount);
+            break;
+        case AUDIO_COMMAND_STOP: mixerStop(mixer, *voice); break;
+        case AUDIO_COMMAND_RELEASE: mixerRelease(mixer, *voice); break;
+        case AUDIO_COMMAND_QUEUE_CLIP:
+            mixerQueueClip(mixer, *voice, command->clip, command->looping, command->clipUseCount);
+            break;
+        case AUDIO_COMMAND_SET_GAIN: mixerSetGain(mixer, *voice, command->gain); break;
+        case AUDIO_COMMAND_RAMP_GAIN: mixerRampGain(mixer, *voice, command->gain, command->numRampFrames); break;
+        case AUDIO_COMMAND_SET_PAN: mixerSetPan(mixer, *voice, command->pan); break;
+        case AUDIO_COMMAND_SET_PITCH: mixerSetPitch(mixer, *voice, command->pitch); break;
+        case AUDIO_COMMAND_SET_TEMPO: mixerSetTempo(mixer, *voice, command->tempo); break;
+        case AUDIO_COMMAND_SET_EFFECT: mixerSetEffect(mixer, *voice, command->effectSlot, &command->effect); break;
+        case AUDIO_COMMAND_SET_REVERB_SEND: mixerSetReverbSend(mixer, *voice, command->reverbSend); break;
+        case AUDIO_COMMAND_SET_POSITION:
+            mixerSetPosition(mixer, *voice, command->position[0], command->position[1], command->position[2]);
+            break;
+        case AUDIO_COMMAND_SET_ATTENUATION:
+            mixerSetAttenuation(mixer, *voice, command->attenuationCurve, command->minDistance, command->maxDistance,
+                                command->rolloff);
+            break;
+        case AUDIO_COMMAND_SET_MASTER_EFFECT: mixerSetMasterEffect(mixer, command->effectSlot, &command->effect); break;
+        case AUDIO_COMMAND_SET_LISTENER: mixerSetListener(mixer, &command->listener); break;
+    }
+}
+
+uint32_t audioRendererRender(AudioRenderer* renderer, AudioCommandQueue* commandQueue, AudioOutput* output,
+                             uint32_t bufferPadding, uint32_t targetBufferPadding)
+{
+    Mixer* mixer = &renderer->mixer;
+    AudioCommand command;
+    while(popAudioCommand(commandQueue, &command))
+    {
+        // Commands for later wait in the scheduler. If it's full,
+        // starting a sound early is better than not at all
+        if(command.frame <= mixer->numFramesRendered || !audioSchedulerAdd(&renderer->scheduler, &command))
+            audioRendererApplyCommand(renderer, &command);
+    }
+
+    uint32_t numFramesToWrite = bufferPadding < targetBufferPadding ? targetBufferPadding - bufferPadding : 0;
+    uint8_t* buffer = numFramesToWrite ? (uint8_t*)output->getBuffer(output, numFramesToWrite) : nullptr;
+
+    // Split the buffer at each scheduled command's frame, so the mixer
+    // renders straight through between them and every command lands
+    // on exactly the right sample
+    uint32_t numFramesLeft = numFramesToWrite;
+    while(true)
+    {
+        while(audioSchedulerPopDue(&renderer->scheduler, mixer->numFramesRendered, &command))
+            audioRendererApplyCommand(renderer, &command);
+        if(numFramesLeft == 0)
+            break;
+
+        uint32_t numFramesToRender = numFramesLeft;
+        uint64_t numFramesUntilNextCommand = audioSchedulerNextFrame(&renderer->scheduler) - mixer->numFramesRendered;
+        if(numFramesUntilNextCommand < numFramesToRender)
+            numFramesToRender = (uint32_t)numFramesUntilNextCommand;
+
+        mixerRender(mixer, buffer, numFramesToRender);
+        buffer += numFramesToRender * output->format.numBytesPerFrame;
+        numFramesLeft -= numFramesToRender;
+    }
+
+    if(numFramesToWrite)
+        output->releaseBuffer(output, numFramesToWrite);
+    return numFramesToWrite;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "AudioCommandQueue.h"
+#include "AudioOutput.h"
+#include "AudioScheduler.h"
+#include "Mixer.h"
+
+// Must be a power of two. If the game has more sounds than this
+// in flight, the oldest ones can no longer be stopped or changed
+#define MAX_SOUND_HANDLES 1024
+
+// Everything the audio thread owns: the mixer, the commands waiting for
+// their frame, and which voice each of the game's sounds ended up with.
+// The same code runs live, offline and headless in the benchmarks
+struct AudioRenderer {
+    Mixer mixer;
+    AudioScheduler scheduler;
+    // Maps the game's SoundHandles to mixer voices
+    VoiceId soundVoices[MAX_SOUND_HANDLES];
+};
+
+// Renders interleaved 16-bit stereo until mixerSetOutputFormat(&renderer->mixer) says otherwise
+void audioRendererInit(AudioRenderer* renderer, uint32_t outputSampleRate);
+void audioRendererApplyCommand(AudioRenderer* renderer, const AudioCommand* command);
+// Take any new commands from the game then top up the output
+// from bufferPadding to targetBufferPadding with mixed audio.
+// Returns the number of frames written
+uint32_t audioRendererRender(AudioRenderer* renderer, AudioCommandQueue* commandQueue, AudioOutput* output,
+                             uint32_t bufferPadding, uint32_t targetBufferPadding);
@@ -0,0 +1,77 @@
+#include "AudioScheduler.h"
+
+static bool isEarlier(const ScheduledCommandKey* a, const ScheduledCommandKey* b)
+{
+    return a->frame < b->frame || (a->frame == b->frame && (int32_t)(a->sequence - b->sequence) < 0);
+}
+
+void audioSchedulerInit(AudioScheduler* scheduler)
+{
+    scheduler->numCommands = 0;
+    scheduler->nextSequence = 0;
+    // Free indices are taken from the end, whichever order they're in
+    for(uint32_t i = 0; i < AUDIO_SCHEDULER_MAX_COMMANDS; ++i)
+        scheduler->freeCommandIndices[i] = i;
+}
+
+bool audioSchedulerAdd(AudioScheduler* scheduler, const AudioCommand* command)
+{
+    if(scheduler->numCommands == AUDIO_SCHEDULER_MAX_COMMANDS)
+        return false;
+
+    // There are always as many free commands as free places in the heap
+    uint32_t index = scheduler->numCommands++;
+    ScheduledCommandKey newKey;
+    newKey.frame = command->frame;
+    newKey.sequence = scheduler->nextSequence++;
+    newKey.commandIndex = scheduler->freeCommandIndices[AUDIO_SCHEDULER_MAX_COMMANDS - scheduler->numCommands];
+    scheduler->commands[newKey.commandIndex] = *command;
+
+    // Sift up: move parents down until we find where the new command goes
+    ScheduledCommandKey* heap = scheduler->heap;
+    while(index > 0)
+    {
+        uint32_t parent = (index - 1) / 2;
+        if(!isEarlier(&newKey, &heap[parent]))
+            break;
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = newKey;
+    return true;
+}
+
+uint64_t audioSchedulerNextFrame(const AudioScheduler* scheduler)
+{
+    return scheduler->numCommands ? scheduler->heap[0].frame : UINT64_MAX;
+}
+
+bool audioSchedulerPopDue(AudioScheduler* scheduler, uint64_t frame, AudioCommand* command)
+{
+    if(scheduler->numCommands == 0 || scheduler->heap[0].frame > frame)
+        return false;
+    ScheduledCommandKey* heap = scheduler->heap;
+    uint32_t commandIndex = heap[0].commandIndex;
+    *command = scheduler->commands[commandIndex];
+
+    // Sift down: take the last command and move earlier children up
+    // until we find where it goes
+    uint32_t numCommands = --scheduler->numCommands;
+    scheduler->freeCommandIndices[AUDIO_SCHEDULER_MAX_COMMANDS - 1 - numCommands] = commandIndex;
+    const ScheduledCommandKey last = heap[numCommands];
+    uint32_t index = 0;
+    while(true)
+    {
+        uint32_t child = 2 * index + 1;
+        if(child >= numCommands)
+            break;
+        if(child + 1 < numCommands && isEarlier(&heap[child + 1], &heap[child]))
+            ++child;
+        if(!isEarlier(&heap[child], &last))
+            break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = last;
+    return true;
+}
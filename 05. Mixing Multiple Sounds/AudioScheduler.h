@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "AudioCommandQueue.h"
+
+// Max number of commands that can be waiting for their frame at once.
+// A few command queues' worth, any more and they're applied early
+#define AUDIO_SCHEDULER_MAX_COMMANDS 4096
+
+// What the heap orders. The commands themselves stay where they are in the
+// scheduler's pool, so sifting only moves these around, not whole commands
+struct ScheduledCommandKey {
+    uint64_t frame;
+    // Commands for the same frame come out in the order they went in.
+    // Wraps around, which is fine as long as no command waits
+    // while another 2^31 are scheduled after it
+    uint32_t sequence;
+    uint32_t commandIndex;
+};
+
+// Holds commands until the mixer reaches their frame. Binary min-heap
+// ordered by frame, so adding and removing are both O(log n)
+// and the next command due is always at the front
+struct AudioScheduler {
+    ScheduledCommandKey heap[AUDIO_SCHEDULER_MAX_COMMANDS];
+    uint32_t numCommands;
+    uint32_t nextSequence;
+    AudioCommand commands[AUDIO_SCHEDULER_MAX_COMMANDS];
+    // Indices of the unused entries in commands
+    uint32_t freeCommandIndices[AUDIO_SCHEDULER_MAX_COMMANDS];
+};
+
+void audioSchedulerInit(AudioScheduler* scheduler);
+// Returns false if the scheduler is full
+bool audioSchedulerAdd(AudioScheduler* scheduler, const AudioCommand* command);
+// Frame of the earliest command, or UINT64_MAX if there aren't any
+uint64_t audioSchedulerNextFrame(const AudioScheduler* scheduler);
+// Removes the earliest command if it's due at or before frame. Returns false otherwise
+bool audioSchedulerPopDue(AudioScheduler* scheduler, uint64_t frame, AudioCommand* command);
@@ -0,0 +1,78 @@
+#include "AudioTelemetry.h"
+
+#include <math.h>
+#include <string.h>
+
+void audioTelemetryRecord(AudioTelemetryRing* ring, const AudioTelemetrySample* sample)
+{
+    uint32_t writeIndex = ring->writeIndex.load(std::memory_order_relaxed);
+    uint32_t readIndex = ring->readIndex.load(std::memory_order_acquire);
+    if(writeIndex - readIndex == AUDIO_TELEMETRY_RING_SIZE)
+    {
+        ring->numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->samples[writeIndex & (AUDIO_TELEMETRY_RING_SIZE - 1)] = *sample;
+    ring->writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void audioTelemetryStatsInit(AudioTelemetryStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->minPaddingAtWakeUp = 0xFFFFFFFF;
+    stats->maxPeakDbfs = -HUGE_VALF;
+    stats->maxShortTermLufs = -HUGE_VALF;
+}
+
+void audioTelemetryPoll(AudioTelemetryRing* ring, AudioTelemetryStats* stats, FILE* traceFile)
+{
+    uint32_t readIndex = ring->readIndex.load(std::memory_order_relaxed);
+    uint32_t writeIndex = ring->writeIndex.load(std::memory_order_acquire);
+    for(; readIndex != writeIndex; ++readIndex)
+    {
+        const AudioTelemetrySample* sample = &ring->samples[readIndex & (AUDIO_TELEMETRY_RING_SIZE - 1)];
+
+        ++stats->numSamples;
+        if(sample->isUnderrun)
+            ++stats->numUnderruns;
+        if(sample->renderMicroseconds > stats->maxRenderMicroseconds)
+            stats->maxRenderMicroseconds = sample->renderMicroseconds;
+        if(sample->paddingAtWakeUp < stats->minPaddingAtWakeUp)
+            stats->minPaddingAtWakeUp = sample->paddingAtWakeUp;
+        stats->lastDeviceClockDriftMicroseconds = sample->deviceClockDriftMicroseconds;
+        if(sample->peakDbfs > stats->maxPeakDbfs)
+            stats->maxPeakDbfs = sample->peakDbfs;
+        if(sample->peakDbfs >= 0.f)
+            ++stats->numClippedUpdates;
+        if(sample->shortTermLufs > stats->maxShortTermLufs)
+            stats->maxShortTermLufs = sample->shortTermLufs;
+
+        uint32_t bucket = sample->renderMicroseconds / AUDIO_TELEMETRY_HISTOGRAM_BUCKET_MICROSECONDS;
+        if(bucket >= AUDIO_TELEMETRY_HISTOGRAM_SIZE)
+            bucket = AUDIO_TELEMETRY_HISTOGRAM_SIZE - 1;
+        ++stats->renderTimeHistogram[bucket];
+
+        if(traceFile)
+        {
+            fprintf(traceFile, "%llu,%u,%u,%u,%d,%d,%.2f,%.2f,%.2f,%.2f\n", (unsigned long long)sample->wallClockMicroseconds,
+                    sample->renderMicroseconds, sample->numFramesWritten, sample->paddingAtWakeUp,
+                    sample->deviceClockDriftMicroseconds, sample->isUnderrun ? 1 : 0,
+                    sample->peakDbfs, sample->rmsDbfs, sample->momentaryLufs, sample->shortTermLufs);
+        }
+    }
+    // Release so the audio thread doesn't overwrite samples before we've read them
+    ring->readIndex.store(readIndex, std::memory_order_release);
+}
+
+uint32_t audioTelemetryRenderTimePercentile(const AudioTelemetryStats* stats, double fraction)
+{
+    uint64_t target = (uint64_t)(stats->numSamples * fraction);
+    uint64_t count = 0;
+    for(uint32_t bucket = 0; bucket < AUDIO_TELEMETRY_HISTOGRAM_SIZE; ++bucket)
+    {
+        count += stats->renderTimeHistogram[bucket];
+        if(count > target)
+            return (bucket + 1) * AUDIO_TELEMETRY_HISTOGRAM_BUCKET_MICROSECONDS;
+    }
+    return stats->maxRenderMicroseconds;
+}
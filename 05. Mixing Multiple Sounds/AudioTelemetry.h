@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+
+// One entry per audio thread wake-up
+struct AudioTelemetrySample {
+    uint64_t wallClockMicroseconds; // When the update started, since the stream started
+    uint32_t renderMicroseconds;    // How long the update took
+    uint32_t numFramesWritten;
+    uint32_t paddingAtWakeUp;
+    int32_t deviceClockDriftMicroseconds; // Device clock minus wall clock, since the stream started
+    bool isUnderrun;
+    // Level of the final mix over the update, and its loudness as of the update
+    float peakDbfs;
+    float rmsDbfs;
+    float momentaryLufs;
+    float shortTermLufs;
+};
+
+// Must be a power of two
+#define AUDIO_TELEMETRY_RING_SIZE 4096
+
+// Wait-free single producer single consumer ring buffer, same as
+// AudioCommandQueue but going the other way. The audio thread records
+// samples and never waits, if the host hasn't kept up they get dropped
+struct AudioTelemetryRing {
+    AudioTelemetrySample samples[AUDIO_TELEMETRY_RING_SIZE];
+    alignas(64) std::atomic<uint32_t> writeIndex;
+    alignas(64) std::atomic<uint32_t> readIndex;
+    alignas(64) std::atomic<uint32_t> numDropped;
+};
+
+// Audio thread only
+void audioTelemetryRecord(AudioTelemetryRing* ring, const AudioTelemetrySample* sample);
+
+// Render times are bucketed by this many microseconds, anything
+// past the last bucket goes in the last bucket
+#define AUDIO_TELEMETRY_HISTOGRAM_BUCKET_MICROSECONDS 10
+#define AUDIO_TELEMETRY_HISTOGRAM_SIZE 1000
+
+// Running totals kept by the host as it polls the ring
+struct AudioTelemetryStats {
+    uint64_t numSamples;
+    uint32_t numUnderruns;
+    uint32_t maxRenderMicroseconds;
+    uint32_t minPaddingAtWakeUp;
+    int32_t lastDeviceClockDriftMicroseconds;
+    float maxPeakDbfs;
+    uint32_t numClippedUpdates; // Updates where the mix hit full scale, and was clipped
+    float maxShortTermLufs;
+    uint32_t renderTimeHistogram[AUDIO_TELEMETRY_HISTOGRAM_SIZE];
+};
+
+void audioTelemetryStatsInit(AudioTelemetryStats* stats);
+// Host thread only. Moves everything recorded since the last poll into stats,
+// and writes each sample as a line of CSV to traceFile if it isn't null
+void audioTelemetryPoll(AudioTelemetryRing* ring, AudioTelemetryStats* stats, FILE* traceFile);
+// Render time in microseconds below which the given fraction (e.g. 0.99) of updates fall
+uint32_t audioTelemetryRenderTimePercentile(const AudioTelemetryStats* stats, double fraction);
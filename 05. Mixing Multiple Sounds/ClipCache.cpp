@@ -0,0 +1,265 @@
+#include "ClipCache.h"
+
+#include <string.h>
+
+// FNV-1a, so most lookups only compare a hash rather than the whole filename
+static uint32_t hashFilename(const char* filename)
+{
+    uint32_t hash = 2166136261u;
+    for(const char* c = filename; *c; ++c)
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    return hash;
+}
+
+static void waitWhileLoading(ClipCache* cache, CachedClip* cachedClip)
+{
+    std::unique_lock<std::mutex> lock(cache->loadMutex);
+    cache->loadFinished.wait(lock, [cachedClip] {
+        return cachedClip->state.load(std::memory_order_acquire) != CACHED_CLIP_LOADING;
+    });
+}
+
+// Drops queued plays of cachedClip, or of every clip if it's null
+static void dropPendingPlays(ClipCache* cache, CachedClip* cachedClip)
+{
+    uint32_t numKept = 0;
+    for(uint32_t i = 0; i < cache->numPendingPlays; ++i)
+    {
+        PendingClipPlay* play = &cache->pendingPlays[i];
+        if(cachedClip && play->cachedClip != cachedClip)
+        {
+            cache->pendingPlays[numKept++] = *play;
+            continue;
+        }
+        play->cachedClip->numVoicesPlaying.fetch_sub(1, std::memory_order_relaxed);
+        ++cache->numDroppedPlays;
+    }
+    cache->numPendingPlays = numKept;
+}
+
+static void unloadClip(ClipCache* cache, CachedClip* cachedClip)
+{
+    if(cachedClip->isLoadCounted)
+        cache->numBytesLoaded -= cachedClip->numBytes;
+    cache->loader->unload(cache->loader, cachedClip);
+    cachedClip->fileBytes = nullptr;
+    cachedClip->convertedSamples = nullptr;
+    cachedClip->clip = {};
+    cachedClip->numBytes = 0;
+    cachedClip->isLoadCounted = false;
+    cachedClip->filename[0] = 0;
+    cachedClip->state.store(CACHED_CLIP_EMPTY, std::memory_order_relaxed);
+}
+
+// Least recently used clip that's loaded and not playing, if there is one
+static CachedClip* findClipToEvict(ClipCache* cache)
+{
+    CachedClip* oldest = nullptr;
+    for(int i = 0; i < CLIP_CACHE_MAX_CLIPS; ++i)
+    {
+        CachedClip* cachedClip = &cache->clips[i];
+        if(!cachedClip->isLoadCounted || cachedClip->numVoicesPlaying.load(std::memory_order_acquire) > 0)
+            continue;
+        if(!oldest || cachedClip->lastUsed < oldest->lastUsed)
+            oldest = cachedClip;
+    }
+    return oldest;
+}
+
+void clipCacheInit(ClipCache* cache, ClipLoader* loader, uint64_t byteBudget, bool convertToPlanar)
+{
+    for(int i = 0; i < CLIP_CACHE_MAX_CLIPS; ++i)
+    {
+        CachedClip* cachedClip = &cache->clips[i];
+        cachedClip->cache = cache;
+        cachedClip->filename[0] = 0;
+        cachedClip->fileBytes = nullptr;
+        cachedClip->convertedSamples = nullptr;
+        cachedClip->numBytes = 0;
+        cachedClip->isLoadCounted = false;
+        cachedClip->state.store(CACHED_CLIP_EMPTY, std::memory_order_relaxed);
+        cachedClip->numVoicesPlaying.store(0, std::memory_order_relaxed);
+    }
+    cache->loader = loader;
+    cache->byteBudget = byteBudget;
+    cache->numBytesLoaded = 0;
+    cache->useCounter = 0;
+    cache->convertToPlanar = convertToPlanar;
+    cache->numPendingPlays = 0;
+    cache->numHits = 0;
+    cache->numMisses = 0;
+    cache->numEvictions = 0;
+    cache->numDroppedPlays = 0;
+    memset(cache->loadTimeHistogram, 0, sizeof(cache->loadTimeHistogram));
+}
+
+// Finds the clip, or starts loading it. Returns null if there's nowhere to load it
+static CachedClip* findOrStartLoad(ClipCache* cache, const char* filename)
+{
+    uint32_t hash = hashFilename(filename);
+    CachedClip* cachedClip = nullptr;
+    CachedClip* emptySlot = nullptr;
+    for(int i = 0; i < CLIP_CACHE_MAX_CLIPS; ++i)
+    {
+        CachedClip* slot = &cache->clips[i];
+        if(slot->state.load(std::memory_order_relaxed) == CACHED_CLIP_EMPTY) {
+            if(!emptySlot) emptySlot = slot;
+        }
+        else if(slot->filenameHash == hash && strcmp(slot->filename, filename) == 0) {
+            cachedClip = slot;
+            break;
+        }
+    }
+
+    if(!cachedClip)
+    {
+        ++cache->numMisses;
+        size_t filenameLength = strlen(filename);
+        if(filenameLength >= CLIP_CACHE_MAX_FILENAME)
+            return nullptr;
+        if(!emptySlot)
+        {
+            // Lots of small clips can use up every slot while still under budget
+            emptySlot = findClipToEvict(cache);
+            if(!emptySlot)
+                return nullptr; // Every slot is loading or playing
+            unloadClip(cache, emptySlot);
+            ++cache->numEvictions;
+        }
+
+        cachedClip = emptySlot;
+        memcpy(cachedClip->filename, filename, filenameLength + 1);
+        cachedClip->filenameHash = hash;
+        cachedClip->convertToPlanar = cache->convertToPlanar;
+        cachedClip->state.store(CACHED_CLIP_LOADING, std::memory_order_relaxed);
+        cache->loader->startLoad(cache->loader, cachedClip);
+    }
+    else if(cachedClip->state.load(std::memory_order_acquire) == CACHED_CLIP_LOADED)
+    {
+        ++cache->numHits;
+    }
+    else
+    {
+        ++cache->numMisses; // Still loading
+    }
+    cachedClip->lastUsed = ++cache->useCounter;
+    return cachedClip;
+}
+
+CachedClip* clipCacheGet(ClipCache* cache, const char* filename, bool waitForLoad)
+{
+    CachedClip* cachedClip = findOrStartLoad(cache, filename);
+    if(!cachedClip)
+        return nullptr;
+    if(waitForLoad)
+        waitWhileLoading(cache, cachedClip);
+    return cachedClip->state.load(std::memory_order_acquire) == CACHED_CLIP_LOADED ? cachedClip : nullptr;
+}
+
+CachedClip* clipCacheGetOrQueue(ClipCache* cache, const char* filename, uint64_t userData)
+{
+    CachedClip* cachedClip = findOrStartLoad(cache, filename);
+    if(!cachedClip)
+    {
+        ++cache->numDroppedPlays;
+        return nullptr;
+    }
+    CachedClipState state = cachedClip->state.load(std::memory_order_acquire);
+    if(state == CACHED_CLIP_LOADED)
+        return cachedClip;
+    // A failed load is only cleared out by clipCacheUpdate(), and won't get any better
+    if(state == CACHED_CLIP_FAILED || cache->numPendingPlays == CLIP_CACHE_MAX_PENDING_PLAYS)
+    {
+        ++cache->numDroppedPlays;
+        return nullptr;
+    }
+
+    PendingClipPlay* play = &cache->pendingPlays[cache->numPendingPlays++];
+    play->cachedClip = cachedClip;
+    play->userData = userData;
+    cachedClip->numVoicesPlaying.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+uint32_t clipCacheTakeLoadedPlays(ClipCache* cache, PendingClipPlay* plays, uint32_t maxPlays)
+{
+    uint32_t numTaken = 0;
+    uint32_t numKept = 0;
+    for(uint32_t i = 0; i < cache->numPendingPlays; ++i)
+    {
+        PendingClipPlay* play = &cache->pendingPlays[i];
+        if(numTaken < maxPlays && play->cachedClip->state.load(std::memory_order_acquire) == CACHED_CLIP_LOADED)
+        {
+            // The game takes over keeping it loaded when it plays it
+            play->cachedClip->numVoicesPlaying.fetch_sub(1, std::memory_order_relaxed);
+            play->cachedClip->lastUsed = ++cache->useCounter;
+            plays[numTaken++] = *play;
+        }
+        else
+        {
+            cache->pendingPlays[numKept++] = *play;
+        }
+    }
+    cache->numPendingPlays = numKept;
+    return numTaken;
+}
+
+void clipCacheUpdate(ClipCache* cache)
+{
+    // Account for any loads that finished since last time
+    for(int i = 0; i < CLIP_CACHE_MAX_CLIPS; ++i)
+    {
+        CachedClip* cachedClip = &cache->clips[i];
+        CachedClipState state = cachedClip->state.load(std::memory_order_acquire);
+        if(state == CACHED_CLIP_FAILED)
+        {
+            dropPendingPlays(cache, cachedClip);
+            unloadClip(cache, cachedClip);
+        }
+        else if(state == CACHED_CLIP_LOADED && !cachedClip->isLoadCounted)
+        {
+            cachedClip->isLoadCounted = true;
+            cache->numBytesLoaded += cachedClip->numBytes;
+
+            uint32_t loadTimeMs = cachedClip->loadTimeMicroseconds / 1000;
+            int bucket = 0;
+            while(bucket < CLIP_CACHE_LOAD_TIME_HISTOGRAM_SIZE - 1 && loadTimeMs >= (1u << bucket))
+                ++bucket;
+            ++cache->loadTimeHistogram[bucket];
+        }
+    }
+
+    // Evict least recently used clips until we're back under budget
+    while(cache->numBytesLoaded > cache->byteBudget)
+    {
+        CachedClip* oldest = findClipToEvict(cache);
+        if(!oldest)
+            break; // Everything over budget is still playing
+        unloadClip(cache, oldest);
+        ++cache->numEvictions;
+    }
+}
+
+void clipCacheFinishLoad(CachedClip* cachedClip, CachedClipState state)
+{
+    ClipCache* cache = cachedClip->cache;
+    {
+        // Under the lock so a waiter can't miss the notify between checking and sleeping.
+        // Release so the game thread sees the loaded clip once it sees LOADED
+        std::lock_guard<std::mutex> lock(cache->loadMutex);
+        cachedClip->state.store(state, std::memory_order_release);
+    }
+    cache->loadFinished.notify_all();
+}
+
+void clipCacheShutdown(ClipCache* cache)
+{
+    dropPendingPlays(cache, nullptr);
+    for(int i = 0; i < CLIP_CACHE_MAX_CLIPS; ++i)
+    {
+        CachedClip* cachedClip = &cache->clips[i];
+        waitWhileLoading(cache, cachedClip);
+        if(cachedClip->state.load(std::memory_order_relaxed) != CACHED_CLIP_EMPTY)
+            unloadClip(cache, cachedClip);
+    }
+}
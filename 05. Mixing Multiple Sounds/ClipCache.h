@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "LoadWavFile.h"
+#include "Loudness.h"
+
+#define CLIP_CACHE_MAX_CLIPS 256
+#define CLIP_CACHE_MAX_FILENAME 260
+// Bucket i counts loads that took less than 2^i milliseconds
+#define CLIP_CACHE_LOAD_TIME_HISTOGRAM_SIZE 16
+#define CLIP_CACHE_MAX_PENDING_PLAYS 64
+
+enum CachedClipState {
+    CACHED_CLIP_EMPTY,
+    CACHED_CLIP_LOADING,
+    CACHED_CLIP_LOADED,
+    CACHED_CLIP_FAILED,
+};
+
+struct ClipCache;
+
+struct CachedClip {
+    ClipCache* cache;
+    char filename[CLIP_CACHE_MAX_FILENAME];
+    uint32_t filenameHash;
+    // Set to LOADING by the game thread, then to LOADED or FAILED by the loader through clipCacheFinishLoad()
+    std::atomic<CachedClipState> state;
+    AudioClip clip;
+    LoudnessStats loudness; // Measured by the loader, e.g. to normalise clips with loudnessNormalisationGain()
+    // Whatever the loader needs to free the clip again
+    void* fileBytes;
+    float* convertedSamples; // Only used for clips the mixer can't read directly, or planar ones
+    bool convertToPlanar; // Copied from the ClipCache when the load starts
+    uint32_t numBytes;
+    uint32_t loadTimeMicroseconds;
+    bool isLoadCounted;
+    uint64_t lastUsed;
+    // Voices currently playing this clip. Incremented by the game before it
+    // sends a play command, decremented by the mixer when the voice ends.
+    // Clips are never evicted while they're playing
+    std::atomic<uint32_t> numVoicesPlaying;
+};
+
+// Where clips actually come from. startLoad is called on the game thread and
+// mustn't block: it fills in the clip, numBytes and loadTimeMicroseconds, then
+// calls clipCacheFinishLoad() from whatever thread it gets there on.
+// unload frees whatever startLoad allocated
+struct ClipLoader {
+    void (*startLoad)(ClipLoader* loader, CachedClip* cachedClip);
+    void (*unload)(ClipLoader* loader, CachedClip* cachedClip);
+};
+
+// A play asked for with clipCacheGetOrQueue() while its clip was still loading
+struct PendingClipPlay {
+    CachedClip* cachedClip;
+    uint64_t userData; // Whatever the game needs to start it, e.g. which beat it was for
+};
+
+// Keeps recently used clips loaded up to a budget, evicting the least
+// recently used ones when it's exceeded. The loader does the loading in the
+// background so asking for a clip never blocks the game. Game thread only,
+// apart from clipCacheFinishLoad().
+// There's no streaming: a clip can't play until it's completely loaded, so
+// plays asked for before then are queued and handed back when it is
+struct ClipCache {
+    CachedClip clips[CLIP_CACHE_MAX_CLIPS];
+    ClipLoader* loader;
+    uint64_t byteBudget;
+    uint64_t numBytesLoaded;
+    uint64_t useCounter;
+    bool convertToPlanar;
+    // Only for waiting on loads, the state itself is atomic
+    std::mutex loadMutex;
+    std::condition_variable loadFinished;
+    // Each one holds a use of its clip so it can't be evicted before it's played
+    PendingClipPlay pendingPlays[CLIP_CACHE_MAX_PENDING_PLAYS];
+    uint32_t numPendingPlays;
+
+    uint32_t numHits;
+    uint32_t numMisses;
+    uint32_t numEvictions;
+    uint32_t numDroppedPlays; // Queued plays whose clip failed to load, or that didn't fit
+    uint32_t loadTimeHistogram[CLIP_CACHE_LOAD_TIME_HISTOGRAM_SIZE];
+};
+
+// If convertToPlanar is set, the loader converts uncompressed clips to planar float
+// so the mixer can use SIMD on them. That takes up to twice the memory of 16-bit clips
+void clipCacheInit(ClipCache* cache, ClipLoader* loader, uint64_t byteBudget, bool convertToPlanar = false);
+// Returns the clip if it's loaded. Otherwise starts loading it in the background
+// and returns null, unless waitForLoad is set in which case it blocks until it's ready
+CachedClip* clipCacheGet(ClipCache* cache, const char* filename, bool waitForLoad = false);
+// Returns the clip if it's loaded, so it can be played straight away. Otherwise
+// starts loading it if need be and queues the play, so it starts late rather
+// than not at all: clipCacheTakeLoadedPlays() hands it back with userData once it's loaded
+CachedClip* clipCacheGetOrQueue(ClipCache* cache, const char* filename, uint64_t userData);
+// Removes queued plays whose clips have loaded, in the order they were asked for,
+// and returns how many. Play them before the next clipCacheGet() or clipCacheUpdate(),
+// which could evict them once they're no longer queued
+uint32_t clipCacheTakeLoadedPlays(ClipCache* cache, PendingClipPlay* plays, uint32_t maxPlays);
+// Call once per game update to account for finished loads and evict clips if over budget
+void clipCacheUpdate(ClipCache* cache);
+// Called by the loader, on any thread, once a load has finished. state is LOADED or FAILED.
+// Everything it filled in is visible to the game thread once it sees the new state
+void clipCacheFinishLoad(CachedClip* cachedClip, CachedClipState state);
+// Waits for any loads in progress and unloads everything
+void clipCacheShutdown(ClipCache* cache);
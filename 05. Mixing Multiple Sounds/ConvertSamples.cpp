@@ -0,0 +1,170 @@
+#include "ConvertSamples.h"
+
+#include <assert.h>
+#include <string.h>
+#include <emmintrin.h> // SSE2
+
+// Bulk sample format converters. Every format does at least 4 samples per
+// iteration with SSE2 so converting a whole clip is limited by memory
+// bandwidth rather than by per-sample int to float conversion
+
+static void convertU8ToFloat(const uint8_t* src, uint32_t numSamples, float* dest)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 128.f);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi16(128);
+    uint32_t i = 0;
+    for(; i + 16 <= numSamples; i += 16)
+    {
+        __m128i samples = _mm_loadu_si128((const __m128i*)(src + i));
+        // Widen to 16-bit and take off the offset, then
+        // sign-extend to 32-bit like convertS16ToFloat
+        __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(samples, zero), offset);
+        __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(samples, zero), offset);
+        __m128i s0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16);
+        __m128i s1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16);
+        __m128i s2 = _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16);
+        __m128i s3 = _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(s0), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(s1), scale));
+        _mm_storeu_ps(dest + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(s2), scale));
+        _mm_storeu_ps(dest + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(s3), scale));
+    }
+    for(; i < numSamples; ++i)
+        dest[i] = ((int)src[i] - 128) * (1.f / 128.f);
+}
+
+static void convertS16ToFloat(const int16_t* src, uint32_t numSamples, float* dest)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    uint32_t i = 0;
+    for(; i + 8 <= numSamples; i += 8)
+    {
+        __m128i samples = _mm_loadu_si128((const __m128i*)(src + i));
+        // Put each sample in the top half of a 32-bit lane then
+        // shift it back down to sign-extend it
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    for(; i < numSamples; ++i)
+        dest[i] = src[i] * (1.f / 32768.f);
+}
+
+static void convertS24ToFloat(const uint8_t* src, uint32_t numSamples, float* dest)
+{
+    // Packed 3 bytes per sample. Build each sample in the top 24 bits of an
+    // int32 so the sign comes along for free, then scale as if it were 32-bit.
+    // 4 samples are 12 bytes, and shifting them left by 1 to 4 bytes puts
+    // sample k where it belongs in lane k, so masking out the rest is all it takes
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    const __m128i mask0 = _mm_set_epi32(0, 0, 0, (int32_t)0xFFFFFF00);
+    const __m128i mask1 = _mm_set_epi32(0, 0, (int32_t)0xFFFFFF00, 0);
+    const __m128i mask2 = _mm_set_epi32(0, (int32_t)0xFFFFFF00, 0, 0);
+    const __m128i mask3 = _mm_set_epi32((int32_t)0xFFFFFF00, 0, 0, 0);
+    uint32_t i = 0;
+    // Each load is 16 bytes, 4 more than the samples it converts
+    for(; i + 6 <= numSamples; i += 4, src += 12)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)src);
+        __m128i samples = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_slli_si128(bytes, 1), mask0),
+                                                    _mm_and_si128(_mm_slli_si128(bytes, 2), mask1)),
+                                       _mm_or_si128(_mm_and_si128(_mm_slli_si128(bytes, 3), mask2),
+                                                    _mm_and_si128(_mm_slli_si128(bytes, 4), mask3)));
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+    }
+    for(; i < numSamples; ++i, src += 3)
+    {
+        int32_t sample = (int32_t)(((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24));
+        dest[i] = sample * (1.f / 2147483648.f);
+    }
+}
+
+static void convertS32ToFloat(const int32_t* src, uint32_t numSamples, float* dest)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    uint32_t i = 0;
+    for(; i + 8 <= numSamples; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+    }
+    for(; i < numSamples; ++i)
+        dest[i] = src[i] * (1.f / 2147483648.f);
+}
+
+void convertSamplesToFloat(const void* src, SampleFormat sampleFormat, uint32_t numBitsPerSample,
+                           uint32_t numSamples, float* dest)
+{
+    if(sampleFormat == SAMPLE_FORMAT_FLOAT)
+    {
+        memcpy(dest, src, numSamples * sizeof(float));
+        return;
+    }
+    switch(numBitsPerSample)
+    {
+        case 8: convertU8ToFloat((const uint8_t*)src, numSamples, dest); break;
+        case 16: convertS16ToFloat((const int16_t*)src, numSamples, dest); break;
+        case 24: convertS24ToFloat((const uint8_t*)src, numSamples, dest); break;
+        case 32: convertS32ToFloat((const int32_t*)src, numSamples, dest); break;
+        default: assert(!"Unsupported PCM bit depth");
+    }
+}
+
+// Split interleaved stereo into two planes, 4 frames at a time
+static void deinterleaveStereo(const float* src, uint32_t numFrames, float* left, float* right)
+{
+    uint32_t i = 0;
+    for(; i + 4 <= numFrames; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(src + 2 * i);     // L0 R0 L1 R1
+        __m128 b = _mm_loadu_ps(src + 2 * i + 4); // L2 R2 L3 R3
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    for(; i < numFrames; ++i)
+    {
+        left[i] = src[2 * i];
+        right[i] = src[2 * i + 1];
+    }
+}
+
+void convertSamplesToPlanarFloat(const void* src, SampleFormat sampleFormat, uint32_t numBitsPerSample,
+                                 uint32_t numChannels, uint32_t numFrames, float* dest)
+{
+    const uint32_t stride = planarStride(numFrames);
+    if(numChannels == 1)
+    {
+        convertSamplesToFloat(src, sampleFormat, numBitsPerSample, numFrames, dest);
+    }
+    else
+    {
+        // Convert a chunk at a time to interleaved float, then split it up
+        const uint32_t CHUNK_SIZE_IN_FRAMES = 256;
+        float chunk[CHUNK_SIZE_IN_FRAMES * 8];
+        assert(numChannels <= 8);
+        const uint32_t numBytesPerFrame = numChannels * numBitsPerSample / 8;
+        for(uint32_t firstFrame = 0; firstFrame < numFrames; firstFrame += CHUNK_SIZE_IN_FRAMES)
+        {
+            uint32_t numChunkFrames = numFrames - firstFrame < CHUNK_SIZE_IN_FRAMES ? numFrames - firstFrame : CHUNK_SIZE_IN_FRAMES;
+            convertSamplesToFloat((const uint8_t*)src + (size_t)firstFrame * numBytesPerFrame, sampleFormat,
+                                  numBitsPerSample, numChunkFrames * numChannels, chunk);
+            if(numChannels == 2)
+            {
+                deinterleaveStereo(chunk, numChunkFrames, dest + firstFrame, dest + stride + firstFrame);
+                continue;
+            }
+            for(uint32_t c = 0; c < numChannels; ++c)
+            {
+                float* plane = dest + c * stride + firstFrame;
+                for(uint32_t i = 0; i < numChunkFrames; ++i)
+                    plane[i] = chunk[i * numChannels + c];
+            }
+        }
+    }
+    for(uint32_t c = 0; c < numChannels; ++c)
+        memset(dest + c * stride + numFrames, 0, (stride - numFrames) * sizeof(float));
+}
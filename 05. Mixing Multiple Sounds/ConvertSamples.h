@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "LoadWavFile.h"
+
+// Convert numSamples samples of any format parseWavFile supports to float in [-1, 1)
+void convertSamplesToFloat(const void* src, SampleFormat sampleFormat, uint32_t numBitsPerSample,
+                           uint32_t numSamples, float* dest);
+
+// Number of floats from the start of one plane to the next. Keeps every plane
+// 64-byte aligned if the first one is, with at least one frame of padding at the end
+inline uint32_t planarStride(uint32_t numFrames)
+{
+    return (numFrames + 1 + 15) & ~15u;
+}
+
+// Same as convertSamplesToFloat but splits interleaved src into a plane per channel,
+// planarStride(numFrames) floats apart. Padding after the last frame is zeroed
+void convertSamplesToPlanarFloat(const void* src, SampleFormat sampleFormat, uint32_t numBitsPerSample,
+                                 uint32_t numChannels, uint32_t numFrames, float* dest);
@@ -0,0 +1,223 @@
+#include "Effects.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+
+// Filters and the limiter feed each output back into the next one, so
+// there's no way to work on several frames of a channel at once. Instead
+// each effect goes over a whole block of one channel in a tight loop
+// with its state in registers, rather than frame by frame through the chain
+
+static BiquadCoefficients biquadCoefficients(const EffectParams* params, uint32_t sampleRate)
+{
+    float w0 = 2.f * (float)M_PI * params->frequency / sampleRate;
+    float cosW0 = cosf(w0);
+    float alpha = sinf(w0) / (2.f * params->q);
+    float A = powf(10.f, params->gainDb / 40.f);
+
+    float b0 = 1.f, b1 = 0.f, b2 = 0.f, a0 = 1.f, a1 = 0.f, a2 = 0.f;
+    switch(params->type)
+    {
+        case EFFECT_LOW_PASS:
+            b0 = (1.f - cosW0) / 2.f; b1 = 1.f - cosW0; b2 = b0;
+            a0 = 1.f + alpha; a1 = -2.f * cosW0; a2 = 1.f - alpha;
+            break;
+        case EFFECT_HIGH_PASS:
+            b0 = (1.f + cosW0) / 2.f; b1 = -(1.f + cosW0); b2 = b0;
+            a0 = 1.f + alpha; a1 = -2.f * cosW0; a2 = 1.f - alpha;
+            break;
+        case EFFECT_PEAKING_EQ:
+            b0 = 1.f + alpha * A; b1 = -2.f * cosW0; b2 = 1.f - alpha * A;
+            a0 = 1.f + alpha / A; a1 = -2.f * cosW0; a2 = 1.f - alpha / A;
+            break;
+        case EFFECT_LOW_SHELF:
+        {
+            float sqrtAAlpha = 2.f * sqrtf(A) * alpha;
+            b0 = A * ((A + 1.f) - (A - 1.f) * cosW0 + sqrtAAlpha);
+            b1 = 2.f * A * ((A - 1.f) - (A + 1.f) * cosW0);
+            b2 = A * ((A + 1.f) - (A - 1.f) * cosW0 - sqrtAAlpha);
+            a0 = (A + 1.f) + (A - 1.f) * cosW0 + sqrtAAlpha;
+            a1 = -2.f * ((A - 1.f) + (A + 1.f) * cosW0);
+            a2 = (A + 1.f) + (A - 1.f) * cosW0 - sqrtAAlpha;
+            break;
+        }
+        case EFFECT_HIGH_SHELF:
+        {
+            float sqrtAAlpha = 2.f * sqrtf(A) * alpha;
+            b0 = A * ((A + 1.f) + (A - 1.f) * cosW0 + sqrtAAlpha);
+            b1 = -2.f * A * ((A - 1.f) + (A + 1.f) * cosW0);
+            b2 = A * ((A + 1.f) + (A - 1.f) * cosW0 - sqrtAAlpha);
+            a0 = (A + 1.f) - (A - 1.f) * cosW0 + sqrtAAlpha;
+            a1 = 2.f * ((A - 1.f) - (A + 1.f) * cosW0);
+            a2 = (A + 1.f) - (A - 1.f) * cosW0 - sqrtAAlpha;
+            break;
+        }
+        default: assert(!"Not a filter");
+    }
+
+    BiquadCoefficients result;
+    result.b0 = b0 / a0;
+    result.b1 = b1 / a0;
+    result.b2 = b2 / a0;
+    result.a1 = a1 / a0;
+    result.a2 = a2 / a0;
+    return result;
+}
+
+void effectSet(Effect* effect, const EffectParams* params, uint32_t sampleRate)
+{
+    if(effect->type != params->type)
+    {
+        *effect = {};
+        effect->type = params->type;
+    }
+    switch(params->type)
+    {
+        case EFFECT_NONE: break;
+        case EFFECT_LIMITER:
+            effect->limiterThreshold = powf(10.f, params->gainDb / 20.f);
+            // Decays by 60dB over the release time
+            effect->limiterRelease = powf(0.001f, 1000.f / (params->releaseMs * sampleRate));
+            break;
+        default:
+            assert(params->frequency > 0 && params->frequency < sampleRate / 2 && params->q > 0);
+            effect->coefficients = biquadCoefficients(params, sampleRate);
+            break;
+    }
+}
+
+static void biquadProcess(const BiquadCoefficients* c, float* state, float* samples, uint32_t numFrames)
+{
+    float z1 = state[0];
+    float z2 = state[1];
+    for(uint32_t i = 0; i < numFrames; ++i)
+    {
+        float in = samples[i];
+        float out = c->b0 * in + z1;
+        z1 = c->b1 * in - c->a1 * out + z2;
+        z2 = c->b2 * in - c->a2 * out;
+        samples[i] = out;
+    }
+    // Flush denormals once the input goes quiet, they're very slow on x86
+    state[0] = fabsf(z1) < 1e-20f ? 0.f : z1;
+    state[1] = fabsf(z2) < 1e-20f ? 0.f : z2;
+}
+
+// Follows the peak of both channels, jumping straight up to any new peak so
+// nothing ever gets through above the threshold, then slowly falling back.
+// Both channels get the same gain so the stereo image doesn't shift
+static void limiterProcess(Effect* effect, float* left, float* right, uint32_t numFrames)
+{
+    float envelope = effect->limiterEnvelope;
+    const float threshold = effect->limiterThreshold;
+    const float release = effect->limiterRelease;
+    for(uint32_t i = 0; i < numFrames; ++i)
+    {
+        float peak = fmaxf(fabsf(left[i]), fabsf(right[i]));
+        envelope = fmaxf(peak, envelope * release);
+        float gain = envelope > threshold ? threshold / envelope : 1.f;
+        left[i] *= gain;
+        right[i] *= gain;
+    }
+    effect->limiterEnvelope = envelope;
+}
+
+void effectProcess(Effect* effect, float* left, float* right, uint32_t numFrames)
+{
+    switch(effect->type)
+    {
+        case EFFECT_NONE: break;
+        case EFFECT_LIMITER: limiterProcess(effect, left, right, numFrames); break;
+        default:
+            biquadProcess(&effect->coefficients, effect->filterState[0], left, numFrames);
+            biquadProcess(&effect->coefficients, effect->filterState[1], right, numFrames);
+            break;
+    }
+}
+
+void effectChainReset(EffectChain* chain)
+{
+    for(uint32_t i = 0; i < EFFECT_CHAIN_MAX_EFFECTS; ++i)
+        chain->effects[i].type = EFFECT_NONE;
+}
+
+void effectChainProcess(EffectChain* chain, float* left, float* right, uint32_t numFrames)
+{
+    for(uint32_t i = 0; i < EFFECT_CHAIN_MAX_EFFECTS; ++i)
+        effectProcess(&chain->effects[i], left, right, numFrames);
+}
+
+// Freeverb's delay lengths, tuned for 44.1kHz
+static const uint32_t combLengths[REVERB_NUM_COMBS] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+static const uint32_t allpassLengths[REVERB_NUM_ALLPASSES] = { 556, 441, 341, 225 };
+static const uint32_t stereoSpread = 23;
+
+void reverbInit(Reverb* reverb, uint32_t sampleRate, float roomSize, float damping, float wetGain)
+{
+    memset(reverb, 0, sizeof(*reverb));
+    float lengthScale = sampleRate / 44100.f;
+    for(uint32_t c = 0; c < 2; ++c)
+    {
+        uint32_t spread = c * stereoSpread;
+        for(uint32_t i = 0; i < REVERB_NUM_COMBS; ++i) {
+            reverb->combs[c][i].length = (uint32_t)((combLengths[i] + spread) * lengthScale);
+            assert(reverb->combs[c][i].length <= REVERB_MAX_DELAY_LENGTH);
+        }
+        for(uint32_t i = 0; i < REVERB_NUM_ALLPASSES; ++i) {
+            reverb->allpasses[c][i].length = (uint32_t)((allpassLengths[i] + spread) * lengthScale);
+            assert(reverb->allpasses[c][i].length <= REVERB_MAX_DELAY_LENGTH);
+        }
+    }
+    reverb->feedback = 0.7f + 0.28f * roomSize;
+    reverb->damping = 0.4f * damping;
+    reverb->wetGain = wetGain;
+}
+
+static void reverbProcessChannel(Reverb* reverb, uint32_t channel, const float* send, float* out, uint32_t numFrames)
+{
+    // Combs in parallel, each one over the whole block
+    const float INPUT_GAIN = 0.015f;
+    float* wet = reverb->wet;
+    assert(numFrames <= REVERB_MAX_FRAMES);
+    memset(wet, 0, numFrames * sizeof(float));
+    for(uint32_t i = 0; i < REVERB_NUM_COMBS; ++i)
+    {
+        ReverbDelayLine* comb = &reverb->combs[channel][i];
+        float filterState = comb->filterState;
+        uint32_t pos = comb->pos;
+        for(uint32_t frame = 0; frame < numFrames; ++frame)
+        {
+            float delayed = comb->buffer[pos];
+            filterState = delayed + (filterState - delayed) * reverb->damping;
+            comb->buffer[pos] = send[frame] * INPUT_GAIN + filterState * reverb->feedback;
+            if(++pos == comb->length) pos = 0;
+            wet[frame] += delayed;
+        }
+        comb->filterState = fabsf(filterState) < 1e-20f ? 0.f : filterState;
+        comb->pos = pos;
+    }
+    // Then the allpasses in series
+    for(uint32_t i = 0; i < REVERB_NUM_ALLPASSES; ++i)
+    {
+        ReverbDelayLine* allpass = &reverb->allpasses[channel][i];
+        uint32_t pos = allpass->pos;
+        for(uint32_t frame = 0; frame < numFrames; ++frame)
+        {
+            float delayed = allpass->buffer[pos];
+            allpass->buffer[pos] = wet[frame] + delayed * 0.5f;
+            wet[frame] = delayed - wet[frame];
+            if(++pos == allpass->length) pos = 0;
+        }
+        allpass->pos = pos;
+    }
+    for(uint32_t frame = 0; frame < numFrames; ++frame)
+        out[frame] += wet[frame] * reverb->wetGain;
+}
+
+void reverbProcess(Reverb* reverb, const float* send, float* left, float* right, uint32_t numFrames)
+{
+    reverbProcessChannel(reverb, 0, send, left, numFrames);
+    reverbProcessChannel(reverb, 1, send, right, numFrames);
+}
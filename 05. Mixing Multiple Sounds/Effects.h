@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+// Effects run on blocks of de-interleaved float samples, one buffer per channel.
+// Everything is allocated up front: an effect chain is a fixed number of slots,
+// and changing an effect just overwrites its slot, so the audio thread
+// never has to allocate to add or change one
+
+enum EffectType {
+    EFFECT_NONE,
+    EFFECT_LOW_PASS,
+    EFFECT_HIGH_PASS,
+    EFFECT_PEAKING_EQ,
+    EFFECT_LOW_SHELF,
+    EFFECT_HIGH_SHELF,
+    EFFECT_LIMITER,
+};
+
+// What the game asks for. The audio thread turns it into an Effect
+struct EffectParams {
+    EffectType type;
+    float frequency; // Filters only, in Hz
+    float q;         // Filters only, 0.707 is a gentle slope with no resonant peak
+    float gainDb;    // EQ and shelf gain, or the limiter's threshold
+    float releaseMs; // Limiter only, how quickly it lets the level back up again
+};
+
+// Transposed direct form II, see the Audio EQ Cookbook by Robert Bristow-Johnson
+struct BiquadCoefficients {
+    float b0, b1, b2;
+    float a1, a2;
+};
+
+struct Effect {
+    EffectType type;
+    BiquadCoefficients coefficients;
+    float filterState[2][2]; // Per channel
+    float limiterThreshold;
+    float limiterRelease; // Envelope multiplier per frame
+    float limiterEnvelope;
+};
+
+#define EFFECT_CHAIN_MAX_EFFECTS 4
+
+// Slots are processed in order, empty ones are skipped
+struct EffectChain {
+    Effect effects[EFFECT_CHAIN_MAX_EFFECTS];
+};
+
+// Only clears the effect's state if the type changed,
+// so sweeping e.g. a filter's frequency doesn't click
+void effectSet(Effect* effect, const EffectParams* params, uint32_t sampleRate);
+void effectProcess(Effect* effect, float* left, float* right, uint32_t numFrames);
+void effectChainReset(EffectChain* chain);
+void effectChainProcess(EffectChain* chain, float* left, float* right, uint32_t numFrames);
+
+// Freeverb style reverb: 8 parallel low-passed comb filters per channel
+// into 4 allpass filters, with slightly different lengths on each side
+#define REVERB_NUM_COMBS 8
+#define REVERB_NUM_ALLPASSES 4
+// Enough for up to 48kHz
+#define REVERB_MAX_DELAY_LENGTH 2048
+// Max number of frames per reverbProcess() call
+#define REVERB_MAX_FRAMES 1024
+
+struct ReverbDelayLine {
+    float buffer[REVERB_MAX_DELAY_LENGTH];
+    uint32_t length;
+    uint32_t pos;
+    float filterState; // Combs only
+};
+
+struct Reverb {
+    ReverbDelayLine combs[2][REVERB_NUM_COMBS];
+    ReverbDelayLine allpasses[2][REVERB_NUM_ALLPASSES];
+    float feedback; // Bigger is a longer tail
+    float damping;  // Bigger loses high frequencies faster
+    float wetGain;
+    float wet[REVERB_MAX_FRAMES]; // Scratch space for one channel
+};
+
+void reverbInit(Reverb* reverb, uint32_t sampleRate, float roomSize, float damping, float wetGain);
+// Reverberates the mono send buffer and adds the result into left and right
+void reverbProcess(Reverb* reverb, const float* send, float* left, float* right, uint32_t numFrames);
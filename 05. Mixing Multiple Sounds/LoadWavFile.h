@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+enum SampleFormat {
+    SAMPLE_FORMAT_PCM,   // Integer, 8-bit is unsigned and the rest are signed
+    SAMPLE_FORMAT_FLOAT, // 32-bit float
+    SAMPLE_FORMAT_IMA_ADPCM, // 4-bit, see ImaAdpcm.h
+};
+
+enum SampleLayout {
+    SAMPLE_LAYOUT_INTERLEAVED, // Frame by frame, the way wav files store them
+    SAMPLE_LAYOUT_PLANAR,      // Each channel on its own, see convertSamplesToPlanarFloat()
+};
+
+struct AudioClip {
+    SampleFormat sampleFormat;
+    SampleLayout layout;
+    uint32_t numChannels;
+    uint32_t numBitsPerSample;
+    uint32_t sampleRate;
+    uint32_t numSamples; // For IMA-ADPCM this is the number once decoded
+    void* samples;
+    // Only used by IMA-ADPCM
+    uint32_t numBytesPerBlock;
+    uint32_t numFramesPerBlock;
+    // Only used by planar clips. Channel c starts at samples + c * planeStride
+    uint32_t planeStride;
+    // Loop region from the file's smpl or cue chunk, in frames. A looping voice plays
+    // up to loopEndFrame then jumps back to loopStartFrame, and once released plays
+    // on to the end. loopEndFrame is 0 if there isn't one and the whole clip loops
+    uint32_t loopStartFrame;
+    uint32_t loopEndFrame;
+};
+
+enum WavError {
+    WAV_OK,
+    WAV_ERROR_NOT_A_WAV_FILE,
+    WAV_ERROR_TRUNCATED,
+    WAV_ERROR_MISSING_FMT_CHUNK,
+    WAV_ERROR_MISSING_DATA_CHUNK,
+    WAV_ERROR_INVALID_FORMAT,     // The fmt chunk doesn't make sense
+    WAV_ERROR_UNSUPPORTED_FORMAT, // Valid, but not something we can play
+};
+
+// Where a chunk's data is in the file, just after its header. Both are 0 if the file doesn't have one
+struct WavChunk {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Every chunk we care about, found in one pass over the file so
+// looking up metadata later doesn't mean walking the file again.
+// If a file has more than one of a chunk, only the first one counts
+struct WavChunkIndex {
+    WavChunk fmt;
+    WavChunk data;
+    WavChunk fact;
+    WavChunk cue;  // Cue points
+    WavChunk smpl; // Sampler info, including loop points
+    WavChunk adtl; // LIST of type adtl: labels and lengths for the cue points
+    WavChunk list; // Any other LIST, e.g. INFO tags
+};
+
+// Checks every read against fileSize, so it's safe to call on any bytes at all.
+// Fills in clip on success and zeroes it on failure. chunks is optional
+WavError parseWavFile(const uint8_t* fileBytes, uint32_t fileSize, AudioClip* clip, WavChunkIndex* chunks = nullptr);
+const char* wavErrorString(WavError error);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "LoadWavFile.h"
+
+// Loudness measurement following ITU-R BS.1770 and EBU R128: K-weighted mean
+// square over 400ms blocks, gated so silence and quiet passages don't drag the
+// result down, plus the peak between samples found by oversampling 4x.
+// The same meter works offline over whole clips and live on the mixer's output.
+// Mono and stereo only, with both channels weighted 1 as the standard says
+
+#define LOUDNESS_MAX_CHANNELS 2
+// Blocks are gated and counted in a histogram of 0.1 LU bins from
+// -70 LUFS (the absolute gate) up to +10 LUFS, so memory use is fixed
+#define LOUDNESS_HISTOGRAM_MIN_LUFS -70.f
+#define LOUDNESS_HISTOGRAM_BINS 800
+// Blocks are made of 100ms steps: 4 for momentary, 30 for short-term loudness
+#define LOUDNESS_MOMENTARY_STEPS 4
+#define LOUDNESS_SHORT_TERM_STEPS 30
+// Taps per phase of the 4x oversampling filter for the true peak
+#define LOUDNESS_TRUE_PEAK_TAPS 12
+// Frames handled at a time internally
+#define LOUDNESS_CHUNK_FRAMES 256
+
+// What comes out of a meter, in LUFS, LU and dB. Loudness of silence is -HUGE_VALF
+struct LoudnessStats {
+    float integratedLufs;
+    float loudnessRangeLu; // Spread between the 10th and 95th percentiles of short-term loudness
+    float maxMomentaryLufs;
+    float maxShortTermLufs;
+    float truePeakDbtp;
+    float samplePeakDbfs;
+};
+
+struct LoudnessHistogram {
+    uint32_t counts[LOUDNESS_HISTOGRAM_BINS];
+    double energy[LOUDNESS_HISTOGRAM_BINS]; // Sum of the mean squares of the blocks in each bin
+};
+
+struct LoudnessMeter {
+    uint32_t numChannels;
+    uint32_t numFramesPerStep;
+    // K-weighting: a high shelf for the head then a high-pass, in double since the
+    // high-pass is down at 38Hz. Both channels go through at once in one SSE2 register
+    double filterB[2][3];
+    double filterA[2][2];
+    alignas(16) double filterState[2][2][2]; // [stage][state][channel]
+    double stepEnergy; // Sum of squares over both channels so far this step
+    uint32_t numStepFrames;
+    double recentSteps[LOUDNESS_SHORT_TERM_STEPS]; // Mean squares, ring buffer
+    uint64_t numSteps;
+    // Updated every 100ms, for a live meter
+    float momentaryLufs;
+    float shortTermLufs;
+    float maxMomentaryLufs;
+    float maxShortTermLufs;
+    LoudnessHistogram momentaryHistogram; // For the integrated loudness
+    LoudnessHistogram shortTermHistogram; // For the loudness range
+    // Polyphase windowed sinc, tap k of all 4 phases together so they can be worked out at once
+    alignas(16) float truePeakFilter[LOUDNESS_TRUE_PEAK_TAPS][4];
+    // The last LOUDNESS_TRUE_PEAK_TAPS - 1 frames of the previous chunk, then this chunk
+    alignas(16) float truePeakInput[LOUDNESS_MAX_CHANNELS][LOUDNESS_TRUE_PEAK_TAPS - 1 + LOUDNESS_CHUNK_FRAMES];
+    float samplePeak; // Linear
+    float truePeak;
+    // Plain peak and RMS since the last loudnessMeterTakeLevels(), unweighted
+    float levelPeak;
+    double levelEnergy;
+    uint32_t numLevelFrames;
+};
+
+void loudnessMeterInit(LoudnessMeter* meter, uint32_t sampleRate, uint32_t numChannels);
+// right is ignored for mono
+void loudnessMeterProcess(LoudnessMeter* meter, const float* left, const float* right, uint32_t numFrames);
+void loudnessMeterGetStats(const LoudnessMeter* meter, LoudnessStats* stats);
+// Peak and RMS level in dBFS since the last call, then starts again. For a live meter
+void loudnessMeterTakeLevels(LoudnessMeter* meter, float* peakDbfs, float* rmsDbfs);
+
+// Measures a whole clip in any format the mixer plays
+void loudnessAnalyseClip(const AudioClip* clip, LoudnessStats* stats);
+// Gain to bring something measured as stats to targetLufs (-23 for EBU R128 broadcast,
+// around -16 to -18 for games), turned down if needed to keep the true peak under maxTruePeakDbtp
+float loudnessNormalisationGain(const LoudnessStats* stats, float targetLufs, float maxTruePeakDbtp = -1.f);
@@ -0,0 +1,994 @@
+#include "Mixer.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include <emmintrin.h> // SSE2
+
+// Simple software mixer: every playing voice is resampled to the output rate,
+// run through its effects and summed into a float buffer per speaker, which goes
+// through the master effects and is written out once at the end in whatever
+// format the device mixes in (16, 24 or 32-bit integer, or float, see OutputFormat.h).
+// Mixing in float means voices can add up past full scale without wrapping,
+// the master limiter brings it back down before we convert it for the audio device.
+
+static_assert(MIXER_MAX_FRAMES_PER_PASS <= REVERB_MAX_FRAMES, "Reverb can't take a whole pass at once");
+
+void mixerInit(Mixer* mixer, uint32_t outputSampleRate)
+{
+    *mixer = {};
+    mixer->outputSampleRate = outputSampleRate;
+    for(uint32_t i = 0; i < MIXER_MAX_VOICES; ++i) {
+        // Push in reverse so voice 0 is handed out first
+        mixer->freeVoices[i] = (uint16_t)(MIXER_MAX_VOICES - 1 - i);
+    }
+    mixer->numFreeVoices = MIXER_MAX_VOICES;
+    arenaInit(&mixer->scratch, mixer->scratchMemory, sizeof(mixer->scratchMemory));
+    for(uint32_t i = 0; i < MIXER_MAX_VOICES; ++i)
+        mixer->voices[i].emitterIndex = SPATIAL_NO_EMITTER;
+    spatialInit(&mixer->emitters);
+    mixer->listener.forward[2] = 1.f;
+    mixer->listener.up[1] = 1.f;
+    poolInit(&mixer->decodeBufferPool, mixer->decodeBuffers, sizeof(mixer->decodeBuffers[0]), MIXER_MAX_ADPCM_VOICES);
+    poolInit(&mixer->timeStretchPool, mixer->timeStretches, sizeof(mixer->timeStretches[0]), MIXER_MAX_TIME_STRETCH_VOICES);
+
+    loudnessMeterInit(&mixer->masterMeter, outputSampleRate, 2);
+    reverbInit(&mixer->reverb, outputSampleRate, 0.5f, 0.5f, 1.f);
+    AudioOutputFormat outputFormat = audioOutputFormatInt16Stereo(outputSampleRate);
+    mixerSetOutputFormat(mixer, &outputFormat);
+    EffectParams limiter = {};
+    limiter.type = EFFECT_LIMITER;
+    limiter.gainDb = -1.f;
+    limiter.releaseMs = 100.f;
+    mixerSetMasterEffect(mixer, EFFECT_CHAIN_MAX_EFFECTS - 1, &limiter);
+}
+
+static Voice* getVoice(Mixer* mixer, VoiceId id)
+{
+    uint32_t index = id & 0xFFFF;
+    if(index >= MIXER_MAX_VOICES)
+        return nullptr;
+    Voice* voice = &mixer->voices[index];
+    if(!voice->isPlaying || voice->generation != (id >> 16))
+        return nullptr;
+    return voice;
+}
+
+// Takes the voice back out of 3D, leaving its pan where it was. In 5.1 and 7.1
+// that's as near as stereo gets, its gains in the front left and right
+static void removeEmitter(Mixer* mixer, Voice* voice)
+{
+    uint32_t index = voice->emitterIndex;
+    if(index == SPATIAL_NO_EMITTER)
+        return;
+    if(mixer->speakerLayout != SPEAKER_LAYOUT_STEREO)
+    {
+        voice->panGains[0] = voice->targetPanGains[0] = voice->speakerGains[0];
+        voice->panGains[1] = voice->targetPanGains[1] = voice->speakerGains[1];
+    }
+    // The last emitter moves into the gap, so its voice needs to know
+    uint32_t lastIndex = mixer->emitters.numEmitters - 1;
+    spatialRemoveEmitter(&mixer->emitters, index);
+    mixer->emitterVoices[index] = mixer->emitterVoices[lastIndex];
+    mixer->voices[mixer->emitterVoices[index]].emitterIndex = index;
+    voice->emitterIndex = SPATIAL_NO_EMITTER;
+}
+
+static void freeVoice(Mixer* mixer, Voice* voice)
+{
+    assert(mixer->numFreeVoices < MIXER_MAX_VOICES);
+    voice->isPlaying = false;
+    if(voice->clipUseCount)
+        voice->clipUseCount->fetch_sub(1, std::memory_order_release);
+    voice->clipUseCount = nullptr;
+    for(uint32_t i = 0; i < voice->numQueuedClips; ++i)
+    {
+        if(voice->queuedClips[i].clipUseCount)
+            voice->queuedClips[i].clipUseCount->fetch_sub(1, std::memory_order_release);
+    }
+    voice->numQueuedClips = 0;
+    removeEmitter(mixer, voice);
+    if(voice->decodedBlock)
+        poolFree(&mixer->decodeBufferPool, voice->decodedBlock);
+    voice->decodedBlock = nullptr;
+    if(voice->timeStretch)
+        poolFree(&mixer->timeStretchPool, voice->timeStretch);
+    voice->timeStretch = nullptr;
+    // Invalidate any ids that still refer to this voice
+    ++voice->generation;
+    mixer->freeVoices[mixer->numFreeVoices++] = (uint16_t)(voice - mixer->voices);
+}
+
+// What one unit of the clip's samples is in the [-1, 1] range
+static float clipSampleScale(const AudioClip* clip)
+{
+    return clip->sampleFormat == SAMPLE_FORMAT_FLOAT ? 1.f : 1.f / 32768.f;
+}
+
+// Reads one frame of clip. Mono clips give the same sample for both channels
+static void readClipFrame(Mixer* mixer, const AudioClip* clip, uint32_t frame, float* left, float* right)
+{
+    const uint32_t numChannels = clip->numChannels;
+    if(clip->layout == SAMPLE_LAYOUT_PLANAR)
+    {
+        const float* samples = (const float*)clip->samples;
+        *left = samples[frame];
+        *right = samples[(numChannels - 1) * clip->planeStride + frame];
+    }
+    else if(clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM)
+    {
+        // Rare enough (once per loop or clip change) to just decode the block up to the frame.
+        // This can run between passes too, so give the scratch memory back afterwards
+        uint32_t blockIndex = frame / clip->numFramesPerBlock;
+        uint32_t frameInBlock = frame - blockIndex * clip->numFramesPerBlock;
+        size_t scratchUsed = mixer->scratch.used;
+        int16_t* decoded = ARENA_PUSH_ARRAY(&mixer->scratch, int16_t, (frameInBlock + 1) * numChannels);
+        imaAdpcmDecodeBlock((const uint8_t*)clip->samples + blockIndex * clip->numBytesPerBlock, numChannels,
+                            frameInBlock + 1, decoded);
+        *left = decoded[frameInBlock * numChannels];
+        *right = decoded[frameInBlock * numChannels + numChannels - 1];
+        mixer->scratch.used = scratchUsed;
+    }
+    else if(clip->sampleFormat == SAMPLE_FORMAT_FLOAT)
+    {
+        const float* samples = (const float*)clip->samples + frame * numChannels;
+        *left = samples[0];
+        *right = samples[numChannels - 1];
+    }
+    else
+    {
+        const int16_t* samples = (const int16_t*)clip->samples + frame * numChannels;
+        *left = samples[0];
+        *right = samples[numChannels - 1];
+    }
+}
+
+// Frame the voice's current part of its clip starts from when it loops
+static uint32_t loopStartFrame(const Voice* voice)
+{
+    return voice->isLooping && voice->clip->loopEndFrame ? voice->clip->loopStartFrame : 0;
+}
+
+// Frame the voice loops, moves on to the next clip or stops at
+static uint32_t regionEndFrame(const Voice* voice)
+{
+    if(voice->isLooping && voice->clip->loopEndFrame)
+        return voice->clip->loopEndFrame;
+    return voice->clip->numSamples / voice->clip->numChannels;
+}
+
+static void updateSeamFrame(Mixer* mixer, Voice* voice)
+{
+    const AudioClip* clip = voice->clip;
+    const AudioClip* nextClip = clip;
+    uint32_t nextFrame = regionEndFrame(voice) - 1;
+    if(voice->isLooping)
+        nextFrame = loopStartFrame(voice);
+    else if(voice->numQueuedClips > 0) {
+        nextClip = voice->queuedClips[0].clip;
+        nextFrame = 0;
+    }
+    readClipFrame(mixer, nextClip, nextFrame, &voice->seamFrame[0], &voice->seamFrame[1]);
+    // The next clip can be in a different format to this one
+    const float scale = clipSampleScale(nextClip) / clipSampleScale(clip);
+    voice->seamFrame[0] *= scale;
+    voice->seamFrame[1] *= scale;
+}
+
+// Called when pos reaches the end of the voice's region. Jumps back to the loop
+// start, moves on to the next queued clip or stops the voice.
+// Returns true if it moved on, meaning the voice's clip has changed
+static bool finishRegion(Mixer* mixer, Voice* voice, uint64_t* pos)
+{
+    const uint64_t endPos = (uint64_t)regionEndFrame(voice) << 32;
+    if(voice->isLooping)
+    {
+        // Only happens once per loop, so a modulo is fine. It also
+        // copes with steps bigger than the whole loop
+        const uint64_t loopStartPos = (uint64_t)loopStartFrame(voice) << 32;
+        *pos = loopStartPos + (*pos - loopStartPos) % (endPos - loopStartPos);
+        return false;
+    }
+    if(voice->numQueuedClips == 0)
+    {
+        voice->isPlaying = false;
+        return false;
+    }
+
+    // Keep the fraction so the step carries on evenly into the next clip
+    *pos -= endPos;
+    if(voice->clipUseCount)
+        voice->clipUseCount->fetch_sub(1, std::memory_order_release);
+    QueuedClip next = voice->queuedClips[0];
+    --voice->numQueuedClips;
+    memmove(voice->queuedClips, voice->queuedClips + 1, voice->numQueuedClips * sizeof(QueuedClip));
+    voice->clip = next.clip;
+    voice->isLooping = next.looping;
+    voice->clipUseCount = next.clipUseCount;
+    voice->decodedBlockIndex = 0xFFFFFFFF;
+    updateSeamFrame(mixer, voice);
+    return true;
+}
+
+// Equal-power panning keeps the perceived loudness constant across the stereo field
+static void setPanGains(float* panGains, float pan)
+{
+    const float panAngle = (pan + 1) * (float)M_PI / 4;
+    panGains[0] = cosf(panAngle);
+    panGains[1] = sinf(panAngle);
+}
+
+VoiceId mixerPlay(Mixer* mixer, const AudioClip* clip, float gain, float pan, float pitch, bool looping,
+                  std::atomic<uint32_t>* clipUseCount)
+{
+    assert(clip->numChannels == 1 || clip->numChannels == 2);
+    // Other formats need converting to float at load time (see ConvertSamples.h)
+    assert((clip->sampleFormat == SAMPLE_FORMAT_PCM && clip->numBitsPerSample == 16)
+           || clip->sampleFormat == SAMPLE_FORMAT_FLOAT || clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM);
+    assert(clip->numSamples >= clip->numChannels);
+    assert(clip->loopStartFrame < clip->loopEndFrame || clip->loopEndFrame == 0);
+    int16_t* decodedBlock = nullptr;
+    if(mixer->numFreeVoices == 0 || (clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM
+                                     && !(decodedBlock = (int16_t*)poolAlloc(&mixer->decodeBufferPool))))
+    {
+        if(clipUseCount)
+            clipUseCount->fetch_sub(1, std::memory_order_release);
+        return INVALID_VOICE_ID;
+    }
+
+    uint16_t index = mixer->freeVoices[--mixer->numFreeVoices];
+    Voice* voice = &mixer->voices[index];
+    voice->clip = clip;
+    voice->playbackPos = 0;
+    voice->gain = gain;
+    voice->numGainRampFramesLeft = 0;
+    setPanGains(voice->panGains, pan);
+    setPanGains(voice->targetPanGains, pan);
+    voice->pitch = pitch;
+    voice->isLooping = looping;
+    voice->isPlaying = true;
+    voice->decodedBlock = decodedBlock;
+    voice->decodedBlockIndex = 0xFFFFFFFF;
+    effectChainReset(&voice->effects);
+    voice->reverbSend = 0.f;
+    voice->clipUseCount = clipUseCount;
+    voice->numQueuedClips = 0;
+    updateSeamFrame(mixer, voice);
+    return ((VoiceId)voice->generation << 16) | index;
+}
+
+void mixerStop(Mixer* mixer, VoiceId id)
+{
+    if(Voice* voice = getVoice(mixer, id))
+        freeVoice(mixer, voice);
+}
+
+void mixerRelease(Mixer* mixer, VoiceId id)
+{
+    Voice* voice = getVoice(mixer, id);
+    if(voice && voice->isLooping) {
+        voice->isLooping = false;
+        updateSeamFrame(mixer, voice);
+    }
+}
+
+bool mixerQueueClip(Mixer* mixer, VoiceId id, const AudioClip* clip, bool looping, std::atomic<uint32_t>* clipUseCount)
+{
+    assert(clip->numChannels == 1 || clip->numChannels == 2);
+    assert((clip->sampleFormat == SAMPLE_FORMAT_PCM && clip->numBitsPerSample == 16)
+           || clip->sampleFormat == SAMPLE_FORMAT_FLOAT || clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM);
+    assert(clip->numSamples >= clip->numChannels);
+    assert(clip->loopStartFrame < clip->loopEndFrame || clip->loopEndFrame == 0);
+    Voice* voice = getVoice(mixer, id);
+    // Get the decode buffer now, so there's no way to run out of them later when the clip starts
+    if(voice && clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM && !voice->decodedBlock)
+        voice->decodedBlock = (int16_t*)poolAlloc(&mixer->decodeBufferPool);
+    if(!voice || voice->numQueuedClips == MIXER_MAX_QUEUED_CLIPS
+       || (clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM && !voice->decodedBlock))
+    {
+        if(clipUseCount)
+            clipUseCount->fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    QueuedClip* queuedClip = &voice->queuedClips[voice->numQueuedClips++];
+    queuedClip->clip = clip;
+    queuedClip->looping = looping;
+    queuedClip->clipUseCount = clipUseCount;
+    if(voice->numQueuedClips == 1)
+        updateSeamFrame(mixer, voice);
+    return true;
+}
+
+void mixerSetGain(Mixer* mixer, VoiceId id, float gain)
+{
+    if(Voice* voice = getVoice(mixer, id)) {
+        voice->gain = gain;
+        voice->numGainRampFramesLeft = 0;
+    }
+}
+
+void mixerRampGain(Mixer* mixer, VoiceId id, float targetGain, uint32_t numFrames)
+{
+    if(Voice* voice = getVoice(mixer, id)) {
+        if(numFrames == 0)
+            voice->gain = targetGain;
+        voice->gainRampTarget = targetGain;
+        voice->numGainRampFramesLeft = numFrames;
+    }
+}
+
+void mixerSetEffect(Mixer* mixer, VoiceId id, uint32_t slot, const EffectParams* params)
+{
+    assert(slot < EFFECT_CHAIN_MAX_EFFECTS);
+    if(Voice* voice = getVoice(mixer, id))
+        effectSet(&voice->effects.effects[slot], params, mixer->outputSampleRate);
+}
+
+void mixerSetReverbSend(Mixer* mixer, VoiceId id, float send)
+{
+    if(Voice* voice = getVoice(mixer, id))
+        voice->reverbSend = send;
+}
+
+void mixerSetMasterEffect(Mixer* mixer, uint32_t slot, const EffectParams* params)
+{
+    assert(slot < EFFECT_CHAIN_MAX_EFFECTS);
+    for(uint32_t i = 0; i < SPATIAL_MAX_CHANNELS / 2; ++i)
+        effectSet(&mixer->masterEffects[i].effects[slot], params, mixer->outputSampleRate);
+}
+
+void mixerSetPan(Mixer* mixer, VoiceId id, float pan)
+{
+    if(Voice* voice = getVoice(mixer, id)) {
+        removeEmitter(mixer, voice);
+        setPanGains(voice->targetPanGains, pan);
+    }
+}
+
+void mixerSetListener(Mixer* mixer, const SpatialListener* listener)
+{
+    mixer->listener = *listener;
+}
+
+void mixerSetPosition(Mixer* mixer, VoiceId id, float x, float y, float z)
+{
+    Voice* voice = getVoice(mixer, id);
+    if(!voice)
+        return;
+    if(voice->emitterIndex == SPATIAL_NO_EMITTER)
+    {
+        uint32_t index = spatialAddEmitter(&mixer->emitters);
+        if(index == SPATIAL_NO_EMITTER)
+            return;
+        voice->emitterIndex = index;
+        voice->snapPanGains = true;
+        mixer->emitterVoices[index] = (uint16_t)(voice - mixer->voices);
+    }
+    spatialSetPosition(&mixer->emitters, voice->emitterIndex, x, y, z);
+}
+
+void mixerSetAttenuation(Mixer* mixer, VoiceId id, AttenuationCurve curve, float minDistance, float maxDistance, float rolloff)
+{
+    Voice* voice = getVoice(mixer, id);
+    if(voice && voice->emitterIndex != SPATIAL_NO_EMITTER)
+        spatialSetAttenuation(&mixer->emitters, voice->emitterIndex, curve, minDistance, maxDistance, rolloff);
+}
+
+// Works out the pan gains of every positioned voice for this pass, all at once. In 5.1
+// and 7.1 those are speaker gains, and the voice itself is rendered without panning
+static void updateEmitters(Mixer* mixer)
+{
+    SpatialEmitters* emitters = &mixer->emitters;
+    if(emitters->numEmitters == 0)
+        return;
+    spatialUpdate(&mixer->listener, emitters, mixer->speakerLayout);
+    const bool isStereo = mixer->speakerLayout == SPEAKER_LAYOUT_STEREO;
+    for(uint32_t i = 0; i < emitters->numEmitters; ++i)
+    {
+        Voice* voice = &mixer->voices[mixer->emitterVoices[i]];
+        voice->targetPanGains[0] = isStereo ? emitters->gains[0][i] : 1.f;
+        voice->targetPanGains[1] = isStereo ? emitters->gains[1][i] : 1.f;
+        if(!isStereo) {
+            for(uint32_t channel = 0; channel < mixer->numMixChannels; ++channel)
+                voice->targetSpeakerGains[channel] = emitters->gains[channel][i];
+        }
+        // Don't sweep in from wherever the voice was panned before it had a position
+        if(voice->snapPanGains) {
+            voice->panGains[0] = voice->targetPanGains[0];
+            voice->panGains[1] = voice->targetPanGains[1];
+            memcpy(voice->speakerGains, voice->targetSpeakerGains, sizeof(voice->speakerGains));
+            voice->snapPanGains = false;
+        }
+    }
+}
+
+void mixerSetPitch(Mixer* mixer, VoiceId id, float pitch)
+{
+    if(Voice* voice = getVoice(mixer, id))
+        voice->pitch = pitch;
+}
+
+void mixerSetTempo(Mixer* mixer, VoiceId id, float tempo)
+{
+    Voice* voice = getVoice(mixer, id);
+    if(!voice)
+        return;
+    if(tempo <= 0.f)
+    {
+        if(voice->timeStretch)
+            poolFree(&mixer->timeStretchPool, voice->timeStretch);
+        voice->timeStretch = nullptr;
+        return;
+    }
+    if(!voice->timeStretch)
+    {
+        voice->timeStretch = (TimeStretch*)poolAlloc(&mixer->timeStretchPool);
+        if(!voice->timeStretch)
+            return;
+        timeStretchReset(voice->timeStretch);
+    }
+    voice->tempo = tempo;
+}
+
+// Number of output frames, up to maxFrames, that start before pos reaches endPos
+static inline uint32_t numFramesBefore(uint64_t pos, uint64_t endPos, uint64_t step, uint32_t maxFrames)
+{
+    if(pos >= endPos)
+        return 0;
+    if(step && (endPos - pos + step - 1) / step < maxFrames)
+        return (uint32_t)((endPos - pos + step - 1) / step);
+    return maxFrames;
+}
+
+// Resample voice's clip and add up to numFrames of it into outLeft and outRight, starting
+// at gains (left and right, pan included) and changing by gainSteps every frame. SampleType is int16_t or float, sampleScale
+// brings it into the [-1, 1] range. Returns the number of frames mixed, which is less than
+// numFrames if the voice stopped or moved on to a queued clip part way through.
+// The clip is mixed in stretches where the frame after each one is the next one in the
+// clip, so the inner loop never checks for the end. Only the last frame before the end
+// of the voice's region interpolates towards the voice's seamFrame instead
+template<typename SampleType>
+static uint32_t mixVoiceSamples(Mixer* mixer, Voice* voice, float* outLeft, float* outRight, uint32_t numFrames,
+                                float sampleScale, const float* gains, const float* gainSteps)
+{
+    const AudioClip* clip = voice->clip;
+    const SampleType* samples = (SampleType*)clip->samples;
+    const uint32_t numChannels = clip->numChannels;
+    const uint64_t endPos = (uint64_t)regionEndFrame(voice) << 32;
+    const uint64_t lastContiguousPos = endPos - (1ull << 32);
+    const uint64_t step = (uint64_t)(4294967296.0 * voice->pitch * clip->sampleRate / mixer->outputSampleRate);
+
+    // Scale the samples down to [-1, 1] along with the gains
+    float leftGain = sampleScale * gains[0];
+    float rightGain = sampleScale * gains[1];
+    const float leftGainStep = sampleScale * gainSteps[0];
+    const float rightGainStep = sampleScale * gainSteps[1];
+
+    uint64_t pos = voice->playbackPos;
+    uint32_t numFramesMixed = 0;
+    while(numFramesMixed < numFrames)
+    {
+        uint32_t numContiguousFrames = numFramesBefore(pos, lastContiguousPos, step, numFrames - numFramesMixed);
+        for(uint32_t frameIndex = 0; frameIndex < numContiguousFrames; ++frameIndex)
+        {
+            // For mono clips the left and right samples are the same one
+            const SampleType* prevFrame = samples + (uint32_t)(pos >> 32) * numChannels;
+            const SampleType* nextFrame = prevFrame + numChannels;
+            float t = (uint32_t)pos * (1.f / 4294967296.f);
+            float left = prevFrame[0] + (nextFrame[0] - prevFrame[0]) * t;
+            float right = prevFrame[numChannels-1] + (nextFrame[numChannels-1] - prevFrame[numChannels-1]) * t;
+
+            *outLeft++ += left * leftGain;
+            *outRight++ += right * rightGain;
+            leftGain += leftGainStep;
+            rightGain += rightGainStep;
+            pos += step;
+        }
+        numFramesMixed += numContiguousFrames;
+
+        uint32_t numSeamFrames = numFramesBefore(pos, endPos, step, numFrames - numFramesMixed);
+        for(uint32_t frameIndex = 0; frameIndex < numSeamFrames; ++frameIndex)
+        {
+            const SampleType* prevFrame = samples + (uint32_t)(pos >> 32) * numChannels;
+            float t = (uint32_t)pos * (1.f / 4294967296.f);
+            float left = prevFrame[0] + (voice->seamFrame[0] - prevFrame[0]) * t;
+            float right = prevFrame[numChannels-1] + (voice->seamFrame[1] - prevFrame[numChannels-1]) * t;
+
+            *outLeft++ += left * leftGain;
+            *outRight++ += right * rightGain;
+            leftGain += leftGainStep;
+            rightGain += rightGainStep;
+            pos += step;
+        }
+        numFramesMixed += numSeamFrames;
+
+        if(pos >= endPos && (finishRegion(mixer, voice, &pos) || !voice->isPlaying))
+            break;
+    }
+    voice->playbackPos = pos;
+    return numFramesMixed;
+}
+
+// Fill the voice's decode buffer with the given block of its IMA-ADPCM clip
+static const int16_t* decodeAdpcmBlock(Voice* voice, uint32_t blockIndex)
+{
+    const AudioClip* clip = voice->clip;
+    const uint32_t numChannels = clip->numChannels;
+    const uint32_t clipNumFrames = clip->numSamples / numChannels;
+    int16_t* decoded = voice->decodedBlock;
+    if(voice->decodedBlockIndex == blockIndex)
+        return decoded;
+
+    const uint8_t* blocks = (const uint8_t*)clip->samples;
+    uint32_t blockStartFrame = blockIndex * clip->numFramesPerBlock;
+    uint32_t numFrames = clipNumFrames - blockStartFrame;
+    if(numFrames > clip->numFramesPerBlock)
+        numFrames = clip->numFramesPerBlock;
+    imaAdpcmDecodeBlock(blocks + blockIndex * clip->numBytesPerBlock, numChannels, numFrames, decoded);
+
+    // Add the frame after the block so interpolating never has to look outside the buffer.
+    // Every block header starts with its first frame so there's nothing to decode.
+    // The last block just repeats its last frame, nothing interpolates towards that one
+    int16_t* extraFrame = decoded + numFrames * numChannels;
+    if(blockStartFrame + numFrames < clipNumFrames)
+    {
+        const int16_t* nextFrame = (const int16_t*)(blocks + (blockIndex + 1) * clip->numBytesPerBlock);
+        for(uint32_t c = 0; c < numChannels; ++c)
+            extraFrame[c] = nextFrame[2 * c]; // Headers are 4 bytes per channel
+    }
+    else
+    {
+        const int16_t* lastFrame = extraFrame - numChannels;
+        for(uint32_t c = 0; c < numChannels; ++c)
+            extraFrame[c] = lastFrame[c];
+    }
+
+    voice->decodedBlockIndex = blockIndex;
+    return decoded;
+}
+
+// Same as mixVoiceSamples but for IMA-ADPCM clips, which we decode as we
+// go so they stay compressed in memory. Frames are mixed a block at a time
+// straight out of the decode buffer
+static uint32_t mixAdpcmVoiceSamples(Mixer* mixer, Voice* voice, float* outLeft, float* outRight, uint32_t numFrames,
+                                     const float* gains, const float* gainSteps)
+{
+    const AudioClip* clip = voice->clip;
+    const uint32_t numChannels = clip->numChannels;
+    const uint64_t endPos = (uint64_t)regionEndFrame(voice) << 32;
+    const uint64_t lastContiguousPos = endPos - (1ull << 32);
+    const uint64_t step = (uint64_t)(4294967296.0 * voice->pitch * clip->sampleRate / mixer->outputSampleRate);
+
+    float leftGain = (1.f / 32768.f) * gains[0];
+    float rightGain = (1.f / 32768.f) * gains[1];
+    const float leftGainStep = (1.f / 32768.f) * gainSteps[0];
+    const float rightGainStep = (1.f / 32768.f) * gainSteps[1];
+
+    uint64_t pos = voice->playbackPos;
+    uint32_t numFramesMixed = 0;
+    while(numFramesMixed < numFrames)
+    {
+        if(pos >= endPos)
+        {
+            if(finishRegion(mixer, voice, &pos) || !voice->isPlaying)
+                break;
+            continue;
+        }
+
+        uint32_t blockIndex = (uint32_t)(pos >> 32) / clip->numFramesPerBlock;
+        const int16_t* samples = decodeAdpcmBlock(voice, blockIndex);
+        const uint64_t blockStartPos = (uint64_t)(blockIndex * clip->numFramesPerBlock) << 32;
+        const uint64_t blockEndPos = blockStartPos + ((uint64_t)clip->numFramesPerBlock << 32);
+        uint64_t blockPos = pos - blockStartPos;
+        if(pos < lastContiguousPos)
+        {
+            // Up to the end of the block, where the frame after the last one is the
+            // start of the next block, or up to the seam, whichever comes first
+            uint32_t numFramesThisBlock = numFramesBefore(pos, blockEndPos < lastContiguousPos ? blockEndPos : lastContiguousPos,
+                                                          step, numFrames - numFramesMixed);
+            for(uint32_t frameIndex = 0; frameIndex < numFramesThisBlock; ++frameIndex)
+            {
+                const int16_t* prevFrame = samples + (uint32_t)(blockPos >> 32) * numChannels;
+                const int16_t* nextFrame = prevFrame + numChannels;
+                float t = (uint32_t)blockPos * (1.f / 4294967296.f);
+                float left = prevFrame[0] + (nextFrame[0] - prevFrame[0]) * t;
+                float right = prevFrame[numChannels-1] + (nextFrame[numChannels-1] - prevFrame[numChannels-1]) * t;
+
+                *outLeft++ += left * leftGain;
+                *outRight++ += right * rightGain;
+                leftGain += leftGainStep;
+                rightGain += rightGainStep;
+                blockPos += step;
+            }
+            pos += numFramesThisBlock * step;
+            numFramesMixed += numFramesThisBlock;
+        }
+        else
+        {
+            uint32_t numSeamFrames = numFramesBefore(pos, endPos, step, numFrames - numFramesMixed);
+            for(uint32_t frameIndex = 0; frameIndex < numSeamFrames; ++frameIndex)
+            {
+                const int16_t* prevFrame = samples + (uint32_t)(blockPos >> 32) * numChannels;
+                float t = (uint32_t)blockPos * (1.f / 4294967296.f);
+                float left = prevFrame[0] + (voice->seamFrame[0] - prevFrame[0]) * t;
+                float right = prevFrame[numChannels-1] + (voice->seamFrame[1] - prevFrame[numChannels-1]) * t;
+
+                *outLeft++ += left * leftGain;
+                *outRight++ += right * rightGain;
+                leftGain += leftGainStep;
+                rightGain += rightGainStep;
+                blockPos += step;
+            }
+            pos += numSeamFrames * step;
+            numFramesMixed += numSeamFrames;
+        }
+    }
+    voice->playbackPos = pos;
+    return numFramesMixed;
+}
+
+// Same as mixVoiceSamples but for planar float clips. Each channel is contiguous,
+// so we interpolate 4 output frames at a time with SSE. While the clip plays at
+// the output rate the source frames are contiguous as well and get loaded directly
+static uint32_t mixPlanarVoiceSamples(Mixer* mixer, Voice* voice, float* outLeft, float* outRight, uint32_t numFrames,
+                                      const float* gains, const float* gainSteps)
+{
+    const AudioClip* clip = voice->clip;
+    const float* leftSamples = (const float*)clip->samples;
+    const float* rightSamples = leftSamples + (clip->numChannels - 1) * clip->planeStride;
+    const uint64_t endPos = (uint64_t)regionEndFrame(voice) << 32;
+    const uint64_t lastContiguousPos = endPos - (1ull << 32);
+    const uint64_t step = (uint64_t)(4294967296.0 * voice->pitch * clip->sampleRate / mixer->outputSampleRate);
+
+    float leftGain = gains[0];
+    float rightGain = gains[1];
+    const float leftGainStep = gainSteps[0];
+    const float rightGainStep = gainSteps[1];
+    const __m128 frameOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    const __m128 leftGainStep4 = _mm_set1_ps(4.f * leftGainStep);
+    const __m128 rightGainStep4 = _mm_set1_ps(4.f * rightGainStep);
+    const float POS_TO_T = 1.f / 4294967296.f;
+
+    uint64_t pos = voice->playbackPos;
+    uint32_t numFramesMixed = 0;
+    while(numFramesMixed < numFrames)
+    {
+        uint32_t numContiguousFrames = numFramesBefore(pos, lastContiguousPos, step, numFrames - numFramesMixed);
+
+        __m128 leftGains = _mm_add_ps(_mm_set1_ps(leftGain), _mm_mul_ps(frameOffsets, _mm_set1_ps(leftGainStep)));
+        __m128 rightGains = _mm_add_ps(_mm_set1_ps(rightGain), _mm_mul_ps(frameOffsets, _mm_set1_ps(rightGainStep)));
+        uint32_t frameIndex = 0;
+        for(; frameIndex + 4 <= numContiguousFrames; frameIndex += 4)
+        {
+            __m128 prevLeft, nextLeft, prevRight, nextRight, t;
+            if(step == (1ull << 32))
+            {
+                const uint32_t i = (uint32_t)(pos >> 32);
+                prevLeft = _mm_loadu_ps(leftSamples + i);
+                nextLeft = _mm_loadu_ps(leftSamples + i + 1);
+                prevRight = _mm_loadu_ps(rightSamples + i);
+                nextRight = _mm_loadu_ps(rightSamples + i + 1);
+                t = _mm_set1_ps((uint32_t)pos * POS_TO_T);
+            }
+            else
+            {
+                // No gathers in SSE2, but at least every load is from one small stretch of one plane
+                const uint64_t pos1 = pos + step, pos2 = pos1 + step, pos3 = pos2 + step;
+                const uint32_t i0 = (uint32_t)(pos >> 32), i1 = (uint32_t)(pos1 >> 32);
+                const uint32_t i2 = (uint32_t)(pos2 >> 32), i3 = (uint32_t)(pos3 >> 32);
+                prevLeft = _mm_setr_ps(leftSamples[i0], leftSamples[i1], leftSamples[i2], leftSamples[i3]);
+                nextLeft = _mm_setr_ps(leftSamples[i0+1], leftSamples[i1+1], leftSamples[i2+1], leftSamples[i3+1]);
+                prevRight = _mm_setr_ps(rightSamples[i0], rightSamples[i1], rightSamples[i2], rightSamples[i3]);
+                nextRight = _mm_setr_ps(rightSamples[i0+1], rightSamples[i1+1], rightSamples[i2+1], rightSamples[i3+1]);
+                t = _mm_setr_ps((uint32_t)pos * POS_TO_T, (uint32_t)pos1 * POS_TO_T,
+                                (uint32_t)pos2 * POS_TO_T, (uint32_t)pos3 * POS_TO_T);
+            }
+            __m128 left = _mm_add_ps(prevLeft, _mm_mul_ps(_mm_sub_ps(nextLeft, prevLeft), t));
+            __m128 right = _mm_add_ps(prevRight, _mm_mul_ps(_mm_sub_ps(nextRight, prevRight), t));
+            _mm_storeu_ps(outLeft, _mm_add_ps(_mm_loadu_ps(outLeft), _mm_mul_ps(left, leftGains)));
+            _mm_storeu_ps(outRight, _mm_add_ps(_mm_loadu_ps(outRight), _mm_mul_ps(right, rightGains)));
+            leftGains = _mm_add_ps(leftGains, leftGainStep4);
+            rightGains = _mm_add_ps(rightGains, rightGainStep4);
+            outLeft += 4;
+            outRight += 4;
+            pos += 4 * step;
+        }
+        leftGain += frameIndex * leftGainStep;
+        rightGain += frameIndex * rightGainStep;
+
+        // The rest of the contiguous frames one at a time
+        for(; frameIndex < numContiguousFrames; ++frameIndex)
+        {
+            const uint32_t i = (uint32_t)(pos >> 32);
+            float t = (uint32_t)pos * POS_TO_T;
+            *outLeft++ += (leftSamples[i] + (leftSamples[i+1] - leftSamples[i]) * t) * leftGain;
+            *outRight++ += (rightSamples[i] + (rightSamples[i+1] - rightSamples[i]) * t) * rightGain;
+            leftGain += leftGainStep;
+            rightGain += rightGainStep;
+            pos += step;
+        }
+        numFramesMixed += numContiguousFrames;
+
+        uint32_t numSeamFrames = numFramesBefore(pos, endPos, step, numFrames - numFramesMixed);
+        for(uint32_t i = 0; i < numSeamFrames; ++i)
+        {
+            const uint32_t prevFrameIndex = (uint32_t)(pos >> 32);
+            float t = (uint32_t)pos * POS_TO_T;
+            float left = leftSamples[prevFrameIndex] + (voice->seamFrame[0] - leftSamples[prevFrameIndex]) * t;
+            float right = rightSamples[prevFrameIndex] + (voice->seamFrame[1] - rightSamples[prevFrameIndex]) * t;
+
+            *outLeft++ += left * leftGain;
+            *outRight++ += right * rightGain;
+            leftGain += leftGainStep;
+            rightGain += rightGainStep;
+            pos += step;
+        }
+        numFramesMixed += numSeamFrames;
+
+        if(pos >= endPos && (finishRegion(mixer, voice, &pos) || !voice->isPlaying))
+            break;
+    }
+    voice->playbackPos = pos;
+    return numFramesMixed;
+}
+
+// Mixes the voice a clip at a time, since a queued clip can be in a different format
+static void mixVoiceSegment(Mixer* mixer, Voice* voice, float* outLeft, float* outRight, uint32_t numFrames,
+                            const float* startGains, const float* gainSteps)
+{
+    float gains[2] = { startGains[0], startGains[1] };
+    while(numFrames > 0 && voice->isPlaying)
+    {
+        uint32_t numFramesMixed;
+        if(voice->clip->layout == SAMPLE_LAYOUT_PLANAR)
+            numFramesMixed = mixPlanarVoiceSamples(mixer, voice, outLeft, outRight, numFrames, gains, gainSteps);
+        else if(voice->clip->sampleFormat == SAMPLE_FORMAT_IMA_ADPCM)
+            numFramesMixed = mixAdpcmVoiceSamples(mixer, voice, outLeft, outRight, numFrames, gains, gainSteps);
+        else if(voice->clip->sampleFormat == SAMPLE_FORMAT_FLOAT)
+            numFramesMixed = mixVoiceSamples<float>(mixer, voice, outLeft, outRight, numFrames, 1.f, gains, gainSteps);
+        else
+            numFramesMixed = mixVoiceSamples<int16_t>(mixer, voice, outLeft, outRight, numFrames, 1.f / 32768.f, gains, gainSteps);
+        outLeft += numFramesMixed;
+        outRight += numFramesMixed;
+        numFrames -= numFramesMixed;
+        gains[0] += numFramesMixed * gainSteps[0];
+        gains[1] += numFramesMixed * gainSteps[1];
+    }
+}
+
+// Same as mixVoiceSegment but for voices with their own tempo. The clip is resampled at
+// the voice's pitch as usual into the time stretch's input, which then gets played back
+// at tempo / pitch input frames per output frame to bring it to the voice's tempo
+static void mixTimeStretchedVoiceSegment(Mixer* mixer, Voice* voice, float* outLeft, float* outRight, uint32_t numFrames,
+                                         const float* startGains, const float* gainSteps)
+{
+    TimeStretch* stretch = voice->timeStretch;
+    size_t scratchUsed = mixer->scratch.used;
+    float* stretchedLeft = ARENA_PUSH_ARRAY(&mixer->scratch, float, numFrames);
+    float* stretchedRight = ARENA_PUSH_ARRAY(&mixer->scratch, float, numFrames);
+    const float ratio = voice->tempo / voice->pitch;
+    const float unityGains[2] = { 1.f, 1.f };
+    const float noGainSteps[2] = { 0.f, 0.f };
+    uint32_t numFramesStretched = 0;
+    for(;;)
+    {
+        numFramesStretched += timeStretchProcess(stretch, ratio, stretchedLeft + numFramesStretched,
+                                                 stretchedRight + numFramesStretched, numFrames - numFramesStretched);
+        if(numFramesStretched == numFrames)
+            break;
+        // Once the voice has stopped the input is just silence
+        uint32_t numInputFrames = timeStretchNumInputFramesNeeded(stretch);
+        float* inputLeft;
+        float* inputRight;
+        timeStretchAddInput(stretch, numInputFrames, &inputLeft, &inputRight);
+        mixVoiceSegment(mixer, voice, inputLeft, inputRight, numInputFrames, unityGains, noGainSteps);
+    }
+
+    float leftGain = startGains[0];
+    float rightGain = startGains[1];
+    for(uint32_t i = 0; i < numFrames; ++i)
+    {
+        outLeft[i] += stretchedLeft[i] * leftGain;
+        outRight[i] += stretchedRight[i] * rightGain;
+        leftGain += gainSteps[0];
+        rightGain += gainSteps[1];
+    }
+    mixer->scratch.used = scratchUsed;
+}
+
+// Left and right gains, numFrames into the pass, for a voice whose pan gains
+// move linearly to their targets over the numPassFrames frames of the pass
+static void panGainsAt(const Voice* voice, uint32_t numFrames, uint32_t numPassFrames, float* panGains)
+{
+    float t = (float)numFrames / numPassFrames;
+    panGains[0] = voice->panGains[0] + (voice->targetPanGains[0] - voice->panGains[0]) * t;
+    panGains[1] = voice->panGains[1] + (voice->targetPanGains[1] - voice->panGains[1]) * t;
+}
+
+// Mixes frames startFrame to endFrame of the pass with the voice's gain going
+// linearly from startGain to endGain, and its pan gains moving towards their targets
+static void mixVoiceRange(Mixer* mixer, Voice* voice, uint32_t startFrame, uint32_t endFrame, uint32_t numPassFrames,
+                          float startGain, float endGain)
+{
+    float startPanGains[2], endPanGains[2];
+    panGainsAt(voice, startFrame, numPassFrames, startPanGains);
+    panGainsAt(voice, endFrame, numPassFrames, endPanGains);
+    const float numFrames = (float)(endFrame - startFrame);
+    // Both ramping at once isn't quite linear, but it's close enough over one pass
+    const float gains[2] = { startGain * startPanGains[0], startGain * startPanGains[1] };
+    const float gainSteps[2] = { (endGain * endPanGains[0] - gains[0]) / numFrames,
+                                 (endGain * endPanGains[1] - gains[1]) / numFrames };
+    if(voice->timeStretch)
+        mixTimeStretchedVoiceSegment(mixer, voice, mixer->voiceBuffer[0] + startFrame, mixer->voiceBuffer[1] + startFrame,
+                                     endFrame - startFrame, gains, gainSteps);
+    else
+        mixVoiceSegment(mixer, voice, mixer->voiceBuffer[0] + startFrame, mixer->voiceBuffer[1] + startFrame,
+                        endFrame - startFrame, gains, gainSteps);
+}
+
+// Add the voice buffer into the mix, and into the reverb send if sendGain isn't 0.
+// The reverb is mono in, so the send gets the average of both channels
+static void addVoiceToMix(Mixer* mixer, uint32_t numFrames, float sendGain)
+{
+    const float* voiceLeft = mixer->voiceBuffer[0];
+    const float* voiceRight = mixer->voiceBuffer[1];
+    float* mixLeft = mixer->mixBuffer[0];
+    float* mixRight = mixer->mixBuffer[1];
+    float* send = mixer->reverbSendBuffer;
+    const float halfSendGain = 0.5f * sendGain;
+    const __m128 sendScale = _mm_set1_ps(halfSendGain);
+    uint32_t i = 0;
+    for(; i + 4 <= numFrames; i += 4)
+    {
+        __m128 left = _mm_load_ps(voiceLeft + i);
+        __m128 right = _mm_load_ps(voiceRight + i);
+        _mm_store_ps(mixLeft + i, _mm_add_ps(_mm_load_ps(mixLeft + i), left));
+        _mm_store_ps(mixRight + i, _mm_add_ps(_mm_load_ps(mixRight + i), right));
+        if(sendGain != 0.f)
+            _mm_store_ps(send + i, _mm_add_ps(_mm_load_ps(send + i), _mm_mul_ps(_mm_add_ps(left, right), sendScale)));
+    }
+    for(; i < numFrames; ++i)
+    {
+        mixLeft[i] += voiceLeft[i];
+        mixRight[i] += voiceRight[i];
+        send[i] += (voiceLeft[i] + voiceRight[i]) * halfSendGain;
+    }
+}
+
+// Same as addVoiceToMix but for positioned voices in a 5.1 or 7.1 mix. Where the voice
+// is decides which speakers it comes out of, so its left and right are averaged and that
+// goes to each speaker with the speaker's gain moving to its target over the pass.
+// The reverb send is scaled by the voice's overall level across the speakers, so
+// it's the same as a voice straight ahead in stereo and falls off with distance too
+static void addVoiceToSurroundMix(Mixer* mixer, Voice* voice, uint32_t numFrames)
+{
+    float* mono = mixer->voiceBuffer[0];
+    const float* voiceRight = mixer->voiceBuffer[1];
+    const __m128 half = _mm_set1_ps(0.5f);
+    uint32_t i = 0;
+    for(; i + 4 <= numFrames; i += 4)
+        _mm_store_ps(mono + i, _mm_mul_ps(_mm_add_ps(_mm_load_ps(mono + i), _mm_load_ps(voiceRight + i)), half));
+    for(; i < numFrames; ++i)
+        mono[i] = 0.5f * (mono[i] + voiceRight[i]);
+
+    const __m128 frameOffsets = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+    float sumOfSquares = 0.f;
+    for(uint32_t channel = 0; channel < mixer->numMixChannels; ++channel)
+    {
+        const float targetGain = voice->targetSpeakerGains[channel];
+        float gain = voice->speakerGains[channel];
+        voice->speakerGains[channel] = targetGain;
+        sumOfSquares += targetGain * targetGain;
+        // Most speakers are silent for any one voice, e.g. the LFE and everything but the nearest two
+        if(gain == 0.f && targetGain == 0.f)
+            continue;
+        float* mix = mixer->mixBuffer[channel];
+        const float gainStep = (targetGain - gain) / numFrames;
+        __m128 gains = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(frameOffsets, _mm_set1_ps(gainStep)));
+        const __m128 gainStep4 = _mm_set1_ps(4.f * gainStep);
+        i = 0;
+        for(; i + 4 <= numFrames; i += 4)
+        {
+            _mm_store_ps(mix + i, _mm_add_ps(_mm_load_ps(mix + i), _mm_mul_ps(_mm_load_ps(mono + i), gains)));
+            gains = _mm_add_ps(gains, gainStep4);
+        }
+        gain += i * gainStep;
+        for(; i < numFrames; ++i, gain += gainStep)
+            mix[i] += mono[i] * gain;
+    }
+
+    if(voice->reverbSend == 0.f)
+        return;
+    float* send = mixer->reverbSendBuffer;
+    const float sendGain = voice->reverbSend * (float)M_SQRT1_2 * sqrtf(sumOfSquares);
+    for(i = 0; i < numFrames; ++i)
+        send[i] += mono[i] * sendGain;
+}
+
+static void mixVoice(Mixer* mixer, Voice* voice, uint32_t numFrames)
+{
+    // A voice that finishes part way through leaves the rest silent
+    memset(mixer->voiceBuffer[0], 0, numFrames * sizeof(float));
+    memset(mixer->voiceBuffer[1], 0, numFrames * sizeof(float));
+    // Mix any remaining part of a gain ramp separately so the
+    // rest of the pass has one straight line of gains
+    uint32_t numRampFrames = 0;
+    if(voice->numGainRampFramesLeft > 0)
+    {
+        numRampFrames = numFrames < voice->numGainRampFramesLeft ? numFrames : voice->numGainRampFramesLeft;
+        float gainStep = (voice->gainRampTarget - voice->gain) / voice->numGainRampFramesLeft;
+        float endGain = voice->numGainRampFramesLeft > numRampFrames ? voice->gain + gainStep * numRampFrames : voice->gainRampTarget;
+        mixVoiceRange(mixer, voice, 0, numRampFrames, numFrames, voice->gain, endGain);
+
+        voice->numGainRampFramesLeft -= numRampFrames;
+        voice->gain = endGain;
+    }
+    if(numRampFrames < numFrames && voice->isPlaying)
+        mixVoiceRange(mixer, voice, numRampFrames, numFrames, numFrames, voice->gain, voice->gain);
+    voice->panGains[0] = voice->targetPanGains[0];
+    voice->panGains[1] = voice->targetPanGains[1];
+
+    effectChainProcess(&voice->effects, mixer->voiceBuffer[0], mixer->voiceBuffer[1], numFrames);
+    if(voice->emitterIndex != SPATIAL_NO_EMITTER && mixer->speakerLayout != SPEAKER_LAYOUT_STEREO)
+        addVoiceToSurroundMix(mixer, voice, numFrames);
+    else
+        addVoiceToMix(mixer, numFrames, voice->reverbSend);
+}
+
+void mixerSetOutputFormat(Mixer* mixer, const AudioOutputFormat* format)
+{
+    assert(format->sampleRate == mixer->outputSampleRate);
+    mixer->outputFormat = *format;
+    mixer->mixWriter = chooseMixWriter(format);
+    assert(mixer->mixWriter);
+    SpeakerLayout speakerLayout = speakerLayoutForOutput(format->numChannels, format->channelMask);
+    if(speakerLayout == mixer->speakerLayout && mixer->numMixChannels)
+        return;
+    mixer->speakerLayout = speakerLayout;
+    mixer->numMixChannels = speakerLayoutNumChannels(speakerLayout);
+    // Positioned voices swap between pan gains and speaker gains, so
+    // they jump to the new ones rather than sweeping from the old
+    for(uint32_t i = 0; i < mixer->emitters.numEmitters; ++i)
+        mixer->voices[mixer->emitterVoices[i]].snapPanGains = true;
+}
+
+void mixerRender(Mixer* mixer, void* output, uint32_t numFrames)
+{
+    uint8_t* dest = (uint8_t*)output;
+    while(numFrames > 0)
+    {
+        uint32_t numFramesThisPass = numFrames < MIXER_MAX_FRAMES_PER_PASS ? numFrames : MIXER_MAX_FRAMES_PER_PASS;
+        arenaReset(&mixer->scratch);
+        for(uint32_t channel = 0; channel < mixer->numMixChannels; ++channel)
+            memset(mixer->mixBuffer[channel], 0, numFramesThisPass * sizeof(float));
+        memset(mixer->reverbSendBuffer, 0, numFramesThisPass * sizeof(float));
+        updateEmitters(mixer);
+
+        for(uint32_t i = 0; i < MIXER_MAX_VOICES; ++i)
+        {
+            Voice* voice = &mixer->voices[i];
+            if(!voice->isPlaying)
+                continue;
+            mixVoice(mixer, voice, numFramesThisPass);
+            if(!voice->isPlaying) // Reached the end of a non-looping clip
+                freeVoice(mixer, voice);
+        }
+
+        reverbProcess(&mixer->reverb, mixer->reverbSendBuffer, mixer->mixBuffer[0], mixer->mixBuffer[1], numFramesThisPass);
+        const float* mixChannels[SPATIAL_MAX_CHANNELS];
+        for(uint32_t channel = 0; channel < mixer->numMixChannels; channel += 2)
+        {
+            effectChainProcess(&mixer->masterEffects[channel / 2], mixer->mixBuffer[channel], mixer->mixBuffer[channel + 1],
+                               numFramesThisPass);
+            mixChannels[channel] = mixer->mixBuffer[channel];
+            mixChannels[channel + 1] = mixer->mixBuffer[channel + 1];
+        }
+        loudnessMeterProcess(&mixer->masterMeter, mixer->mixBuffer[0], mixer->mixBuffer[1], numFramesThisPass);
+        mixer->mixWriter(mixChannels, mixer->numMixChannels, dest, numFramesThisPass, mixer->outputFormat.numChannels);
+        dest += numFramesThisPass * mixer->outputFormat.numBytesPerFrame;
+        numFrames -= numFramesThisPass;
+        mixer->numFramesRendered += numFramesThisPass;
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#include "Allocators.h"
+#include "Effects.h"
+#include "ImaAdpcm.h"
+#include "LoadWavFile.h"
+#include "Loudness.h"
+#include "OutputFormat.h"
+#include "Spatial.h"
+#include "TimeStretch.h"
+
+// Max number of sounds that can play at once. All voices are
+// allocated up front so playing a sound never allocates memory
+#define MIXER_MAX_VOICES 256
+// Max number of frames we mix in one go. Bigger requests get split up
+#define MIXER_MAX_FRAMES_PER_PASS 1024
+// Max number of clips waiting to play after a voice's current one
+#define MIXER_MAX_QUEUED_CLIPS 4
+// Max number of voices that can play IMA-ADPCM clips at once, since each one
+// needs its own decode buffer. Playing more fails like running out of voices
+#define MIXER_MAX_ADPCM_VOICES 64
+// The current block plus the first frame of the one after it, in 16-bit
+// samples. Rounded up so every buffer in the pool stays 64-byte aligned
+#define MIXER_DECODE_BUFFER_SIZE ((2 * (IMA_ADPCM_MAX_FRAMES_PER_BLOCK + 1) + 31) & ~31)
+// Max number of voices with a tempo separate from their pitch, see mixerSetTempo()
+#define MIXER_MAX_TIME_STRETCH_VOICES 32
+// Memory for anything the mixer only needs during one pass
+#define MIXER_SCRATCH_SIZE (64 * 1024)
+
+// Identifies a playing voice. Contains a generation count so that
+// using the id of a voice that has since finished does nothing
+typedef uint32_t VoiceId;
+#define INVALID_VOICE_ID 0xFFFFFFFF
+
+// A clip that plays straight after the one before it, see mixerQueueClip()
+struct QueuedClip {
+    const AudioClip* clip;
+    bool looping;
+    std::atomic<uint32_t>* clipUseCount;
+};
+
+struct Voice {
+    const AudioClip* clip;
+    uint64_t playbackPos; // 32.32 fixed-point frame index into clip
+    float gain;
+    float gainRampTarget;
+    uint32_t numGainRampFramesLeft; // 0 if the gain isn't ramping
+    // Left and right gains from panning or the voice's position. They move
+    // from panGains to targetPanGains over each pass so changes don't click
+    float panGains[2];
+    float targetPanGains[2];
+    float pitch; // Playback speed, 2 is twice as fast and an octave up
+    // From Mixer::timeStretchPool, only for voices whose tempo doesn't follow their pitch
+    TimeStretch* timeStretch;
+    float tempo; // Only used with timeStretch
+    bool isLooping; // Loops the clip's loop region until released
+    bool isPlaying;
+    uint16_t generation;
+    // From Mixer::decodeBufferPool, only for voices that play an IMA-ADPCM clip
+    int16_t* decodedBlock;
+    // Which block of an IMA-ADPCM clip is in decodedBlock
+    uint32_t decodedBlockIndex;
+    EffectChain effects; // e.g. a low-pass filter when the sound is occluded
+    float reverbSend; // How much of the voice goes to the reverb
+    // Optional, decremented when the voice stops so the owner
+    // of the clip knows when it's safe to unload it
+    std::atomic<uint32_t>* clipUseCount;
+    // Clips to play when this one ends, in order
+    QueuedClip queuedClips[MIXER_MAX_QUEUED_CLIPS];
+    uint32_t numQueuedClips;
+    // What to interpolate the last frame before the voice loops, moves on to the
+    // next clip or stops towards: the loop start, the start of the next clip or the
+    // last frame again. Worked out whenever that changes so the mixing loops never
+    // have to check for the end of the clip, in the same units as clip's samples
+    float seamFrame[2];
+    // Index into Mixer::emitters, or SPATIAL_NO_EMITTER if the voice isn't positioned
+    uint32_t emitterIndex;
+    bool snapPanGains; // Jump straight to the first gains from the voice's position
+    // For positioned voices in a 5.1 or 7.1 mix, which leaves their pan gains at 1: the gain
+    // in each speaker, moving from speakerGains to targetSpeakerGains over each pass
+    float speakerGains[SPATIAL_MAX_CHANNELS];
+    float targetSpeakerGains[SPATIAL_MAX_CHANNELS];
+};
+
+struct Mixer {
+    uint32_t outputSampleRate;
+    // What mixerRender writes, and the writer chosen for it
+    AudioOutputFormat outputFormat;
+    MixWriter mixWriter;
+    // The speakers positioned voices are panned over, from the output's channels,
+    // and how many channels the mix has. Stereo unless the output is 5.1 or 7.1
+    SpeakerLayout speakerLayout;
+    uint32_t numMixChannels;
+    uint64_t numFramesRendered; // Sample clock that scheduled commands are timed against
+    Voice voices[MIXER_MAX_VOICES];
+    // Stack of indices of voices that aren't playing
+    uint16_t freeVoices[MIXER_MAX_VOICES];
+    uint32_t numFreeVoices;
+    // Each voice is rendered into voiceBuffer and run through its effects,
+    // then summed into mixBuffer and reverbSendBuffer. The reverb output
+    // goes into mixBuffer too, then the master effects run on the lot.
+    // All de-interleaved: one buffer for the left channel and one for the right,
+    // and the mix has one for each of its numMixChannels in the output's order.
+    // Unpositioned voices and the reverb only go to the front left and right
+    alignas(16) float voiceBuffer[2][MIXER_MAX_FRAMES_PER_PASS];
+    alignas(16) float mixBuffer[SPATIAL_MAX_CHANNELS][MIXER_MAX_FRAMES_PER_PASS];
+    alignas(16) float reverbSendBuffer[MIXER_MAX_FRAMES_PER_PASS];
+    Reverb reverb;
+    // One chain for each pair of mix channels, all with the same effects
+    EffectChain masterEffects[SPATIAL_MAX_CHANNELS / 2];
+    // Reset at the start of every pass. The audio thread never
+    // touches the system heap, so temporary buffers come from here
+    MemoryArena scratch;
+    alignas(64) uint8_t scratchMemory[MIXER_SCRATCH_SIZE];
+    // IMA-ADPCM clips are decoded a block at a time as they play, into a
+    // buffer from this pool that the voice keeps until it stops
+    MemoryPool decodeBufferPool;
+    alignas(64) int16_t decodeBuffers[MIXER_MAX_ADPCM_VOICES][MIXER_DECODE_BUFFER_SIZE];
+    MemoryPool timeStretchPool;
+    alignas(64) TimeStretch timeStretches[MIXER_MAX_TIME_STRETCH_VOICES];
+    // Positioned voices, all spatialised together once per pass
+    SpatialListener listener;
+    SpatialEmitters emitters;
+    uint16_t emitterVoices[SPATIAL_MAX_EMITTERS]; // Which voice each emitter belongs to
+    // Measures the final mix after the master effects, only the front left
+    // and right of a 5.1 or 7.1 one. Audio thread only
+    LoudnessMeter masterMeter;
+};
+
+// Renders interleaved 16-bit stereo until mixerSetOutputFormat says otherwise
+void mixerInit(Mixer* mixer, uint32_t outputSampleRate);
+// Renders straight into format from now on, e.g. the device's mix format, mixing in
+// 5.1 or 7.1 if that's what it is. Its sample rate has to be the one the mixer was initialised with
+void mixerSetOutputFormat(Mixer* mixer, const AudioOutputFormat* format);
+// Returns INVALID_VOICE_ID if all voices (or IMA-ADPCM decode buffers) are in use. If clipUseCount is given
+// it gets decremented once the voice stops, including if it fails to start
+VoiceId mixerPlay(Mixer* mixer, const AudioClip* clip, float gain, float pan, float pitch, bool looping,
+                  std::atomic<uint32_t>* clipUseCount = nullptr);
+void mixerStop(Mixer* mixer, VoiceId id);
+// Stops a looping voice looping. It plays on from where it is to the end
+// of the clip, so sounds with a sustain loop can play their release part
+void mixerRelease(Mixer* mixer, VoiceId id);
+// Plays clip straight after the voice's current clip (and any already queued)
+// without a gap, e.g. a music intro followed by a looping part. The voice keeps
+// its gain, pan, pitch and effects. Returns false if the voice has stopped, its queue
+// is full or there's no decode buffer for an IMA-ADPCM clip, in which case clipUseCount
+// gets decremented like in mixerPlay
+bool mixerQueueClip(Mixer* mixer, VoiceId id, const AudioClip* clip, bool looping,
+                    std::atomic<uint32_t>* clipUseCount = nullptr);
+void mixerSetGain(Mixer* mixer, VoiceId id, float gain);
+// Linearly moves the voice's gain to targetGain over the next numFrames frames
+void mixerRampGain(Mixer* mixer, VoiceId id, float targetGain, uint32_t numFrames);
+// Sets slot (less than EFFECT_CHAIN_MAX_EFFECTS) of the voice's effect chain. EFFECT_NONE removes it
+void mixerSetEffect(Mixer* mixer, VoiceId id, uint32_t slot, const EffectParams* params);
+void mixerSetReverbSend(Mixer* mixer, VoiceId id, float send);
+// Same as mixerSetEffect but for the effects on the final mix. The
+// last slot starts out with a limiter to stop the mix from clipping
+void mixerSetMasterEffect(Mixer* mixer, uint32_t slot, const EffectParams* params);
+// -1 is fully left, 1 is fully right. Overrides any position the voice had
+void mixerSetPan(Mixer* mixer, VoiceId id, float pan);
+// The listener starts at the origin facing along z with y up
+void mixerSetListener(Mixer* mixer, const SpatialListener* listener);
+// Pans and attenuates the voice from where it is relative to the listener, from the next pass on
+void mixerSetPosition(Mixer* mixer, VoiceId id, float x, float y, float z);
+// Only for voices that have a position
+void mixerSetAttenuation(Mixer* mixer, VoiceId id, AttenuationCurve curve, float minDistance, float maxDistance, float rolloff);
+void mixerSetPitch(Mixer* mixer, VoiceId id, float pitch);
+// Plays the voice at tempo (2 is twice as fast) whatever its pitch, e.g. to slow
+// music down without it going lower, or an engine sound whose pitch follows its RPM.
+// Tempo over pitch has to be between TIME_STRETCH_MIN_RATIO and TIME_STRETCH_MAX_RATIO, and
+// once a stretched voice ends the last ~30ms of its clip gets cut off. Does nothing if
+// MIXER_MAX_TIME_STRETCH_VOICES are already stretched. 0 goes back to tempo following pitch
+void mixerSetTempo(Mixer* mixer, VoiceId id, float tempo);
+// Mixes all playing voices into numFrames of output in the mixer's output format
+void mixerRender(Mixer* mixer, void* output, uint32_t numFrames);
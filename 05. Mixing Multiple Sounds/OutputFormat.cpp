@@ -0,0 +1,235 @@
+#include "OutputFormat.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <emmintrin.h> // SSE2
+
+// Mix writers for every output format, each one a template instantiated for its
+// sample type and channel count, so the choice is made once per stream rather
+// than per sample. Stereo int16 and float, the formats nearly every device
+// uses, get hand-written SSE2 versions
+// For illustrative purposes only, no warranty is implied
+// References:
+// https://learn.microsoft.com/en-us/windows/win32/api/mmreg/ns-mmreg-waveformatextensible
+// https://learn.microsoft.com/en-us/windows/win32/api/audioclient/nf-audioclient-iaudioclient-getmixformat
+
+// Same values as the WAVE_FORMAT_ tags in mmreg.h
+#define WAVE_FORMAT_TAG_PCM 0x0001
+#define WAVE_FORMAT_TAG_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_TAG_EXTENSIBLE 0xFFFE
+
+static uint16_t readU16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+AudioOutputFormat audioOutputFormatInt16Stereo(uint32_t sampleRate)
+{
+    AudioOutputFormat format;
+    format.sampleType = OUTPUT_SAMPLE_INT16;
+    format.numChannels = 2;
+    format.sampleRate = sampleRate;
+    format.numBytesPerFrame = 2 * sizeof(int16_t);
+    format.channelMask = 0x3; // SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT
+    return format;
+}
+
+bool audioOutputFormatFromWaveFormat(const void* waveFormat, uint32_t waveFormatSize, AudioOutputFormat* format)
+{
+    const uint8_t* bytes = (const uint8_t*)waveFormat;
+    if(waveFormatSize < 16)
+        return false;
+    uint32_t formatTag = readU16(bytes);
+    uint32_t numChannels = readU16(bytes + 2);
+    uint32_t sampleRate = readU32(bytes + 4);
+    uint32_t blockAlign = readU16(bytes + 12);
+    uint32_t numBitsPerSample = readU16(bytes + 14);
+    uint32_t channelMask = 0;
+    if(formatTag == WAVE_FORMAT_TAG_EXTENSIBLE)
+    {
+        // The real format is in SubFormat, a GUID that starts with the WAVE_FORMAT_
+        // tag for the basic formats (KSDATAFORMAT_SUBTYPE_PCM and _IEEE_FLOAT)
+        static const uint8_t BASE_GUID[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        if(waveFormatSize < 40 || readU16(bytes + 16) < 22 || memcmp(bytes + 28, BASE_GUID, sizeof(BASE_GUID)) != 0)
+            return false;
+        formatTag = readU32(bytes + 24);
+        channelMask = readU32(bytes + 20);
+    }
+    if(numChannels == 0 || numChannels > OUTPUT_MAX_CHANNELS || sampleRate == 0
+       || blockAlign != numChannels * numBitsPerSample / 8)
+        return false;
+
+    if(formatTag == WAVE_FORMAT_TAG_PCM && numBitsPerSample == 16)
+        format->sampleType = OUTPUT_SAMPLE_INT16;
+    else if(formatTag == WAVE_FORMAT_TAG_PCM && numBitsPerSample == 24)
+        format->sampleType = OUTPUT_SAMPLE_INT24;
+    else if(formatTag == WAVE_FORMAT_TAG_PCM && numBitsPerSample == 32)
+        format->sampleType = OUTPUT_SAMPLE_INT32;
+    else if(formatTag == WAVE_FORMAT_TAG_IEEE_FLOAT && numBitsPerSample == 32)
+        format->sampleType = OUTPUT_SAMPLE_FLOAT32;
+    else
+        return false;
+    format->numChannels = numChannels;
+    format->sampleRate = sampleRate;
+    format->numBytesPerFrame = blockAlign;
+    format->channelMask = channelMask;
+    return true;
+}
+
+struct Int24 {
+    uint8_t bytes[3];
+};
+
+static inline float clampMixSample(float sample)
+{
+    if(sample > 1.f) sample = 1.f;
+    if(sample < -1.f) sample = -1.f;
+    return sample;
+}
+
+template<typename SampleType>
+static inline SampleType convertMixSample(float sample);
+
+template<>
+inline int16_t convertMixSample<int16_t>(float sample)
+{
+    return (int16_t)lrintf(clampMixSample(sample) * 32767.f);
+}
+
+template<>
+inline Int24 convertMixSample<Int24>(float sample)
+{
+    int32_t value = (int32_t)lrintf(clampMixSample(sample) * 8388607.f);
+    Int24 result = { { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16) } };
+    return result;
+}
+
+template<>
+inline int32_t convertMixSample<int32_t>(float sample)
+{
+    // Full scale doesn't fit in a float's 24 bits of precision
+    return (int32_t)lrint(clampMixSample(sample) * 2147483647.0);
+}
+
+template<>
+inline float convertMixSample<float>(float sample)
+{
+    return clampMixSample(sample);
+}
+
+// NumChannels is 0 for channel counts that aren't worth a version of their own.
+// Goes a channel at a time, so the inner loop doesn't have to pick where each sample comes from
+template<typename SampleType, uint32_t NumChannels>
+static void writeMix(const float* const* mix, uint32_t numMixChannels, void* output, uint32_t numFrames, uint32_t numChannels)
+{
+    SampleType* dest = (SampleType*)output;
+    const uint32_t stride = NumChannels ? NumChannels : numChannels;
+    assert(numMixChannels == 2 || numMixChannels == stride);
+    if(stride == 1)
+    {
+        for(uint32_t i = 0; i < numFrames; ++i)
+            dest[i] = convertMixSample<SampleType>(0.5f * (mix[0][i] + mix[1][i]));
+        return;
+    }
+    const SampleType silence = convertMixSample<SampleType>(0.f);
+    for(uint32_t channel = 0; channel < stride; ++channel)
+    {
+        SampleType* channelDest = dest + channel;
+        if(channel < numMixChannels)
+        {
+            const float* source = mix[channel];
+            for(uint32_t i = 0; i < numFrames; ++i)
+                channelDest[i * stride] = convertMixSample<SampleType>(source[i]);
+        }
+        else
+        {
+            for(uint32_t i = 0; i < numFrames; ++i)
+                channelDest[i * stride] = silence;
+        }
+    }
+}
+
+// Clamp float samples to [-1, 1], convert to 16-bit and interleave, 4 frames at a time
+template<>
+void writeMix<int16_t, 2>(const float* const* mix, uint32_t, void* output, uint32_t numFrames, uint32_t)
+{
+    const float* left = mix[0];
+    const float* right = mix[1];
+    int16_t* dest = (int16_t*)output;
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 minusOne = _mm_set1_ps(-1.f);
+    const __m128 scale = _mm_set1_ps(32767.f);
+    uint32_t i = 0;
+    for(; i + 4 <= numFrames; i += 4)
+    {
+        __m128 l = _mm_load_ps(left + i);
+        __m128 r = _mm_load_ps(right + i);
+        l = _mm_mul_ps(_mm_min_ps(_mm_max_ps(l, minusOne), one), scale);
+        r = _mm_mul_ps(_mm_min_ps(_mm_max_ps(r, minusOne), one), scale);
+        __m128i l32 = _mm_cvtps_epi32(l);
+        __m128i r32 = _mm_cvtps_epi32(r);
+        // L0 R0 L1 R1 and L2 R2 L3 R3
+        __m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(l32, r32), _mm_unpackhi_epi32(l32, r32));
+        _mm_storeu_si128((__m128i*)(dest + 2 * i), packed);
+    }
+    for(; i < numFrames; ++i)
+    {
+        dest[2 * i] = convertMixSample<int16_t>(left[i]);
+        dest[2 * i + 1] = convertMixSample<int16_t>(right[i]);
+    }
+}
+
+// Same for float, which only needs clamping and interleaving
+template<>
+void writeMix<float, 2>(const float* const* mix, uint32_t, void* output, uint32_t numFrames, uint32_t)
+{
+    const float* left = mix[0];
+    const float* right = mix[1];
+    float* dest = (float*)output;
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 minusOne = _mm_set1_ps(-1.f);
+    uint32_t i = 0;
+    for(; i + 4 <= numFrames; i += 4)
+    {
+        __m128 l = _mm_min_ps(_mm_max_ps(_mm_load_ps(left + i), minusOne), one);
+        __m128 r = _mm_min_ps(_mm_max_ps(_mm_load_ps(right + i), minusOne), one);
+        _mm_storeu_ps(dest + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(dest + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+    for(; i < numFrames; ++i)
+    {
+        dest[2 * i] = convertMixSample<float>(left[i]);
+        dest[2 * i + 1] = convertMixSample<float>(right[i]);
+    }
+}
+
+template<typename SampleType>
+static MixWriter chooseMixWriterForChannels(uint32_t numChannels)
+{
+    switch(numChannels)
+    {
+        case 1: return writeMix<SampleType, 1>;
+        case 2: return writeMix<SampleType, 2>;
+        case 6: return writeMix<SampleType, 6>; // 5.1
+        case 8: return writeMix<SampleType, 8>; // 7.1
+        default: return writeMix<SampleType, 0>;
+    }
+}
+
+MixWriter chooseMixWriter(const AudioOutputFormat* format)
+{
+    switch(format->sampleType)
+    {
+        case OUTPUT_SAMPLE_INT16: return chooseMixWriterForChannels<int16_t>(format->numChannels);
+        case OUTPUT_SAMPLE_INT24: return chooseMixWriterForChannels<Int24>(format->numChannels);
+        case OUTPUT_SAMPLE_INT32: return chooseMixWriterForChannels<int32_t>(format->numChannels);
+        case OUTPUT_SAMPLE_FLOAT32: return chooseMixWriterForChannels<float>(format->numChannels);
+    }
+    return nullptr;
+}
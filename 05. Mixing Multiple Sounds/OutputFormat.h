@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+// The sample formats the mixer can write straight into a device buffer
+enum OutputSampleType {
+    OUTPUT_SAMPLE_INT16,
+    OUTPUT_SAMPLE_INT24, // Packed into 3 bytes
+    OUTPUT_SAMPLE_INT32, // Also 24-bit samples in a 32-bit container, since they're left-justified
+    OUTPUT_SAMPLE_FLOAT32,
+};
+
+#define OUTPUT_MAX_CHANNELS 8
+
+// What the output wants, usually the shared-mode engine's own mix format
+// (float at 48kHz on most machines), so there's nothing left for Windows to convert
+struct AudioOutputFormat {
+    OutputSampleType sampleType;
+    uint32_t numChannels;
+    uint32_t sampleRate;
+    uint32_t numBytesPerFrame;
+    // Which speaker each channel is, as in WAVEFORMATEXTENSIBLE. 0 if the format didn't say
+    uint32_t channelMask;
+};
+
+// Interleaved 16-bit stereo, which every device takes with AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM
+AudioOutputFormat audioOutputFormatInt16Stereo(uint32_t sampleRate);
+
+// Reads a WAVEFORMATEX, or a WAVEFORMATEXTENSIBLE if its cbSize says so, from
+// memory as IAudioClient::GetMixFormat returns it (the same layout as a wav
+// file's fmt chunk). Doesn't need any Windows headers, so any format can be tried out.
+// Returns false if the mixer can't write it, e.g. 8-bit or 64-bit float
+bool audioOutputFormatFromWaveFormat(const void* waveFormat, uint32_t waveFormatSize, AudioOutputFormat* format);
+
+// Interleaves the mix's numMixChannels channels into numFrames of output. The mix is either
+// stereo or already in the output's channel order, e.g. 5.1 for a 5.1 device. Mono outputs get
+// a stereo mix's two channels mixed together, outputs with more channels than the mix get it
+// on the first ones (front left and right for a stereo mix) and silence on the rest
+typedef void (*MixWriter)(const float* const* mix, uint32_t numMixChannels, void* output, uint32_t numFrames,
+                          uint32_t numChannels);
+
+// Picks the writer for the format once, when the stream starts
+MixWriter chooseMixWriter(const AudioOutputFormat* format);
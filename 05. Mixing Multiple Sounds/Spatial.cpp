@@ -0,0 +1,227 @@
+#include "Spatial.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <assert.h>
+#include <emmintrin.h> // SSE2
+
+// For illustrative purposes only, no warranty is implied
+// References:
+// Ville Pulkki, Virtual Sound Source Positioning Using Vector Base Amplitude Panning
+// ITU-R BS.775 for the speaker angles
+
+#define SPEAKER_LFE -1.f // Not a direction, never gets panned to
+
+// Clockwise from straight ahead in degrees, indexed by channel
+static const float STEREO_AZIMUTHS[] = { -30.f, 30.f };
+static const float SURROUND_5_1_AZIMUTHS[] = { -30.f, 30.f, 0.f, SPEAKER_LFE, -110.f, 110.f };
+static const float SURROUND_7_1_AZIMUTHS[] = { -30.f, 30.f, 0.f, SPEAKER_LFE, -150.f, 150.f, -90.f, 90.f };
+
+uint32_t speakerLayoutNumChannels(SpeakerLayout layout)
+{
+    switch(layout)
+    {
+        case SPEAKER_LAYOUT_STEREO: return 2;
+        case SPEAKER_LAYOUT_5_1: return 6;
+        case SPEAKER_LAYOUT_7_1: return 8;
+    }
+    return 2;
+}
+
+SpeakerLayout speakerLayoutForOutput(uint32_t numChannels, uint32_t channelMask)
+{
+    // KSAUDIO_SPEAKER_5POINT1 has back surrounds and _5POINT1_SURROUND side ones, but both
+    // put them in the last two channels. Without a mask 6 and 8 channels are taken to be the usual ones
+    if(numChannels == 6 && (channelMask == 0 || channelMask == 0x3F || channelMask == 0x60F))
+        return SPEAKER_LAYOUT_5_1;
+    // KSAUDIO_SPEAKER_7POINT1_SURROUND. The old _7POINT1 has front left and right of centre instead
+    if(numChannels == 8 && (channelMask == 0 || channelMask == 0x63F))
+        return SPEAKER_LAYOUT_7_1;
+    return SPEAKER_LAYOUT_STEREO;
+}
+
+void spatialInit(SpatialEmitters* emitters)
+{
+    emitters->numEmitters = 0;
+}
+
+uint32_t spatialAddEmitter(SpatialEmitters* emitters)
+{
+    if(emitters->numEmitters == SPATIAL_MAX_EMITTERS)
+        return SPATIAL_NO_EMITTER;
+    uint32_t index = emitters->numEmitters++;
+    spatialSetPosition(emitters, index, 0.f, 0.f, 0.f);
+    spatialSetAttenuation(emitters, index, ATTENUATION_INVERSE, 1.f, 100.f, 1.f);
+    return index;
+}
+
+void spatialRemoveEmitter(SpatialEmitters* emitters, uint32_t index)
+{
+    assert(index < emitters->numEmitters);
+    uint32_t last = --emitters->numEmitters;
+    emitters->positionX[index] = emitters->positionX[last];
+    emitters->positionY[index] = emitters->positionY[last];
+    emitters->positionZ[index] = emitters->positionZ[last];
+    emitters->minDistance[index] = emitters->minDistance[last];
+    emitters->maxDistance[index] = emitters->maxDistance[last];
+    emitters->rolloff[index] = emitters->rolloff[last];
+    emitters->isLinear[index] = emitters->isLinear[last];
+}
+
+void spatialSetPosition(SpatialEmitters* emitters, uint32_t index, float x, float y, float z)
+{
+    assert(index < emitters->numEmitters);
+    emitters->positionX[index] = x;
+    emitters->positionY[index] = y;
+    emitters->positionZ[index] = z;
+}
+
+void spatialSetAttenuation(SpatialEmitters* emitters, uint32_t index, AttenuationCurve curve,
+                           float minDistance, float maxDistance, float rolloff)
+{
+    assert(index < emitters->numEmitters);
+    // Keep the curves from dividing by zero
+    if(minDistance < 1e-3f)
+        minDistance = 1e-3f;
+    if(maxDistance < minDistance + 1e-3f)
+        maxDistance = minDistance + 1e-3f;
+    emitters->minDistance[index] = minDistance;
+    emitters->maxDistance[index] = maxDistance;
+    emitters->rolloff[index] = rolloff;
+    emitters->isLinear[index] = curve == ATTENUATION_LINEAR ? 0xFFFFFFFF : 0;
+}
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// A pair of neighbouring speakers, with the inverse of the matrix whose
+// columns are their direction vectors so we can solve for the two gains
+struct SpeakerPair {
+    uint32_t channels[2];
+    float inverse[2][2];
+};
+
+// Sorts the speakers by angle and pairs up each one with the next,
+// wrapping around at the back. Returns the number of pairs
+static uint32_t makeSpeakerPairs(const float* azimuths, uint32_t numChannels, SpeakerPair* pairs)
+{
+    uint32_t order[SPATIAL_MAX_CHANNELS];
+    uint32_t numSpeakers = 0;
+    for(uint32_t c = 0; c < numChannels; ++c)
+    {
+        if(azimuths[c] == SPEAKER_LFE)
+            continue;
+        uint32_t i = numSpeakers++;
+        for(; i > 0 && azimuths[order[i - 1]] > azimuths[c]; --i)
+            order[i] = order[i - 1];
+        order[i] = c;
+    }
+
+    for(uint32_t i = 0; i < numSpeakers; ++i)
+    {
+        uint32_t a = order[i];
+        uint32_t b = order[(i + 1) % numSpeakers];
+        float ax = sinf(azimuths[a] * (float)M_PI / 180.f), az = cosf(azimuths[a] * (float)M_PI / 180.f);
+        float bx = sinf(azimuths[b] * (float)M_PI / 180.f), bz = cosf(azimuths[b] * (float)M_PI / 180.f);
+        float det = ax * bz - bx * az;
+        pairs[i].channels[0] = a;
+        pairs[i].channels[1] = b;
+        pairs[i].inverse[0][0] = bz / det;
+        pairs[i].inverse[0][1] = -bx / det;
+        pairs[i].inverse[1][0] = -az / det;
+        pairs[i].inverse[1][1] = ax / det;
+    }
+    return numSpeakers;
+}
+
+void spatialUpdate(const SpatialListener* listener, SpatialEmitters* emitters, SpeakerLayout layout)
+{
+    const uint32_t numChannels = speakerLayoutNumChannels(layout);
+    SpeakerPair pairs[SPATIAL_MAX_CHANNELS];
+    uint32_t numPairs = 0;
+    if(layout == SPEAKER_LAYOUT_5_1)
+        numPairs = makeSpeakerPairs(SURROUND_5_1_AZIMUTHS, numChannels, pairs);
+    else if(layout == SPEAKER_LAYOUT_7_1)
+        numPairs = makeSpeakerPairs(SURROUND_7_1_AZIMUTHS, numChannels, pairs);
+    (void)STEREO_AZIMUTHS; // Stereo pans on the side-to-side position instead, so sounds behind still work
+
+    // Right is up x forward, since we're left-handed
+    const float* f = listener->forward;
+    const float* u = listener->up;
+    const float right[3] = { u[1] * f[2] - u[2] * f[1], u[2] * f[0] - u[0] * f[2], u[0] * f[1] - u[1] * f[0] };
+
+    const __m128 listenerX = _mm_set1_ps(listener->position[0]);
+    const __m128 listenerY = _mm_set1_ps(listener->position[1]);
+    const __m128 listenerZ = _mm_set1_ps(listener->position[2]);
+    const __m128 rightX = _mm_set1_ps(right[0]), rightY = _mm_set1_ps(right[1]), rightZ = _mm_set1_ps(right[2]);
+    const __m128 forwardX = _mm_set1_ps(f[0]), forwardY = _mm_set1_ps(f[1]), forwardZ = _mm_set1_ps(f[2]);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    // Anything closer than this to straight above or below the listener counts as in front
+    const __m128 minHorizontalDistanceSq = _mm_set1_ps(1e-12f);
+    const __m128 minPairGain = _mm_set1_ps(-1e-5f);
+
+    for(uint32_t i = 0; i < emitters->numEmitters; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(emitters->positionX + i), listenerX);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(emitters->positionY + i), listenerY);
+        __m128 dz = _mm_sub_ps(_mm_load_ps(emitters->positionZ + i), listenerZ);
+
+        // Distance attenuation
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 minDistance = _mm_load_ps(emitters->minDistance + i);
+        __m128 maxDistance = _mm_load_ps(emitters->maxDistance + i);
+        __m128 clampedDistance = _mm_min_ps(_mm_max_ps(distance, minDistance), maxDistance);
+        __m128 distancePastMin = _mm_sub_ps(clampedDistance, minDistance);
+        __m128 inverse = _mm_div_ps(minDistance, _mm_add_ps(minDistance, _mm_mul_ps(_mm_load_ps(emitters->rolloff + i), distancePastMin)));
+        __m128 linear = _mm_sub_ps(one, _mm_div_ps(distancePastMin, _mm_sub_ps(maxDistance, minDistance)));
+        __m128 attenuation = select(_mm_load_ps((const float*)emitters->isLinear + i), linear, inverse);
+
+        // Direction in the listener's horizontal plane as a unit vector
+        __m128 localX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rightX), _mm_mul_ps(dy, rightY)), _mm_mul_ps(dz, rightZ));
+        __m128 localZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, forwardX), _mm_mul_ps(dy, forwardY)), _mm_mul_ps(dz, forwardZ));
+        __m128 horizontalDistanceSq = _mm_add_ps(_mm_mul_ps(localX, localX), _mm_mul_ps(localZ, localZ));
+        __m128 hasDirection = _mm_cmpgt_ps(horizontalDistanceSq, minHorizontalDistanceSq);
+        __m128 invHorizontalDistance = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(horizontalDistanceSq, minHorizontalDistanceSq)));
+        __m128 dirX = select(hasDirection, _mm_mul_ps(localX, invHorizontalDistance), zero);
+        __m128 dirZ = select(hasDirection, _mm_mul_ps(localZ, invHorizontalDistance), one);
+
+        if(layout == SPEAKER_LAYOUT_STEREO)
+        {
+            // sqrt((1 -+ x) / 2) is the same as mixerSetPan()'s cos/sin panning with the
+            // pan going from -1 to 1 as the sound goes round from fully left to fully right
+            __m128 left = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(half, _mm_sub_ps(one, dirX)), zero));
+            __m128 right = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(half, _mm_add_ps(one, dirX)), zero));
+            _mm_store_ps(emitters->gains[0] + i, _mm_mul_ps(left, attenuation));
+            _mm_store_ps(emitters->gains[1] + i, _mm_mul_ps(right, attenuation));
+            continue;
+        }
+
+        // Find the pair of speakers the direction falls between: the one where
+        // writing it as a sum of the two speakers' directions needs no negative
+        // amounts of either. Exactly on a speaker, two pairs match so take the first
+        __m128 gains[SPATIAL_MAX_CHANNELS];
+        for(uint32_t c = 0; c < numChannels; ++c)
+            gains[c] = zero;
+        __m128 isPanned = zero;
+        for(uint32_t p = 0; p < numPairs; ++p)
+        {
+            const SpeakerPair* pair = &pairs[p];
+            __m128 gainA = _mm_add_ps(_mm_mul_ps(dirX, _mm_set1_ps(pair->inverse[0][0])), _mm_mul_ps(dirZ, _mm_set1_ps(pair->inverse[0][1])));
+            __m128 gainB = _mm_add_ps(_mm_mul_ps(dirX, _mm_set1_ps(pair->inverse[1][0])), _mm_mul_ps(dirZ, _mm_set1_ps(pair->inverse[1][1])));
+            __m128 isInPair = _mm_andnot_ps(isPanned, _mm_and_ps(_mm_cmpge_ps(gainA, minPairGain), _mm_cmpge_ps(gainB, minPairGain)));
+            // Constant power: scale the pair's gains so their squares add up to 1
+            gainA = _mm_max_ps(gainA, zero);
+            gainB = _mm_max_ps(gainB, zero);
+            __m128 scale = _mm_div_ps(attenuation, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(gainA, gainA), _mm_mul_ps(gainB, gainB))));
+            gains[pair->channels[0]] = select(isInPair, _mm_mul_ps(gainA, scale), gains[pair->channels[0]]);
+            gains[pair->channels[1]] = select(isInPair, _mm_mul_ps(gainB, scale), gains[pair->channels[1]]);
+            isPanned = _mm_or_ps(isPanned, isInPair);
+        }
+        for(uint32_t c = 0; c < numChannels; ++c)
+            _mm_store_ps(emitters->gains[c] + i, gains[c]);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+// Positional audio: works out how loud each emitter should be in each speaker
+// from where it is relative to the listener. Emitters are stored as structure
+// of arrays so spatialUpdate can do 4 at a time with SIMD, and it runs once per
+// mixer pass rather than once per frame
+
+// Multiple of 4 so SIMD never has to deal with a partial batch
+#define SPATIAL_MAX_EMITTERS 1024
+#define SPATIAL_MAX_CHANNELS 8
+#define SPATIAL_NO_EMITTER 0xFFFFFFFF
+
+// Channels are in the same order as WAVEFORMATEXTENSIBLE's channel mask:
+// front left, front right, front centre, LFE, back left, back right, side left, side right
+enum SpeakerLayout {
+    SPEAKER_LAYOUT_STEREO,
+    SPEAKER_LAYOUT_5_1, // Back left and right are the surrounds, at 110 degrees
+    SPEAKER_LAYOUT_7_1,
+};
+
+enum AttenuationCurve {
+    ATTENUATION_INVERSE, // Like a real point source: minDistance / distance, with rolloff stretching it
+    ATTENUATION_LINEAR,  // Straight down to silence at maxDistance
+};
+
+// x is right, y is up and z is forward, in whatever units the game uses
+struct SpatialListener {
+    float position[3];
+    float forward[3]; // Both unit length and at right angles to each other
+    float up[3];
+};
+
+struct SpatialEmitters {
+    uint32_t numEmitters;
+    alignas(16) float positionX[SPATIAL_MAX_EMITTERS];
+    alignas(16) float positionY[SPATIAL_MAX_EMITTERS];
+    alignas(16) float positionZ[SPATIAL_MAX_EMITTERS];
+    // Full volume up to minDistance, and it stops getting any quieter past maxDistance
+    alignas(16) float minDistance[SPATIAL_MAX_EMITTERS];
+    alignas(16) float maxDistance[SPATIAL_MAX_EMITTERS];
+    alignas(16) float rolloff[SPATIAL_MAX_EMITTERS]; // Only for ATTENUATION_INVERSE
+    alignas(16) uint32_t isLinear[SPATIAL_MAX_EMITTERS]; // All bits set for ATTENUATION_LINEAR, so it works as a SIMD mask
+    // Written by spatialUpdate: the gain of each emitter in each speaker, distance attenuation included
+    alignas(16) float gains[SPATIAL_MAX_CHANNELS][SPATIAL_MAX_EMITTERS];
+};
+
+uint32_t speakerLayoutNumChannels(SpeakerLayout layout);
+// The layout to mix for an output with numChannels, from its WAVEFORMATEXTENSIBLE channel
+// mask, 0 if it didn't have one. Anything that isn't 5.1 or 7.1 in the order above gets stereo
+SpeakerLayout speakerLayoutForOutput(uint32_t numChannels, uint32_t channelMask);
+
+void spatialInit(SpatialEmitters* emitters);
+// Returns SPATIAL_NO_EMITTER if there's no room. New emitters
+// are at the origin with ATTENUATION_INVERSE from 1 to 100
+uint32_t spatialAddEmitter(SpatialEmitters* emitters);
+// Moves the last emitter into index to keep them packed
+void spatialRemoveEmitter(SpatialEmitters* emitters, uint32_t index);
+void spatialSetPosition(SpatialEmitters* emitters, uint32_t index, float x, float y, float z);
+void spatialSetAttenuation(SpatialEmitters* emitters, uint32_t index, AttenuationCurve curve,
+                           float minDistance, float maxDistance, float rolloff);
+// Works out gains for every emitter. Stereo uses equal-power panning on how far to the side
+// each emitter is. 5.1 and 7.1 use pairwise constant-power panning between the two speakers
+// either side of it (2D VBAP), ignoring height. The LFE channel is always 0
+void spatialUpdate(const SpatialListener* listener, SpatialEmitters* emitters, SpeakerLayout layout);
@@ -0,0 +1,233 @@
+#include "TimeStretch.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include <emmintrin.h> // SSE2
+
+// For illustrative purposes only, no warranty is implied
+// References:
+// Werner Verhelst and Marc Roelands, An Overlap-Add Technique Based on Waveform
+// Similarity (WSOLA) for High Quality Time-Scale Modification of Speech
+
+static_assert(TIME_STRETCH_SEARCH % 4 == 0 && TIME_STRETCH_HOP % 4 == 0, "The coarse search works in groups of 4 frames");
+// At the max ratio the oldest frame we keep is where the last segment carries on from, up to
+// a search range before its ideal position, and the next search ends a window past its range
+static_assert(TIME_STRETCH_INPUT_SIZE >= 2 * TIME_STRETCH_SEARCH + (TIME_STRETCH_MAX_RATIO - 1) * TIME_STRETCH_HOP
+                                        + TIME_STRETCH_WINDOW + 1, "Input buffer too small for the max ratio");
+
+// Periodic Hann, so two of them half a window apart add up to exactly 1
+static float hannWindow[TIME_STRETCH_WINDOW];
+static bool isHannWindowInitialised;
+
+void timeStretchReset(TimeStretch* stretch)
+{
+    if(!isHannWindowInitialised)
+    {
+        for(uint32_t i = 0; i < TIME_STRETCH_WINDOW; ++i)
+            hannWindow[i] = 0.5f - 0.5f * cosf(2.f * (float)M_PI * i / TIME_STRETCH_WINDOW);
+        isHannWindowInitialised = true;
+    }
+    stretch->numInputFrames = 0;
+    stretch->idealPos = 0.0;
+    stretch->continuationPos = 0;
+    stretch->isFirstSegment = true;
+    memset(stretch->output, 0, sizeof(stretch->output));
+    stretch->outputReadPos = 0;
+    stretch->hasOutput = false;
+}
+
+static inline float clampRatio(float ratio)
+{
+    if(ratio < TIME_STRETCH_MIN_RATIO) return TIME_STRETCH_MIN_RATIO;
+    if(ratio > TIME_STRETCH_MAX_RATIO) return TIME_STRETCH_MAX_RATIO;
+    return ratio;
+}
+
+// First input frame the next segment could start at
+static uint32_t searchStartPos(const TimeStretch* stretch)
+{
+    int64_t pos = llround(stretch->idealPos) - TIME_STRETCH_SEARCH;
+    return pos > 0 ? (uint32_t)pos : 0;
+}
+
+uint32_t timeStretchNumInputFramesNeeded(const TimeStretch* stretch)
+{
+    uint32_t endPos = TIME_STRETCH_WINDOW;
+    if(!stretch->isFirstSegment)
+    {
+        endPos = searchStartPos(stretch) + 2 * TIME_STRETCH_SEARCH + TIME_STRETCH_WINDOW;
+        if(stretch->continuationPos + TIME_STRETCH_HOP > endPos)
+            endPos = stretch->continuationPos + TIME_STRETCH_HOP;
+    }
+    return endPos > stretch->numInputFrames ? endPos - stretch->numInputFrames : 0;
+}
+
+void timeStretchAddInput(TimeStretch* stretch, uint32_t numFrames, float** left, float** right)
+{
+    assert(stretch->numInputFrames + numFrames <= TIME_STRETCH_INPUT_SIZE);
+    *left = stretch->input[0] + stretch->numInputFrames;
+    *right = stretch->input[1] + stretch->numInputFrames;
+    memset(*left, 0, numFrames * sizeof(float));
+    memset(*right, 0, numFrames * sizeof(float));
+    stretch->numInputFrames += numFrames;
+}
+
+// numValues must be a multiple of 8
+static float dotProduct(const float* a, const float* b, uint32_t numValues)
+{
+    // Two sums so each add doesn't have to wait for the one before
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    for(uint32_t i = 0; i < numValues; i += 8)
+    {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 sum = _mm_add_ps(sum0, sum1);
+    sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(sum);
+}
+
+// Normalised cross-correlation, squared but keeping its sign so that
+// lining up out of phase scores lower than not lining up at all
+static inline float similarity(float correlation, float energy)
+{
+    return correlation * fabsf(correlation) / (energy + 1e-9f);
+}
+
+// Offset from searchStart of the segment start that best carries on from the last
+// segment. A coarse pass over everything 4x decimated, then a fine pass around the best
+static uint32_t findBestOffset(TimeStretch* stretch, uint32_t searchStart, uint32_t idealOffset)
+{
+    const uint32_t NUM_CANDIDATE_FRAMES = TIME_STRETCH_HOP + 2 * TIME_STRETCH_SEARCH;
+    const float* left = stretch->input[0];
+    const float* right = stretch->input[1];
+    float* reference = stretch->reference;
+    float* candidates = stretch->candidates;
+    for(uint32_t i = 0; i < TIME_STRETCH_HOP; ++i)
+        reference[i] = left[stretch->continuationPos + i] + right[stretch->continuationPos + i];
+    for(uint32_t i = 0; i < NUM_CANDIDATE_FRAMES; ++i)
+        candidates[i] = left[searchStart + i] + right[searchStart + i];
+    for(uint32_t i = 0; i < TIME_STRETCH_HOP / 4; ++i)
+        stretch->coarseReference[i] = reference[4*i] + reference[4*i+1] + reference[4*i+2] + reference[4*i+3];
+    for(uint32_t i = 0; i < NUM_CANDIDATE_FRAMES / 4; ++i)
+        stretch->coarseCandidates[i] = candidates[4*i] + candidates[4*i+1] + candidates[4*i+2] + candidates[4*i+3];
+
+    // With nothing to line up with (e.g. silence) stay where we should be
+    uint32_t bestOffset = idealOffset;
+    float bestSimilarity = 0.f;
+
+    const float* coarseCandidates = stretch->coarseCandidates;
+    const uint32_t COARSE_LENGTH = TIME_STRETCH_HOP / 4;
+    float energy = dotProduct(coarseCandidates, coarseCandidates, COARSE_LENGTH);
+    uint32_t bestCoarseOffset = idealOffset / 4;
+    float bestCoarseSimilarity = 0.f;
+    for(uint32_t offset = 0; offset <= 2 * TIME_STRETCH_SEARCH / 4; ++offset)
+    {
+        float correlation = dotProduct(stretch->coarseReference, coarseCandidates + offset, COARSE_LENGTH);
+        float score = similarity(correlation, energy);
+        if(score > bestCoarseSimilarity) {
+            bestCoarseSimilarity = score;
+            bestCoarseOffset = offset;
+        }
+        // Slide the energy along by one
+        float removed = coarseCandidates[offset];
+        float added = offset + COARSE_LENGTH < NUM_CANDIDATE_FRAMES / 4 ? coarseCandidates[offset + COARSE_LENGTH] : 0.f;
+        energy += added * added - removed * removed;
+    }
+    if(bestCoarseSimilarity == 0.f)
+        return bestOffset;
+
+    const uint32_t fineStart = bestCoarseOffset * 4 >= 3 ? bestCoarseOffset * 4 - 3 : 0;
+    uint32_t fineEnd = bestCoarseOffset * 4 + 3;
+    if(fineEnd > 2 * TIME_STRETCH_SEARCH)
+        fineEnd = 2 * TIME_STRETCH_SEARCH;
+    for(uint32_t offset = fineStart; offset <= fineEnd; ++offset)
+    {
+        float correlation = dotProduct(reference, candidates + offset, TIME_STRETCH_HOP);
+        float candidateEnergy = dotProduct(candidates + offset, candidates + offset, TIME_STRETCH_HOP);
+        float score = similarity(correlation, candidateEnergy);
+        if(score > bestSimilarity) {
+            bestSimilarity = score;
+            bestOffset = offset;
+        }
+    }
+    return bestOffset;
+}
+
+// Picks where the next segment starts and overlap-adds it into the output
+static void addSegment(TimeStretch* stretch, float ratio)
+{
+    uint32_t segmentStart = 0;
+    if(!stretch->isFirstSegment)
+    {
+        uint32_t searchStart = searchStartPos(stretch);
+        uint32_t idealOffset = (uint32_t)(llround(stretch->idealPos) - searchStart);
+        segmentStart = searchStart + findBestOffset(stretch, searchStart, idealOffset);
+    }
+
+    for(uint32_t c = 0; c < 2; ++c)
+    {
+        float* output = stretch->output[c];
+        const float* input = stretch->input[c] + segmentStart;
+        // The finished half has been read, move the unfinished half down
+        memmove(output, output + TIME_STRETCH_HOP, TIME_STRETCH_HOP * sizeof(float));
+        memset(output + TIME_STRETCH_HOP, 0, TIME_STRETCH_HOP * sizeof(float));
+        uint32_t i = 0;
+        if(stretch->isFirstSegment)
+        {
+            // Nothing to overlap with, so don't fade in and soften the start of the sound
+            for(; i < TIME_STRETCH_HOP; ++i)
+                output[i] = input[i];
+        }
+        for(; i < TIME_STRETCH_WINDOW; i += 4)
+        {
+            __m128 windowed = _mm_mul_ps(_mm_loadu_ps(input + i), _mm_load_ps(hannWindow + i));
+            _mm_store_ps(output + i, _mm_add_ps(_mm_load_ps(output + i), windowed));
+        }
+    }
+    stretch->isFirstSegment = false;
+    stretch->continuationPos = segmentStart + TIME_STRETCH_HOP;
+    stretch->idealPos += TIME_STRETCH_HOP * (double)ratio;
+    stretch->hasOutput = true;
+    stretch->outputReadPos = 0;
+
+    // Drop any input that neither the next search nor its reference can reach
+    uint32_t numFramesToDrop = searchStartPos(stretch);
+    if(stretch->continuationPos < numFramesToDrop)
+        numFramesToDrop = stretch->continuationPos;
+    if(numFramesToDrop > stretch->numInputFrames)
+        numFramesToDrop = stretch->numInputFrames;
+    uint32_t numFramesLeft = stretch->numInputFrames - numFramesToDrop;
+    memmove(stretch->input[0], stretch->input[0] + numFramesToDrop, numFramesLeft * sizeof(float));
+    memmove(stretch->input[1], stretch->input[1] + numFramesToDrop, numFramesLeft * sizeof(float));
+    stretch->numInputFrames = numFramesLeft;
+    stretch->continuationPos -= numFramesToDrop;
+    stretch->idealPos -= numFramesToDrop;
+}
+
+uint32_t timeStretchProcess(TimeStretch* stretch, float ratio, float* outLeft, float* outRight, uint32_t numFrames)
+{
+    ratio = clampRatio(ratio);
+    uint32_t numFramesWritten = 0;
+    while(numFramesWritten < numFrames)
+    {
+        if(!stretch->hasOutput || stretch->outputReadPos == TIME_STRETCH_HOP)
+        {
+            if(timeStretchNumInputFramesNeeded(stretch) > 0)
+                break;
+            addSegment(stretch, ratio);
+        }
+        uint32_t numFramesToCopy = TIME_STRETCH_HOP - stretch->outputReadPos;
+        if(numFramesToCopy > numFrames - numFramesWritten)
+            numFramesToCopy = numFrames - numFramesWritten;
+        memcpy(outLeft + numFramesWritten, stretch->output[0] + stretch->outputReadPos, numFramesToCopy * sizeof(float));
+        memcpy(outRight + numFramesWritten, stretch->output[1] + stretch->outputReadPos, numFramesToCopy * sizeof(float));
+        stretch->outputReadPos += numFramesToCopy;
+        numFramesWritten += numFramesToCopy;
+    }
+    return numFramesWritten;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+// WSOLA (waveform similarity overlap-add) time-stretching. Changes how fast a sound
+// plays without changing its pitch by cutting the input into overlapping windowed
+// segments and laying them back down at a different spacing. Each segment is
+// nudged to wherever it lines up best with the one before it, so the waveforms
+// overlap in phase instead of cancelling out. Resampling first and then
+// stretching back by the same amount shifts the pitch without changing the tempo.
+// Works on de-interleaved stereo float, and all state is in the struct so
+// nothing is allocated while it runs
+
+// Frames per segment, about 21ms at 48kHz. Longer smears transients, shorter makes low notes rough
+#define TIME_STRETCH_WINDOW 1024
+// Output frames between segments. Half a window so the Hann windows add up to 1
+#define TIME_STRETCH_HOP (TIME_STRETCH_WINDOW / 2)
+// How far either side of its ideal position a segment can move to line up. Multiple of 4
+#define TIME_STRETCH_SEARCH 256
+// Input frames read per output frame is clamped to this range
+#define TIME_STRETCH_MIN_RATIO 0.25f
+#define TIME_STRETCH_MAX_RATIO 4.f
+// Enough for a segment and its search range at the max ratio, plus
+// the input the previous segment would have carried on into
+#define TIME_STRETCH_INPUT_SIZE 4096
+
+struct TimeStretch {
+    // Input that may still be used, input[c][0] is the oldest frame we kept
+    alignas(16) float input[2][TIME_STRETCH_INPUT_SIZE];
+    uint32_t numInputFrames;
+    // Where the next segment would start with no nudging, in input frames
+    double idealPos;
+    // Where the last segment would have carried on, which the next one should line up with
+    uint32_t continuationPos;
+    bool isFirstSegment;
+    // Overlap-add accumulator. The first TIME_STRETCH_HOP frames are
+    // finished once a segment has been added, the rest wait for the next one
+    alignas(16) float output[2][TIME_STRETCH_WINDOW];
+    uint32_t outputReadPos; // Frames of the finished part already read
+    bool hasOutput;
+    // Mono mixdowns for the search, 4x decimated for the coarse pass
+    alignas(16) float reference[TIME_STRETCH_HOP];
+    alignas(16) float candidates[TIME_STRETCH_HOP + 2 * TIME_STRETCH_SEARCH];
+    alignas(16) float coarseReference[TIME_STRETCH_HOP / 4];
+    alignas(16) float coarseCandidates[(TIME_STRETCH_HOP + 2 * TIME_STRETCH_SEARCH) / 4];
+};
+
+void timeStretchReset(TimeStretch* stretch);
+// How many more input frames timeStretchProcess needs before it can make the next segment
+uint32_t timeStretchNumInputFramesNeeded(const TimeStretch* stretch);
+// Returns where to write the next numFrames input frames, which must be no more than
+// timeStretchNumInputFramesNeeded. They start out as silence so they can be mixed into
+void timeStretchAddInput(TimeStretch* stretch, uint32_t numFrames, float** left, float** right);
+// Writes up to numFrames output frames and returns how many it wrote. Stops
+// early when it needs more input, see timeStretchNumInputFramesNeeded
+uint32_t timeStretchProcess(TimeStretch* stretch, float ratio, float* outLeft, float* outRight, uint32_t numFrames);
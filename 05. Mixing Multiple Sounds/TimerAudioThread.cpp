@@ -0,0 +1,73 @@
+#include "TimerAudioThread.h"
+
+#include <assert.h>
+#include <chrono>
+
+#include "AdaptiveLatency.h"
+#include "Allocators.h"
+
+static void timerAudioThreadProc(TimerAudioThread* audioThread)
+{
+    typedef std::chrono::steady_clock Clock;
+    allocatorMarkAudioThread();
+
+    AudioOutput* output = audioThread->output;
+    const uint32_t sampleRate = output->format.sampleRate;
+    AdaptiveLatency latency;
+    adaptiveLatencyInit(&latency, audioThread->periodInFrames, output->bufferSizeInFrames);
+
+    // Wake-ups are worked out from the start time rather than the last
+    // wake-up, so being late once doesn't push every one after it back
+    const Clock::time_point startTime = Clock::now();
+    for(uint64_t period = 0; !audioThread->quit.load(std::memory_order_acquire); ++period)
+    {
+        const uint64_t periodStartFrame = period * audioThread->periodInFrames;
+        const Clock::time_point wakeUpTime = startTime + std::chrono::microseconds(periodStartFrame * 1000000 / sampleRate);
+        std::this_thread::sleep_until(wakeUpTime);
+
+        // Where the simulated device has got to. Anything past what we'd written was silence
+        Clock::time_point now = Clock::now();
+        uint64_t elapsedMicroseconds = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - startTime).count();
+        uint64_t numFramesPlayed = elapsedMicroseconds * sampleRate / 1000000 - audioThread->numSilentFramesPlayed;
+        if(numFramesPlayed > audioThread->numFramesWritten)
+        {
+            audioThread->numSilentFramesPlayed += numFramesPlayed - audioThread->numFramesWritten;
+            numFramesPlayed = audioThread->numFramesWritten;
+        }
+        uint32_t bufferPadding = (uint32_t)(audioThread->numFramesWritten - numFramesPlayed);
+
+        uint32_t targetBufferPadding = adaptiveLatencyUpdate(&latency, bufferPadding);
+        audioThread->numFramesWritten += audioRendererRender(audioThread->renderer, audioThread->commandQueue, output,
+                                                             bufferPadding, targetBufferPadding);
+
+        uint64_t lateMicroseconds = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - wakeUpTime).count();
+        if(lateMicroseconds > audioThread->maxLateMicroseconds)
+            audioThread->maxLateMicroseconds = (uint32_t)lateMicroseconds;
+        ++audioThread->numWakeUps;
+    }
+    audioThread->numUnderruns = latency.numUnderruns;
+}
+
+void timerAudioThreadStart(TimerAudioThread* audioThread, AudioRenderer* renderer, AudioCommandQueue* commandQueue,
+                           AudioOutput* output, uint32_t periodInFrames)
+{
+    assert(periodInFrames > 0 && periodInFrames <= output->bufferSizeInFrames);
+    audioThread->renderer = renderer;
+    audioThread->commandQueue = commandQueue;
+    audioThread->output = output;
+    audioThread->periodInFrames = periodInFrames;
+    audioThread->quit.store(false, std::memory_order_relaxed);
+    audioThread->numFramesWritten = 0;
+    audioThread->numSilentFramesPlayed = 0;
+    audioThread->numWakeUps = 0;
+    audioThread->numUnderruns = 0;
+    audioThread->maxLateMicroseconds = 0;
+    audioThread->thread = std::thread(timerAudioThreadProc, audioThread);
+}
+
+void timerAudioThreadStop(TimerAudioThread* audioThread)
+{
+    audioThread->quit.store(true, std::memory_order_release);
+    if(audioThread->thread.joinable())
+        audioThread->thread.join();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "AudioCommandQueue.h"
+#include "AudioOutput.h"
+#include "AudioRenderer.h"
+
+// Stands in for main.cpp's event-driven audio thread where there's no WASAPI to
+// wake it, e.g. headless on Linux. A std::thread sleeps until the start of each
+// period and then does what the WASAPI thread does when its event fires: gets the
+// buffer padding, picks a target with AdaptiveLatency and calls audioRendererRender.
+// The output's device is simulated, playing its buffer in real time from the
+// first wake-up, so it works with outputs that don't track time themselves,
+// like NullAudioOutput. When the buffer runs dry the device plays silence, the
+// same as a real one, and the audio written after that plays that much later
+struct TimerAudioThread {
+    AudioRenderer* renderer;
+    AudioCommandQueue* commandQueue;
+    AudioOutput* output;
+    uint32_t periodInFrames; // How often the thread wakes up
+    std::atomic<bool> quit;
+    std::thread thread;
+    // Written by the audio thread, only read them once it has stopped
+    uint64_t numFramesWritten;
+    uint64_t numSilentFramesPlayed; // Simulated device time spent underrunning
+    uint32_t numWakeUps;
+    uint32_t numUnderruns;
+    uint32_t maxLateMicroseconds; // Worst wake-up after the period started
+};
+
+void timerAudioThreadStart(TimerAudioThread* audioThread, AudioRenderer* renderer, AudioCommandQueue* commandQueue,
+                           AudioOutput* output, uint32_t periodInFrames);
+// Stops waking up and waits for the thread to finish
+void timerAudioThreadStop(TimerAudioThread* audioThread);
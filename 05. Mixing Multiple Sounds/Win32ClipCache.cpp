@@ -0,0 +1,91 @@
+#include "Win32ClipCache.h"
+
+#include <assert.h>
+
+#include "Allocators.h"
+#include "ConvertSamples.h"
+#include "Win32LoadEntireFile.h"
+
+// Runs on the Win32 thread pool
+static VOID CALLBACK loadClipCallback(PTP_CALLBACK_INSTANCE, PVOID param)
+{
+    CachedClip* cachedClip = (CachedClip*)param;
+    LARGE_INTEGER startTime;
+    QueryPerformanceCounter(&startTime);
+
+    uint32_t fileSize;
+    if(!win32MapEntireFile(cachedClip->filename, &cachedClip->fileBytes, &fileSize))
+    {
+        clipCacheFinishLoad(cachedClip, CACHED_CLIP_FAILED);
+        return;
+    }
+
+    AudioClip clip;
+    WavError error = parseWavFile((uint8_t*)cachedClip->fileBytes, fileSize, &clip);
+    cachedClip->numBytes = fileSize;
+    // The mixer only plays mono and stereo
+    if(error != WAV_OK || clip.numChannels > 2 || clip.numSamples == 0)
+    {
+        clipCacheFinishLoad(cachedClip, CACHED_CLIP_FAILED);
+        return;
+    }
+
+    // The mixer reads 16-bit, float and IMA-ADPCM clips directly.
+    // Anything else gets converted to float up front
+    if(cachedClip->convertToPlanar && clip.sampleFormat != SAMPLE_FORMAT_IMA_ADPCM)
+    {
+        uint32_t numFrames = clip.numSamples / clip.numChannels;
+        uint32_t numConvertedBytes = clip.numChannels * planarStride(numFrames) * sizeof(float);
+        cachedClip->convertedSamples = (float*)trackedAlloc(numConvertedBytes, ALLOCATION_TAG_CLIPS, 64);
+        assert(cachedClip->convertedSamples);
+        convertSamplesToPlanarFloat(clip.samples, clip.sampleFormat, clip.numBitsPerSample,
+                                    clip.numChannels, numFrames, cachedClip->convertedSamples);
+        clip.sampleFormat = SAMPLE_FORMAT_FLOAT;
+        clip.layout = SAMPLE_LAYOUT_PLANAR;
+        clip.numBitsPerSample = 32;
+        clip.planeStride = planarStride(numFrames);
+        clip.samples = cachedClip->convertedSamples;
+        cachedClip->numBytes += numConvertedBytes;
+        // Don't need the file any more
+        Win32UnmapFileData(cachedClip->fileBytes);
+        cachedClip->fileBytes = nullptr;
+        cachedClip->numBytes -= fileSize;
+    }
+    else if(clip.sampleFormat == SAMPLE_FORMAT_PCM && clip.numBitsPerSample != 16)
+    {
+        cachedClip->convertedSamples = (float*)trackedAlloc(clip.numSamples * sizeof(float), ALLOCATION_TAG_CLIPS, 64);
+        assert(cachedClip->convertedSamples);
+        convertSamplesToFloat(clip.samples, clip.sampleFormat, clip.numBitsPerSample,
+                              clip.numSamples, cachedClip->convertedSamples);
+        clip.sampleFormat = SAMPLE_FORMAT_FLOAT;
+        clip.numBitsPerSample = 32;
+        clip.samples = cachedClip->convertedSamples;
+        cachedClip->numBytes += clip.numSamples * sizeof(float);
+    }
+    cachedClip->clip = clip;
+    if(clip.samples)
+        loudnessAnalyseClip(&clip, &cachedClip->loudness);
+
+    LARGE_INTEGER endTime, ticksPerSecond;
+    QueryPerformanceCounter(&endTime);
+    QueryPerformanceFrequency(&ticksPerSecond);
+    cachedClip->loadTimeMicroseconds = (uint32_t)((endTime.QuadPart - startTime.QuadPart) * 1000000 / ticksPerSecond.QuadPart);
+
+    clipCacheFinishLoad(cachedClip, clip.samples ? CACHED_CLIP_LOADED : CACHED_CLIP_FAILED);
+}
+
+static void win32StartLoad(ClipLoader*, CachedClip* cachedClip)
+{
+    if(!TrySubmitThreadpoolCallback(loadClipCallback, cachedClip, nullptr))
+        loadClipCallback(nullptr, cachedClip);
+}
+
+static void win32Unload(ClipLoader*, CachedClip* cachedClip)
+{
+    if(cachedClip->convertedSamples)
+        trackedFree(cachedClip->convertedSamples);
+    if(cachedClip->fileBytes)
+        Win32UnmapFileData(cachedClip->fileBytes);
+}
+
+ClipLoader win32ClipLoader = { win32StartLoad, win32Unload };
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <windows.h>
+
+#include "ClipCache.h"
+
+// Loads clips on the Win32 thread pool. Maps the file, parses it and
+// converts it if the mixer can't read it directly
+extern ClipLoader win32ClipLoader;
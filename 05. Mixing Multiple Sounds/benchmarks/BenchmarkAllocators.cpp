@@ -0,0 +1,140 @@
+// Measures allocating and freeing with each allocator, from one thread and from
+// several at once. The heap has to synchronise between threads, where each
+// thread's pool or arena is its own so they never contend. Also shows the slowest
+// single allocation and free, since for the audio thread that matters more
+// than the average. Cycles are timestamp counter ticks.
+// Usage: BenchmarkAllocators
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <x86intrin.h> // __rdtsc
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "../Allocators.h"
+
+#define NUM_OPS 1000000
+// Each thread keeps this many allocations alive, freeing the oldest to make room
+#define NUM_LIVE 64
+#define MAX_SIZE 1024
+#define MAX_THREADS 4
+#define MEMORY_SIZE (NUM_LIVE * MAX_SIZE)
+
+enum AllocatorMethod {
+    ALLOCATOR_MALLOC,
+    ALLOCATOR_TRACKED,
+    ALLOCATOR_POOL,
+    ALLOCATOR_ARENA,
+};
+
+struct BenchmarkThread {
+    AllocatorMethod method;
+    uint32_t seed;
+    void* memory; // Backing memory for the pool or arena
+    MemoryPool pool;
+    MemoryArena arena;
+    uint64_t maxCycles; // Slowest single allocation and free
+};
+
+// So all the threads start together rather than as each one is created
+static std::atomic<bool> isStarted;
+
+static void runThread(BenchmarkThread* thread)
+{
+    void* live[NUM_LIVE] = {};
+    uint32_t random = thread->seed;
+    uint64_t maxCycles = 0;
+    while(!isStarted.load(std::memory_order_acquire))
+        std::this_thread::yield();
+    for(uint32_t i = 0; i < NUM_OPS; ++i)
+    {
+        random = random * 1664525 + 1013904223;
+        size_t size = 16 + (random >> 8) % (MAX_SIZE - 16);
+        uint32_t slot = i % NUM_LIVE;
+        uint64_t startCycles = __rdtsc();
+        switch(thread->method)
+        {
+            case ALLOCATOR_MALLOC:
+                free(live[slot]);
+                live[slot] = malloc(size);
+                break;
+            case ALLOCATOR_TRACKED:
+                trackedFree(live[slot]);
+                live[slot] = trackedAlloc(size, ALLOCATION_TAG_OTHER);
+                break;
+            case ALLOCATOR_POOL:
+                // Every block is the biggest size
+                if(live[slot])
+                    poolFree(&thread->pool, live[slot]);
+                live[slot] = poolAlloc(&thread->pool);
+                break;
+            case ALLOCATOR_ARENA:
+                // Frees everything at once, like the mixer does every pass
+                if(slot == 0)
+                    arenaReset(&thread->arena);
+                live[slot] = arenaPush(&thread->arena, size);
+                break;
+        }
+        uint64_t cycles = __rdtsc() - startCycles;
+        if(cycles > maxCycles)
+            maxCycles = cycles;
+        *(volatile uint8_t*)live[slot] = (uint8_t)i;
+    }
+    for(uint32_t slot = 0; slot < NUM_LIVE; ++slot)
+    {
+        if(thread->method == ALLOCATOR_MALLOC)
+            free(live[slot]);
+        else if(thread->method == ALLOCATOR_TRACKED)
+            trackedFree(live[slot]);
+    }
+    thread->maxCycles = maxCycles;
+}
+
+int main()
+{
+    typedef std::chrono::steady_clock Clock;
+    static BenchmarkThread threads[MAX_THREADS];
+    const uint32_t threadCounts[] = { 1, MAX_THREADS };
+    const char* methodNames[] = { "malloc", "trackedAlloc", "pool", "arena" };
+
+    printf("%-14s %8s %22s %16s\n", "", "threads", "ns per alloc and free", "slowest cycles");
+    for(uint32_t numThreads : threadCounts)
+    {
+        for(uint32_t method = ALLOCATOR_MALLOC; method <= ALLOCATOR_ARENA; ++method)
+        {
+            isStarted.store(false);
+            std::thread threadHandles[MAX_THREADS];
+            for(uint32_t i = 0; i < numThreads; ++i)
+            {
+                BenchmarkThread* thread = &threads[i];
+                thread->method = (AllocatorMethod)method;
+                thread->seed = 12345 + i;
+                thread->memory = malloc(MEMORY_SIZE);
+                if(!thread->memory)
+                    return 1;
+                poolInit(&thread->pool, thread->memory, MAX_SIZE, NUM_LIVE);
+                arenaInit(&thread->arena, thread->memory, MEMORY_SIZE);
+                threadHandles[i] = std::thread(runThread, thread);
+            }
+
+            Clock::time_point startTime = Clock::now();
+            isStarted.store(true, std::memory_order_release);
+            for(uint32_t i = 0; i < numThreads; ++i)
+                threadHandles[i].join();
+            double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+            uint64_t maxCycles = 0;
+            for(uint32_t i = 0; i < numThreads; ++i)
+            {
+                if(threads[i].maxCycles > maxCycles)
+                    maxCycles = threads[i].maxCycles;
+                free(threads[i].memory);
+            }
+            printf("%-14s %8u %22.1f %16llu\n", methodNames[method], numThreads, seconds * 1e9 / NUM_OPS,
+                   (unsigned long long)maxCycles);
+        }
+    }
+    return 0;
+}
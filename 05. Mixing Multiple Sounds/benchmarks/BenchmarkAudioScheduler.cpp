@@ -0,0 +1,149 @@
+// Measures adding and removing scheduled commands with a few commands waiting
+// and with the scheduler full, both all at once and the way the audio thread
+// really uses it: a few commands added each update and whatever is due popped.
+// Also checks commands come out in frame order, and that commands for the same
+// frame come out in the order they went in.
+// Usage: BenchmarkAudioScheduler
+// Returns 1 if anything comes out in the wrong order or goes missing.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "../AudioScheduler.h"
+
+// Time each case for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define SAMPLE_RATE 48000
+// What the audio thread renders per update, 10ms
+#define FRAMES_PER_UPDATE (SAMPLE_RATE / 100)
+
+static AudioScheduler scheduler;
+
+static uint32_t nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+// The command's sound is the order it was added in, so pops can be checked.
+// Frames are rounded to a whole update so plenty land on the same one
+static void addCommand(uint64_t frame, uint32_t order)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_GAIN;
+    command.sound = order;
+    command.frame = frame / FRAMES_PER_UPDATE * FRAMES_PER_UPDATE;
+    if(!audioSchedulerAdd(&scheduler, &command))
+        printf("Scheduler full after %u commands\n", order);
+}
+
+// Checks each popped command against the one before it
+struct OrderCheck {
+    uint64_t lastFrame;
+    uint32_t lastOrder;
+    uint32_t numPopped;
+    bool passed;
+};
+
+static void checkPop(OrderCheck* check, const AudioCommand* command)
+{
+    if(check->numPopped > 0
+       && (command->frame < check->lastFrame || (command->frame == check->lastFrame && command->sound < check->lastOrder)))
+        check->passed = false;
+    check->lastFrame = command->frame;
+    check->lastOrder = command->sound;
+    ++check->numPopped;
+}
+
+// Fills the scheduler with numCommands at random frames over the next minute,
+// then empties it. Returns ns per add and per pop
+static bool timeFillAndEmpty(uint32_t numCommands, double* nsPerAdd, double* nsPerPop)
+{
+    typedef std::chrono::steady_clock Clock;
+    double addSeconds = 0.0;
+    double popSeconds = 0.0;
+    uint64_t numRuns = 0;
+    bool passed = true;
+    uint32_t random = 12345;
+    do
+    {
+        audioSchedulerInit(&scheduler);
+        // Have the sequence numbers wrap around halfway through
+        scheduler.nextSequence = UINT32_MAX - numCommands / 2;
+        Clock::time_point startTime = Clock::now();
+        for(uint32_t i = 0; i < numCommands; ++i)
+            addCommand(nextRandom(&random) % (60 * SAMPLE_RATE), i);
+        Clock::time_point addedTime = Clock::now();
+        OrderCheck check = {};
+        check.passed = true;
+        AudioCommand command;
+        while(audioSchedulerPopDue(&scheduler, UINT64_MAX, &command))
+            checkPop(&check, &command);
+        Clock::time_point poppedTime = Clock::now();
+        addSeconds += std::chrono::duration<double>(addedTime - startTime).count();
+        popSeconds += std::chrono::duration<double>(poppedTime - addedTime).count();
+        passed = passed && check.passed && check.numPopped == numCommands;
+        ++numRuns;
+    } while(addSeconds + popSeconds < MIN_BENCHMARK_SECONDS);
+    *nsPerAdd = addSeconds * 1e9 / (numRuns * numCommands);
+    *nsPerPop = popSeconds * 1e9 / (numRuns * numCommands);
+    return passed;
+}
+
+// Like the audio thread: each update adds a few commands for up to a second
+// ahead, then pops everything due this update. Keeps about numWaiting
+// commands waiting. Returns ns per command added and popped
+static bool timeSteady(uint32_t numWaiting, double* nsPerCommand)
+{
+    typedef std::chrono::steady_clock Clock;
+    // Commands stay a second on average, so this many a second keeps numWaiting waiting
+    const uint32_t numPerUpdate = numWaiting / 100 ? numWaiting / 100 : 1;
+    audioSchedulerInit(&scheduler);
+    uint32_t random = 12345;
+    uint32_t order = 0;
+    uint64_t numFramesRendered = 0;
+    uint64_t numCommands = 0;
+    OrderCheck check = {};
+    check.passed = true;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        for(uint32_t i = 0; i < numPerUpdate; ++i)
+            addCommand(numFramesRendered + nextRandom(&random) % (2 * SAMPLE_RATE), order++);
+        numFramesRendered += FRAMES_PER_UPDATE;
+        AudioCommand command;
+        // Later adds can be for earlier frames, so only order within an update is checked
+        check.numPopped = 0;
+        while(audioSchedulerPopDue(&scheduler, numFramesRendered, &command))
+        {
+            checkPop(&check, &command);
+            ++numCommands;
+        }
+        // Checking the time costs about as much as a few commands
+        if(numFramesRendered % (100 * FRAMES_PER_UPDATE) == 0)
+            seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    *nsPerCommand = seconds * 1e9 / numCommands;
+    return check.passed;
+}
+
+int main()
+{
+    printf("%u commands at most, %u bytes\n", AUDIO_SCHEDULER_MAX_COMMANDS, (uint32_t)sizeof(AudioScheduler));
+    printf("%-12s %14s %14s %14s\n", "waiting", "ns per add", "ns per pop", "ns steady");
+    const uint32_t numsWaiting[] = { 256, 1024, AUDIO_SCHEDULER_MAX_COMMANDS / 2, AUDIO_SCHEDULER_MAX_COMMANDS };
+    bool passed = true;
+    for(uint32_t numWaiting : numsWaiting)
+    {
+        double nsPerAdd, nsPerPop, nsSteady;
+        bool isOrdered = timeFillAndEmpty(numWaiting, &nsPerAdd, &nsPerPop);
+        // Steady state runs at about half full, so the scheduler doesn't fill up
+        isOrdered = timeSteady(numWaiting / 2, &nsSteady) && isOrdered;
+        printf("%-12u %14.1f %14.1f %14.1f%s\n", numWaiting, nsPerAdd, nsPerPop, nsSteady, isOrdered ? "" : " FAILED");
+        passed = isOrdered && passed;
+    }
+    printf(passed ? "All commands came out in order\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+// Replays a made-up trace of a game asking the clip cache for sounds, to see how
+// the least recently used policy does at a few budgets. The game moves through
+// levels, each with its own set of sounds overlapping the one before, plus a few
+// sounds used everywhere, with some sounds asked for far more than others. Loads
+// take a time based on their size, and clips stay in use while they play, so
+// they can't be evicted. There's no I/O: a fake loader makes up each clip.
+// Sounds asked for while they're loading are queued and played once they've
+// loaded, and it reports how many updates late they started on average.
+// Also checks hits never start a load, playing clips are never evicted, the
+// cache only stays over budget when everything loaded is playing, every queued
+// play is either played once its clip has loaded or dropped, and a get that
+// waits for a load on another thread wakes up when it finishes.
+// Usage: BenchmarkClipCache
+// Returns 1 if any check fails.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include "../ClipCache.h"
+
+#define NUM_ASSETS 2000
+#define NUM_GLOBAL_ASSETS 50
+#define NUM_LEVEL_ASSETS 150
+// How far along each level's sounds start from the last level's, so neighbours share some
+#define LEVEL_ASSET_STRIDE 100
+#define NUM_LEVELS 10
+#define UPDATES_PER_SECOND 60
+#define UPDATES_PER_LEVEL (60 * UPDATES_PER_SECOND)
+#define GETS_PER_UPDATE 4
+#define MAX_VOICES 32
+// Pretend disk: a fixed cost per load plus this many bytes per second
+#define LOAD_LATENCY_MICROSECONDS 2000
+#define LOAD_BYTES_PER_SECOND (100 * 1024 * 1024)
+// 16-bit stereo at 48kHz, to turn sizes into how long clips play for
+#define BYTES_PER_SECOND_OF_AUDIO (48000 * 4)
+
+static uint32_t assetSizes[NUM_ASSETS];
+
+// Loads finish some number of updates after they start, in the order they
+// would on a disk that does one at a time
+struct FakeClipLoader {
+    ClipLoader loader;
+    uint32_t currentUpdate;
+    uint32_t diskFreeAtUpdate;
+    uint32_t readyUpdate[CLIP_CACHE_MAX_CLIPS];
+    bool isLoading[CLIP_CACHE_MAX_CLIPS];
+    ClipCache* cache;
+    uint32_t numLoads;
+    uint64_t numBytesRead;
+    uint32_t numPlayingEvictions;
+};
+
+static uint32_t assetIndex(const char* filename)
+{
+    // "sfx/1234.wav"
+    return (uint32_t)strtoul(filename + 4, nullptr, 10);
+}
+
+static void fakeStartLoad(ClipLoader* loader, CachedClip* cachedClip)
+{
+    FakeClipLoader* fakeLoader = (FakeClipLoader*)loader;
+    uint32_t slot = (uint32_t)(cachedClip - fakeLoader->cache->clips);
+    uint32_t numBytes = assetSizes[assetIndex(cachedClip->filename)];
+    uint64_t loadTimeMicroseconds = LOAD_LATENCY_MICROSECONDS + (uint64_t)numBytes * 1000000 / LOAD_BYTES_PER_SECOND;
+    uint32_t loadTimeUpdates = (uint32_t)(loadTimeMicroseconds * UPDATES_PER_SECOND / 1000000) + 1;
+    uint32_t startUpdate = fakeLoader->currentUpdate > fakeLoader->diskFreeAtUpdate ? fakeLoader->currentUpdate
+                                                                                     : fakeLoader->diskFreeAtUpdate;
+    fakeLoader->diskFreeAtUpdate = startUpdate + loadTimeUpdates;
+    fakeLoader->readyUpdate[slot] = fakeLoader->diskFreeAtUpdate;
+    fakeLoader->isLoading[slot] = true;
+    cachedClip->numBytes = numBytes;
+    cachedClip->loadTimeMicroseconds = (uint32_t)loadTimeMicroseconds;
+    ++fakeLoader->numLoads;
+    fakeLoader->numBytesRead += numBytes;
+}
+
+static void fakeUnload(ClipLoader* loader, CachedClip* cachedClip)
+{
+    FakeClipLoader* fakeLoader = (FakeClipLoader*)loader;
+    if(cachedClip->numVoicesPlaying.load(std::memory_order_relaxed) > 0)
+        ++fakeLoader->numPlayingEvictions;
+}
+
+// What the loader's thread would do, all at once at the start of the update
+static void finishLoads(FakeClipLoader* fakeLoader)
+{
+    for(uint32_t slot = 0; slot < CLIP_CACHE_MAX_CLIPS; ++slot)
+    {
+        if(fakeLoader->isLoading[slot] && fakeLoader->readyUpdate[slot] <= fakeLoader->currentUpdate)
+        {
+            fakeLoader->isLoading[slot] = false;
+            clipCacheFinishLoad(&fakeLoader->cache->clips[slot], CACHED_CLIP_LOADED);
+        }
+    }
+}
+
+static uint32_t nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+// Zipf-ish: the sound at rank r is asked for in proportion to 1 / (r + 1)
+static uint32_t pickRank(uint32_t* random, const float* cumulativeWeights, uint32_t numRanks)
+{
+    float x = (nextRandom(random) / 16777216.f) * cumulativeWeights[numRanks - 1];
+    uint32_t rank = 0;
+    while(rank < numRanks - 1 && cumulativeWeights[rank] < x)
+        ++rank;
+    return rank;
+}
+
+struct ReplayResult {
+    uint32_t numGets;
+    uint32_t numHits;
+    uint32_t numMisses;
+    uint32_t numSlotsFull; // Misses that couldn't even start a load
+    uint32_t numLoads;
+    uint64_t numBytesRead;
+    uint32_t numEvictions;
+    uint32_t numQueued; // Plays asked for while their clip was loading
+    uint32_t numLatePlays;
+    uint64_t numUpdatesLate;
+    uint32_t numDroppedPlays;
+    uint64_t maxBytesLoaded;
+    double nsPerGet;
+    bool passed;
+};
+
+static ClipCache cache;
+static FakeClipLoader fakeLoader;
+
+struct Voice {
+    CachedClip* cachedClip;
+    uint32_t endUpdate;
+};
+
+// Voices cut off once they're all playing, like a real mixer's
+static void startVoice(Voice* voices, CachedClip* cachedClip, uint32_t update)
+{
+    for(uint32_t i = 0; i < MAX_VOICES; ++i)
+    {
+        if(!voices[i].cachedClip)
+        {
+            cachedClip->numVoicesPlaying.fetch_add(1, std::memory_order_relaxed);
+            voices[i].cachedClip = cachedClip;
+            voices[i].endUpdate = update + 1 + cachedClip->numBytes / (BYTES_PER_SECOND_OF_AUDIO / UPDATES_PER_SECOND);
+            break;
+        }
+    }
+}
+
+// Plays whatever queued plays have loaded, checking they really have
+static void startLoadedPlays(Voice* voices, uint32_t update, ReplayResult* result)
+{
+    PendingClipPlay plays[CLIP_CACHE_MAX_PENDING_PLAYS];
+    uint32_t numPlays = clipCacheTakeLoadedPlays(&cache, plays, CLIP_CACHE_MAX_PENDING_PLAYS);
+    for(uint32_t i = 0; i < numPlays; ++i)
+    {
+        if(plays[i].cachedClip->state.load(std::memory_order_acquire) != CACHED_CLIP_LOADED)
+            result->passed = false;
+        ++result->numLatePlays;
+        result->numUpdatesLate += update - plays[i].userData;
+        startVoice(voices, plays[i].cachedClip, update);
+    }
+}
+
+static ReplayResult replay(uint64_t byteBudget)
+{
+    fakeLoader = {};
+    fakeLoader.loader.startLoad = fakeStartLoad;
+    fakeLoader.loader.unload = fakeUnload;
+    fakeLoader.cache = &cache;
+    clipCacheInit(&cache, &fakeLoader.loader, byteBudget);
+
+    float globalWeights[NUM_GLOBAL_ASSETS];
+    float levelWeights[NUM_LEVEL_ASSETS];
+    float sum = 0.f;
+    for(uint32_t i = 0; i < NUM_GLOBAL_ASSETS; ++i)
+        globalWeights[i] = sum += 1.f / (i + 1);
+    sum = 0.f;
+    for(uint32_t i = 0; i < NUM_LEVEL_ASSETS; ++i)
+        levelWeights[i] = sum += 1.f / (i + 1);
+
+    Voice voices[MAX_VOICES] = {};
+    ReplayResult result = {};
+    result.passed = true;
+    uint32_t random = 1;
+    char filename[32];
+    double getSeconds = 0.0;
+    typedef std::chrono::steady_clock Clock;
+
+    for(uint32_t update = 0; update < NUM_LEVELS * UPDATES_PER_LEVEL; ++update)
+    {
+        fakeLoader.currentUpdate = update;
+        finishLoads(&fakeLoader);
+        for(uint32_t i = 0; i < MAX_VOICES; ++i)
+        {
+            if(voices[i].cachedClip && voices[i].endUpdate <= update)
+            {
+                voices[i].cachedClip->numVoicesPlaying.fetch_sub(1, std::memory_order_relaxed);
+                voices[i].cachedClip = nullptr;
+            }
+        }
+
+        uint32_t level = update / UPDATES_PER_LEVEL;
+        for(uint32_t get = 0; get < GETS_PER_UPDATE; ++get)
+        {
+            uint32_t asset;
+            if(nextRandom(&random) % 10 < 3)
+                asset = NUM_ASSETS - NUM_GLOBAL_ASSETS + pickRank(&random, globalWeights, NUM_GLOBAL_ASSETS);
+            else
+                asset = level * LEVEL_ASSET_STRIDE + pickRank(&random, levelWeights, NUM_LEVEL_ASSETS);
+            snprintf(filename, sizeof(filename), "sfx/%04u.wav", asset);
+
+            uint32_t numLoadsBefore = fakeLoader.numLoads;
+            uint32_t numPendingBefore = cache.numPendingPlays;
+            Clock::time_point startTime = Clock::now();
+            CachedClip* cachedClip = clipCacheGetOrQueue(&cache, filename, update);
+            getSeconds += std::chrono::duration<double>(Clock::now() - startTime).count();
+            ++result.numGets;
+            if(cachedClip && fakeLoader.numLoads != numLoadsBefore)
+                result.passed = false; // A hit did I/O
+            if(!cachedClip)
+            {
+                result.numQueued += cache.numPendingPlays - numPendingBefore;
+                // Either it's loading, or there was no free slot to load it into
+                bool isInCache = false;
+                for(uint32_t slot = 0; slot < CLIP_CACHE_MAX_CLIPS; ++slot)
+                    if(strcmp(cache.clips[slot].filename, filename) == 0)
+                        isInCache = true;
+                if(!isInCache)
+                    ++result.numSlotsFull;
+                continue;
+            }
+            startVoice(voices, cachedClip, update);
+        }
+
+        clipCacheUpdate(&cache);
+        if(cache.numBytesLoaded > result.maxBytesLoaded)
+            result.maxBytesLoaded = cache.numBytesLoaded;
+        // Over budget is only allowed when there's nothing left to evict
+        if(cache.numBytesLoaded > byteBudget)
+        {
+            for(uint32_t slot = 0; slot < CLIP_CACHE_MAX_CLIPS; ++slot)
+            {
+                CachedClip* cachedClip = &cache.clips[slot];
+                if(cachedClip->isLoadCounted && cachedClip->numVoicesPlaying.load(std::memory_order_relaxed) == 0)
+                    result.passed = false;
+            }
+        }
+        // After checking, since clips whose plays don't get a voice can be evicted again next update
+        startLoadedPlays(voices, update, &result);
+    }
+
+    for(uint32_t i = 0; i < MAX_VOICES; ++i)
+    {
+        if(voices[i].cachedClip)
+        {
+            voices[i].cachedClip->numVoicesPlaying.fetch_sub(1, std::memory_order_relaxed);
+            voices[i].cachedClip = nullptr;
+        }
+    }
+    // Everything still queued gets played once its load finishes
+    fakeLoader.currentUpdate = ~0u;
+    finishLoads(&fakeLoader);
+    clipCacheUpdate(&cache);
+    startLoadedPlays(voices, NUM_LEVELS * UPDATES_PER_LEVEL, &result);
+    if(cache.numPendingPlays != 0)
+        result.passed = false;
+    for(uint32_t i = 0; i < MAX_VOICES; ++i)
+        if(voices[i].cachedClip)
+            voices[i].cachedClip->numVoicesPlaying.fetch_sub(1, std::memory_order_relaxed);
+    clipCacheShutdown(&cache);
+
+    result.numHits = cache.numHits;
+    result.numMisses = cache.numMisses;
+    result.numEvictions = cache.numEvictions;
+    result.numDroppedPlays = cache.numDroppedPlays;
+    result.numLoads = fakeLoader.numLoads;
+    result.numBytesRead = fakeLoader.numBytesRead;
+    result.nsPerGet = getSeconds * 1e9 / result.numGets;
+    // Nothing fails to load here, so plays are only dropped when they can't be queued
+    if(result.numHits + result.numMisses != result.numGets || fakeLoader.numPlayingEvictions > 0 ||
+       result.numQueued != result.numLatePlays)
+        result.passed = false;
+    return result;
+}
+
+// Finishes each load on its own thread a little later, like a real loader would
+static void threadStartLoad(ClipLoader*, CachedClip* cachedClip)
+{
+    cachedClip->numBytes = 1024;
+    std::thread([cachedClip] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        clipCacheFinishLoad(cachedClip, CACHED_CLIP_LOADED);
+    }).detach();
+}
+
+static void threadUnload(ClipLoader*, CachedClip*)
+{
+}
+
+static bool testWaitForLoad()
+{
+    static ClipLoader threadLoader = { threadStartLoad, threadUnload };
+    clipCacheInit(&cache, &threadLoader, 1 << 20);
+    CachedClip* cachedClip = clipCacheGet(&cache, "sfx/0000.wav", true);
+    bool passed = cachedClip && cachedClip->state.load(std::memory_order_acquire) == CACHED_CLIP_LOADED;
+    // And a second one that's only waited for at shutdown
+    clipCacheGet(&cache, "sfx/0001.wav");
+    clipCacheShutdown(&cache);
+    for(uint32_t slot = 0; slot < CLIP_CACHE_MAX_CLIPS; ++slot)
+        if(cache.clips[slot].state.load(std::memory_order_relaxed) != CACHED_CLIP_EMPTY)
+            passed = false;
+    return passed;
+}
+
+int main()
+{
+    // Sizes spread evenly in octaves from 16KB to 8MB, the same every run
+    uint32_t random = 12345;
+    uint64_t totalBytes = 0;
+    for(uint32_t i = 0; i < NUM_ASSETS; ++i)
+    {
+        float octaves = 9.f * (nextRandom(&random) / 16777216.f);
+        assetSizes[i] = (uint32_t)(16 * 1024 * exp2f(octaves));
+        totalBytes += assetSizes[i];
+    }
+
+    printf("%u sounds, %llu MB in total, %u levels of %u sounds, %u gets\n", NUM_ASSETS,
+           (unsigned long long)(totalBytes >> 20), NUM_LEVELS, NUM_LEVEL_ASSETS, NUM_LEVELS * UPDATES_PER_LEVEL * GETS_PER_UPDATE);
+    printf("%-10s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "budget", "hit rate", "loads", "MB read", "evictions",
+           "slots full", "queued", "dropped", "late", "max MB", "ns/get");
+    const uint64_t budgetsInMb[] = { 16, 64, 256, 1024 };
+    bool passed = true;
+    for(uint64_t budgetInMb : budgetsInMb)
+    {
+        ReplayResult result = replay(budgetInMb << 20);
+        // Late is how many updates queued plays waited for their load, on average
+        printf("%-10llu %9.1f%% %10u %10llu %10u %10u %10u %10u %10.1f %10llu %10.1f%s\n", (unsigned long long)budgetInMb,
+               100.0 * result.numHits / result.numGets, result.numLoads, (unsigned long long)(result.numBytesRead >> 20),
+               result.numEvictions, result.numSlotsFull, result.numQueued, result.numDroppedPlays,
+               result.numLatePlays ? (double)result.numUpdatesLate / result.numLatePlays : 0.0,
+               (unsigned long long)(result.maxBytesLoaded >> 20), result.nsPerGet, result.passed ? "" : " FAILED");
+        passed = result.passed && passed;
+    }
+
+    bool waitedForLoad = testWaitForLoad();
+    printf("Waiting for a load on another thread: %s\n", waitedForLoad ? "ok" : "FAILED");
+    passed = waitedForLoad && passed;
+    printf(passed ? "All checks passed\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+// Measures resampling and mixing a lot of voices of the same clip, stored as
+// interleaved 16-bit the way it's loaded from a wav file and as the planar
+// float the clip cache converts it to, at the clip's own rate and pitched down.
+// Usage: BenchmarkClipLayouts
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../ConvertSamples.h"
+#include "../Mixer.h"
+
+// Time each case for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define SAMPLE_RATE 44100
+#define NUM_CLIP_FRAMES (10 * SAMPLE_RATE)
+#define NUM_VOICES 64
+#define NUM_OUTPUT_FRAMES SAMPLE_RATE
+
+static Mixer mixer;
+static int16_t output[2 * NUM_OUTPUT_FRAMES];
+
+// Returns ns per voice per frame
+static double timeClip(const AudioClip* clip, float pitch)
+{
+    typedef std::chrono::steady_clock Clock;
+    mixerInit(&mixer, SAMPLE_RATE);
+    for(uint32_t i = 0; i < NUM_VOICES; ++i)
+        mixerPlay(&mixer, clip, 1.f / NUM_VOICES, 0.f, pitch, true);
+
+    uint64_t numFrames = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        mixerRender(&mixer, output, NUM_OUTPUT_FRAMES);
+        numFrames += NUM_OUTPUT_FRAMES;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds * 1e9 / ((double)NUM_VOICES * numFrames);
+}
+
+int main()
+{
+    int16_t* interleavedSamples = (int16_t*)malloc(2 * NUM_CLIP_FRAMES * sizeof(int16_t));
+    float* planarSamples = (float*)aligned_alloc(64, 2 * planarStride(NUM_CLIP_FRAMES) * sizeof(float));
+    if(!interleavedSamples || !planarSamples)
+        return 1;
+    uint32_t random = 12345;
+    for(uint32_t i = 0; i < 2 * NUM_CLIP_FRAMES; ++i)
+    {
+        random = random * 1664525 + 1013904223;
+        interleavedSamples[i] = (int16_t)(random >> 16);
+    }
+    convertSamplesToPlanarFloat(interleavedSamples, SAMPLE_FORMAT_PCM, 16, 2, NUM_CLIP_FRAMES, planarSamples);
+
+    AudioClip interleavedClip = {};
+    interleavedClip.sampleFormat = SAMPLE_FORMAT_PCM;
+    interleavedClip.layout = SAMPLE_LAYOUT_INTERLEAVED;
+    interleavedClip.numChannels = 2;
+    interleavedClip.numBitsPerSample = 16;
+    interleavedClip.sampleRate = SAMPLE_RATE;
+    interleavedClip.numSamples = 2 * NUM_CLIP_FRAMES;
+    interleavedClip.samples = interleavedSamples;
+    AudioClip planarClip = interleavedClip;
+    planarClip.sampleFormat = SAMPLE_FORMAT_FLOAT;
+    planarClip.layout = SAMPLE_LAYOUT_PLANAR;
+    planarClip.numBitsPerSample = 32;
+    planarClip.planeStride = planarStride(NUM_CLIP_FRAMES);
+    planarClip.samples = planarSamples;
+
+    printf("%u voices of a stereo clip, 16-bit stereo output at %uHz, ns per voice per frame\n", NUM_VOICES, SAMPLE_RATE);
+    printf("%-12s %14s %14s\n", "", "pitch 1", "pitch 0.93");
+    printf("%-12s %14.2f %14.2f\n", "interleaved", timeClip(&interleavedClip, 1.f), timeClip(&interleavedClip, 0.93f));
+    printf("%-12s %14.2f %14.2f\n", "planar", timeClip(&planarClip, 1.f), timeClip(&planarClip, 0.93f));
+
+    free(interleavedSamples);
+    free(planarSamples);
+    return 0;
+}
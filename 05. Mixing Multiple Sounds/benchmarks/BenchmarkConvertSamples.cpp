@@ -0,0 +1,160 @@
+// Measures how many frames per second each sample format converts to float, as
+// the clip cache does when it loads a clip, interleaved and split into planes,
+// next to a plain one-sample-at-a-time loop. Also checks the converters give
+// exactly what the plain loop does, for every length up to a few vectors so
+// the leftover samples at the end get checked too.
+// Usage: BenchmarkConvertSamples
+// Returns 1 if any converter's output is wrong.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "../ConvertSamples.h"
+
+// Time each format for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define NUM_CHANNELS 2
+// 1 second at 48kHz, a typical sound effect
+#define NUM_FRAMES 48000
+#define NUM_SAMPLES (NUM_FRAMES * NUM_CHANNELS)
+
+static uint8_t source[NUM_SAMPLES * 4];
+alignas(64) static float dest[NUM_CHANNELS * (NUM_FRAMES + 16)];
+alignas(64) static float expected[NUM_SAMPLES];
+
+// What the converters have to match, a sample at a time
+static void referenceConvert(const uint8_t* src, SampleFormat sampleFormat, uint32_t numBitsPerSample,
+                             uint32_t numSamples, float* out)
+{
+    for(uint32_t i = 0; i < numSamples; ++i)
+    {
+        const uint8_t* s = src + i * (numBitsPerSample / 8);
+        if(sampleFormat == SAMPLE_FORMAT_FLOAT)
+        {
+            memcpy(&out[i], s, sizeof(float));
+            continue;
+        }
+        switch(numBitsPerSample)
+        {
+            case 8: out[i] = ((int)s[0] - 128) * (1.f / 128.f); break;
+            case 16: out[i] = (int16_t)(s[0] | (s[1] << 8)) * (1.f / 32768.f); break;
+            case 24:
+                out[i] = (int32_t)(((uint32_t)s[0] << 8) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 24))
+                         * (1.f / 2147483648.f);
+                break;
+            case 32:
+                out[i] = (int32_t)((uint32_t)s[0] | ((uint32_t)s[1] << 8) | ((uint32_t)s[2] << 16) | ((uint32_t)s[3] << 24))
+                         * (1.f / 2147483648.f);
+                break;
+        }
+    }
+}
+
+// Random bytes make valid samples of every integer format. Floats
+// are made separately so they're all in range and not NaNs
+static void makeSource(SampleFormat sampleFormat)
+{
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < sizeof(source); ++i)
+    {
+        random = random * 1664525 + 1013904223;
+        source[i] = (uint8_t)(random >> 24);
+    }
+    if(sampleFormat == SAMPLE_FORMAT_FLOAT)
+    {
+        float* samples = (float*)source;
+        for(uint32_t i = 0; i < NUM_SAMPLES; ++i)
+            samples[i] = (int32_t)(i * 2654435761u) / 2147483648.f;
+    }
+}
+
+static bool checkFormat(SampleFormat sampleFormat, uint32_t numBitsPerSample)
+{
+    // Every length, and every start byte so unaligned sources get checked too
+    for(uint32_t offset = 0; offset < 4; ++offset)
+    {
+        for(uint32_t numSamples = 0; numSamples <= 64; ++numSamples)
+        {
+            const uint8_t* src = source + offset * numBitsPerSample / 8;
+            referenceConvert(src, sampleFormat, numBitsPerSample, numSamples, expected);
+            dest[numSamples] = -2.f;
+            convertSamplesToFloat(src, sampleFormat, numBitsPerSample, numSamples, dest);
+            if(memcmp(dest, expected, numSamples * sizeof(float)) != 0 || dest[numSamples] != -2.f)
+                return false;
+        }
+    }
+    referenceConvert(source, sampleFormat, numBitsPerSample, NUM_SAMPLES, expected);
+    convertSamplesToPlanarFloat(source, sampleFormat, numBitsPerSample, NUM_CHANNELS, NUM_FRAMES, dest);
+    uint32_t stride = planarStride(NUM_FRAMES);
+    for(uint32_t i = 0; i < NUM_SAMPLES; ++i)
+        if(dest[(i % NUM_CHANNELS) * stride + i / NUM_CHANNELS] != expected[i])
+            return false;
+    return true;
+}
+
+enum ConvertMethod {
+    CONVERT_REFERENCE,
+    CONVERT_INTERLEAVED,
+    CONVERT_PLANAR,
+};
+
+// Returns frames per second
+static double timeConvert(SampleFormat sampleFormat, uint32_t numBitsPerSample, ConvertMethod method)
+{
+    typedef std::chrono::steady_clock Clock;
+    uint64_t numFrames = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        switch(method)
+        {
+            case CONVERT_REFERENCE: referenceConvert(source, sampleFormat, numBitsPerSample, NUM_SAMPLES, dest); break;
+            case CONVERT_INTERLEAVED: convertSamplesToFloat(source, sampleFormat, numBitsPerSample, NUM_SAMPLES, dest); break;
+            case CONVERT_PLANAR:
+                convertSamplesToPlanarFloat(source, sampleFormat, numBitsPerSample, NUM_CHANNELS, NUM_FRAMES, dest);
+                break;
+        }
+        numFrames += NUM_FRAMES;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return numFrames / seconds;
+}
+
+int main()
+{
+    struct Format {
+        const char* name;
+        SampleFormat sampleFormat;
+        uint32_t numBitsPerSample;
+    };
+    const Format formats[] = {
+        { "8-bit",  SAMPLE_FORMAT_PCM,   8 },
+        { "16-bit", SAMPLE_FORMAT_PCM,   16 },
+        { "24-bit", SAMPLE_FORMAT_PCM,   24 },
+        { "32-bit", SAMPLE_FORMAT_PCM,   32 },
+        { "float",  SAMPLE_FORMAT_FLOAT, 32 },
+    };
+
+    printf("Stereo, M frames per second\n");
+    printf("%-10s %14s %14s %14s\n", "", "one at a time", "interleaved", "planar");
+    bool passed = true;
+    for(const Format& format : formats)
+    {
+        makeSource(format.sampleFormat);
+        if(!checkFormat(format.sampleFormat, format.numBitsPerSample))
+        {
+            printf("FAILED: %s doesn't convert the same as one sample at a time\n", format.name);
+            passed = false;
+            continue;
+        }
+        printf("%-10s %14.1f %14.1f %14.1f\n", format.name,
+               timeConvert(format.sampleFormat, format.numBitsPerSample, CONVERT_REFERENCE) / 1e6,
+               timeConvert(format.sampleFormat, format.numBitsPerSample, CONVERT_INTERLEAVED) / 1e6,
+               timeConvert(format.sampleFormat, format.numBitsPerSample, CONVERT_PLANAR) / 1e6);
+    }
+    return passed ? 0 : 1;
+}
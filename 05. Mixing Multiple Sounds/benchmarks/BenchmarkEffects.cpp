@@ -0,0 +1,86 @@
+// Measures what each effect and the reverb cost per stereo frame, on blocks of
+// noise the size of a mixer pass. Cycles are timestamp counter ticks, which on
+// modern CPUs run at a fixed rate rather than the core's current clock speed.
+// The block is refilled before each run so repeated filtering can't drive it to zero.
+// Usage: BenchmarkEffects
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <x86intrin.h> // __rdtsc
+#include <chrono>
+
+#include "../Effects.h"
+#include "../Mixer.h"
+
+// Time each effect for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define SAMPLE_RATE 48000
+#define NUM_FRAMES MIXER_MAX_FRAMES_PER_PASS
+
+alignas(16) static float noise[NUM_FRAMES];
+alignas(16) static float left[NUM_FRAMES];
+alignas(16) static float right[NUM_FRAMES];
+static Reverb reverb;
+
+// Runs one effect, or the reverb if effect is null, until enough time has gone by
+static void timeEffect(const char* name, Effect* effect)
+{
+    typedef std::chrono::steady_clock Clock;
+    uint64_t numCycles = 0;
+    uint64_t numFrames = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        if(effect)
+        {
+            memcpy(left, noise, sizeof(noise));
+            memcpy(right, noise, sizeof(noise));
+        }
+        else
+        {
+            memset(left, 0, sizeof(left));
+            memset(right, 0, sizeof(right));
+        }
+        uint64_t startCycles = __rdtsc();
+        if(effect)
+            effectProcess(effect, left, right, NUM_FRAMES);
+        else
+            reverbProcess(&reverb, noise, left, right, NUM_FRAMES);
+        numCycles += __rdtsc() - startCycles;
+        numFrames += NUM_FRAMES;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    printf("%-12s %16.2f\n", name, (double)numCycles / numFrames);
+}
+
+int main()
+{
+    uint32_t random = 12345;
+    for(uint32_t i = 0; i < NUM_FRAMES; ++i)
+    {
+        random = random * 1664525 + 1013904223;
+        noise[i] = (int32_t)random * (0.5f / 2147483648.f);
+    }
+
+    printf("%u frame blocks at %uHz\n", NUM_FRAMES, SAMPLE_RATE);
+    printf("%-12s %16s\n", "", "cycles per frame");
+    const char* effectNames[] = { "none", "low-pass", "high-pass", "peaking EQ", "low shelf", "high shelf", "limiter" };
+    for(uint32_t type = EFFECT_NONE; type <= EFFECT_LIMITER; ++type)
+    {
+        EffectParams params = {};
+        params.type = (EffectType)type;
+        params.frequency = 1000.f;
+        params.q = 0.707f;
+        params.gainDb = -6.f;
+        params.releaseMs = 100.f;
+        Effect effect = {};
+        effectSet(&effect, &params, SAMPLE_RATE);
+        timeEffect(effectNames[type], &effect);
+    }
+
+    reverbInit(&reverb, SAMPLE_RATE, 0.5f, 0.5f, 1.f);
+    timeEffect("reverb", nullptr);
+    return 0;
+}
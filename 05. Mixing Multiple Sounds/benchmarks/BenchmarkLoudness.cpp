@@ -0,0 +1,118 @@
+// Measures how fast clips can be loudness analysed, as the clip cache does when
+// it loads them, with 1 up to every core working through a batch of clips at once.
+// Half the clips are interleaved 16-bit and half planar float, like the two
+// formats the cache usually ends up with.
+// Usage: BenchmarkLoudness
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "../Loudness.h"
+
+#define SAMPLE_RATE 48000
+#define NUM_CLIPS 32
+#define CLIP_SECONDS 20
+#define NUM_CLIP_FRAMES (SAMPLE_RATE * CLIP_SECONDS)
+// Time each thread count for at least this long
+#define MIN_BENCHMARK_SECONDS 0.5
+#define MAX_THREADS 64
+
+static AudioClip clips[NUM_CLIPS];
+static LoudnessStats stats[NUM_CLIPS];
+static std::atomic<uint32_t> nextClip;
+
+// A tone that gets louder and quieter with some noise on top,
+// so the gates and the histograms all get a workout
+static void makeClips()
+{
+    uint32_t random = 1;
+    for(uint32_t c = 0; c < NUM_CLIPS; ++c)
+    {
+        AudioClip* clip = &clips[c];
+        bool isPlanar = c & 1;
+        clip->sampleFormat = isPlanar ? SAMPLE_FORMAT_FLOAT : SAMPLE_FORMAT_PCM;
+        clip->layout = isPlanar ? SAMPLE_LAYOUT_PLANAR : SAMPLE_LAYOUT_INTERLEAVED;
+        clip->numChannels = 2;
+        clip->numBitsPerSample = isPlanar ? 32 : 16;
+        clip->sampleRate = SAMPLE_RATE;
+        clip->numSamples = NUM_CLIP_FRAMES * 2;
+        clip->planeStride = NUM_CLIP_FRAMES;
+        clip->samples = malloc((size_t)NUM_CLIP_FRAMES * 2 * (isPlanar ? sizeof(float) : sizeof(int16_t)));
+        const double frequency = 110.0 * (c + 1);
+        for(uint32_t i = 0; i < NUM_CLIP_FRAMES; ++i)
+        {
+            double t = (double)i / SAMPLE_RATE;
+            double envelope = 0.05 + 0.2 * (1.0 + sin(2 * M_PI * 0.25 * t));
+            random = random * 1664525 + 1013904223;
+            float left = (float)(envelope * sin(2 * M_PI * frequency * t)) + (float)(int32_t)random / 2147483648.f * 0.02f;
+            float right = (float)(envelope * cos(2 * M_PI * frequency * t));
+            if(isPlanar)
+            {
+                ((float*)clip->samples)[i] = left;
+                ((float*)clip->samples)[NUM_CLIP_FRAMES + i] = right;
+            }
+            else
+            {
+                ((int16_t*)clip->samples)[i * 2] = (int16_t)(left * 32767.f);
+                ((int16_t*)clip->samples)[i * 2 + 1] = (int16_t)(right * 32767.f);
+            }
+        }
+    }
+}
+
+static void analyseClips()
+{
+    uint32_t clipIndex;
+    while((clipIndex = nextClip.fetch_add(1)) < NUM_CLIPS)
+        loudnessAnalyseClip(&clips[clipIndex], &stats[clipIndex]);
+}
+
+// Returns hours of audio analysed per second
+static double timeThreads(uint32_t numThreads)
+{
+    typedef std::chrono::steady_clock Clock;
+    std::thread threads[MAX_THREADS];
+    uint32_t numBatches = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        nextClip = 0;
+        for(uint32_t i = 1; i < numThreads; ++i)
+            threads[i] = std::thread(analyseClips);
+        analyseClips();
+        for(uint32_t i = 1; i < numThreads; ++i)
+            threads[i].join();
+        ++numBatches;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return numBatches * (double)NUM_CLIPS * CLIP_SECONDS / 3600.0 / seconds;
+}
+
+int main()
+{
+    makeClips();
+    uint32_t maxThreads = std::thread::hardware_concurrency();
+    if(maxThreads < 1) maxThreads = 1;
+    if(maxThreads > MAX_THREADS) maxThreads = MAX_THREADS;
+
+    printf("%u clips of %u s at %u Hz\n", NUM_CLIPS, CLIP_SECONDS, SAMPLE_RATE);
+    printf("%8s %22s %10s\n", "threads", "hours of audio per s", "speedup");
+    double singleThreaded = 0.0;
+    for(uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        double hoursPerSecond = timeThreads(numThreads);
+        if(numThreads == 1)
+            singleThreaded = hoursPerSecond;
+        printf("%8u %22.2f %9.2fx\n", numThreads, hoursPerSecond, hoursPerSecond / singleThreaded);
+    }
+    printf("Clip 0: %.1f LUFS, %.1f LU range, %.1f dBTP\n",
+           stats[0].integratedLufs, stats[0].loudnessRangeLu, stats[0].truePeakDbtp);
+    return 0;
+}
@@ -0,0 +1,879 @@
+// Runs the whole pipeline offline, from parsing wav files through converting,
+// decoding, resampling, mixing and writing the device's format, and picking that
+// format from mocked up WAVEFORMATEXs, and checks every stage's output against
+// golden results so a change that alters the sound (or slows it down) gets caught.
+// Usage: BenchmarkRegression [-d wavDirectory] [-w results.csv] [-c golden.csv] [-t percent]
+//   -d  where HelloWorld.wav and Testing48kHz.wav are, .. by default
+//   -w  writes the results, e.g. to make a new golden file after a deliberate change
+//   -c  compares against a golden file, e.g. golden.csv next to this. Each scenario has
+//       to produce exactly the same output, or failing that (e.g. with another compiler's
+//       sinf) the same level in every channel and every eighth of the output to within a
+//       small tolerance, and can't allocate more often. Scenarios with no level to compare
+//       have to match exactly
+//   -t  also fails any scenario more than percent slower per frame than the golden
+//       file. Only meaningful against a file written on the same machine
+// Results go to stdout as CSV. Returns 1 if anything failed. The scenarios that don't
+// output audio count something else as a frame: parse_wav a file and
+// choose_output_format a format, so their timings are per file or format.
+//
+// Everything is deterministic: the mixer runs without an audio thread, but the
+// scenes go through the command queue and AudioRenderer exactly like main.cpp,
+// into a NullAudioOutput, and the generated signals come from a fixed seed. Each scenario runs repeatedly
+// for timing and has to give the same output every time.
+
+#define _USE_MATH_DEFINES
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#include "../AudioCommandQueue.h"
+#include "../AudioOutput.h"
+#include "../AudioRenderer.h"
+#include "../ConvertSamples.h"
+#include "../ImaAdpcm.h"
+#include "../LoadWavFile.h"
+#include "../Mixer.h"
+#include "../OutputFormat.h"
+
+// Run each scenario for at least this long
+#define MIN_BENCHMARK_SECONDS 0.25
+#define MIN_RUNS 3
+#define OUTPUT_SAMPLE_RATE 44100
+#define GAME_UPDATES_PER_SECOND 60
+#define MAX_SCENARIOS 32
+// How far off the golden levels an output that doesn't match exactly may be
+#define RMS_TOLERANCE_DB 0.05
+#define PEAK_TOLERANCE (4.0 / 32768.0)
+// Levels are kept for each channel over each of this many equal parts of the output,
+// so a mistake in one part or one channel doesn't get lost in the overall level
+#define RESULT_MAX_CHANNELS 8
+#define RESULT_NUM_BLOCKS 8
+// Anything quieter counts as silence when comparing levels
+#define SILENCE_DB -100.0
+
+// build.sh links with --wrap so every allocation our code makes comes through here
+static std::atomic<uint64_t> numAllocations;
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* memory, size_t size);
+void* __real_aligned_alloc(size_t alignment, size_t size);
+void* __wrap_malloc(size_t size) { ++numAllocations; return __real_malloc(size); }
+void* __wrap_calloc(size_t count, size_t size) { ++numAllocations; return __real_calloc(count, size); }
+void* __wrap_realloc(void* memory, size_t size) { ++numAllocations; return __real_realloc(memory, size); }
+void* __wrap_aligned_alloc(size_t alignment, size_t size) { ++numAllocations; return __real_aligned_alloc(alignment, size); }
+}
+void* operator new(size_t size)
+{
+    void* memory = malloc(size ? size : 1);
+    if(!memory) throw std::bad_alloc();
+    return memory;
+}
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+
+// What a scenario's output boils down to
+struct ScenarioResult {
+    uint64_t hash; // FNV-1a of the output, for an exact match
+    uint64_t numFrames;
+    // Levels of the output in [-1, 1], for a close match. 0 channels
+    // for the scenarios with no level, which have to match exactly
+    uint32_t numChannels;
+    double rms;
+    double peak;
+    double channelPeaks[RESULT_MAX_CHANNELS];
+    double blockRmsDb[RESULT_MAX_CHANNELS][RESULT_NUM_BLOCKS];
+    uint64_t numFramesAdded; // Only used until resultFinish
+};
+
+struct Scenario {
+    const char* name;
+    void (*run)(ScenarioResult* result);
+};
+
+// What runScenario found
+struct ScenarioRun {
+    ScenarioResult result;
+    double nsPerFrame;
+    double allocationsPerRun;
+    bool isDeterministic;
+};
+
+struct GoldenResult {
+    char name[64];
+    ScenarioResult result;
+    double nsPerFrame;
+    double allocationsPerRun;
+};
+
+struct WavFile {
+    uint8_t* bytes;
+    uint32_t size;
+};
+
+static WavFile helloWorldFile;
+static WavFile testingFile;
+static AudioClip helloWorld;         // Interleaved 16-bit, as in the file
+static AudioClip helloWorldPlanar;   // Converted to planar float like the clip cache does
+static AudioClip testing;            // Interleaved 16-bit mono at 48kHz
+static AudioClip sweep;              // Generated stereo 16-bit
+static AudioClip sweepAdpcm;         // The sweep compressed to IMA-ADPCM
+static AudioClip noise;              // Generated mono float
+static float convertedSamples[2 * (OUTPUT_SAMPLE_RATE * 5 + 16)];
+static int16_t decodedSamples[2 * OUTPUT_SAMPLE_RATE * 6];
+// The sweep as the mixer's float output would be, a bit too loud so the writers have to clamp it
+alignas(16) static float mixLeft[OUTPUT_SAMPLE_RATE * 5];
+alignas(16) static float mixRight[OUTPUT_SAMPLE_RATE * 5];
+// What the writers make of it
+alignas(16) static uint8_t output[OUTPUT_SAMPLE_RATE * 5 * OUTPUT_MAX_CHANNELS * sizeof(float)];
+
+// The scenes' audio thread, and the game's side of it
+static AudioRenderer renderer;
+static AudioCommandQueue commandQueue;
+
+static void hashBytes(uint64_t* hash, const void* bytes, size_t numBytes)
+{
+    for(size_t i = 0; i < numBytes; ++i)
+    {
+        *hash ^= ((const uint8_t*)bytes)[i];
+        *hash *= 0x100000001B3ull;
+    }
+}
+
+// numFrames is how many frames the scenario's output will have in the end
+static void resultInit(ScenarioResult* result, uint32_t numChannels, uint64_t numFrames)
+{
+    assert(numChannels <= RESULT_MAX_CHANNELS);
+    *result = {};
+    result->hash = 0xCBF29CE484222325ull;
+    result->numChannels = numChannels;
+    result->numFrames = numFrames;
+}
+
+// Adds the next numFrames of output to the levels, with channel c of frame i at
+// samples[i * frameStride + c * channelStride]. The rms and blockRmsDb are sums of squares until resultFinish
+template<typename SampleType>
+static void resultAddLevels(ScenarioResult* result, const SampleType* samples, uint32_t numFrames,
+                            uint32_t frameStride, uint32_t channelStride, double scale)
+{
+    assert(result->numFramesAdded + numFrames <= result->numFrames);
+    for(uint32_t i = 0; i < numFrames; ++i, ++result->numFramesAdded)
+    {
+        uint32_t block = (uint32_t)(result->numFramesAdded * RESULT_NUM_BLOCKS / result->numFrames);
+        for(uint32_t c = 0; c < result->numChannels; ++c)
+        {
+            double sample = samples[i * frameStride + c * channelStride] * scale;
+            result->rms += sample * sample;
+            result->blockRmsDb[c][block] += sample * sample;
+            if(fabs(sample) > result->channelPeaks[c])
+                result->channelPeaks[c] = fabs(sample);
+        }
+    }
+}
+
+// Adds the next numFrames of interleaved output
+template<typename SampleType>
+static void resultAdd(ScenarioResult* result, const SampleType* samples, uint32_t numFrames, double scale)
+{
+    hashBytes(&result->hash, samples, numFrames * result->numChannels * sizeof(SampleType));
+    resultAddLevels(result, samples, numFrames, result->numChannels, 1, scale);
+}
+
+static double levelDb(double rms)
+{
+    double db = rms > 0.0 ? 20.0 * log10(rms) : SILENCE_DB;
+    return db > SILENCE_DB ? db : SILENCE_DB;
+}
+
+static void resultFinish(ScenarioResult* result)
+{
+    if(!result->numChannels)
+        return;
+    assert(result->numFramesAdded == result->numFrames);
+    result->rms = sqrt(result->rms / ((double)result->numFrames * result->numChannels));
+    for(uint32_t c = 0; c < result->numChannels; ++c)
+    {
+        if(result->channelPeaks[c] > result->peak)
+            result->peak = result->channelPeaks[c];
+        for(uint32_t block = 0; block < RESULT_NUM_BLOCKS; ++block)
+        {
+            uint64_t firstFrame = result->numFrames * block / RESULT_NUM_BLOCKS;
+            uint64_t endFrame = result->numFrames * (block + 1) / RESULT_NUM_BLOCKS;
+            double sumOfSquares = result->blockRmsDb[c][block];
+            result->blockRmsDb[c][block] = levelDb(endFrame > firstFrame ? sqrt(sumOfSquares / (endFrame - firstFrame)) : 0.0);
+        }
+    }
+}
+
+static bool loadFile(const char* directory, const char* name, WavFile* file)
+{
+    char filename[1024];
+    snprintf(filename, sizeof(filename), "%s/%s", directory, name);
+    FILE* f = fopen(filename, "rb");
+    if(!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    file->bytes = (uint8_t*)malloc(size > 0 ? size : 1);
+    file->size = (uint32_t)size;
+    bool result = size >= 0 && fread(file->bytes, 1, size, f) == (size_t)size;
+    fclose(f);
+    return result;
+}
+
+static uint32_t nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state;
+}
+
+// Makes the test signals, computed in double so they come out
+// the same whatever the compiler does with float maths
+static void makeClips()
+{
+    // 5 seconds sweeping 50Hz to 15kHz, one channel a quarter turn behind the other
+    const uint32_t NUM_SWEEP_FRAMES = OUTPUT_SAMPLE_RATE * 5;
+    int16_t* sweepSamples = (int16_t*)malloc(NUM_SWEEP_FRAMES * 2 * sizeof(int16_t));
+    double phase = 0.0;
+    for(uint32_t i = 0; i < NUM_SWEEP_FRAMES; ++i)
+    {
+        double frequency = 50.0 * pow(300.0, (double)i / NUM_SWEEP_FRAMES);
+        phase += 2 * M_PI * frequency / OUTPUT_SAMPLE_RATE;
+        sweepSamples[i * 2] = (int16_t)lrint(sin(phase) * 16000.0);
+        sweepSamples[i * 2 + 1] = (int16_t)lrint(cos(phase) * 16000.0);
+        mixLeft[i] = (float)(sin(phase) * 1.25);
+        mixRight[i] = (float)(cos(phase) * 1.25);
+    }
+    sweep = {};
+    sweep.sampleFormat = SAMPLE_FORMAT_PCM;
+    sweep.layout = SAMPLE_LAYOUT_INTERLEAVED;
+    sweep.numChannels = 2;
+    sweep.numBitsPerSample = 16;
+    sweep.sampleRate = OUTPUT_SAMPLE_RATE;
+    sweep.numSamples = NUM_SWEEP_FRAMES * 2;
+    sweep.samples = sweepSamples;
+
+    const uint32_t NUM_BYTES_PER_BLOCK = 1024;
+    const uint32_t numFramesPerBlock = imaAdpcmFramesPerBlock(NUM_BYTES_PER_BLOCK, 2);
+    const uint32_t numBlocks = (NUM_SWEEP_FRAMES + numFramesPerBlock - 1) / numFramesPerBlock;
+    uint8_t* blocks = (uint8_t*)malloc(numBlocks * NUM_BYTES_PER_BLOCK);
+    ImaAdpcmEncoder encoder = {};
+    for(uint32_t block = 0; block < numBlocks; ++block)
+    {
+        uint32_t firstFrame = block * numFramesPerBlock;
+        uint32_t numFrames = NUM_SWEEP_FRAMES - firstFrame < numFramesPerBlock ? NUM_SWEEP_FRAMES - firstFrame : numFramesPerBlock;
+        imaAdpcmEncodeBlock(&encoder, sweepSamples + firstFrame * 2, 2, numFrames, NUM_BYTES_PER_BLOCK,
+                            blocks + block * NUM_BYTES_PER_BLOCK);
+    }
+    sweepAdpcm = sweep;
+    sweepAdpcm.sampleFormat = SAMPLE_FORMAT_IMA_ADPCM;
+    sweepAdpcm.numBitsPerSample = 4;
+    sweepAdpcm.samples = blocks;
+    sweepAdpcm.numBytesPerBlock = NUM_BYTES_PER_BLOCK;
+    sweepAdpcm.numFramesPerBlock = numFramesPerBlock;
+
+    // 1 second of white noise, looped by the scenes
+    const uint32_t NUM_NOISE_FRAMES = 48000;
+    float* noiseSamples = (float*)malloc(NUM_NOISE_FRAMES * sizeof(float));
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < NUM_NOISE_FRAMES; ++i)
+        noiseSamples[i] = (float)((int32_t)nextRandom(&random) / 2147483648.0 * 0.25);
+    noise = {};
+    noise.sampleFormat = SAMPLE_FORMAT_FLOAT;
+    noise.layout = SAMPLE_LAYOUT_INTERLEAVED;
+    noise.numChannels = 1;
+    noise.numBitsPerSample = 32;
+    noise.sampleRate = 48000;
+    noise.numSamples = NUM_NOISE_FRAMES;
+    noise.samples = noiseSamples;
+}
+
+// One frame per file
+static void runParse(ScenarioResult* result)
+{
+    WavFile* files[] = { &helloWorldFile, &testingFile };
+    resultInit(result, 0, sizeof(files) / sizeof(files[0]));
+    for(WavFile* file : files)
+    {
+        AudioClip clip;
+        WavChunkIndex chunks;
+        WavError error = parseWavFile(file->bytes, file->size, &clip, &chunks);
+        uint32_t fields[] = { (uint32_t)error, (uint32_t)clip.sampleFormat, clip.numChannels, clip.numBitsPerSample,
+                              clip.sampleRate, clip.numSamples, clip.loopStartFrame, clip.loopEndFrame,
+                              (uint32_t)((uint8_t*)clip.samples - file->bytes) };
+        hashBytes(&result->hash, fields, sizeof(fields));
+    }
+}
+
+static void runConvert(ScenarioResult* result)
+{
+    uint32_t numFrames = sweep.numSamples / 2;
+    resultInit(result, 2, numFrames);
+    convertSamplesToFloat(sweep.samples, sweep.sampleFormat, sweep.numBitsPerSample, sweep.numSamples, convertedSamples);
+    resultAdd(result, convertedSamples, numFrames, 1.0);
+    resultFinish(result);
+}
+
+static void runConvertPlanar(ScenarioResult* result)
+{
+    uint32_t numFrames = sweep.numSamples / 2;
+    uint32_t stride = planarStride(numFrames);
+    resultInit(result, 2, numFrames);
+    convertSamplesToPlanarFloat(sweep.samples, sweep.sampleFormat, sweep.numBitsPerSample, 2, numFrames, convertedSamples);
+    // The padding too, since it has to be zeroed
+    hashBytes(&result->hash, convertedSamples, 2 * stride * sizeof(float));
+    resultAddLevels(result, convertedSamples, numFrames, 1, stride, 1.0);
+    resultFinish(result);
+}
+
+static void runDecodeAdpcm(ScenarioResult* result)
+{
+    uint32_t numFrames = sweepAdpcm.numSamples / 2;
+    resultInit(result, 2, numFrames);
+    const uint8_t* block = (const uint8_t*)sweepAdpcm.samples;
+    for(uint32_t frame = 0; frame < numFrames; frame += sweepAdpcm.numFramesPerBlock)
+    {
+        uint32_t numBlockFrames = numFrames - frame < sweepAdpcm.numFramesPerBlock ? numFrames - frame : sweepAdpcm.numFramesPerBlock;
+        imaAdpcmDecodeBlock(block, 2, numBlockFrames, decodedSamples + frame * 2);
+        block += sweepAdpcm.numBytesPerBlock;
+    }
+    resultAdd(result, decodedSamples, numFrames, 1.0 / 32768.0);
+    resultFinish(result);
+}
+
+// Sends a command the way the game does. The renderer applies it straight away
+// or holds it in its scheduler until its frame, once the scene starts rendering
+static void schedule(const AudioCommand* command)
+{
+    bool result = pushAudioCommand(&commandQueue, command);
+    assert(result);
+    (void)result;
+}
+
+static AudioCommand makeCommand(AudioCommandType type, SoundHandle sound, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = type;
+    command.sound = sound;
+    command.frame = frame;
+    return command;
+}
+
+static void schedulePlay(SoundHandle sound, const AudioClip* clip, float gain, float pan, float pitch, bool looping,
+                         uint64_t frame)
+{
+    AudioCommand command = makeCommand(AUDIO_COMMAND_PLAY, sound, frame);
+    command.clip = clip;
+    command.gain = gain;
+    command.pan = pan;
+    command.pitch = pitch;
+    command.looping = looping;
+    schedule(&command);
+}
+
+static NullAudioOutput nullOutput;
+
+static void sceneInit(const AudioOutputFormat* format)
+{
+    audioRendererInit(&renderer, format->sampleRate);
+    mixerSetOutputFormat(&renderer.mixer, format);
+    nullAudioOutputInit(&nullOutput, format);
+    // Anything a scene before didn't get round to
+    AudioCommand command;
+    while(popAudioCommand(&commandQueue, &command)) {}
+}
+
+// Renders numFrames into the null output a game update at a time, the way main.cpp
+// renders offline, and adds each update's audio to the result once it's "played"
+static void sceneRender(uint32_t numFrames, ScenarioResult* result)
+{
+    const AudioOutputFormat* format = &nullOutput.output.format;
+    resultInit(result, format->numChannels, numFrames);
+    uint32_t numFramesPerUpdate = format->sampleRate / GAME_UPDATES_PER_SECOND;
+    for(uint32_t frame = 0; frame < numFrames; frame += numFramesPerUpdate)
+    {
+        uint32_t numFramesToRender = numFrames - frame < numFramesPerUpdate ? numFrames - frame : numFramesPerUpdate;
+        uint32_t bufferPadding = nullOutput.output.getCurrentPadding(&nullOutput.output);
+        audioRendererRender(&renderer, &commandQueue, &nullOutput.output, bufferPadding, numFramesToRender);
+        if(format->sampleType == OUTPUT_SAMPLE_FLOAT32)
+            resultAdd(result, (const float*)nullOutput.buffer, numFramesToRender, 1.0);
+        else
+            resultAdd(result, (const int16_t*)nullOutput.buffer, numFramesToRender, 1.0 / 32768.0);
+    }
+    assert(nullOutput.numFramesPlayed == numFrames);
+    resultFinish(result);
+}
+
+// One clip played straight through at a time, to check each resampling path on its own
+static void runResample(ScenarioResult* result, const AudioClip* clip, float pitch)
+{
+    AudioOutputFormat format = audioOutputFormatInt16Stereo(OUTPUT_SAMPLE_RATE);
+    sceneInit(&format);
+    schedulePlay(0, clip, 1.f, 0.f, pitch, false, 0);
+    uint32_t numFrames = (uint32_t)((uint64_t)(clip->numSamples / clip->numChannels) * OUTPUT_SAMPLE_RATE
+                                    / clip->sampleRate / pitch);
+    sceneRender(numFrames, result);
+}
+
+static void runResampleInt16(ScenarioResult* result) { runResample(result, &testing, 1.f); }
+static void runResamplePlanar(ScenarioResult* result) { runResample(result, &helloWorldPlanar, 1.37f); }
+static void runResampleFloat(ScenarioResult* result) { runResample(result, &noise, 0.81f); }
+static void runResampleAdpcm(ScenarioResult* result) { runResample(result, &sweepAdpcm, 1.f); }
+
+// The scene from main.cpp: music with an intro queued into a loop, occluded for a
+// while then faded out, and a sound effect every half second circling the listener
+static void runGameScene(ScenarioResult* result, const AudioOutputFormat* format)
+{
+    const uint32_t NUM_SECONDS = 10;
+    const uint32_t sampleRate = format->sampleRate;
+    sceneInit(format);
+    AudioCommand command = makeCommand(AUDIO_COMMAND_SET_LISTENER, 0, 0);
+    command.listener.forward[2] = 1.f;
+    command.listener.up[1] = 1.f;
+    schedule(&command);
+
+    schedulePlay(0, &helloWorldPlanar, 0.5f, 0.f, 1.f, false, 0);
+    command = makeCommand(AUDIO_COMMAND_QUEUE_CLIP, 0, 0);
+    command.clip = &helloWorldPlanar;
+    command.looping = true;
+    schedule(&command);
+    command = makeCommand(AUDIO_COMMAND_SET_EFFECT, 0, 3 * sampleRate);
+    command.effect.type = EFFECT_LOW_PASS;
+    command.effect.frequency = 600.f;
+    command.effect.q = 0.707f;
+    schedule(&command);
+    command = makeCommand(AUDIO_COMMAND_SET_EFFECT, 0, 6 * sampleRate);
+    schedule(&command);
+    const uint64_t FADE_OUT_START_FRAME = (uint64_t)(NUM_SECONDS - 2) * sampleRate;
+    command = makeCommand(AUDIO_COMMAND_RAMP_GAIN, 0, FADE_OUT_START_FRAME);
+    command.gain = 0.f;
+    command.numRampFrames = 2 * sampleRate;
+    schedule(&command);
+    command = makeCommand(AUDIO_COMMAND_RELEASE, 0, FADE_OUT_START_FRAME);
+    schedule(&command);
+
+    for(uint32_t beat = 1; beat < NUM_SECONDS * 2; ++beat)
+    {
+        uint64_t frame = (uint64_t)beat * sampleRate / 2;
+        SoundHandle sound = 1 + beat;
+        schedulePlay(sound, &testing, 0.8f, 0.f, 1.f - beat / 40.f, false, frame);
+        command = makeCommand(AUDIO_COMMAND_SET_REVERB_SEND, sound, frame);
+        command.reverbSend = 0.4f;
+        schedule(&command);
+        command = makeCommand(AUDIO_COMMAND_SET_TEMPO, sound, frame);
+        command.tempo = 1.f;
+        schedule(&command);
+        float angle = beat * (float)M_PI / 4.f;
+        float distance = 1.f + beat * 0.3f;
+        command = makeCommand(AUDIO_COMMAND_SET_POSITION, sound, frame);
+        command.position[0] = distance * (float)sin(angle);
+        command.position[2] = distance * (float)cos(angle);
+        schedule(&command);
+        command = makeCommand(AUDIO_COMMAND_SET_ATTENUATION, sound, frame);
+        command.attenuationCurve = ATTENUATION_INVERSE;
+        command.minDistance = 1.f;
+        command.maxDistance = 20.f;
+        command.rolloff = 1.f;
+        schedule(&command);
+    }
+    sceneRender(NUM_SECONDS * sampleRate, result);
+}
+
+static void runGameSceneInt16(ScenarioResult* result)
+{
+    AudioOutputFormat format = audioOutputFormatInt16Stereo(OUTPUT_SAMPLE_RATE);
+    runGameScene(result, &format);
+}
+
+// The same at the usual shared-mode mix format, float at 48kHz
+static void runGameSceneFloat48k(ScenarioResult* result)
+{
+    AudioOutputFormat format = { OUTPUT_SAMPLE_FLOAT32, 2, 48000, 2 * sizeof(float), 0x3 };
+    runGameScene(result, &format);
+}
+
+// And on a 5.1 device, where the sound effects go round the surrounds as well
+static void runGameSceneFloat51(ScenarioResult* result)
+{
+    AudioOutputFormat format = { OUTPUT_SAMPLE_FLOAT32, 6, 48000, 6 * sizeof(float), 0x3F };
+    runGameScene(result, &format);
+}
+
+// Lots of voices in every format and at every pitch at once, for throughput
+static void runManyVoices(ScenarioResult* result)
+{
+    const uint32_t NUM_VOICES = 64;
+    AudioOutputFormat format = audioOutputFormatInt16Stereo(OUTPUT_SAMPLE_RATE);
+    sceneInit(&format);
+    const AudioClip* clips[] = { &helloWorld, &helloWorldPlanar, &testing, &sweep, &sweepAdpcm, &noise };
+    const uint32_t numClips = sizeof(clips) / sizeof(clips[0]);
+    uint32_t random = 7;
+    for(uint32_t i = 0; i < NUM_VOICES; ++i)
+    {
+        float pitch = 0.5f + (nextRandom(&random) >> 8) / 16777216.f * 1.5f;
+        float pan = (nextRandom(&random) >> 8) / 8388608.f - 1.f;
+        schedulePlay(i, clips[i % numClips], 1.f / 16.f, pan, pitch, true, i * 441);
+        if(i % 4 == 0)
+        {
+            AudioCommand command = makeCommand(AUDIO_COMMAND_SET_EFFECT, i, i * 441);
+            command.effect.type = EFFECT_LOW_PASS;
+            command.effect.frequency = 2000.f + i * 100.f;
+            command.effect.q = 0.707f;
+            schedule(&command);
+        }
+        if(i % 8 == 1)
+        {
+            AudioCommand command = makeCommand(AUDIO_COMMAND_SET_POSITION, i, i * 441);
+            command.position[0] = (float)i - NUM_VOICES / 2;
+            command.position[2] = 4.f;
+            schedule(&command);
+        }
+    }
+    sceneRender(5 * OUTPUT_SAMPLE_RATE, result);
+}
+
+// Writes the mix a pass at a time like mixerRender does
+static void runWriter(ScenarioResult* result, OutputSampleType sampleType, uint32_t numChannels)
+{
+    const uint32_t numBytesPerSample[] = { 2, 3, 4, 4 };
+    AudioOutputFormat format = { sampleType, numChannels, OUTPUT_SAMPLE_RATE, numChannels * numBytesPerSample[sampleType], 0 };
+    MixWriter writer = chooseMixWriter(&format);
+    const uint32_t numFrames = sizeof(mixLeft) / sizeof(mixLeft[0]);
+    for(uint32_t frame = 0; frame < numFrames; frame += MIXER_MAX_FRAMES_PER_PASS)
+    {
+        uint32_t numPassFrames = numFrames - frame < MIXER_MAX_FRAMES_PER_PASS ? numFrames - frame : MIXER_MAX_FRAMES_PER_PASS;
+        const float* mix[2] = { mixLeft + frame, mixRight + frame };
+        writer(mix, 2, output + frame * format.numBytesPerFrame, numPassFrames, numChannels);
+    }
+    resultInit(result, 0, numFrames);
+    hashBytes(&result->hash, output, numFrames * format.numBytesPerFrame);
+}
+
+static void runWriteInt16Stereo(ScenarioResult* result) { runWriter(result, OUTPUT_SAMPLE_INT16, 2); }
+static void runWriteFloatStereo(ScenarioResult* result) { runWriter(result, OUTPUT_SAMPLE_FLOAT32, 2); }
+static void runWriteFloatMono(ScenarioResult* result) { runWriter(result, OUTPUT_SAMPLE_FLOAT32, 1); }
+static void runWriteInt24Surround(ScenarioResult* result) { runWriter(result, OUTPUT_SAMPLE_INT24, 6); }
+static void runWriteInt32Surround(ScenarioResult* result) { runWriter(result, OUTPUT_SAMPLE_INT32, 8); }
+static void runWriteInt16ThreeChannels(ScenarioResult* result) { runWriter(result, OUTPUT_SAMPLE_INT16, 3); }
+
+static void writeU32(uint8_t* dest, uint32_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+    dest[2] = (uint8_t)(value >> 16);
+    dest[3] = (uint8_t)(value >> 24);
+}
+
+static void writeU16(uint8_t* dest, uint16_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+}
+
+// Lays out a WAVEFORMATEX, or a WAVEFORMATEXTENSIBLE if subFormatTag isn't 0, the way
+// GetMixFormat returns one. Returns its size
+static uint32_t mockWaveFormat(uint8_t* bytes, uint16_t formatTag, uint16_t numChannels, uint32_t sampleRate,
+                               uint16_t numBitsPerSample, uint16_t subFormatTag = 0, uint16_t numValidBits = 0)
+{
+    static const uint8_t BASE_GUID[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+    uint16_t blockAlign = (uint16_t)(numChannels * numBitsPerSample / 8);
+    memset(bytes, 0, 40);
+    writeU16(bytes, subFormatTag ? 0xFFFE : formatTag);
+    writeU16(bytes + 2, numChannels);
+    writeU32(bytes + 4, sampleRate);
+    writeU32(bytes + 8, sampleRate * blockAlign);
+    writeU16(bytes + 12, blockAlign);
+    writeU16(bytes + 14, numBitsPerSample);
+    if(!subFormatTag)
+        return 18;
+    writeU16(bytes + 16, 22);
+    writeU16(bytes + 18, numValidBits ? numValidBits : numBitsPerSample);
+    writeU32(bytes + 20, numChannels == 2 ? 0x3 : 0x3F); // SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT, or 5.1
+    writeU32(bytes + 24, subFormatTag);
+    memcpy(bytes + 28, BASE_GUID, sizeof(BASE_GUID));
+    return 40;
+}
+
+// Formats devices really report, and some the mixer has to turn down
+static void runChooseOutputFormat(ScenarioResult* result)
+{
+    uint8_t waveFormats[16][40];
+    uint32_t sizes[16];
+    uint32_t numFormats = 0;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 2, 48000, 32, 0x0003); ++numFormats; // The usual one
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0x0001, 2, 44100, 16); ++numFormats;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 2, 96000, 32, 0x0001, 24); ++numFormats;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 6, 48000, 24, 0x0001); ++numFormats;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0x0003, 8, 192000, 32); ++numFormats;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 1, 16000, 16, 0x0001); ++numFormats;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0x0001, 2, 48000, 8); ++numFormats;      // 8-bit
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 2, 48000, 64, 0x0003); ++numFormats;  // Double
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0x0001, 10, 48000, 16); ++numFormats;    // Too many channels
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 2, 48000, 32, 0x0003); // Unknown GUID
+    waveFormats[numFormats][39] ^= 1;
+    ++numFormats;
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0, 2, 48000, 32, 0x0003) - 2; ++numFormats; // Cut short
+    sizes[numFormats] = mockWaveFormat(waveFormats[numFormats], 0x0001, 2, 48000, 16); // Wrong block align
+    writeU16(waveFormats[numFormats] + 12, 3);
+    ++numFormats;
+
+    resultInit(result, 0, numFormats);
+    for(uint32_t i = 0; i < numFormats; ++i)
+    {
+        AudioOutputFormat format = {};
+        bool isSupported = audioOutputFormatFromWaveFormat(waveFormats[i], sizes[i], &format);
+        uint32_t fields[] = { isSupported, (uint32_t)format.sampleType, format.numChannels, format.sampleRate,
+                              format.numBytesPerFrame, isSupported && chooseMixWriter(&format) != nullptr };
+        hashBytes(&result->hash, fields, sizeof(fields));
+    }
+}
+
+static bool sameResult(const ScenarioResult* a, const ScenarioResult* b)
+{
+    return a->hash == b->hash && a->numFrames == b->numFrames;
+}
+
+// Every channel's peak and its level in every block has to be within the tolerances
+static bool closeResult(const ScenarioResult* result, const ScenarioResult* expected)
+{
+    if(result->numFrames != expected->numFrames || result->numChannels != expected->numChannels
+       || expected->numChannels == 0)
+        return false;
+    for(uint32_t c = 0; c < expected->numChannels; ++c)
+    {
+        if(fabs(result->channelPeaks[c] - expected->channelPeaks[c]) > PEAK_TOLERANCE)
+            return false;
+        for(uint32_t block = 0; block < RESULT_NUM_BLOCKS; ++block)
+            if(fabs(result->blockRmsDb[c][block] - expected->blockRmsDb[c][block]) > RMS_TOLERANCE_DB)
+                return false;
+    }
+    return true;
+}
+
+static void runScenario(const Scenario* scenario, ScenarioRun* run)
+{
+    typedef std::chrono::steady_clock Clock;
+    // Once untimed, to warm up and to compare every timed run against
+    scenario->run(&run->result);
+    run->isDeterministic = true;
+    uint64_t numAllocationsBefore = numAllocations;
+    uint32_t numRuns = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        ScenarioResult result;
+        scenario->run(&result);
+        if(!sameResult(&result, &run->result))
+            run->isDeterministic = false;
+        ++numRuns;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS || numRuns < MIN_RUNS);
+    run->nsPerFrame = seconds * 1e9 / ((double)numRuns * run->result.numFrames);
+    run->allocationsPerRun = (double)(numAllocations - numAllocationsBefore) / numRuns;
+}
+
+// Reads up to maxValues space separated numbers from text, up to the next comma
+static uint32_t readValues(const char** text, double* values, uint32_t maxValues)
+{
+    uint32_t numValues = 0;
+    while(**text && **text != ',' && **text != '\n')
+    {
+        char* end;
+        double value = strtod(*text, &end);
+        if(end == *text)
+            break;
+        if(numValues < maxValues)
+            values[numValues] = value;
+        ++numValues;
+        *text = end;
+    }
+    if(**text == ',')
+        ++*text;
+    return numValues;
+}
+
+static uint32_t readGoldenFile(const char* filename, GoldenResult* golden, uint32_t maxResults)
+{
+    FILE* f = fopen(filename, "r");
+    if(!f) return 0;
+    uint32_t numResults = 0;
+    char line[2048];
+    while(numResults < maxResults && fgets(line, sizeof(line), f))
+    {
+        GoldenResult* result = &golden[numResults];
+        *result = {};
+        unsigned long long hash, numFrames;
+        int numChars = 0;
+        if(sscanf(line, "%63[^,],%llx,%lf,%lf,%llu,%lf,%*f,%lf,%n", result->name, &hash, &result->result.rms,
+                  &result->result.peak, &numFrames, &result->nsPerFrame, &result->allocationsPerRun, &numChars) != 7
+           || numChars == 0)
+            continue;
+        result->result.hash = hash;
+        result->result.numFrames = numFrames;
+        const char* levels = line + numChars;
+        uint32_t numChannels = readValues(&levels, result->result.channelPeaks, RESULT_MAX_CHANNELS);
+        uint32_t numBlocks = readValues(&levels, &result->result.blockRmsDb[0][0], RESULT_MAX_CHANNELS * RESULT_NUM_BLOCKS);
+        if(numChannels > RESULT_MAX_CHANNELS || numBlocks != numChannels * RESULT_NUM_BLOCKS)
+            continue;
+        result->result.numChannels = numChannels;
+        ++numResults;
+    }
+    fclose(f);
+    return numResults;
+}
+
+static void printResults(FILE* f, const Scenario* scenarios, const ScenarioRun* runs, uint32_t numScenarios,
+                         const char* const* statuses)
+{
+    fprintf(f, "scenario,hash,rms,peak,frames,nsPerFrame,framesPerSecond,allocationsPerRun,channelPeaks,blockRmsDb%s\n",
+            statuses ? ",status" : "");
+    for(uint32_t i = 0; i < numScenarios; ++i)
+    {
+        const ScenarioResult* result = &runs[i].result;
+        fprintf(f, "%s,%016llx,%.9f,%.9f,%llu,%.3f,%.0f,%.1f,", scenarios[i].name, (unsigned long long)result->hash,
+                result->rms, result->peak, (unsigned long long)result->numFrames, runs[i].nsPerFrame,
+                1e9 / runs[i].nsPerFrame, runs[i].allocationsPerRun);
+        for(uint32_t c = 0; c < result->numChannels; ++c)
+            fprintf(f, c ? " %.9f" : "%.9f", result->channelPeaks[c]);
+        fprintf(f, ",");
+        for(uint32_t c = 0; c < result->numChannels; ++c)
+            for(uint32_t block = 0; block < RESULT_NUM_BLOCKS; ++block)
+                fprintf(f, c || block ? " %.4f" : "%.4f", result->blockRmsDb[c][block]);
+        fprintf(f, statuses ? ",%s\n" : "\n", statuses ? statuses[i] : "");
+    }
+}
+
+// The first failure is the one that sticks, so a worse one doesn't get hidden by a later check
+static void failScenario(const char** status, const char* failure)
+{
+    if(strncmp(*status, "FAIL", 4) != 0)
+        *status = failure;
+}
+
+int main(int argc, char** argv)
+{
+    const char* wavDirectory = "..";
+    const char* resultsFilename = nullptr;
+    const char* goldenFilename = nullptr;
+    double maxSlowdownPercent = 0.0;
+    bool isValid = argc % 2 == 1;
+    for(int i = 1; isValid && i + 1 < argc; i += 2)
+    {
+        if(strcmp(argv[i], "-d") == 0) wavDirectory = argv[i + 1];
+        else if(strcmp(argv[i], "-w") == 0) resultsFilename = argv[i + 1];
+        else if(strcmp(argv[i], "-c") == 0) goldenFilename = argv[i + 1];
+        else if(strcmp(argv[i], "-t") == 0) maxSlowdownPercent = atof(argv[i + 1]);
+        else isValid = false;
+    }
+    if(!isValid)
+    {
+        fprintf(stderr, "Usage: %s [-d wavDirectory] [-w results.csv] [-c golden.csv] [-t percent]\n", argv[0]);
+        return 1;
+    }
+
+    if(!loadFile(wavDirectory, "HelloWorld.wav", &helloWorldFile) || !loadFile(wavDirectory, "Testing48kHz.wav", &testingFile)
+       || parseWavFile(helloWorldFile.bytes, helloWorldFile.size, &helloWorld) != WAV_OK
+       || parseWavFile(testingFile.bytes, testingFile.size, &testing) != WAV_OK)
+    {
+        fprintf(stderr, "Failed to load the wav files from %s\n", wavDirectory);
+        return 1;
+    }
+    uint32_t numHelloWorldFrames = helloWorld.numSamples / helloWorld.numChannels;
+    helloWorldPlanar = helloWorld;
+    helloWorldPlanar.sampleFormat = SAMPLE_FORMAT_FLOAT;
+    helloWorldPlanar.layout = SAMPLE_LAYOUT_PLANAR;
+    helloWorldPlanar.numBitsPerSample = 32;
+    helloWorldPlanar.planeStride = planarStride(numHelloWorldFrames);
+    helloWorldPlanar.samples = aligned_alloc(64, helloWorld.numChannels * helloWorldPlanar.planeStride * sizeof(float));
+    convertSamplesToPlanarFloat(helloWorld.samples, helloWorld.sampleFormat, helloWorld.numBitsPerSample,
+                                helloWorld.numChannels, numHelloWorldFrames, (float*)helloWorldPlanar.samples);
+    makeClips();
+
+    static const Scenario scenarios[] = {
+        { "parse_wav", runParse },
+        { "convert_int16_float", runConvert },
+        { "convert_int16_planar", runConvertPlanar },
+        { "decode_ima_adpcm", runDecodeAdpcm },
+        { "resample_int16_48k", runResampleInt16 },
+        { "resample_planar_pitch", runResamplePlanar },
+        { "resample_float_pitch", runResampleFloat },
+        { "resample_ima_adpcm", runResampleAdpcm },
+        { "game_scene", runGameSceneInt16 },
+        { "game_scene_float_48k", runGameSceneFloat48k },
+        { "game_scene_float_5_1", runGameSceneFloat51 },
+        { "many_voices", runManyVoices },
+        { "choose_output_format", runChooseOutputFormat },
+        { "write_int16_stereo", runWriteInt16Stereo },
+        { "write_float_stereo", runWriteFloatStereo },
+        { "write_float_mono", runWriteFloatMono },
+        { "write_int24_5_1", runWriteInt24Surround },
+        { "write_int32_7_1", runWriteInt32Surround },
+        { "write_int16_3_channels", runWriteInt16ThreeChannels },
+    };
+    const uint32_t numScenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+    static_assert(sizeof(scenarios) / sizeof(scenarios[0]) <= MAX_SCENARIOS, "Too many scenarios");
+    static ScenarioRun runs[MAX_SCENARIOS];
+    for(uint32_t i = 0; i < numScenarios; ++i)
+        runScenario(&scenarios[i], &runs[i]);
+
+    static GoldenResult golden[MAX_SCENARIOS];
+    uint32_t numGolden = 0;
+    if(goldenFilename && (numGolden = readGoldenFile(goldenFilename, golden, MAX_SCENARIOS)) == 0)
+    {
+        fprintf(stderr, "Failed to read %s\n", goldenFilename);
+        return 1;
+    }
+
+    const char* statuses[MAX_SCENARIOS];
+    uint32_t numFailed = 0;
+    for(uint32_t i = 0; i < numScenarios; ++i)
+    {
+        const ScenarioRun* run = &runs[i];
+        statuses[i] = "ok";
+        if(!run->isDeterministic)
+            failScenario(&statuses[i], "FAIL_NONDETERMINISTIC");
+        const GoldenResult* expected = nullptr;
+        for(uint32_t j = 0; j < numGolden; ++j)
+            if(strcmp(golden[j].name, scenarios[i].name) == 0)
+                expected = &golden[j];
+        if(goldenFilename && !expected)
+            failScenario(&statuses[i], "FAIL_NO_GOLDEN");
+        if(expected && !sameResult(&run->result, &expected->result))
+        {
+            if(closeResult(&run->result, &expected->result))
+                failScenario(&statuses[i], "close");
+            else
+                failScenario(&statuses[i], "FAIL_OUTPUT");
+        }
+        if(expected && run->allocationsPerRun > expected->allocationsPerRun)
+            failScenario(&statuses[i], "FAIL_ALLOCATIONS");
+        if(expected && maxSlowdownPercent > 0.0
+           && run->nsPerFrame > expected->nsPerFrame * (1.0 + maxSlowdownPercent / 100.0))
+            failScenario(&statuses[i], "FAIL_SLOWER");
+        if(strncmp(statuses[i], "FAIL", 4) == 0)
+            ++numFailed;
+    }
+
+    printResults(stdout, scenarios, runs, numScenarios, goldenFilename ? statuses : nullptr);
+    if(resultsFilename)
+    {
+        FILE* f = fopen(resultsFilename, "w");
+        if(!f)
+        {
+            fprintf(stderr, "Failed to write %s\n", resultsFilename);
+            return 1;
+        }
+        printResults(f, scenarios, runs, numScenarios, nullptr);
+        fclose(f);
+    }
+    if(goldenFilename)
+        fprintf(stderr, "%u of %u scenarios failed\n", numFailed, numScenarios);
+    return numFailed ? 1 : 0;
+}
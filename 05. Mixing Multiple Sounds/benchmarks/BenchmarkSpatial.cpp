@@ -0,0 +1,137 @@
+// Measures how long spatialUpdate() takes per mixer pass as the number of
+// emitters goes up, for each speaker layout. For comparison it also times the
+// straightforward way: one emitter at a time with atan2, cos and sin.
+// Usage: BenchmarkSpatial
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "../Spatial.h"
+
+// Time each emitter count for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+// To put the times in context: how long a pass of this many frames lasts at 48kHz
+#define FRAMES_PER_PASS 512
+
+static SpatialEmitters emitters;
+static float scalarGains[2][SPATIAL_MAX_EMITTERS];
+
+static uint32_t nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+static float randomFloat(uint32_t* state, float min, float max)
+{
+    return min + (max - min) * (nextRandom(state) & 0xFFFF) / 65535.f;
+}
+
+// Stereo only, the same gains spatialUpdate works out but without SIMD or structure of arrays
+static void scalarStereoUpdate(const SpatialListener* listener, const SpatialEmitters* emitters)
+{
+    for(uint32_t i = 0; i < emitters->numEmitters; ++i)
+    {
+        float dx = emitters->positionX[i] - listener->position[0];
+        float dy = emitters->positionY[i] - listener->position[1];
+        float dz = emitters->positionZ[i] - listener->position[2];
+        float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+        float minDistance = emitters->minDistance[i];
+        float maxDistance = emitters->maxDistance[i];
+        float clamped = distance < minDistance ? minDistance : distance > maxDistance ? maxDistance : distance;
+        float attenuation = emitters->isLinear[i]
+                          ? 1.f - (clamped - minDistance) / (maxDistance - minDistance)
+                          : minDistance / (minDistance + emitters->rolloff[i] * (clamped - minDistance));
+        // The listener faces along z with y up here, so right is x. Sounds behind
+        // pan the same as the ones in front they mirror, like mixerSetPan() would
+        float horizontalDistance = sqrtf(dx * dx + dz * dz);
+        float pan = horizontalDistance > 1e-6f ? asinf(dx / horizontalDistance) / ((float)M_PI / 2) : 0.f;
+        float panAngle = (pan + 1) * (float)M_PI / 4;
+        scalarGains[0][i] = cosf(panAngle) * attenuation;
+        scalarGains[1][i] = sinf(panAngle) * attenuation;
+    }
+}
+
+typedef void (*UpdateFunction)(const SpatialListener* listener, SpeakerLayout layout);
+
+static void simdUpdate(const SpatialListener* listener, SpeakerLayout layout)
+{
+    spatialUpdate(listener, &emitters, layout);
+}
+
+static void scalarUpdate(const SpatialListener* listener, SpeakerLayout)
+{
+    scalarStereoUpdate(listener, &emitters);
+}
+
+// Returns nanoseconds per call
+static double timeUpdate(UpdateFunction update, SpatialListener* listener, SpeakerLayout layout)
+{
+    typedef std::chrono::steady_clock Clock;
+    uint32_t numCalls = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        for(uint32_t i = 0; i < 64; ++i)
+        {
+            // Move the listener a little so nothing can be hoisted out of the loop
+            listener->position[0] = (float)(numCalls & 7) * 0.01f;
+            update(listener, layout);
+            ++numCalls;
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds * 1e9 / numCalls;
+}
+
+int main()
+{
+    uint32_t random = 1;
+    spatialInit(&emitters);
+    for(uint32_t i = 0; i < SPATIAL_MAX_EMITTERS; ++i)
+    {
+        uint32_t index = spatialAddEmitter(&emitters);
+        spatialSetPosition(&emitters, index, randomFloat(&random, -50.f, 50.f), randomFloat(&random, -5.f, 5.f),
+                           randomFloat(&random, -50.f, 50.f));
+        spatialSetAttenuation(&emitters, index, (i & 1) ? ATTENUATION_LINEAR : ATTENUATION_INVERSE, 1.f, 60.f, 1.f);
+    }
+
+    SpatialListener listener = {};
+    listener.forward[2] = 1.f;
+    listener.up[1] = 1.f;
+
+    // Check the two agree before timing them
+    spatialUpdate(&listener, &emitters, SPEAKER_LAYOUT_STEREO);
+    scalarStereoUpdate(&listener, &emitters);
+    float maxError = 0.f;
+    for(uint32_t c = 0; c < 2; ++c)
+    {
+        for(uint32_t i = 0; i < SPATIAL_MAX_EMITTERS; ++i)
+        {
+            float error = fabsf(emitters.gains[c][i] - scalarGains[c][i]);
+            if(error > maxError)
+                maxError = error;
+        }
+    }
+    printf("Max difference from scalar stereo gains: %g\n\n", maxError);
+
+    const double passNs = 1e9 * FRAMES_PER_PASS / 48000.0;
+    printf("ns per pass (%% of a %u frame pass at 48kHz)\n", FRAMES_PER_PASS);
+    printf("%9s %18s %18s %18s %18s\n", "emitters", "scalar stereo", "stereo", "5.1", "7.1");
+    for(uint32_t numEmitters = 16; numEmitters <= SPATIAL_MAX_EMITTERS; numEmitters *= 2)
+    {
+        emitters.numEmitters = numEmitters;
+        double scalarNs = timeUpdate(scalarUpdate, &listener, SPEAKER_LAYOUT_STEREO);
+        double stereoNs = timeUpdate(simdUpdate, &listener, SPEAKER_LAYOUT_STEREO);
+        double surround51Ns = timeUpdate(simdUpdate, &listener, SPEAKER_LAYOUT_5_1);
+        double surround71Ns = timeUpdate(simdUpdate, &listener, SPEAKER_LAYOUT_7_1);
+        printf("%9u %9.0f (%4.2f%%) %9.0f (%4.2f%%) %9.0f (%4.2f%%) %9.0f (%4.2f%%)\n", numEmitters,
+               scalarNs, 100.0 * scalarNs / passNs, stereoNs, 100.0 * stereoNs / passNs,
+               surround51Ns, 100.0 * surround51Ns / passNs, surround71Ns, 100.0 * surround71Ns / passNs);
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Measures how much CPU one time-stretched voice costs at different stretch
+// ratios (input frames read per output frame), on a couple of test signals.
+// This is only the stretch itself, the mixer's resampling comes on top.
+// Usage: BenchmarkTimeStretch
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "../TimeStretch.h"
+
+// Time each ratio for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define SAMPLE_RATE 48000
+// Frames per timeStretchProcess call, like one mixer pass
+#define FRAMES_PER_PASS 512
+
+static TimeStretch stretch;
+static float outLeft[FRAMES_PER_PASS];
+static float outRight[FRAMES_PER_PASS];
+
+// Made up front so generating the input doesn't get timed as well
+#define SIGNAL_LENGTH 65536
+static float chord[2][SIGNAL_LENGTH]; // Three sines, easy to line up
+static float noise[2][SIGNAL_LENGTH]; // Nothing lines up, so no shortcuts
+
+static void makeSignals()
+{
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < SIGNAL_LENGTH; ++i)
+    {
+        double t = (double)i / SAMPLE_RATE;
+        chord[0][i] = (float)(0.3 * sin(2 * M_PI * 220.0 * t) + 0.2 * sin(2 * M_PI * 277.2 * t));
+        chord[1][i] = (float)(0.3 * sin(2 * M_PI * 220.0 * t) + 0.2 * sin(2 * M_PI * 329.6 * t));
+        random = random * 1664525 + 1013904223;
+        noise[0][i] = (float)(int32_t)random / 2147483648.f * 0.5f;
+        random = random * 1664525 + 1013904223;
+        noise[1][i] = (float)(int32_t)random / 2147483648.f * 0.5f;
+    }
+}
+
+// Returns nanoseconds per output frame
+static double timeStretchRatio(float (*signal)[SIGNAL_LENGTH], float ratio)
+{
+    typedef std::chrono::steady_clock Clock;
+    uint32_t signalPos = 0;
+    timeStretchReset(&stretch);
+    uint64_t numFramesOut = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        uint32_t numFramesDone = 0;
+        while(numFramesDone < FRAMES_PER_PASS)
+        {
+            numFramesDone += timeStretchProcess(&stretch, ratio, outLeft + numFramesDone, outRight + numFramesDone,
+                                                FRAMES_PER_PASS - numFramesDone);
+            if(numFramesDone < FRAMES_PER_PASS)
+            {
+                uint32_t numInputFrames = timeStretchNumInputFramesNeeded(&stretch);
+                float* inputLeft;
+                float* inputRight;
+                timeStretchAddInput(&stretch, numInputFrames, &inputLeft, &inputRight);
+                for(uint32_t i = 0; i < numInputFrames; ++i, signalPos = (signalPos + 1) % SIGNAL_LENGTH)
+                {
+                    inputLeft[i] = signal[0][signalPos];
+                    inputRight[i] = signal[1][signalPos];
+                }
+            }
+        }
+        numFramesOut += FRAMES_PER_PASS;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds * 1e9 / numFramesOut;
+}
+
+int main()
+{
+    makeSignals();
+    const float ratios[] = { 0.25f, 0.5f, 0.75f, 0.9f, 1.f, 1.1f, 1.5f, 2.f, 3.f, 4.f };
+    printf("ns per output frame (%% of a core per voice at %u Hz)\n", SAMPLE_RATE);
+    printf("%6s %20s %20s\n", "ratio", "chord", "noise");
+    for(float ratio : ratios)
+    {
+        double chordNs = timeStretchRatio(chord, ratio);
+        double noiseNs = timeStretchRatio(noise, ratio);
+        printf("%6.2f %10.2f (%5.3f%%) %10.2f (%5.3f%%)\n", ratio,
+               chordNs, chordNs * SAMPLE_RATE * 1e-7, noiseNs, noiseNs * SAMPLE_RATE * 1e-7);
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Measures how many voices the mixer can mix in 1ms of CPU per 10ms buffer,
+// i.e. a tenth of one core, for the clip layouts and pitches games use most.
+// Each case is timed with no voices (the master effects, meter and writing the
+// output) and with every voice playing, and the difference gives the cost of one voice.
+// Voices past MIXER_MAX_VOICES won't actually play, those counts are marked with a *
+// Usage: BenchmarkVoices
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../ConvertSamples.h"
+#include "../Mixer.h"
+
+// Time each voice count for at least this long
+#define MIN_BENCHMARK_SECONDS 0.2
+#define SAMPLE_RATE 48000
+// What the device asks for at once, 10ms
+#define FRAMES_PER_BUFFER (SAMPLE_RATE / 100)
+// The CPU time the mix gets per buffer
+#define BUDGET_SECONDS 0.001
+// 2 seconds, long enough that the voices don't all sit in the cache
+#define NUM_CLIP_FRAMES (SAMPLE_RATE * 2)
+
+static Mixer mixer;
+static AudioClip stereoClip;       // Interleaved 16-bit, as loaded from a wav file
+static AudioClip stereoPlanarClip; // Planar float, as the clip cache converts them
+static AudioClip monoClip;         // Interleaved 16-bit mono
+alignas(16) static float output[FRAMES_PER_BUFFER * 2];
+
+static void makeClips()
+{
+    int16_t* samples = (int16_t*)malloc(NUM_CLIP_FRAMES * 2 * sizeof(int16_t));
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < NUM_CLIP_FRAMES * 2; ++i)
+    {
+        random = random * 1664525 + 1013904223;
+        samples[i] = (int16_t)(random >> 18);
+    }
+    stereoClip = {};
+    stereoClip.sampleFormat = SAMPLE_FORMAT_PCM;
+    stereoClip.layout = SAMPLE_LAYOUT_INTERLEAVED;
+    stereoClip.numChannels = 2;
+    stereoClip.numBitsPerSample = 16;
+    stereoClip.sampleRate = SAMPLE_RATE;
+    stereoClip.numSamples = NUM_CLIP_FRAMES * 2;
+    stereoClip.samples = samples;
+
+    stereoPlanarClip = stereoClip;
+    stereoPlanarClip.sampleFormat = SAMPLE_FORMAT_FLOAT;
+    stereoPlanarClip.layout = SAMPLE_LAYOUT_PLANAR;
+    stereoPlanarClip.numBitsPerSample = 32;
+    stereoPlanarClip.planeStride = planarStride(NUM_CLIP_FRAMES);
+    float* planes = (float*)aligned_alloc(64, stereoPlanarClip.planeStride * 2 * sizeof(float));
+    convertSamplesToPlanarFloat(samples, SAMPLE_FORMAT_PCM, 16, 2, NUM_CLIP_FRAMES, planes);
+    stereoPlanarClip.samples = planes;
+
+    // The left channel of the stereo one, every other sample
+    monoClip = stereoClip;
+    monoClip.numChannels = 1;
+}
+
+// Returns seconds per buffer with numVoices voices playing clip
+static double timeVoices(const AudioClip* clip, float pitch, uint32_t numVoices)
+{
+    typedef std::chrono::steady_clock Clock;
+    mixerInit(&mixer, SAMPLE_RATE);
+    AudioOutputFormat format = { OUTPUT_SAMPLE_FLOAT32, 2, SAMPLE_RATE, 2 * sizeof(float), 0x3 };
+    mixerSetOutputFormat(&mixer, &format);
+    for(uint32_t i = 0; i < numVoices; ++i)
+    {
+        // Spread them out so they don't all pan and read the same
+        float pan = (float)i / numVoices * 2.0f - 1.0f;
+        VoiceId id = mixerPlay(&mixer, clip, 0.01f, pan, pitch, true);
+        if(id == INVALID_VOICE_ID)
+            return 0.0;
+        mixerRender(&mixer, output, 7);
+    }
+    // Once round first so the clips are in memory
+    mixerRender(&mixer, output, FRAMES_PER_BUFFER);
+
+    uint64_t numBuffers = 0;
+    double seconds = 0.0;
+    Clock::time_point startTime = Clock::now();
+    do
+    {
+        for(uint32_t i = 0; i < 16; ++i)
+            mixerRender(&mixer, output, FRAMES_PER_BUFFER);
+        numBuffers += 16;
+        seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    } while(seconds < MIN_BENCHMARK_SECONDS);
+    return seconds / numBuffers;
+}
+
+int main()
+{
+    makeClips();
+
+    struct Case {
+        const char* name;
+        const AudioClip* clip;
+        float pitch;
+    };
+    const Case cases[] = {
+        { "16-bit stereo",              &stereoClip,       1.0f },
+        { "16-bit stereo, pitch 0.93",  &stereoClip,       0.93f },
+        { "planar float stereo",        &stereoPlanarClip, 1.0f },
+        { "planar float, pitch 0.93",   &stereoPlanarClip, 0.93f },
+        { "16-bit mono",                &monoClip,         1.0f },
+        { "16-bit mono, pitch 0.93",    &monoClip,         0.93f },
+    };
+
+    printf("%u frame buffers at %uHz, %.1fms of CPU each\n", FRAMES_PER_BUFFER, SAMPLE_RATE, BUDGET_SECONDS * 1000.0);
+    printf("%-28s %14s %14s %14s\n", "", "fixed us", "us per voice", "voices in 1ms");
+    for(const Case& c : cases)
+    {
+        double fixedSeconds = timeVoices(c.clip, c.pitch, 0);
+        double allSeconds = timeVoices(c.clip, c.pitch, MIXER_MAX_VOICES);
+        if(allSeconds == 0.0)
+        {
+            printf("FAILED: couldn't play %u voices\n", MIXER_MAX_VOICES);
+            return 1;
+        }
+        double voiceSeconds = (allSeconds - fixedSeconds) / MIXER_MAX_VOICES;
+        uint32_t numVoices = (uint32_t)floor((BUDGET_SECONDS - fixedSeconds) / voiceSeconds);
+        printf("%-28s %14.2f %14.3f %13u%s\n", c.name, fixedSeconds * 1e6, voiceSeconds * 1e6, numVoices,
+               numVoices > MIXER_MAX_VOICES ? "*" : " ");
+    }
+    return 0;
+}
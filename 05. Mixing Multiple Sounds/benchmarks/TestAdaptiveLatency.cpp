@@ -0,0 +1,156 @@
+// Runs AdaptiveLatency against a simulated device on a simulated clock, so
+// it can be tested with any amount of scheduling jitter and always gives the same
+// result. The device plays continuously, the audio thread wakes up once a period
+// but late by a random amount, and each time it tops the buffer up to whatever
+// AdaptiveLatency asks for. Checks that the latency settles at the minimum when
+// there's no jitter, that it grows to stop underruns when there is, and that it
+// comes back down once the jitter goes away.
+// Usage: TestAdaptiveLatency
+// Returns 1 if any check fails.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../AdaptiveLatency.h"
+
+#define SAMPLE_RATE 48000
+// A small shared-mode period like IAudioClient3 gives us, 2.67ms
+#define PERIOD_IN_FRAMES 128
+#define BUFFER_SIZE_IN_FRAMES 4800
+#define NUM_SECONDS 120
+#define NUM_UPDATES (NUM_SECONDS * SAMPLE_RATE / PERIOD_IN_FRAMES)
+
+// How late the audio thread wakes up, in periods: a random amount up to
+// maxJitter every time, plus spikeSize every so often
+struct Jitter {
+    double maxJitter;
+    double spikeChance;
+    double spikeSize;
+};
+
+struct SimulationResult {
+    uint32_t numUnderruns;        // Times the device actually ran dry
+    uint32_t numLateUnderruns;    // Of those, how many were in the second half
+    uint32_t numDetectedUnderruns; // What AdaptiveLatency counted
+    double meanTargetMs;
+    double finalTargetMs;
+    bool stayedInRange;           // Target never left [minimum, buffer size]
+};
+
+static double nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return (*state >> 8) / 16777216.0;
+}
+
+// jitterUntilUpdate is how many updates jitter lasts for, after that there isn't any
+static SimulationResult simulate(const Jitter* jitter, uint32_t jitterUntilUpdate)
+{
+    AdaptiveLatency latency;
+    adaptiveLatencyInit(&latency, PERIOD_IN_FRAMES, BUFFER_SIZE_IN_FRAMES);
+    SimulationResult result = {};
+    result.stayedInRange = true;
+    uint32_t random = 1;
+    double bufferLevel = 0.0; // Frames written but not yet played
+    double lastWakeUpTime = 0.0;
+    double targetSum = 0.0;
+    for(uint32_t update = 0; update < NUM_UPDATES; ++update)
+    {
+        // In frames, which is the device's clock
+        double wakeUpTime = (double)update * PERIOD_IN_FRAMES;
+        if(update < jitterUntilUpdate)
+        {
+            double late = nextRandom(&random) * jitter->maxJitter;
+            if(nextRandom(&random) < jitter->spikeChance)
+                late += jitter->spikeSize;
+            wakeUpTime += late * PERIOD_IN_FRAMES;
+        }
+        // A wake-up can't come before the one before it
+        if(wakeUpTime < lastWakeUpTime)
+            wakeUpTime = lastWakeUpTime;
+
+        // The device played on since we last wrote anything
+        bufferLevel -= wakeUpTime - lastWakeUpTime;
+        if(bufferLevel < 0.0)
+        {
+            if(update > 0)
+            {
+                ++result.numUnderruns;
+                if(update >= NUM_UPDATES / 2)
+                    ++result.numLateUnderruns;
+            }
+            bufferLevel = 0.0;
+        }
+        lastWakeUpTime = wakeUpTime;
+
+        uint32_t bufferPadding = (uint32_t)bufferLevel;
+        uint32_t targetPadding = adaptiveLatencyUpdate(&latency, bufferPadding);
+        if(targetPadding < latency.minTargetPadding || targetPadding > BUFFER_SIZE_IN_FRAMES)
+            result.stayedInRange = false;
+        if(targetPadding > bufferPadding)
+            bufferLevel += targetPadding - bufferPadding;
+        targetSum += targetPadding;
+    }
+    result.numDetectedUnderruns = latency.numUnderruns;
+    result.meanTargetMs = targetSum / NUM_UPDATES * 1000.0 / SAMPLE_RATE;
+    result.finalTargetMs = latency.targetPadding * 1000.0 / SAMPLE_RATE;
+    return result;
+}
+
+static bool check(bool condition, const char* name, const char* what)
+{
+    if(!condition)
+        printf("FAILED: %s %s\n", name, what);
+    return condition;
+}
+
+int main()
+{
+    const double periodMs = PERIOD_IN_FRAMES * 1000.0 / SAMPLE_RATE;
+    AdaptiveLatency initialLatency;
+    adaptiveLatencyInit(&initialLatency, PERIOD_IN_FRAMES, BUFFER_SIZE_IN_FRAMES);
+    const double minTargetMs = initialLatency.minTargetPadding * 1000.0 / SAMPLE_RATE;
+    // Every time latency shrinks it can find out the hard way that it went too far,
+    // so a jittery device can keep underrunning at most once every shrink
+    const uint32_t maxLateUnderruns = NUM_UPDATES / 2 / 1000 + 1;
+
+    struct Scenario {
+        const char* name;
+        Jitter jitter;
+        uint32_t jitterUntilUpdate;
+    };
+    const Scenario scenarios[] = {
+        { "no jitter",            { 0.0, 0.0, 0.0 },   0 },
+        { "up to half a period",  { 0.5, 0.0, 0.0 },   NUM_UPDATES },
+        { "up to 1.5 periods",    { 1.5, 0.0, 0.0 },   NUM_UPDATES },
+        { "occasional 4 periods", { 0.5, 0.01, 4.0 },  NUM_UPDATES },
+        // Long enough afterwards to shrink all the way back a quarter period at a time
+        { "jitter then calm",     { 1.5, 0.01, 4.0 },  NUM_UPDATES / 10 },
+    };
+
+    printf("%.2fms period, %u updates\n", periodMs, NUM_UPDATES);
+    printf("%-22s %10s %14s %10s %14s %14s\n", "", "underruns", "second half", "detected", "mean ms", "final ms");
+    bool passed = true;
+    for(const Scenario& scenario : scenarios)
+    {
+        SimulationResult result = simulate(&scenario.jitter, scenario.jitterUntilUpdate);
+        printf("%-22s %10u %14u %10u %14.2f %14.2f\n", scenario.name, result.numUnderruns, result.numLateUnderruns,
+               result.numDetectedUnderruns, result.meanTargetMs, result.finalTargetMs);
+        passed = check(result.stayedInRange, scenario.name, "went outside the buffer") && passed;
+        if(scenario.jitterUntilUpdate < NUM_UPDATES / 2)
+        {
+            // With nothing to get in the way, latency ends up as low as it goes and stays there
+            passed = check(result.numLateUnderruns == 0, scenario.name, "underran without any jitter") && passed;
+            if(scenario.jitterUntilUpdate == 0)
+                passed = check(result.numDetectedUnderruns == 0, scenario.name, "saw underruns that weren't there") && passed;
+            passed = check(result.finalTargetMs == minTargetMs, scenario.name, "didn't come back down") && passed;
+        }
+        else
+        {
+            passed = check(result.numLateUnderruns <= maxLateUnderruns, scenario.name, "kept underrunning") && passed;
+            passed = check(result.numDetectedUnderruns >= result.numUnderruns, scenario.name, "missed underruns") && passed;
+        }
+    }
+    printf(passed ? "All checks passed\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Stress tests the command queue with a game thread pushing and an audio thread
+// popping as fast as they can, and checks every command comes out once, in the
+// order it went in and with all of it there, not half of one command and half of
+// another. Runs once with the indices starting at 0 and once just before they
+// wrap around, in bursts that fill the queue up and in a steady trickle.
+// Build it with -fsanitize=thread as well to have the memory ordering checked.
+// Usage: TestAudioCommandQueue [commands per run]
+// Returns 1 if anything is lost, duplicated, out of order or torn.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+#include "../AudioCommandQueue.h"
+
+static AudioCommandQueue queue;
+
+// Every field of the command is made from its sequence number, so the
+// consumer can tell if what it got isn't exactly what was pushed
+static void makeCommand(uint32_t sequence, AudioCommand* command)
+{
+    *command = {};
+    command->type = (AudioCommandType)(sequence % (AUDIO_COMMAND_SET_LISTENER + 1));
+    command->sound = sequence;
+    command->frame = (uint64_t)sequence * 0x9E3779B97F4A7C15ull;
+    command->looping = sequence & 1;
+    command->gain = (float)(sequence & 0xFFFF);
+    command->numRampFrames = ~sequence;
+    command->effectSlot = sequence ^ 0x5A5A5A5A;
+    command->position[0] = (float)(sequence >> 16);
+    command->rolloff = (float)(sequence & 0xFF);
+    command->listener.position[2] = (float)(sequence & 0xFFF);
+}
+
+static bool isCommandIntact(const AudioCommand* command, uint32_t sequence)
+{
+    AudioCommand expected;
+    makeCommand(sequence, &expected);
+    return command->type == expected.type && command->sound == expected.sound && command->frame == expected.frame
+           && command->looping == expected.looping && command->gain == expected.gain
+           && command->numRampFrames == expected.numRampFrames && command->effectSlot == expected.effectSlot
+           && command->position[0] == expected.position[0] && command->rolloff == expected.rolloff
+           && command->listener.position[2] == expected.listener.position[2];
+}
+
+// Pushes numCommands, spinning whenever the queue is full. With burstSize set it
+// waits for the queue to empty after every burst, so it keeps going from empty to full
+static void produce(uint32_t numCommands, uint32_t burstSize)
+{
+    AudioCommand command;
+    for(uint32_t sequence = 0; sequence < numCommands; ++sequence)
+    {
+        makeCommand(sequence, &command);
+        while(!pushAudioCommand(&queue, &command))
+            std::this_thread::yield();
+        if(burstSize && sequence % burstSize == burstSize - 1)
+        {
+            while(queue.readIndex.load(std::memory_order_acquire) != queue.writeIndex.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+        }
+    }
+}
+
+// Returns the number of commands that weren't the one expected next
+static uint32_t consume(uint32_t numCommands, uint32_t* numPopped)
+{
+    AudioCommand command;
+    uint32_t numErrors = 0;
+    uint32_t nextSequence = 0;
+    *numPopped = 0;
+    while(nextSequence < numCommands)
+    {
+        if(!popAudioCommand(&queue, &command))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ++*numPopped;
+        if(!isCommandIntact(&command, nextSequence))
+        {
+            if(numErrors < 10)
+                printf("Expected command %u, got %u\n", nextSequence, command.sound);
+            ++numErrors;
+            // Pick up from whatever it was so one lost command doesn't fail all the rest
+            nextSequence = command.sound;
+        }
+        ++nextSequence;
+    }
+    // Anything left over was pushed twice
+    if(popAudioCommand(&queue, &command))
+    {
+        printf("Extra command %u after the last one\n", command.sound);
+        ++numErrors;
+    }
+    return numErrors;
+}
+
+static bool runTest(const char* name, uint32_t firstIndex, uint32_t numCommands, uint32_t burstSize)
+{
+    queue.writeIndex.store(firstIndex);
+    queue.readIndex.store(firstIndex);
+    uint32_t numPopped;
+    uint32_t numErrors;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point startTime = Clock::now();
+    std::thread producer(produce, numCommands, burstSize);
+    numErrors = consume(numCommands, &numPopped);
+    producer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    bool passed = numErrors == 0 && numPopped == numCommands;
+    printf("%-32s %10u %10u %14.1f %s\n", name, numPopped, numErrors, numPopped / seconds / 1e6, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numCommands = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 4000000;
+    if(numCommands == 0)
+    {
+        printf("Usage: TestAudioCommandQueue [commands per run]\n");
+        return 1;
+    }
+
+    // Far enough before the wrap that it happens a few queues' worth into the run
+    const uint32_t NEAR_WRAP = 0xFFFFFFFFu - 3 * AUDIO_COMMAND_QUEUE_SIZE - 17;
+    printf("%-32s %10s %10s %14s\n", "", "popped", "errors", "M commands/s");
+    bool passed = runTest("steady", 0, numCommands, 0);
+    passed = runTest("steady, indices wrap", NEAR_WRAP, numCommands, 0) && passed;
+    passed = runTest("bursts that fill the queue", 0, numCommands / 4, AUDIO_COMMAND_QUEUE_SIZE + 300) && passed;
+    passed = runTest("bursts, indices wrap", NEAR_WRAP, numCommands / 4, AUDIO_COMMAND_QUEUE_SIZE + 300) && passed;
+    printf(passed ? "All commands arrived once and in order\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
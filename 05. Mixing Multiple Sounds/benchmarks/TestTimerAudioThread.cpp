@@ -0,0 +1,143 @@
+// Runs the renderer on TimerAudioThread in real time, with a game thread sending it
+// commands through the command queue the way main.cpp does: a looping sound whose
+// gain changes every millisecond, and a one-shot started every game update. Checks
+// the audio thread kept up with real time and took every command, and that the
+// last gain sent is the one the voice ended up with. Underruns are only reported,
+// since on a loaded machine the OS may not wake the thread on time.
+// Usage: TestTimerAudioThread [seconds]
+// Returns 1 if commands went missing or the audio thread fell behind.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+#include "../AudioCommandQueue.h"
+#include "../AudioOutput.h"
+#include "../AudioRenderer.h"
+#include "../TimerAudioThread.h"
+
+#define SAMPLE_RATE 48000
+// 10ms, what shared-mode WASAPI usually wakes up at
+#define PERIOD_IN_FRAMES (SAMPLE_RATE / 100)
+#define GAME_UPDATES_PER_SECOND 60
+#define NUM_CLIP_FRAMES (SAMPLE_RATE / 2)
+
+static AudioRenderer renderer;
+static AudioCommandQueue commandQueue;
+static NullAudioOutput nullOutput;
+static TimerAudioThread audioThread;
+static int16_t clipSamples[NUM_CLIP_FRAMES];
+
+// Retries until there's room, returns the number of times the queue was full
+static uint32_t send(const AudioCommand* command)
+{
+    uint32_t numFull = 0;
+    while(!pushAudioCommand(&commandQueue, command))
+    {
+        ++numFull;
+        std::this_thread::yield();
+    }
+    return numFull;
+}
+
+int main(int argc, char** argv)
+{
+    typedef std::chrono::steady_clock Clock;
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    if(seconds <= 0.0)
+    {
+        printf("Usage: TestTimerAudioThread [seconds]\n");
+        return 1;
+    }
+
+    uint32_t random = 12345;
+    for(uint32_t i = 0; i < NUM_CLIP_FRAMES; ++i)
+    {
+        random = random * 1664525 + 1013904223;
+        clipSamples[i] = (int16_t)(random >> 20);
+    }
+    AudioClip clip = {};
+    clip.sampleFormat = SAMPLE_FORMAT_PCM;
+    clip.layout = SAMPLE_LAYOUT_INTERLEAVED;
+    clip.numChannels = 1;
+    clip.numBitsPerSample = 16;
+    clip.sampleRate = SAMPLE_RATE;
+    clip.numSamples = NUM_CLIP_FRAMES;
+    clip.samples = clipSamples;
+
+    AudioOutputFormat format = { OUTPUT_SAMPLE_FLOAT32, 2, SAMPLE_RATE, 2 * sizeof(float), 0x3 };
+    audioRendererInit(&renderer, SAMPLE_RATE);
+    mixerSetOutputFormat(&renderer.mixer, &format);
+    nullAudioOutputInit(&nullOutput, &format);
+    timerAudioThreadStart(&audioThread, &renderer, &commandQueue, &nullOutput.output, PERIOD_IN_FRAMES);
+
+    // Sound 0 loops the whole time, the rest are one-shots
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_PLAY;
+    command.clip = &clip;
+    command.gain = 0.f;
+    command.pitch = 1.f;
+    command.looping = true;
+    uint32_t numCommands = 1;
+    uint32_t numQueueFull = send(&command);
+
+    const Clock::time_point startTime = Clock::now();
+    float lastGain = 0.f;
+    uint32_t numGameUpdates = 0;
+    for(uint32_t millisecond = 1;; ++millisecond)
+    {
+        std::this_thread::sleep_until(startTime + std::chrono::milliseconds(millisecond));
+        double elapsedSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+        if(elapsedSeconds >= seconds)
+            break;
+        command = {};
+        command.type = AUDIO_COMMAND_SET_GAIN;
+        command.gain = lastGain = (millisecond % 1000) / 2000.f;
+        numQueueFull += send(&command);
+        ++numCommands;
+        if(elapsedSeconds * GAME_UPDATES_PER_SECOND >= numGameUpdates + 1)
+        {
+            ++numGameUpdates;
+            command = {};
+            command.type = AUDIO_COMMAND_PLAY;
+            command.sound = numGameUpdates;
+            command.clip = &clip;
+            command.gain = 0.1f;
+            command.pitch = 1.f;
+            numQueueFull += send(&command);
+            ++numCommands;
+        }
+    }
+    // Give the audio thread a couple of periods to take the last commands
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * PERIOD_IN_FRAMES * 1000 / SAMPLE_RATE));
+    timerAudioThreadStop(&audioThread);
+    double elapsedSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    bool passed = true;
+    bool isQueueEmpty = commandQueue.readIndex.load() == commandQueue.writeIndex.load();
+    const Voice* loopingVoice = &renderer.mixer.voices[renderer.soundVoices[0] & 0xFFFF];
+    printf("%u commands, queue full %u times, %s\n", numCommands, numQueueFull,
+           isQueueEmpty ? "all taken" : "some never taken");
+    if(!isQueueEmpty || !loopingVoice->isPlaying || loopingVoice->gain != lastGain)
+    {
+        printf("FAILED: not every command was applied, the looping voice's gain is %.4f and the last one sent was %.4f\n",
+               loopingVoice->gain, lastGain);
+        passed = false;
+    }
+
+    // The thread should have written about as much as played in real time, plus what's still buffered
+    uint64_t numFramesPlayed = (uint64_t)(elapsedSeconds * SAMPLE_RATE) - audioThread.numSilentFramesPlayed;
+    printf("%.2f seconds, %u wake-ups, %llu frames written, %u underruns (%llu silent frames), latest wake-up %u us\n",
+           elapsedSeconds, audioThread.numWakeUps, (unsigned long long)audioThread.numFramesWritten,
+           audioThread.numUnderruns, (unsigned long long)audioThread.numSilentFramesPlayed, audioThread.maxLateMicroseconds);
+    if(audioThread.numFramesWritten + nullOutput.output.bufferSizeInFrames < numFramesPlayed
+       || audioThread.numSilentFramesPlayed > elapsedSeconds * SAMPLE_RATE / 10)
+    {
+        printf("FAILED: the audio thread fell behind real time\n");
+        passed = false;
+    }
+    printf(passed ? "All checks passed\n" : "FAILED\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Builds the benchmarks on Linux
+set -e
+cd "$(dirname "$0")"
+mkdir -p build
+
+echo Building...
+c++ -O2 -DNDEBUG BenchmarkSpatial.cpp ../Spatial.cpp -o build/BenchmarkSpatial
+c++ -O2 -DNDEBUG BenchmarkTimeStretch.cpp ../TimeStretch.cpp -o build/BenchmarkTimeStretch
+c++ -O2 -DNDEBUG -pthread BenchmarkLoudness.cpp ../Loudness.cpp ../ImaAdpcm.cpp -o build/BenchmarkLoudness
+c++ -O2 -DNDEBUG -Wall -Wextra BenchmarkRegression.cpp ../Allocators.cpp ../AudioCommandQueue.cpp ../AudioOutput.cpp ../AudioRenderer.cpp ../AudioScheduler.cpp ../ConvertSamples.cpp ../Effects.cpp \
+    ../ImaAdpcm.cpp ../LoadWavFile.cpp ../Loudness.cpp ../Mixer.cpp ../OutputFormat.cpp ../Spatial.cpp ../TimeStretch.cpp \
+    -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=aligned_alloc -o build/BenchmarkRegression
+c++ -O2 -DNDEBUG BenchmarkVoices.cpp ../Allocators.cpp ../ConvertSamples.cpp ../Effects.cpp ../ImaAdpcm.cpp ../Loudness.cpp \
+    ../Mixer.cpp ../OutputFormat.cpp ../Spatial.cpp ../TimeStretch.cpp -o build/BenchmarkVoices
+c++ -O2 -DNDEBUG -pthread TestAudioCommandQueue.cpp ../AudioCommandQueue.cpp -o build/TestAudioCommandQueue
+c++ -O2 -DNDEBUG BenchmarkConvertSamples.cpp ../ConvertSamples.cpp -o build/BenchmarkConvertSamples
+c++ -O2 -DNDEBUG -Wall -Wextra TestAdaptiveLatency.cpp ../AdaptiveLatency.cpp -o build/TestAdaptiveLatency
+c++ -O2 -DNDEBUG -Wall -Wextra -pthread BenchmarkClipCache.cpp ../ClipCache.cpp -o build/BenchmarkClipCache
+c++ -O2 -DNDEBUG -Wall -Wextra BenchmarkAudioScheduler.cpp ../AudioScheduler.cpp -o build/BenchmarkAudioScheduler
+c++ -O2 -DNDEBUG -Wall -Wextra BenchmarkEffects.cpp ../Effects.cpp -o build/BenchmarkEffects
+c++ -O2 -DNDEBUG -Wall -Wextra BenchmarkClipLayouts.cpp ../Allocators.cpp ../ConvertSamples.cpp ../Effects.cpp ../ImaAdpcm.cpp ../Loudness.cpp \
+    ../Mixer.cpp ../OutputFormat.cpp ../Spatial.cpp ../TimeStretch.cpp -o build/BenchmarkClipLayouts
+c++ -O2 -DNDEBUG -Wall -Wextra -pthread BenchmarkAllocators.cpp ../Allocators.cpp -o build/BenchmarkAllocators
+c++ -O2 -DNDEBUG -Wall -Wextra -pthread TestTimerAudioThread.cpp ../TimerAudioThread.cpp ../AdaptiveLatency.cpp ../Allocators.cpp ../AudioCommandQueue.cpp \
+    ../AudioOutput.cpp ../AudioRenderer.cpp ../AudioScheduler.cpp ../ConvertSamples.cpp ../Effects.cpp ../ImaAdpcm.cpp ../Loudness.cpp \
+    ../Mixer.cpp ../OutputFormat.cpp ../Spatial.cpp ../TimeStretch.cpp -o build/TestTimerAudioThread
+echo Done
@@ -0,0 +1,185 @@
+// Measures how fast parseWavFile() gets through a corpus of wav files.
+// Usage: BenchmarkParseWavFile [file.wav...]
+//        BenchmarkParseWavFile -w outputDirectory
+// With no files it makes up a corpus of a few thousand small wav files
+// in memory, in every format we support and with a mix of other chunks.
+// -w writes that corpus out instead, e.g. as seeds for FuzzParseWavFile
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "../LoadWavFile.h"
+
+#define NUM_GENERATED_FILES 4096
+// Parse the whole corpus this many times over
+#define NUM_PASSES 100
+
+struct WavFileBytes {
+    uint8_t* bytes;
+    uint32_t size;
+};
+
+static void writeU32(uint8_t* dest, uint32_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+    dest[2] = (uint8_t)(value >> 16);
+    dest[3] = (uint8_t)(value >> 24);
+}
+
+static void writeU16(uint8_t* dest, uint16_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+}
+
+static uint32_t nextRandom(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+// Appends a chunk header and numBytes of filler, padded to an even size
+static uint8_t* writeChunk(uint8_t* dest, const char* id, uint32_t numBytes, uint8_t filler)
+{
+    memcpy(dest, id, 4);
+    writeU32(dest + 4, numBytes);
+    memset(dest + 8, filler, numBytes + (numBytes & 1));
+    return dest + 8 + numBytes + (numBytes & 1);
+}
+
+static WavFileBytes generateWavFile(uint32_t* random)
+{
+    // PCM 8/16/24/32, float, IMA-ADPCM, and 16-bit in a WAVE_FORMAT_EXTENSIBLE
+    uint32_t kind = nextRandom(random) % 7;
+    uint16_t numChannels = (uint16_t)(1 + nextRandom(random) % 2);
+    uint16_t bits[] = { 8, 16, 24, 32, 32, 4, 16 };
+    uint16_t formatTag[] = { 1, 1, 1, 1, 3, 0x11, 0xFFFE };
+    uint16_t blockAlign = kind == 5 ? (uint16_t)(256 * numChannels) : (uint16_t)(numChannels * bits[kind] / 8);
+    uint32_t numDataBytes = blockAlign * (16 + nextRandom(random) % 4096);
+    uint32_t numExtraChunks = nextRandom(random) % 4;
+
+    uint32_t maxSize = 12 + 8 + 40 + 8 + 4 + 8 + numDataBytes + numExtraChunks * (8 + 256);
+    uint8_t* bytes = (uint8_t*)malloc(maxSize);
+    uint8_t* dest = bytes + 12;
+
+    // Some files put their metadata before the audio
+    const char* extraChunkIds[] = { "LIST", "cue ", "smpl", "JUNK" };
+    for(uint32_t i = 0; i < numExtraChunks; ++i)
+        dest = writeChunk(dest, extraChunkIds[nextRandom(random) % 4], nextRandom(random) % 256, 0);
+
+    uint32_t fmtSize = kind == 6 ? 40 : (kind == 5 ? 20 : 16);
+    uint8_t* fmt = dest + 8;
+    dest = writeChunk(dest, "fmt ", fmtSize, 0);
+    writeU16(fmt, formatTag[kind]);
+    writeU16(fmt + 2, numChannels);
+    writeU32(fmt + 4, 44100);
+    writeU32(fmt + 8, 44100 * blockAlign);
+    writeU16(fmt + 12, blockAlign);
+    writeU16(fmt + 14, bits[kind]);
+    if(kind == 6)
+        writeU32(fmt + 24, 1); // SubFormat is KSDATAFORMAT_SUBTYPE_PCM
+    if(kind == 5)
+    {
+        dest = writeChunk(dest, "fact", 4, 0);
+        writeU32(dest - 4, numDataBytes / blockAlign * (((256 - 4) * 2) + 1));
+    }
+    dest = writeChunk(dest, "data", numDataBytes, (uint8_t)nextRandom(random));
+
+    WavFileBytes file;
+    file.bytes = bytes;
+    file.size = (uint32_t)(dest - bytes);
+    memcpy(bytes, "RIFF", 4);
+    writeU32(bytes + 4, file.size - 8);
+    memcpy(bytes + 8, "WAVE", 4);
+    return file;
+}
+
+static bool loadFile(const char* filename, WavFileBytes* file)
+{
+    FILE* f = fopen(filename, "rb");
+    if(!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    file->bytes = (uint8_t*)malloc(size > 0 ? size : 1);
+    file->size = (uint32_t)size;
+    bool result = size >= 0 && fread(file->bytes, 1, size, f) == (size_t)size;
+    fclose(f);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    bool writeCorpus = argc == 3 && strcmp(argv[1], "-w") == 0;
+    uint32_t numFiles = (argc > 1 && !writeCorpus) ? (uint32_t)(argc - 1) : NUM_GENERATED_FILES;
+    WavFileBytes* files = (WavFileBytes*)malloc(numFiles * sizeof(WavFileBytes));
+    uint64_t numBytesTotal = 0;
+    uint32_t random = 12345;
+    for(uint32_t i = 0; i < numFiles; ++i)
+    {
+        if(argc > 1 && !writeCorpus)
+        {
+            if(!loadFile(argv[i + 1], &files[i]))
+            {
+                printf("Failed to read %s\n", argv[i + 1]);
+                return 1;
+            }
+        }
+        else
+        {
+            files[i] = generateWavFile(&random);
+        }
+        numBytesTotal += files[i].size;
+    }
+
+    if(writeCorpus)
+    {
+        for(uint32_t i = 0; i < numFiles; ++i)
+        {
+            char filename[1024];
+            snprintf(filename, sizeof(filename), "%s/%04u.wav", argv[2], i);
+            FILE* f = fopen(filename, "wb");
+            if(!f || fwrite(files[i].bytes, 1, files[i].size, f) != files[i].size)
+            {
+                printf("Failed to write %s\n", filename);
+                return 1;
+            }
+            fclose(f);
+        }
+        printf("Wrote %u files to %s\n", numFiles, argv[2]);
+        return 0;
+    }
+
+    uint32_t numErrors[WAV_ERROR_UNSUPPORTED_FORMAT + 1] = {};
+    uint64_t numSamplesTotal = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    for(uint32_t pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        for(uint32_t i = 0; i < numFiles; ++i)
+        {
+            AudioClip clip;
+            WavChunkIndex chunks;
+            WavError error = parseWavFile(files[i].bytes, files[i].size, &clip, &chunks);
+            if(pass == 0)
+                ++numErrors[error];
+            numSamplesTotal += clip.numSamples;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    printf("%u files, %.1f MB\n", numFiles, numBytesTotal / (1024.0 * 1024.0));
+    for(uint32_t error = 0; error <= WAV_ERROR_UNSUPPORTED_FORMAT; ++error)
+        if(numErrors[error])
+            printf("  %s: %u\n", wavErrorString((WavError)error), numErrors[error]);
+    printf("%.0f files/s, %.1f ns per file (%llu samples found)\n", numFiles * NUM_PASSES / seconds,
+           seconds * 1e9 / ((double)numFiles * NUM_PASSES), (unsigned long long)(numSamplesTotal / NUM_PASSES));
+
+    for(uint32_t i = 0; i < numFiles; ++i)
+        free(files[i].bytes);
+    free(files);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/sh
+# Builds the parseWavFile fuzzer and benchmark on Linux. Needs clang for libFuzzer
+set -e
+cd "$(dirname "$0")"
+mkdir -p build
+
+echo Building...
+clang++ -g -O1 -fsanitize=fuzzer,address,undefined FuzzParseWavFile.cpp ../LoadWavFile.cpp -o build/FuzzParseWavFile
+clang++ -O2 -DNDEBUG BenchmarkParseWavFile.cpp ../LoadWavFile.cpp -o build/BenchmarkParseWavFile
+echo Done
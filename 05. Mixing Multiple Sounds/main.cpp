@@ -0,0 +1,605 @@
+
+// Simple example code to load a couple of Wav files and play them
+// at the same time with WASAPI. Each playing sound is a "voice" in
+// the mixer, which resamples and sums them all together for us.
+// The mixer runs on its own audio thread which WASAPI wakes up whenever
+// it needs more data, and the game talks to it through a command queue.
+// It renders straight into the audio engine's own mix format, so the only
+// resampling and conversion is ours rather than Windows' on top.
+// Run with "-o output.wav" to render the same thing to a wav file instead,
+// as fast as possible without an audio device, or "-t trace.csv" to
+// write out the audio thread's timings for every update
+
+#define _CRT_SECURE_NO_WARNINGS // fopen
+#define _USE_MATH_DEFINES
+#include <windows.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+#include <avrt.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AdaptiveLatency.h"
+#include "Allocators.h"
+#include "AudioCommandQueue.h"
+#include "AudioOutput.h"
+#include "AudioRenderer.h"
+#include "AudioTelemetry.h"
+#include "ConvertSamples.h"
+#include "LoadWavFile.h"
+#include "Mixer.h"
+#include "OutputFormat.h"
+#include "Win32ClipCache.h"
+
+// Only ever touched by the audio thread
+static AudioRenderer audioRenderer;
+// Game thread pushes, audio thread pops
+static AudioCommandQueue audioCommandQueue;
+// Game thread only
+static ClipCache clipCache;
+// Audio thread pushes, game thread polls
+static AudioTelemetryRing audioTelemetry;
+
+// Lets the render loop write to WASAPI like any other AudioOutput
+struct WasapiAudioOutput {
+    AudioOutput output;
+    IAudioClient3* audioClient;
+    IAudioRenderClient* audioRenderClient;
+};
+
+static uint32_t wasapiGetCurrentPadding(AudioOutput* output)
+{
+    UINT32 bufferPadding;
+    HRESULT hr = ((WasapiAudioOutput*)output)->audioClient->GetCurrentPadding(&bufferPadding);
+    assert(hr == S_OK);
+    return bufferPadding;
+}
+
+static void* wasapiGetBuffer(AudioOutput* output, uint32_t numFrames)
+{
+    BYTE* buffer;
+    HRESULT hr = ((WasapiAudioOutput*)output)->audioRenderClient->GetBuffer(numFrames, &buffer);
+    assert(hr == S_OK);
+    return buffer;
+}
+
+static void wasapiReleaseBuffer(AudioOutput* output, uint32_t numFrames)
+{
+    HRESULT hr = ((WasapiAudioOutput*)output)->audioRenderClient->ReleaseBuffer(numFrames, 0);
+    assert(hr == S_OK);
+}
+
+struct AudioThreadData {
+    AudioOutput* output;
+    uint32_t periodInFrames; // How often WASAPI wakes us up
+    HANDLE bufferReadyEvent;
+    IAudioClock* audioClock; // For comparing the device's clock to ours
+    std::atomic<bool> quit;
+};
+
+static DWORD WINAPI audioThreadProc(LPVOID param)
+{
+    AudioThreadData* data = (AudioThreadData*)param;
+    allocatorMarkAudioThread();
+
+    // Let the OS know this is a time-critical audio thread
+    DWORD taskIndex = 0;
+    HANDLE avrtHandle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+
+    // How much padding we want our sound buffer to have after writing to it.
+    // Needs to be enough so that the playback doesn't reach garbage data
+    // but we get less latency the lower it is (i.e. how long does it take
+    // between pressing jump and hearing the sound effect).
+    // Rather than picking a fixed amount we start as low as the device
+    // allows and only back off if we can't keep up
+    AdaptiveLatency latency;
+    adaptiveLatencyInit(&latency, data->periodInFrames, data->output->bufferSizeInFrames);
+
+    LARGE_INTEGER perfCounterFrequency;
+    QueryPerformanceFrequency(&perfCounterFrequency);
+    UINT64 deviceClockFrequency = 0;
+    if(data->audioClock)
+        data->audioClock->GetFrequency(&deviceClockFrequency);
+
+    // Both clocks are measured from the first wake-up, so the drift
+    // starts at zero and only shows how far apart they've moved since
+    bool isFirstUpdate = true;
+    LARGE_INTEGER startTime = {};
+    UINT64 startDevicePosition = 0;
+
+    while (!data->quit.load(std::memory_order_acquire))
+    {
+        // Sleep until WASAPI wants more data instead of spinning
+        WaitForSingleObject(data->bufferReadyEvent, INFINITE);
+
+        LARGE_INTEGER wakeUpTime;
+        QueryPerformanceCounter(&wakeUpTime);
+        UINT64 devicePosition = 0;
+        if(deviceClockFrequency)
+            data->audioClock->GetPosition(&devicePosition, nullptr);
+        if(isFirstUpdate)
+        {
+            startTime = wakeUpTime;
+            startDevicePosition = devicePosition;
+        }
+
+        // Padding is how much valid data is queued up in the sound buffer
+        // if there's enough padding then we could skip writing more data
+        uint32_t bufferPadding = data->output->getCurrentPadding(data->output);
+        uint32_t targetBufferPadding = adaptiveLatencyUpdate(&latency, bufferPadding);
+        uint32_t numFramesWritten = audioRendererRender(&audioRenderer, &audioCommandQueue, data->output, bufferPadding,
+                                                         targetBufferPadding);
+
+        LARGE_INTEGER endTime;
+        QueryPerformanceCounter(&endTime);
+
+        AudioTelemetrySample sample;
+        sample.wallClockMicroseconds = (uint64_t)((wakeUpTime.QuadPart - startTime.QuadPart) * 1000000 / perfCounterFrequency.QuadPart);
+        sample.renderMicroseconds = (uint32_t)((endTime.QuadPart - wakeUpTime.QuadPart) * 1000000 / perfCounterFrequency.QuadPart);
+        sample.numFramesWritten = numFramesWritten;
+        sample.paddingAtWakeUp = bufferPadding;
+        sample.deviceClockDriftMicroseconds = 0;
+        if(deviceClockFrequency)
+        {
+            uint64_t deviceMicroseconds = (devicePosition - startDevicePosition) * 1000000 / deviceClockFrequency;
+            sample.deviceClockDriftMicroseconds = (int32_t)((int64_t)deviceMicroseconds - (int64_t)sample.wallClockMicroseconds);
+        }
+        // Playback caught up with everything we'd written, so there was a gap
+        sample.isUnderrun = !isFirstUpdate && bufferPadding == 0;
+        loudnessMeterTakeLevels(&audioRenderer.mixer.masterMeter, &sample.peakDbfs, &sample.rmsDbfs);
+        sample.momentaryLufs = audioRenderer.mixer.masterMeter.momentaryLufs;
+        sample.shortTermLufs = audioRenderer.mixer.masterMeter.shortTermLufs;
+        audioTelemetryRecord(&audioTelemetry, &sample);
+
+        isFirstUpdate = false;
+    }
+
+    if(avrtHandle)
+        AvRevertMmThreadCharacteristics(avrtHandle);
+    return 0;
+}
+
+static void sendAudioCommand(const AudioCommand* command)
+{
+    bool result = pushAudioCommand(&audioCommandQueue, command);
+    assert(result); // Queue is full, the audio thread must have stalled
+}
+
+// Starts playing at the given mixer frame, or straight away if that's already passed
+static SoundHandle playClip(CachedClip* cachedClip, float gain, float pan, float pitch, bool looping, uint64_t frame = 0)
+{
+    static SoundHandle nextSoundHandle = 0;
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_PLAY;
+    command.sound = nextSoundHandle++;
+    command.frame = frame;
+    command.clip = &cachedClip->clip;
+    // Stops the clip cache from unloading the clip while it's playing
+    command.clipUseCount = &cachedClip->numVoicesPlaying;
+    cachedClip->numVoicesPlaying.fetch_add(1, std::memory_order_relaxed);
+    command.gain = gain;
+    command.pan = pan;
+    command.pitch = pitch;
+    command.looping = looping;
+    sendAudioCommand(&command);
+    return command.sound;
+}
+
+// Plays cachedClip once the sound's current clip (and anything queued before it) ends, with no gap
+static void queueClip(SoundHandle sound, CachedClip* cachedClip, bool looping, uint64_t frame = 0)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_QUEUE_CLIP;
+    command.sound = sound;
+    command.frame = frame;
+    command.clip = &cachedClip->clip;
+    command.clipUseCount = &cachedClip->numVoicesPlaying;
+    cachedClip->numVoicesPlaying.fetch_add(1, std::memory_order_relaxed);
+    command.looping = looping;
+    sendAudioCommand(&command);
+}
+
+// Lets a looping sound play on to the end of its clip
+static void releaseSound(SoundHandle sound, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_RELEASE;
+    command.sound = sound;
+    command.frame = frame;
+    sendAudioCommand(&command);
+}
+
+static void rampSoundGain(SoundHandle sound, float targetGain, uint32_t numRampFrames, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_RAMP_GAIN;
+    command.sound = sound;
+    command.frame = frame;
+    command.gain = targetGain;
+    command.numRampFrames = numRampFrames;
+    sendAudioCommand(&command);
+}
+
+static void setSoundEffect(SoundHandle sound, uint32_t slot, const EffectParams* params, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_EFFECT;
+    command.sound = sound;
+    command.frame = frame;
+    command.effectSlot = slot;
+    command.effect = *params;
+    sendAudioCommand(&command);
+}
+
+static void setSoundReverbSend(SoundHandle sound, float send, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_REVERB_SEND;
+    command.sound = sound;
+    command.frame = frame;
+    command.reverbSend = send;
+    sendAudioCommand(&command);
+}
+
+// Keeps the sound playing at tempo whatever its pitch, see mixerSetTempo()
+static void setSoundTempo(SoundHandle sound, float tempo, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_TEMPO;
+    command.sound = sound;
+    command.frame = frame;
+    command.tempo = tempo;
+    sendAudioCommand(&command);
+}
+
+// Pans and attenuates the sound from where it is relative to the listener
+static void setSoundPosition(SoundHandle sound, float x, float y, float z, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_POSITION;
+    command.sound = sound;
+    command.frame = frame;
+    command.position[0] = x;
+    command.position[1] = y;
+    command.position[2] = z;
+    sendAudioCommand(&command);
+}
+
+// Must come after setSoundPosition
+static void setSoundAttenuation(SoundHandle sound, AttenuationCurve curve, float minDistance, float maxDistance,
+                                float rolloff, uint64_t frame)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_ATTENUATION;
+    command.sound = sound;
+    command.frame = frame;
+    command.attenuationCurve = curve;
+    command.minDistance = minDistance;
+    command.maxDistance = maxDistance;
+    command.rolloff = rolloff;
+    sendAudioCommand(&command);
+}
+
+static void setListener(const SpatialListener* listener, uint64_t frame = 0)
+{
+    AudioCommand command = {};
+    command.type = AUDIO_COMMAND_SET_LISTENER;
+    command.frame = frame;
+    command.listener = *listener;
+    sendAudioCommand(&command);
+}
+
+// Offline, and live if the device's mix format is one the mixer can't write
+static const int32_t OUTPUT_SAMPLE_RATE = 44100;
+// What the mixer actually runs at, the device's rate when playing live
+static uint32_t outputSampleRate = OUTPUT_SAMPLE_RATE;
+static const int GAME_UPDATES_PER_SECOND = 60;
+static const int NUM_GAME_UPDATES = GAME_UPDATES_PER_SECOND * 10;
+
+// The sound effect for the beat asked for on update frame, circling the listener.
+// Scheduled for exactly the next half-second beat on the mixer's clock, rather
+// than whenever this happens to run, so it starts straight away if that's gone
+static void playBeat(CachedClip* sfx, int frame)
+{
+    uint64_t beatFrame = (uint64_t)(frame / 30 + 1) * outputSampleRate / 2;
+    SoundHandle sound = playClip(sfx, 0.8f, 0.f, 1.0f - frame / 1200.f, false, beatFrame);
+    setSoundReverbSend(sound, 0.4f, beatFrame);
+    setSoundTempo(sound, 1.f, beatFrame);
+    float angle = frame * (float)M_PI / 120.f;
+    float distance = 1.f + frame / 100.f;
+    setSoundPosition(sound, distance * sinf(angle), 0.f, distance * cosf(angle), beatFrame);
+    setSoundAttenuation(sound, ATTENUATION_INVERSE, 1.f, 20.f, 1.f, beatFrame);
+}
+
+// Pretend game update, called at roughly 60fps. Plays some music, then queues
+// it again to loop with no gap, the way an intro would lead into a loop.
+// It sounds muffled for a few seconds, as if a door closed on it, and
+// fades out at the end while playing on to the end of the clip. Also plays a sound effect with some reverb every
+// half a second, getting lower in pitch but not slower as it circles around the listener and moves further away
+static void updateGame(int frame)
+{
+    if(frame == 0)
+    {
+        SpatialListener listener = {};
+        listener.forward[2] = 1.f;
+        listener.up[1] = 1.f;
+        setListener(&listener);
+
+        if(CachedClip* music = clipCacheGet(&clipCache, "HelloWorld.wav"))
+        {
+            SoundHandle sound = playClip(music, 0.5f, 0.0f, 1.0f, false);
+            queueClip(sound, music, true);
+
+            EffectParams occlusion = {};
+            occlusion.type = EFFECT_LOW_PASS;
+            occlusion.frequency = 600.f;
+            occlusion.q = 0.707f;
+            setSoundEffect(sound, 0, &occlusion, 3 * outputSampleRate);
+            EffectParams noEffect = {};
+            setSoundEffect(sound, 0, &noEffect, 6 * outputSampleRate);
+
+            const uint64_t FADE_OUT_START_FRAME = (uint64_t)(NUM_GAME_UPDATES / GAME_UPDATES_PER_SECOND - 2) * outputSampleRate;
+            rampSoundGain(sound, 0.f, 2 * outputSampleRate, FADE_OUT_START_FRAME);
+            releaseSound(sound, FADE_OUT_START_FRAME);
+        }
+    }
+    if(frame % 30 == 0)
+    {
+        // If the clip isn't loaded yet this kicks off the load and queues the beat
+        if(CachedClip* sfx = clipCacheGetOrQueue(&clipCache, "Testing48kHz.wav", frame))
+            playBeat(sfx, frame);
+    }
+    clipCacheUpdate(&clipCache);
+
+    // Beats whose clip has loaded since they were asked for
+    PendingClipPlay plays[CLIP_CACHE_MAX_PENDING_PLAYS];
+    uint32_t numPlays = clipCacheTakeLoadedPlays(&clipCache, plays, CLIP_CACHE_MAX_PENDING_PLAYS);
+    for(uint32_t i = 0; i < numPlays; ++i)
+        playBeat(plays[i].cachedClip, (int)plays[i].userData);
+}
+
+static void printAudioTelemetry(AudioTelemetryRing* ring, const AudioTelemetryStats* stats)
+{
+    printf("Audio updates: %llu, underruns: %u, dropped telemetry samples: %u\n",
+           (unsigned long long)stats->numSamples, stats->numUnderruns, ring->numDropped.load(std::memory_order_relaxed));
+    printf("Render time (us): p50 %u, p99 %u, max %u\n", audioTelemetryRenderTimePercentile(stats, 0.5),
+           audioTelemetryRenderTimePercentile(stats, 0.99), stats->maxRenderMicroseconds);
+    printf("Min padding at wake-up: %u frames, device clock drift: %d us\n",
+           stats->numSamples ? stats->minPaddingAtWakeUp : 0, stats->lastDeviceClockDriftMicroseconds);
+    printf("Mix peak: %.1f dBFS, clipped in %u updates, max short-term loudness %.1f LUFS\n",
+           stats->maxPeakDbfs, stats->numClippedUpdates, stats->maxShortTermLufs);
+}
+
+static void printLoudness(const char* name, const LoudnessStats* stats)
+{
+    printf("%s: %.1f LUFS integrated, %.1f LU range, %.1f dBTP true peak, %.1f dBFS sample peak\n", name,
+           stats->integratedLufs, stats->loudnessRangeLu, stats->truePeakDbtp, stats->samplePeakDbfs);
+}
+
+// Loudness of every loaded clip, measured as it loaded, then of everything the mixer
+// has played. Only call once the audio thread has stopped, it owns the meter
+static void printLoudnessStats()
+{
+    for(uint32_t i = 0; i < CLIP_CACHE_MAX_CLIPS; ++i)
+    {
+        CachedClip* cachedClip = &clipCache.clips[i];
+        if(cachedClip->state.load(std::memory_order_acquire) == CACHED_CLIP_LOADED)
+            printLoudness(cachedClip->filename, &cachedClip->loudness);
+    }
+    LoudnessStats mixLoudness;
+    loudnessMeterGetStats(&audioRenderer.mixer.masterMeter, &mixLoudness);
+    printLoudness("Mix", &mixLoudness);
+}
+
+static void printAllocatorStats()
+{
+    for(uint32_t tag = 0; tag < ALLOCATION_TAG_COUNT; ++tag)
+    {
+        printf("Heap (%s): %llu KB now, %llu KB at most\n", allocationTagName((AllocationTag)tag),
+               (unsigned long long)trackedAllocNumBytes((AllocationTag)tag) / 1024,
+               (unsigned long long)trackedAllocHighWaterMark((AllocationTag)tag) / 1024);
+    }
+    const Mixer* mixer = &audioRenderer.mixer;
+    printf("Mixer scratch: %llu of %llu bytes at most, IMA-ADPCM decode buffers: %u of %u at most\n",
+           (unsigned long long)mixer->scratch.highWaterMark, (unsigned long long)mixer->scratch.size,
+           mixer->decodeBufferPool.highWaterMark, mixer->decodeBufferPool.numBlocks);
+    printf("Heap allocations on the audio thread: %u\n", allocatorNumAudioThreadAllocations());
+}
+
+int main(int argc, char** argv)
+{
+    const uint64_t CLIP_CACHE_BUDGET_IN_BYTES = 64 * 1024 * 1024;
+    clipCacheInit(&clipCache, &win32ClipLoader, CLIP_CACHE_BUDGET_IN_BYTES, true);
+    // Load the music up front so it can start straight away,
+    // and prefetch the sound effect in the background
+    CachedClip* music = clipCacheGet(&clipCache, "HelloWorld.wav", true);
+    assert(music);
+    clipCacheGet(&clipCache, "Testing48kHz.wav");
+
+    if(argc == 3 && strcmp(argv[1], "-o") == 0)
+    {
+        // Offline: no audio device or audio thread, just render
+        // one game update's worth of audio after each update
+        static WavFileAudioOutput wavOutput;
+        bool result = wavFileAudioOutputOpen(&wavOutput, argv[2], OUTPUT_SAMPLE_RATE);
+        assert(result);
+        audioRendererInit(&audioRenderer, OUTPUT_SAMPLE_RATE);
+        // Make sure everything is loaded so the output doesn't depend on load times
+        clipCacheGet(&clipCache, "Testing48kHz.wav", true);
+        for(int frame = 0; frame < NUM_GAME_UPDATES; ++frame)
+        {
+            updateGame(frame);
+            uint32_t bufferPadding = wavOutput.output.getCurrentPadding(&wavOutput.output);
+            audioRendererRender(&audioRenderer, &audioCommandQueue, &wavOutput.output, bufferPadding,
+                                OUTPUT_SAMPLE_RATE / GAME_UPDATES_PER_SECOND);
+        }
+        wavFileAudioOutputClose(&wavOutput);
+        printLoudnessStats();
+        printAllocatorStats();
+
+        clipCacheShutdown(&clipCache);
+        return 0;
+    }
+
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_SPEED_OVER_MEMORY);
+    assert(hr == S_OK);
+
+    IMMDeviceEnumerator* deviceEnumerator;
+    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (LPVOID*)(&deviceEnumerator));
+    assert(hr == S_OK);
+
+    IMMDevice* audioDevice;
+    hr = deviceEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &audioDevice);
+    assert(hr == S_OK);
+
+    deviceEnumerator->Release();
+
+    // IAudioClient3 (Windows 10+) lets us ask for smaller buffer periods than the default
+    IAudioClient3* audioClient;
+    hr = audioDevice->Activate(__uuidof(IAudioClient3), CLSCTX_ALL, nullptr, (LPVOID*)(&audioClient));
+    assert(hr == S_OK);
+
+    audioDevice->Release();
+
+    // Use whatever format the audio engine mixes in (usually float at 48kHz),
+    // so it can take our output as it is without resampling or converting it.
+    // If it's one we can't write, fall back to 16-bit and let Windows convert
+    WAVEFORMATEX* deviceMixFormat;
+    hr = audioClient->GetMixFormat(&deviceMixFormat);
+    assert(hr == S_OK);
+    AudioOutputFormat outputFormat;
+    bool isNativeFormat = audioOutputFormatFromWaveFormat(deviceMixFormat, sizeof(WAVEFORMATEX) + deviceMixFormat->cbSize,
+                                                          &outputFormat);
+    WAVEFORMATEX int16Format = {};
+    int16Format.wFormatTag = WAVE_FORMAT_PCM;
+    int16Format.nChannels = 2;
+    int16Format.nSamplesPerSec = OUTPUT_SAMPLE_RATE;
+    int16Format.wBitsPerSample = 16;
+    int16Format.nBlockAlign = (int16Format.nChannels * int16Format.wBitsPerSample) / 8;
+    int16Format.nAvgBytesPerSec = int16Format.nSamplesPerSec * int16Format.nBlockAlign;
+    if(!isNativeFormat)
+        outputFormat = audioOutputFormatInt16Stereo(OUTPUT_SAMPLE_RATE);
+    WAVEFORMATEX* mixFormat = isNativeFormat ? deviceMixFormat : &int16Format;
+    outputSampleRate = outputFormat.sampleRate;
+    const char* sampleTypeNames[] = { "16-bit", "24-bit", "32-bit", "float" };
+    printf("Output: %s, %u channels, %u Hz%s\n", sampleTypeNames[outputFormat.sampleType], outputFormat.numChannels,
+           outputFormat.sampleRate, isNativeFormat ? "" : " converted by Windows");
+
+    // Try for the smallest period the audio engine supports for our format.
+    // This only works if the engine can take our format without converting it,
+    // so if it fails we fall back to a regular stream with the default period
+    UINT32 defaultPeriodInFrames, fundamentalPeriodInFrames, minPeriodInFrames, maxPeriodInFrames;
+    hr = audioClient->GetSharedModeEnginePeriod(mixFormat, &defaultPeriodInFrames, &fundamentalPeriodInFrames,
+                                                &minPeriodInFrames, &maxPeriodInFrames);
+    UINT32 periodInFrames = minPeriodInFrames;
+    if(hr == S_OK)
+        hr = audioClient->InitializeSharedAudioStream(AUDCLNT_STREAMFLAGS_EVENTCALLBACK, minPeriodInFrames, mixFormat, nullptr);
+    if(hr != S_OK)
+    {
+        const float BUFFER_SIZE_IN_SECONDS = 2.0f;
+        const int64_t REFTIMES_PER_SEC = 10000000; // hundred nanoseconds
+        REFERENCE_TIME requestedSoundBufferDuration = (REFERENCE_TIME)(REFTIMES_PER_SEC * BUFFER_SIZE_IN_SECONDS);
+        DWORD initStreamFlags = ( AUDCLNT_STREAMFLAGS_RATEADJUST 
+                                | AUDCLNT_STREAMFLAGS_EVENTCALLBACK );
+        if(!isNativeFormat)
+            initStreamFlags |= AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
+        hr = audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, 
+                                     initStreamFlags, 
+                                     requestedSoundBufferDuration, 
+                                     0, mixFormat, nullptr);
+        assert(hr == S_OK);
+
+        REFERENCE_TIME defaultDevicePeriod;
+        hr = audioClient->GetDevicePeriod(&defaultDevicePeriod, nullptr);
+        assert(hr == S_OK);
+        periodInFrames = (UINT32)(defaultDevicePeriod * outputSampleRate / REFTIMES_PER_SEC);
+    }
+    CoTaskMemFree(deviceMixFormat);
+
+    audioRendererInit(&audioRenderer, outputSampleRate);
+    mixerSetOutputFormat(&audioRenderer.mixer, &outputFormat);
+
+    IAudioRenderClient* audioRenderClient;
+    hr = audioClient->GetService(__uuidof(IAudioRenderClient), (LPVOID*)(&audioRenderClient));
+    assert(hr == S_OK);
+
+    UINT32 bufferSizeInFrames;
+    hr = audioClient->GetBufferSize(&bufferSizeInFrames);
+    assert(hr == S_OK);
+
+    static WasapiAudioOutput wasapiOutput;
+    wasapiOutput.output.format = outputFormat;
+    wasapiOutput.output.bufferSizeInFrames = bufferSizeInFrames;
+    wasapiOutput.output.getCurrentPadding = wasapiGetCurrentPadding;
+    wasapiOutput.output.getBuffer = wasapiGetBuffer;
+    wasapiOutput.output.releaseBuffer = wasapiReleaseBuffer;
+    wasapiOutput.audioClient = audioClient;
+    wasapiOutput.audioRenderClient = audioRenderClient;
+
+    // Optional, we just don't report clock drift if it's missing
+    IAudioClock* audioClock = nullptr;
+    hr = audioClient->GetService(__uuidof(IAudioClock), (LPVOID*)(&audioClock));
+    if(hr != S_OK)
+        audioClock = nullptr;
+
+    FILE* traceFile = nullptr;
+    if(argc == 3 && strcmp(argv[1], "-t") == 0)
+    {
+        traceFile = fopen(argv[2], "w");
+        assert(traceFile);
+        fprintf(traceFile, "wallClockMicroseconds,renderMicroseconds,numFramesWritten,paddingAtWakeUp,deviceClockDriftMicroseconds,isUnderrun,"
+                           "peakDbfs,rmsDbfs,momentaryLufs,shortTermLufs\n");
+    }
+    AudioTelemetryStats telemetryStats;
+    audioTelemetryStatsInit(&telemetryStats);
+
+    static AudioThreadData audioThreadData;
+    audioThreadData.output = &wasapiOutput.output;
+    audioThreadData.audioClock = audioClock;
+    audioThreadData.periodInFrames = periodInFrames;
+    audioThreadData.bufferReadyEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    assert(audioThreadData.bufferReadyEvent);
+    hr = audioClient->SetEventHandle(audioThreadData.bufferReadyEvent);
+    assert(hr == S_OK);
+
+    HANDLE audioThread = CreateThread(nullptr, 0, audioThreadProc, &audioThreadData, 0, nullptr);
+    assert(audioThread);
+
+    hr = audioClient->Start();
+    assert(hr == S_OK);
+
+    for(int frame = 0; frame < NUM_GAME_UPDATES; ++frame)
+    {
+        updateGame(frame);
+        audioTelemetryPoll(&audioTelemetry, &telemetryStats, traceFile);
+        Sleep(1000 / GAME_UPDATES_PER_SECOND);
+    }
+
+    audioThreadData.quit.store(true, std::memory_order_release);
+    SetEvent(audioThreadData.bufferReadyEvent);
+    WaitForSingleObject(audioThread, INFINITE);
+    CloseHandle(audioThread);
+
+    audioTelemetryPoll(&audioTelemetry, &telemetryStats, traceFile);
+    printAudioTelemetry(&audioTelemetry, &telemetryStats);
+    printLoudnessStats();
+    printAllocatorStats();
+    if(traceFile)
+        fclose(traceFile);
+
+    audioClient->Stop();
+    if(audioClock)
+        audioClock->Release();
+    audioClient->Release();
+    audioRenderClient->Release();
+    CloseHandle(audioThreadData.bufferReadyEvent);
+
+    clipCacheShutdown(&clipCache);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "BatchResampler.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <assert.h>
+
+// References:
+// https://ccrma.stanford.edu/~jos/resample/
+// https://en.wikipedia.org/wiki/Kaiser_window
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for(int k = 1; k < 32; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+void batchResamplerInit(BatchResampler* resampler, uint32_t inputSampleRate, uint32_t outputSampleRate)
+{
+    resampler->inputSampleRate = inputSampleRate;
+    resampler->outputSampleRate = outputSampleRate;
+
+    // When downsampling, lower the cutoff to the new Nyquist frequency so
+    // anything above it gets filtered out instead of aliasing. Leave a bit
+    // of room for the filter's transition band either way
+    double cutoff = 0.95;
+    if(outputSampleRate < inputSampleRate)
+        cutoff *= (double)outputSampleRate / inputSampleRate;
+
+    const double KAISER_BETA = 8.0;
+    const double halfWidth = BATCH_RESAMPLER_NUM_TAPS / 2;
+    for(int phase = 0; phase <= BATCH_RESAMPLER_NUM_PHASES; ++phase)
+    {
+        double fraction = (double)phase / BATCH_RESAMPLER_NUM_PHASES;
+        double sum = 0.0;
+        for(int tap = 0; tap < BATCH_RESAMPLER_NUM_TAPS; ++tap)
+        {
+            // Distance from the output position to this tap's input sample
+            double x = (BATCH_RESAMPLER_NUM_TAPS / 2 - 1 - tap) + fraction;
+            double sinc = (x == 0.0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double r = x / halfWidth;
+            double window = (r * r < 1.0) ? besselI0(KAISER_BETA * sqrt(1.0 - r * r)) / besselI0(KAISER_BETA) : 0.0;
+            double coefficient = cutoff * sinc * window;
+            resampler->filters[phase][tap] = (float)coefficient;
+            sum += coefficient;
+        }
+        // Normalise so a constant signal comes out at the same level
+        for(int tap = 0; tap < BATCH_RESAMPLER_NUM_TAPS; ++tap)
+            resampler->filters[phase][tap] = (float)(resampler->filters[phase][tap] / sum);
+    }
+}
+
+uint64_t batchResamplerNumOutputFrames(const BatchResampler* resampler, uint64_t numInputFrames)
+{
+    // Round up so we don't drop the tail end
+    return (numInputFrames * resampler->outputSampleRate + resampler->inputSampleRate - 1) / resampler->inputSampleRate;
+}
+
+void batchResamplerProcess(const BatchResampler* resampler, const float* input, uint64_t numInputFrames, uint32_t numChannels,
+                           uint64_t firstOutputFrame, uint32_t numOutputFrames, float* output)
+{
+    assert(numChannels <= 8);
+    const uint64_t inputRate = resampler->inputSampleRate;
+    const uint64_t outputRate = resampler->outputSampleRate;
+
+    for(uint32_t i = 0; i < numOutputFrames; ++i)
+    {
+        // Work out the input position with integer maths so it's exact
+        // for any output frame, however far into the file we are
+        uint64_t outputFrame = firstOutputFrame + i;
+        uint64_t inputFrame = outputFrame * inputRate / outputRate;
+        uint64_t remainder = outputFrame * inputRate % outputRate;
+
+        float phasePosition = (float)remainder * BATCH_RESAMPLER_NUM_PHASES / outputRate;
+        int phase = (int)phasePosition;
+        float phaseT = phasePosition - phase;
+        const float* filterA = resampler->filters[phase];
+        const float* filterB = resampler->filters[phase + 1];
+
+        float sums[8] = {};
+        int64_t firstTapFrame = (int64_t)inputFrame - (BATCH_RESAMPLER_NUM_TAPS / 2 - 1);
+        for(int tap = 0; tap < BATCH_RESAMPLER_NUM_TAPS; ++tap)
+        {
+            int64_t tapFrame = firstTapFrame + tap;
+            if(tapFrame < 0 || tapFrame >= (int64_t)numInputFrames)
+                continue;
+            float coefficient = filterA[tap] + (filterB[tap] - filterA[tap]) * phaseT;
+            const float* frame = input + tapFrame * numChannels;
+            for(uint32_t channel = 0; channel < numChannels; ++channel)
+                sums[channel] += frame[channel] * coefficient;
+        }
+        for(uint32_t channel = 0; channel < numChannels; ++channel)
+            *output++ = sums[channel];
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// Number of input samples that contribute to each output sample
+#define BATCH_RESAMPLER_NUM_TAPS 32
+// Number of fractional positions we precompute filters for.
+// We interpolate between the two nearest ones
+#define BATCH_RESAMPLER_NUM_PHASES 256
+
+// High quality windowed-sinc resampler for offline use. Each output frame is
+// computed purely from its own index, so any range of output frames can be
+// produced independently (e.g. on different threads) and the result is
+// exactly the same as producing the whole thing in one go.
+// Unlike the real-time Resampler in 03, which steps a 32.32 position along from
+// wherever it got to, it works out every position exactly from the ratio of the
+// sample rates, and it has twice the taps since nobody's waiting on it
+struct BatchResampler {
+    uint32_t inputSampleRate;
+    uint32_t outputSampleRate;
+    // One extra phase so we can always interpolate to phase+1
+    float filters[BATCH_RESAMPLER_NUM_PHASES + 1][BATCH_RESAMPLER_NUM_TAPS];
+};
+
+void batchResamplerInit(BatchResampler* resampler, uint32_t inputSampleRate, uint32_t outputSampleRate);
+uint64_t batchResamplerNumOutputFrames(const BatchResampler* resampler, uint64_t numInputFrames);
+// Writes output frames [firstOutputFrame, firstOutputFrame + numOutputFrames) of the
+// resampled input. input and output are interleaved float. Input past either end
+// of the clip is treated as silence
+void batchResamplerProcess(const BatchResampler* resampler, const float* input, uint64_t numInputFrames, uint32_t numChannels,
+                           uint64_t firstOutputFrame, uint32_t numOutputFrames, float* output);
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "LoadWavFile.h"
+
+// Convert numSamples samples of any format parseWavFile supports to float in [-1, 1)
+void convertSamplesToFloat(const void* src, SampleFormat sampleFormat, uint32_t numBitsPerSample,
+                           uint32_t numSamples, float* dest);
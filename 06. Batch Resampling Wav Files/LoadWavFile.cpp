@@ -0,0 +1,178 @@
+#include "LoadWavFile.h"
+
+#include <string.h>
+
+// Rudimentary Wav file loader. Doesn't use any platform headers and reads
+// every field a byte at a time, so it doesn't care about alignment. Batches
+// of files come from anywhere, so a broken one is reported rather than trusted
+// For illustrative purposes only, no warranty is implied
+// References: 
+// https://www.mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+// Handmade Hero Day 138: Loading WAV Files
+
+#define WAV_FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+// Same values as the WAVE_FORMAT_ tags in mmreg.h
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_IEEE_FLOAT 0x0003
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// Anything more is probably a broken file, and the converters only go up to 8
+#define WAV_MAX_CHANNELS 8
+
+static uint16_t readU16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+// Where a chunk's data is in the file, just after its header. Both are 0 if the file doesn't have one
+struct WavChunk {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// If a file has more than one of a chunk, only the first one counts
+struct WavChunkIndex {
+    WavChunk fmt;
+    WavChunk data;
+};
+
+static WavError indexWavChunks(const uint8_t* fileBytes, uint32_t fileSize, WavChunkIndex* chunks)
+{
+    *chunks = {};
+    if(fileSize < 12 || readU32(fileBytes) != WAV_FOURCC('R','I','F','F') || readU32(fileBytes + 8) != WAV_FOURCC('W','A','V','E'))
+        return WAV_ERROR_NOT_A_WAV_FILE;
+
+    // Stop at the end of the RIFF chunk if it's inside the file,
+    // anything after that isn't part of the wav
+    uint64_t end = fileSize;
+    uint64_t riffEnd = 8 + (uint64_t)readU32(fileBytes + 4);
+    if(riffEnd >= 12 && riffEnd < end)
+        end = riffEnd;
+
+    // 64-bit so a huge chunk size can't wrap us back around to the start
+    uint64_t offset = 12;
+    while(offset + 8 <= end)
+    {
+        uint32_t id = readU32(fileBytes + offset);
+        uint32_t size = readU32(fileBytes + offset + 4);
+        uint64_t dataOffset = offset + 8;
+        if(size > end - dataOffset)
+        {
+            // Files that were being recorded when they were cut off often have a data
+            // chunk size that's too big (or never got filled in), so use what's there
+            if(id != WAV_FOURCC('d','a','t','a'))
+                return WAV_ERROR_TRUNCATED;
+            size = (uint32_t)(end - dataOffset);
+        }
+
+        WavChunk* chunk = nullptr;
+        switch(id)
+        {
+            case WAV_FOURCC('f','m','t',' '): chunk = &chunks->fmt; break;
+            case WAV_FOURCC('d','a','t','a'): chunk = &chunks->data; break;
+        }
+        if(chunk && chunk->offset == 0)
+        {
+            chunk->offset = (uint32_t)dataOffset;
+            chunk->size = size;
+        }
+        // Chunks are padded to an even number of bytes
+        offset = dataOffset + size + (size & 1);
+    }
+    return WAV_OK;
+}
+
+static WavError parseFmtChunk(const uint8_t* fmt, uint32_t fmtSize, AudioClip* clip)
+{
+    if(fmtSize < 16)
+        return WAV_ERROR_INVALID_FORMAT;
+    uint32_t formatTag = readU16(fmt);
+    uint32_t numChannels = readU16(fmt + 2);
+    uint32_t sampleRate = readU32(fmt + 4);
+    uint32_t blockAlign = readU16(fmt + 12);
+    uint32_t numBitsPerSample = readU16(fmt + 14);
+    if(formatTag == WAV_FORMAT_EXTENSIBLE)
+    {
+        // The real format is in SubFormat. The GUIDs for the basic formats
+        // (KSDATAFORMAT_SUBTYPE_PCM etc.) are their WAVE_FORMAT_ tag followed
+        // by these same 12 bytes, and any other GUID is a format we don't know
+        static const uint8_t BASE_GUID[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        if(fmtSize < 40)
+            return WAV_ERROR_INVALID_FORMAT;
+        if(memcmp(fmt + 28, BASE_GUID, sizeof(BASE_GUID)) != 0)
+            return WAV_ERROR_UNSUPPORTED_FORMAT;
+        formatTag = readU32(fmt + 24);
+    }
+    if(numChannels == 0 || sampleRate == 0 || blockAlign == 0)
+        return WAV_ERROR_INVALID_FORMAT;
+    if(numChannels > WAV_MAX_CHANNELS)
+        return WAV_ERROR_UNSUPPORTED_FORMAT;
+
+    switch(formatTag)
+    {
+        case WAV_FORMAT_PCM:
+            if(numBitsPerSample != 8 && numBitsPerSample != 16 && numBitsPerSample != 24 && numBitsPerSample != 32)
+                return WAV_ERROR_UNSUPPORTED_FORMAT;
+            clip->sampleFormat = SAMPLE_FORMAT_PCM;
+            break;
+        case WAV_FORMAT_IEEE_FLOAT:
+            if(numBitsPerSample != 32)
+                return WAV_ERROR_UNSUPPORTED_FORMAT;
+            clip->sampleFormat = SAMPLE_FORMAT_FLOAT;
+            break;
+        default:
+            return WAV_ERROR_UNSUPPORTED_FORMAT;
+    }
+    if(blockAlign != numChannels * numBitsPerSample / 8)
+        return WAV_ERROR_INVALID_FORMAT;
+
+    clip->numChannels = numChannels;
+    clip->sampleRate = sampleRate;
+    clip->numBitsPerSample = numBitsPerSample;
+    return WAV_OK;
+}
+
+WavError parseWavFile(const uint8_t* fileBytes, uint32_t fileSize, AudioClip* clip)
+{
+    *clip = {};
+    WavChunkIndex chunks;
+    WavError error = indexWavChunks(fileBytes, fileSize, &chunks);
+    if(error == WAV_OK && !chunks.fmt.offset)
+        error = WAV_ERROR_MISSING_FMT_CHUNK;
+    if(error == WAV_OK && !chunks.data.offset)
+        error = WAV_ERROR_MISSING_DATA_CHUNK;
+    if(error == WAV_OK)
+        error = parseFmtChunk(fileBytes + chunks.fmt.offset, chunks.fmt.size, clip);
+    if(error != WAV_OK)
+    {
+        *clip = {};
+        return error;
+    }
+
+    // Only whole frames, a partly written one at the end is dropped
+    uint32_t numFrames = chunks.data.size / (clip->numChannels * clip->numBitsPerSample / 8);
+    clip->numSamples = numFrames * clip->numChannels;
+    clip->samples = (void*)(fileBytes + chunks.data.offset);
+    return WAV_OK;
+}
+
+const char* wavErrorString(WavError error)
+{
+    switch(error)
+    {
+        case WAV_OK: return "OK";
+        case WAV_ERROR_NOT_A_WAV_FILE: return "Not a wav file";
+        case WAV_ERROR_TRUNCATED: return "File is truncated";
+        case WAV_ERROR_MISSING_FMT_CHUNK: return "No fmt chunk";
+        case WAV_ERROR_MISSING_DATA_CHUNK: return "No data chunk";
+        case WAV_ERROR_INVALID_FORMAT: return "Invalid fmt chunk";
+        case WAV_ERROR_UNSUPPORTED_FORMAT: return "Unsupported format";
+    }
+    return "Unknown error";
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+enum SampleFormat {
+    SAMPLE_FORMAT_PCM,   // Integer, 8-bit is unsigned and the rest are signed
+    SAMPLE_FORMAT_FLOAT, // 32-bit float
+};
+
+struct AudioClip {
+    SampleFormat sampleFormat;
+    uint32_t numChannels;
+    uint32_t numBitsPerSample;
+    uint32_t sampleRate;
+    uint32_t numSamples;
+    void* samples;
+};
+
+enum WavError {
+    WAV_OK,
+    WAV_ERROR_NOT_A_WAV_FILE,
+    WAV_ERROR_TRUNCATED,
+    WAV_ERROR_MISSING_FMT_CHUNK,
+    WAV_ERROR_MISSING_DATA_CHUNK,
+    WAV_ERROR_INVALID_FORMAT,     // The fmt chunk doesn't make sense
+    WAV_ERROR_UNSUPPORTED_FORMAT, // Valid, but not something we can resample
+};
+
+// Checks every read against fileSize, so it's safe to call on any bytes at all.
+// Fills in clip on success and zeroes it on failure
+WavError parseWavFile(const uint8_t* fileBytes, uint32_t fileSize, AudioClip* clip);
+const char* wavErrorString(WavError error);
@@ -0,0 +1,356 @@
+#include "Loudness.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include <emmintrin.h> // SSE2
+
+// For illustrative purposes only, no warranty is implied
+// References:
+// ITU-R BS.1770-4, Algorithms to measure audio programme loudness and true-peak audio level
+// EBU Tech 3341 and 3342, loudness metering and loudness range
+// libebur128 by Jan Kokemüller, for the K-weighting filters at any sample rate
+
+static inline float energyToLufs(double energy)
+{
+    return energy > 0.0 ? (float)(-0.691 + 10.0 * log10(energy)) : -HUGE_VALF;
+}
+
+static inline float linearToDb(double value)
+{
+    return value > 0.0 ? (float)(20.0 * log10(value)) : -HUGE_VALF;
+}
+
+void loudnessMeterInit(LoudnessMeter* meter, uint32_t sampleRate, uint32_t numChannels)
+{
+    assert(numChannels >= 1 && numChannels <= LOUDNESS_MAX_CHANNELS);
+    memset(meter, 0, sizeof(*meter));
+    meter->numChannels = numChannels;
+    meter->numFramesPerStep = sampleRate / 10;
+    meter->momentaryLufs = -HUGE_VALF;
+    meter->shortTermLufs = -HUGE_VALF;
+    meter->maxMomentaryLufs = -HUGE_VALF;
+    meter->maxShortTermLufs = -HUGE_VALF;
+
+    // Stage 1, the head: high shelf of about +4dB above 1.5kHz
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / sampleRate);
+    double vh = pow(10.0, gain / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    meter->filterB[0][0] = (vh + vb * k / q + k * k) / a0;
+    meter->filterB[0][1] = 2.0 * (k * k - vh) / a0;
+    meter->filterB[0][2] = (vh - vb * k / q + k * k) / a0;
+    meter->filterA[0][0] = 2.0 * (k * k - 1.0) / a0;
+    meter->filterA[0][1] = (1.0 - k / q + k * k) / a0;
+
+    // Stage 2, RLB weighting: high-pass at about 38Hz
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / sampleRate);
+    a0 = 1.0 + k / q + k * k;
+    meter->filterB[1][0] = 1.0;
+    meter->filterB[1][1] = -2.0;
+    meter->filterB[1][2] = 1.0;
+    meter->filterA[1][0] = 2.0 * (k * k - 1.0) / a0;
+    meter->filterA[1][1] = (1.0 - k / q + k * k) / a0;
+
+    // 48 tap windowed sinc for 4x oversampling, centred on tap 24 so phase 0 is the
+    // input sample itself. Each phase is normalised to a gain of exactly 1 at DC
+    const uint32_t NUM_TAPS = 4 * LOUDNESS_TRUE_PEAK_TAPS;
+    for(uint32_t phase = 0; phase < 4; ++phase)
+    {
+        double sum = 0.0;
+        double taps[LOUDNESS_TRUE_PEAK_TAPS];
+        for(uint32_t tap = 0; tap < LOUDNESS_TRUE_PEAK_TAPS; ++tap)
+        {
+            uint32_t n = 4 * tap + phase;
+            double x = ((double)n - NUM_TAPS / 2) / 4.0;
+            double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double window = 0.5 - 0.5 * cos(2.0 * M_PI * n / NUM_TAPS);
+            taps[tap] = sinc * window;
+            sum += taps[tap];
+        }
+        for(uint32_t tap = 0; tap < LOUDNESS_TRUE_PEAK_TAPS; ++tap)
+            meter->truePeakFilter[tap][phase] = (float)(taps[tap] / sum);
+    }
+}
+
+static void addToHistogram(LoudnessHistogram* histogram, double energy)
+{
+    float lufs = energyToLufs(energy);
+    if(lufs < LOUDNESS_HISTOGRAM_MIN_LUFS) // Absolute gate
+        return;
+    uint32_t bin = (uint32_t)((lufs - LOUDNESS_HISTOGRAM_MIN_LUFS) * 10.f);
+    if(bin >= LOUDNESS_HISTOGRAM_BINS)
+        bin = LOUDNESS_HISTOGRAM_BINS - 1;
+    ++histogram->counts[bin];
+    histogram->energy[bin] += energy;
+}
+
+static inline float binLufs(uint32_t bin)
+{
+    return LOUDNESS_HISTOGRAM_MIN_LUFS + (bin + 0.5f) * 0.1f;
+}
+
+// First bin at or above the relative gate, which is relativeGateLu below the
+// loudness of everything that made it past the absolute gate
+static uint32_t relativeGateBin(const LoudnessHistogram* histogram, float relativeGateLu)
+{
+    double energy = 0.0;
+    uint64_t count = 0;
+    for(uint32_t bin = 0; bin < LOUDNESS_HISTOGRAM_BINS; ++bin)
+    {
+        energy += histogram->energy[bin];
+        count += histogram->counts[bin];
+    }
+    if(count == 0)
+        return LOUDNESS_HISTOGRAM_BINS;
+    float gateLufs = energyToLufs(energy / count) + relativeGateLu;
+    uint32_t bin = 0;
+    while(bin < LOUDNESS_HISTOGRAM_BINS && binLufs(bin) < gateLufs)
+        ++bin;
+    return bin;
+}
+
+// A 100ms step is done, so there's a new momentary and maybe short-term block
+static void finishStep(LoudnessMeter* meter)
+{
+    meter->recentSteps[meter->numSteps % LOUDNESS_SHORT_TERM_STEPS] = meter->stepEnergy / meter->numFramesPerStep;
+    ++meter->numSteps;
+    meter->stepEnergy = 0.0;
+    meter->numStepFrames = 0;
+
+    if(meter->numSteps >= LOUDNESS_MOMENTARY_STEPS)
+    {
+        double energy = 0.0;
+        for(uint64_t i = meter->numSteps - LOUDNESS_MOMENTARY_STEPS; i < meter->numSteps; ++i)
+            energy += meter->recentSteps[i % LOUDNESS_SHORT_TERM_STEPS];
+        energy /= LOUDNESS_MOMENTARY_STEPS;
+        meter->momentaryLufs = energyToLufs(energy);
+        if(meter->momentaryLufs > meter->maxMomentaryLufs)
+            meter->maxMomentaryLufs = meter->momentaryLufs;
+        addToHistogram(&meter->momentaryHistogram, energy);
+    }
+    if(meter->numSteps >= LOUDNESS_SHORT_TERM_STEPS)
+    {
+        double energy = 0.0;
+        for(uint32_t i = 0; i < LOUDNESS_SHORT_TERM_STEPS; ++i)
+            energy += meter->recentSteps[i];
+        energy /= LOUDNESS_SHORT_TERM_STEPS;
+        meter->shortTermLufs = energyToLufs(energy);
+        if(meter->shortTermLufs > meter->maxShortTermLufs)
+            meter->maxShortTermLufs = meter->shortTermLufs;
+        addToHistogram(&meter->shortTermHistogram, energy);
+    }
+
+    // The filters decay towards denormals in silence, which are very slow
+    double* state = &meter->filterState[0][0][0];
+    for(uint32_t i = 0; i < 8; ++i)
+        if(fabs(state[i]) < 1e-30)
+            state[i] = 0.0;
+}
+
+// K-weight numFrames and add them to the current step
+static void processLoudness(LoudnessMeter* meter, const float* left, const float* right, uint32_t numFrames)
+{
+    const __m128d b00 = _mm_set1_pd(meter->filterB[0][0]), b01 = _mm_set1_pd(meter->filterB[0][1]);
+    const __m128d b02 = _mm_set1_pd(meter->filterB[0][2]);
+    const __m128d a00 = _mm_set1_pd(meter->filterA[0][0]), a01 = _mm_set1_pd(meter->filterA[0][1]);
+    const __m128d b10 = _mm_set1_pd(meter->filterB[1][0]), b11 = _mm_set1_pd(meter->filterB[1][1]);
+    const __m128d b12 = _mm_set1_pd(meter->filterB[1][2]);
+    const __m128d a10 = _mm_set1_pd(meter->filterA[1][0]), a11 = _mm_set1_pd(meter->filterA[1][1]);
+    __m128d z00 = _mm_load_pd(meter->filterState[0][0]), z01 = _mm_load_pd(meter->filterState[0][1]);
+    __m128d z10 = _mm_load_pd(meter->filterState[1][0]), z11 = _mm_load_pd(meter->filterState[1][1]);
+    const bool isStereo = meter->numChannels == 2;
+
+    uint32_t frame = 0;
+    while(frame < numFrames)
+    {
+        uint32_t numFramesThisStep = meter->numFramesPerStep - meter->numStepFrames;
+        if(numFramesThisStep > numFrames - frame)
+            numFramesThisStep = numFrames - frame;
+        __m128d energy = _mm_setzero_pd();
+        for(uint32_t i = frame; i < frame + numFramesThisStep; ++i)
+        {
+            // Transposed direct form II, left in the low half and right in the high half
+            __m128d x = _mm_set_pd(isStereo ? right[i] : 0.0, left[i]);
+            __m128d y = _mm_add_pd(_mm_mul_pd(b00, x), z00);
+            z00 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b01, x), _mm_mul_pd(a00, y)), z01);
+            z01 = _mm_sub_pd(_mm_mul_pd(b02, x), _mm_mul_pd(a01, y));
+            x = y;
+            y = _mm_add_pd(_mm_mul_pd(b10, x), z10);
+            z10 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b11, x), _mm_mul_pd(a10, y)), z11);
+            z11 = _mm_sub_pd(_mm_mul_pd(b12, x), _mm_mul_pd(a11, y));
+            energy = _mm_add_pd(energy, _mm_mul_pd(y, y));
+        }
+        meter->stepEnergy += _mm_cvtsd_f64(energy) + _mm_cvtsd_f64(_mm_unpackhi_pd(energy, energy));
+        meter->numStepFrames += numFramesThisStep;
+        frame += numFramesThisStep;
+        if(meter->numStepFrames == meter->numFramesPerStep)
+        {
+            _mm_store_pd(meter->filterState[0][0], z00);
+            _mm_store_pd(meter->filterState[0][1], z01);
+            _mm_store_pd(meter->filterState[1][0], z10);
+            _mm_store_pd(meter->filterState[1][1], z11);
+            finishStep(meter);
+            z00 = _mm_load_pd(meter->filterState[0][0]);
+            z01 = _mm_load_pd(meter->filterState[0][1]);
+            z10 = _mm_load_pd(meter->filterState[1][0]);
+            z11 = _mm_load_pd(meter->filterState[1][1]);
+        }
+    }
+    _mm_store_pd(meter->filterState[0][0], z00);
+    _mm_store_pd(meter->filterState[0][1], z01);
+    _mm_store_pd(meter->filterState[1][0], z10);
+    _mm_store_pd(meter->filterState[1][1], z11);
+}
+
+// Sample peak, true peak and level for one channel of up to LOUDNESS_CHUNK_FRAMES
+static void processPeaks(LoudnessMeter* meter, uint32_t channel, const float* samples, uint32_t numFrames)
+{
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    __m128 peak = _mm_setzero_ps();
+    __m128 energy = _mm_setzero_ps();
+    uint32_t i = 0;
+    for(; i + 4 <= numFrames; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(samples + i);
+        peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, x));
+        energy = _mm_add_ps(energy, _mm_mul_ps(x, x));
+    }
+    alignas(16) float peaks[4], energies[4];
+    _mm_store_ps(peaks, peak);
+    _mm_store_ps(energies, energy);
+    float samplePeak = fmaxf(fmaxf(peaks[0], peaks[1]), fmaxf(peaks[2], peaks[3]));
+    double levelEnergy = (double)energies[0] + energies[1] + energies[2] + energies[3];
+    for(; i < numFrames; ++i)
+    {
+        samplePeak = fmaxf(samplePeak, fabsf(samples[i]));
+        levelEnergy += samples[i] * samples[i];
+    }
+    meter->samplePeak = fmaxf(meter->samplePeak, samplePeak);
+    meter->levelPeak = fmaxf(meter->levelPeak, samplePeak);
+    meter->levelEnergy += levelEnergy;
+
+    // True peak: work out all 4 phases of each output frame at once,
+    // one filter tap at a time, and keep the biggest
+    const uint32_t HISTORY = LOUDNESS_TRUE_PEAK_TAPS - 1;
+    float* input = meter->truePeakInput[channel];
+    memcpy(input + HISTORY, samples, numFrames * sizeof(float));
+    __m128 truePeak = _mm_setzero_ps();
+    for(uint32_t frame = 0; frame < numFrames; ++frame)
+    {
+        const float* newest = input + frame + HISTORY;
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(newest[0]), _mm_load_ps(meter->truePeakFilter[0]));
+        for(uint32_t tap = 1; tap < LOUDNESS_TRUE_PEAK_TAPS; ++tap)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(newest[-(int32_t)tap]), _mm_load_ps(meter->truePeakFilter[tap])));
+        truePeak = _mm_max_ps(truePeak, _mm_andnot_ps(signMask, sum));
+    }
+    memmove(input, input + numFrames, HISTORY * sizeof(float));
+    _mm_store_ps(peaks, truePeak);
+    meter->truePeak = fmaxf(meter->truePeak, fmaxf(fmaxf(peaks[0], peaks[1]), fmaxf(peaks[2], peaks[3])));
+}
+
+void loudnessMeterProcess(LoudnessMeter* meter, const float* left, const float* right, uint32_t numFrames)
+{
+    processLoudness(meter, left, right, numFrames);
+    for(uint32_t frame = 0; frame < numFrames; frame += LOUDNESS_CHUNK_FRAMES)
+    {
+        uint32_t numChunkFrames = numFrames - frame < LOUDNESS_CHUNK_FRAMES ? numFrames - frame : LOUDNESS_CHUNK_FRAMES;
+        processPeaks(meter, 0, left + frame, numChunkFrames);
+        if(meter->numChannels == 2)
+            processPeaks(meter, 1, right + frame, numChunkFrames);
+    }
+    meter->numLevelFrames += numFrames;
+}
+
+void loudnessMeterGetStats(const LoudnessMeter* meter, LoudnessStats* stats)
+{
+    // Integrated: mean of the momentary blocks within 10 LU of the mean of all of them
+    const LoudnessHistogram* momentary = &meter->momentaryHistogram;
+    double energy = 0.0;
+    uint64_t count = 0;
+    for(uint32_t bin = relativeGateBin(momentary, -10.f); bin < LOUDNESS_HISTOGRAM_BINS; ++bin)
+    {
+        energy += momentary->energy[bin];
+        count += momentary->counts[bin];
+    }
+    stats->integratedLufs = count ? energyToLufs(energy / count) : -HUGE_VALF;
+
+    // Range: 10th to 95th percentile of the short-term blocks within 20 LU of the mean
+    const LoudnessHistogram* shortTerm = &meter->shortTermHistogram;
+    uint32_t firstBin = relativeGateBin(shortTerm, -20.f);
+    count = 0;
+    for(uint32_t bin = firstBin; bin < LOUDNESS_HISTOGRAM_BINS; ++bin)
+        count += shortTerm->counts[bin];
+    stats->loudnessRangeLu = 0.f;
+    if(count > 0)
+    {
+        uint64_t lowCount = (uint64_t)(count * 0.1);
+        uint64_t highCount = (uint64_t)(count * 0.95);
+        uint32_t lowBin = firstBin, highBin = firstBin;
+        uint64_t countSoFar = 0;
+        for(uint32_t bin = firstBin; bin < LOUDNESS_HISTOGRAM_BINS; ++bin)
+        {
+            if(countSoFar <= lowCount)
+                lowBin = bin;
+            countSoFar += shortTerm->counts[bin];
+            if(countSoFar > highCount) {
+                highBin = bin;
+                break;
+            }
+        }
+        stats->loudnessRangeLu = (highBin - lowBin) * 0.1f;
+    }
+
+    stats->maxMomentaryLufs = meter->maxMomentaryLufs;
+    stats->maxShortTermLufs = meter->maxShortTermLufs;
+    stats->samplePeakDbfs = linearToDb(meter->samplePeak);
+    stats->truePeakDbtp = linearToDb(fmaxf(meter->truePeak, meter->samplePeak));
+}
+
+void loudnessMeterTakeLevels(LoudnessMeter* meter, float* peakDbfs, float* rmsDbfs)
+{
+    *peakDbfs = linearToDb(meter->levelPeak);
+    uint32_t numSamples = meter->numLevelFrames * meter->numChannels;
+    *rmsDbfs = numSamples ? (float)(10.0 * log10(meter->levelEnergy / numSamples + 1e-30)) : -HUGE_VALF;
+    meter->levelPeak = 0.f;
+    meter->levelEnergy = 0.0;
+    meter->numLevelFrames = 0;
+}
+
+void loudnessAnalyseSamples(const float* samples, uint32_t numChannels, uint32_t numFrames, uint32_t sampleRate,
+                            LoudnessStats* stats)
+{
+    assert(numChannels == 1 || numChannels == 2);
+    LoudnessMeter meter;
+    loudnessMeterInit(&meter, sampleRate, numChannels);
+    float left[LOUDNESS_CHUNK_FRAMES];
+    float right[LOUDNESS_CHUNK_FRAMES];
+    for(uint32_t frame = 0; frame < numFrames; frame += LOUDNESS_CHUNK_FRAMES)
+    {
+        uint32_t numChunkFrames = numFrames - frame < LOUDNESS_CHUNK_FRAMES ? numFrames - frame : LOUDNESS_CHUNK_FRAMES;
+        const float* chunk = samples + (size_t)frame * numChannels;
+        for(uint32_t i = 0; i < numChunkFrames; ++i)
+        {
+            left[i] = chunk[i * numChannels];
+            right[i] = chunk[i * numChannels + numChannels - 1];
+        }
+        loudnessMeterProcess(&meter, left, right, numChunkFrames);
+    }
+    loudnessMeterGetStats(&meter, stats);
+}
+
+float loudnessNormalisationGain(const LoudnessStats* stats, float targetLufs, float maxTruePeakDbtp)
+{
+    if(stats->integratedLufs == -HUGE_VALF)
+        return 1.f;
+    float gainDb = targetLufs - stats->integratedLufs;
+    if(stats->truePeakDbtp + gainDb > maxTruePeakDbtp)
+        gainDb = maxTruePeakDbtp - stats->truePeakDbtp;
+    return powf(10.f, gainDb / 20.f);
+}
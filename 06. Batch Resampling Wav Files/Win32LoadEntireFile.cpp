@@ -0,0 +1,62 @@
+#include "Win32LoadEntireFile.h"
+
+#include <windows.h>
+
+bool win32LoadEntireFile(const char* filename, void** data, uint32_t* numBytesRead)
+{    
+    HANDLE file = CreateFileA(filename, GENERIC_READ, 0, 0, OPEN_EXISTING, 0, 0);  
+    if((file == INVALID_HANDLE_VALUE)) return false;
+    
+    DWORD fileSize = GetFileSize(file, 0);
+    if(!fileSize) return false;
+    
+    *data = HeapAlloc(GetProcessHeap(), 0, fileSize+1);
+    if(!*data) return false;
+
+    if(!ReadFile(file, *data, fileSize, (LPDWORD)numBytesRead, 0))
+        return false;
+    
+    CloseHandle(file);
+    ((uint8_t*)*data)[fileSize] = 0;
+    
+    return true;
+}
+
+void Win32FreeFileData(void *data)
+{
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+// Alternative to win32LoadEntireFile which maps the file into our address space
+// instead of copying it onto the heap. Pages are only read in from disk as they're
+// touched and live in the OS file cache, so loading is almost free and loaded
+// clips don't take up any extra memory of their own. The data is read-only!
+bool win32MapEntireFile(const char* filename, void** data, uint32_t* fileSize)
+{
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if((file == INVALID_HANDLE_VALUE)) return false;
+
+    DWORD size = GetFileSize(file, 0);
+    HANDLE fileMapping = size ? CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0) : 0;
+    // The mapped view keeps its own reference to the file,
+    // so we don't need these handles once it's created
+    CloseHandle(file);
+    if(!fileMapping) return false;
+
+    *data = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(fileMapping);
+    if(!*data) return false;
+    *fileSize = size;
+
+    // We're going to play the file from start to end, so ask
+    // the OS to start paging it in before we get to it
+    WIN32_MEMORY_RANGE_ENTRY range = { *data, size };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+    return true;
+}
+
+void Win32UnmapFileData(void *data)
+{
+    UnmapViewOfFile(data);
+}
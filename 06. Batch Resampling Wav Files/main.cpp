@@ -0,0 +1,432 @@
+
+// Command line tool to convert a batch of Wav files to one sample rate ahead of time,
+// so the game doesn't need to resample them while it's running.
+// Usage: main.exe [-j numThreads] [-n targetLufs] outputSampleRate outputDirectory input.wav...
+//
+// Work is split into small jobs that every thread pulls from a shared list, so
+// one long file doesn't hold everything up: each file is chopped into segments
+// of output frames that are resampled independently. The resampler works out
+// every output frame from its absolute position, so the output is bit-identical
+// no matter how many threads are used or how the work gets split up.
+//
+// The loudness of every mono or stereo file is measured after resampling, and with
+// -n each one is turned up or down to the target (e.g. -16 or -23 LUFS) so the
+// game doesn't need to balance them by hand, keeping the true peak under -1 dBTP.
+//
+// Files are written in the same format and bit depth they were read in. Integer
+// ones are rounded back to it with TPDF dither, so the rounding error is a little
+// noise rather than distortion that follows the signal.
+
+#include <windows.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ConvertSamples.h"
+#include "LoadWavFile.h"
+#include "Loudness.h"
+#include "BatchResampler.h"
+#include "Win32LoadEntireFile.h"
+
+// How many output frames each resampling job produces
+#define SEGMENT_SIZE_IN_FRAMES (16 * 1024)
+// How many files we have loaded at once
+#define BATCH_SIZE 64
+
+struct ResampleFile {
+    const char* inputFilename;
+    char outputFilename[MAX_PATH];
+    void* fileBytes;
+    AudioClip clip;
+    WavError wavError;
+    float* inputSamples;
+    BatchResampler* resampler;
+    uint64_t numOutputFrames;
+    float* outputSamples;
+    LoudnessStats loudness; // Of the resampled output, before normalising
+    bool isMeasured; // Only mono and stereo files are
+    float normalisationGain;
+    volatile LONG64 ticksSpent; // Summed over every thread that worked on this file
+    bool failed;
+};
+
+enum JobType {
+    JOB_LOAD,
+    JOB_RESAMPLE,
+    JOB_ANALYSE,
+    JOB_WRITE,
+};
+
+struct Job {
+    ResampleFile* file;
+    uint64_t firstOutputFrame;
+    uint32_t numOutputFrames;
+};
+
+struct JobList {
+    JobType type;
+    Job* jobs;
+    LONG numJobs;
+    volatile LONG nextJob;
+    uint32_t outputSampleRate;
+    bool normalise;
+    float targetLufs;
+};
+
+static void* allocate(size_t numBytes)
+{
+    return HeapAlloc(GetProcessHeap(), 0, numBytes);
+}
+
+static void deallocate(void* memory)
+{
+    if(memory) HeapFree(GetProcessHeap(), 0, memory);
+}
+
+static void writeU32(uint8_t* dest, uint32_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+    dest[2] = (uint8_t)(value >> 16);
+    dest[3] = (uint8_t)(value >> 24);
+}
+
+static void writeU16(uint8_t* dest, uint16_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+}
+
+// 32-bit float gets the longer fmt chunk and the fact chunk formats other than PCM need
+static bool writeWavFile(const char* filename, const void* samples, uint32_t numSamples, uint16_t numChannels,
+                         uint32_t sampleRate, SampleFormat sampleFormat, uint16_t numBitsPerSample)
+{
+    const bool isFloat = sampleFormat == SAMPLE_FORMAT_FLOAT;
+    const uint16_t blockAlign = numChannels * numBitsPerSample / 8;
+    const uint32_t numDataBytes = numSamples * (numBitsPerSample / 8);
+    const uint32_t fmtSize = isFloat ? 18 : 16;
+
+    // The canonical 44 byte header for PCM, 58 bytes for float
+    uint8_t header[58];
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    writeU32(header + 16, fmtSize);
+    writeU16(header + 20, isFloat ? 3 : 1); // WAVE_FORMAT_IEEE_FLOAT or WAVE_FORMAT_PCM
+    writeU16(header + 22, numChannels);
+    writeU32(header + 24, sampleRate);
+    writeU32(header + 28, sampleRate * blockAlign);
+    writeU16(header + 32, blockAlign);
+    writeU16(header + 34, numBitsPerSample);
+    uint8_t* chunk = header + 20 + fmtSize;
+    if(isFloat)
+    {
+        writeU16(header + 36, 0); // cbSize, no more format info
+        memcpy(chunk, "fact", 4);
+        writeU32(chunk + 4, 4);
+        writeU32(chunk + 8, numSamples / numChannels);
+        chunk += 12;
+    }
+    memcpy(chunk, "data", 4);
+    writeU32(chunk + 4, numDataBytes);
+    const uint32_t headerSize = (uint32_t)(chunk + 8 - header);
+    writeU32(header + 4, headerSize - 8 + numDataBytes);
+
+    HANDLE file = CreateFileA(filename, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    DWORD numBytesWritten;
+    bool result = WriteFile(file, header, headerSize, &numBytesWritten, 0)
+               && WriteFile(file, samples, numDataBytes, &numBytesWritten, 0);
+    CloseHandle(file);
+    return result;
+}
+
+static float nextDither(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+    return (*state >> 8) / 16777216.f - 0.5f;
+}
+
+// Converts float samples to 8, 16, 24 or 32-bit PCM in place, which fits since
+// none of them are bigger than a float. Two uniform random numbers add up to
+// TPDF dither of +-1 LSB. The seed is fixed so every run writes the same file
+static void quantiseSamples(float* samples, uint32_t numSamples, uint32_t numBitsPerSample, float gain)
+{
+    uint8_t* dest = (uint8_t*)samples;
+    const uint32_t numBytes = numBitsPerSample / 8;
+    const double scale = ldexp(1.0, numBitsPerSample - 1);
+    uint32_t random = 1;
+    for(uint32_t i = 0; i < numSamples; ++i)
+    {
+        double sample = floor((double)samples[i] * gain * scale + nextDither(&random) + nextDither(&random) + 0.5);
+        if(sample > scale - 1.0) sample = scale - 1.0;
+        if(sample < -scale) sample = -scale;
+        int32_t value = (int32_t)sample;
+        if(numBitsPerSample == 8)
+            value += 128; // 8-bit is unsigned
+        for(uint32_t byte = 0; byte < numBytes; ++byte)
+            dest[i * numBytes + byte] = (uint8_t)(value >> (8 * byte));
+    }
+}
+
+static void loadFile(ResampleFile* file, uint32_t outputSampleRate)
+{
+    uint32_t fileSize;
+    if(!win32MapEntireFile(file->inputFilename, &file->fileBytes, &fileSize))
+    {
+        file->fileBytes = nullptr;
+        file->failed = true;
+        return;
+    }
+    file->wavError = parseWavFile((uint8_t*)file->fileBytes, fileSize, &file->clip);
+    if(file->wavError != WAV_OK || file->clip.numSamples == 0)
+    {
+        file->failed = true;
+        return;
+    }
+
+    file->inputSamples = (float*)allocate(file->clip.numSamples * sizeof(float));
+    file->resampler = (BatchResampler*)allocate(sizeof(BatchResampler));
+    uint64_t numInputFrames = file->clip.numSamples / file->clip.numChannels;
+    if(file->inputSamples && file->resampler)
+    {
+        convertSamplesToFloat(file->clip.samples, file->clip.sampleFormat, file->clip.numBitsPerSample,
+                              file->clip.numSamples, file->inputSamples);
+        batchResamplerInit(file->resampler, file->clip.sampleRate, outputSampleRate);
+        file->numOutputFrames = batchResamplerNumOutputFrames(file->resampler, numInputFrames);
+        file->outputSamples = (float*)allocate(file->numOutputFrames * file->clip.numChannels * sizeof(float));
+    }
+    if(!file->outputSamples)
+        file->failed = true;
+}
+
+static void analyseFile(ResampleFile* file, uint32_t outputSampleRate, bool normalise, float targetLufs)
+{
+    file->normalisationGain = 1.f;
+    if(file->failed || file->clip.numChannels > LOUDNESS_MAX_CHANNELS)
+        return;
+    loudnessAnalyseSamples(file->outputSamples, file->clip.numChannels, (uint32_t)file->numOutputFrames,
+                           outputSampleRate, &file->loudness);
+    file->isMeasured = true;
+    if(normalise)
+        file->normalisationGain = loudnessNormalisationGain(&file->loudness, targetLufs);
+}
+
+static void writeFile(ResampleFile* file, uint32_t outputSampleRate)
+{
+    if(!file->failed)
+    {
+        // Back to the format the file came in, in place
+        uint32_t numSamples = (uint32_t)(file->numOutputFrames * file->clip.numChannels);
+        if(file->clip.sampleFormat == SAMPLE_FORMAT_FLOAT)
+        {
+            for(uint32_t i = 0; i < numSamples; ++i)
+                file->outputSamples[i] *= file->normalisationGain;
+        }
+        else
+        {
+            quantiseSamples(file->outputSamples, numSamples, file->clip.numBitsPerSample, file->normalisationGain);
+        }
+        if(!writeWavFile(file->outputFilename, file->outputSamples, numSamples, (uint16_t)file->clip.numChannels,
+                         outputSampleRate, file->clip.sampleFormat, (uint16_t)file->clip.numBitsPerSample))
+            file->failed = true;
+    }
+
+    deallocate(file->inputSamples);
+    deallocate(file->outputSamples);
+    deallocate(file->resampler);
+    if(file->fileBytes)
+        Win32UnmapFileData(file->fileBytes);
+}
+
+static DWORD WINAPI workerThreadProc(LPVOID param)
+{
+    JobList* jobList = (JobList*)param;
+    while(true)
+    {
+        LONG jobIndex = InterlockedIncrement(&jobList->nextJob) - 1;
+        if(jobIndex >= jobList->numJobs)
+            break;
+        Job* job = &jobList->jobs[jobIndex];
+        ResampleFile* file = job->file;
+
+        LARGE_INTEGER startTime;
+        QueryPerformanceCounter(&startTime);
+        switch(jobList->type)
+        {
+            case JOB_LOAD: loadFile(file, jobList->outputSampleRate); break;
+            case JOB_RESAMPLE:
+            {
+                uint64_t numInputFrames = file->clip.numSamples / file->clip.numChannels;
+                float* output = file->outputSamples + job->firstOutputFrame * file->clip.numChannels;
+                batchResamplerProcess(file->resampler, file->inputSamples, numInputFrames, file->clip.numChannels,
+                                      job->firstOutputFrame, job->numOutputFrames, output);
+                break;
+            }
+            case JOB_ANALYSE: analyseFile(file, jobList->outputSampleRate, jobList->normalise, jobList->targetLufs); break;
+            case JOB_WRITE: writeFile(file, jobList->outputSampleRate); break;
+        }
+        LARGE_INTEGER endTime;
+        QueryPerformanceCounter(&endTime);
+        InterlockedAdd64(&file->ticksSpent, endTime.QuadPart - startTime.QuadPart);
+    }
+    return 0;
+}
+
+// Run every job in the list across numThreads threads and wait for them all to finish
+static void runJobs(JobList* jobList, HANDLE* threads, int numThreads)
+{
+    jobList->nextJob = 0;
+    for(int i = 0; i < numThreads; ++i)
+    {
+        threads[i] = CreateThread(nullptr, 0, workerThreadProc, jobList, 0, nullptr);
+        assert(threads[i]);
+    }
+    WaitForMultipleObjects(numThreads, threads, TRUE, INFINITE);
+    for(int i = 0; i < numThreads; ++i)
+        CloseHandle(threads[i]);
+}
+
+int main(int argc, char** argv)
+{
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    int numThreads = (int)systemInfo.dwNumberOfProcessors;
+
+    bool normalise = false;
+    float targetLufs = 0.f;
+    int argIndex = 1;
+    while(argc - argIndex > 1 && argv[argIndex][0] == '-')
+    {
+        if(strcmp(argv[argIndex], "-j") == 0)
+            numThreads = atoi(argv[argIndex + 1]);
+        else if(strcmp(argv[argIndex], "-n") == 0)
+        {
+            normalise = true;
+            targetLufs = (float)atof(argv[argIndex + 1]);
+        }
+        else
+            break;
+        argIndex += 2;
+    }
+    if(argc - argIndex < 3 || numThreads < 1 || numThreads > MAXIMUM_WAIT_OBJECTS)
+    {
+        printf("Usage: %s [-j numThreads] [-n targetLufs] outputSampleRate outputDirectory input.wav...\n", argv[0]);
+        return 1;
+    }
+    uint32_t outputSampleRate = (uint32_t)atoi(argv[argIndex++]);
+    const char* outputDirectory = argv[argIndex++];
+    const char** inputFilenames = (const char**)(argv + argIndex);
+    uint32_t numInputFiles = (uint32_t)(argc - argIndex);
+    if(outputSampleRate == 0)
+    {
+        printf("Invalid output sample rate\n");
+        return 1;
+    }
+    CreateDirectoryA(outputDirectory, nullptr);
+
+    LARGE_INTEGER ticksPerSecond, startTime;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    QueryPerformanceCounter(&startTime);
+
+    HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+    static ResampleFile files[BATCH_SIZE];
+    static Job fileJobs[BATCH_SIZE];
+    uint32_t numFilesFailed = 0;
+    uint64_t numInputFramesTotal = 0;
+    uint64_t numOutputFramesTotal = 0;
+    double secondsOfAudioTotal = 0.0;
+
+    for(uint32_t batchStart = 0; batchStart < numInputFiles; batchStart += BATCH_SIZE)
+    {
+        uint32_t numFiles = numInputFiles - batchStart;
+        if(numFiles > BATCH_SIZE) numFiles = BATCH_SIZE;
+
+        for(uint32_t i = 0; i < numFiles; ++i)
+        {
+            ResampleFile* file = &files[i];
+            *file = {};
+            file->inputFilename = inputFilenames[batchStart + i];
+            const char* baseName = file->inputFilename;
+            for(const char* c = file->inputFilename; *c; ++c)
+                if(*c == '\\' || *c == '/') baseName = c + 1;
+            snprintf(file->outputFilename, MAX_PATH, "%s\\%s", outputDirectory, baseName);
+            fileJobs[i] = {};
+            fileJobs[i].file = file;
+        }
+
+        JobList loadJobs = { JOB_LOAD, fileJobs, (LONG)numFiles, 0, outputSampleRate, normalise, targetLufs };
+        runJobs(&loadJobs, threads, numThreads);
+
+        // Now we know how long every file is, chop them up into segments
+        LONG numSegments = 0;
+        for(uint32_t i = 0; i < numFiles; ++i)
+            if(!files[i].failed)
+                numSegments += (LONG)((files[i].numOutputFrames + SEGMENT_SIZE_IN_FRAMES - 1) / SEGMENT_SIZE_IN_FRAMES);
+        Job* segmentJobs = (Job*)allocate((numSegments ? numSegments : 1) * sizeof(Job));
+        assert(segmentJobs);
+        LONG segmentIndex = 0;
+        for(uint32_t i = 0; i < numFiles; ++i)
+        {
+            if(files[i].failed)
+                continue;
+            for(uint64_t frame = 0; frame < files[i].numOutputFrames; frame += SEGMENT_SIZE_IN_FRAMES)
+            {
+                Job* job = &segmentJobs[segmentIndex++];
+                job->file = &files[i];
+                job->firstOutputFrame = frame;
+                uint64_t numFramesLeft = files[i].numOutputFrames - frame;
+                job->numOutputFrames = (uint32_t)(numFramesLeft < SEGMENT_SIZE_IN_FRAMES ? numFramesLeft : SEGMENT_SIZE_IN_FRAMES);
+            }
+        }
+        JobList resampleJobs = { JOB_RESAMPLE, segmentJobs, numSegments, 0, outputSampleRate, normalise, targetLufs };
+        runJobs(&resampleJobs, threads, numThreads);
+        deallocate(segmentJobs);
+
+        JobList analyseJobs = { JOB_ANALYSE, fileJobs, (LONG)numFiles, 0, outputSampleRate, normalise, targetLufs };
+        runJobs(&analyseJobs, threads, numThreads);
+
+        JobList writeJobs = { JOB_WRITE, fileJobs, (LONG)numFiles, 0, outputSampleRate, normalise, targetLufs };
+        runJobs(&writeJobs, threads, numThreads);
+
+        for(uint32_t i = 0; i < numFiles; ++i)
+        {
+            ResampleFile* file = &files[i];
+            double fileMs = 1000.0 * file->ticksSpent / ticksPerSecond.QuadPart;
+            if(file->failed)
+            {
+                ++numFilesFailed;
+                if(file->wavError != WAV_OK)
+                    printf("%s: FAILED (%s)\n", file->inputFilename, wavErrorString(file->wavError));
+                else
+                    printf("%s: FAILED\n", file->inputFilename);
+                continue;
+            }
+            uint64_t numInputFrames = file->clip.numSamples / file->clip.numChannels;
+            numInputFramesTotal += numInputFrames;
+            numOutputFramesTotal += file->numOutputFrames;
+            secondsOfAudioTotal += (double)numInputFrames / file->clip.sampleRate;
+            printf("%s: %u Hz -> %u Hz, %.2f ms", file->inputFilename, file->clip.sampleRate, outputSampleRate, fileMs);
+            if(file->isMeasured)
+            {
+                printf(", %.1f LUFS, %.1f dBTP", file->loudness.integratedLufs, file->loudness.truePeakDbtp);
+                if(normalise)
+                    printf(", gain %+.1f dB", 20.0 * log10(file->normalisationGain));
+            }
+            printf("\n");
+        }
+    }
+
+    LARGE_INTEGER endTime;
+    QueryPerformanceCounter(&endTime);
+    double totalSeconds = (double)(endTime.QuadPart - startTime.QuadPart) / ticksPerSecond.QuadPart;
+    printf("\n%u files (%u failed) on %d threads in %.3f s\n", numInputFiles, numFilesFailed, numThreads, totalSeconds);
+    printf("%.1f s of audio, %.0fx realtime, %.0f input frames/s, %.0f output frames/s\n",
+           secondsOfAudioTotal, secondsOfAudioTotal / totalSeconds,
+           numInputFramesTotal / totalSeconds, numOutputFramesTotal / totalSeconds);
+
+    return numFilesFailed ? 1 : 0;
+}
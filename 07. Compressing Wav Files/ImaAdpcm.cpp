@@ -0,0 +1,151 @@
+#include "ImaAdpcm.h"
+
+#include <assert.h>
+
+// Reference: IMA Digital Audio Focus and Technical Working Groups,
+// "Recommended Practices for Enhancing Digital Audio Compatibility
+// in Multimedia Systems", revision 3.00
+
+static const int16_t stepSizes[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t stepIndexChanges[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+struct ImaAdpcmChannel {
+    int32_t predictor;
+    int32_t stepIndex;
+};
+
+// Without branches, since which way each one goes is close to random.
+// The difference is built from shifted copies of the step the same way
+// the reference decoder does it, so the rounding matches bit for bit
+static inline int16_t decodeNibble(ImaAdpcmChannel* channel, uint32_t nibble)
+{
+    int32_t step = stepSizes[channel->stepIndex];
+    int32_t diff = (step >> 3)
+                 + (step & -(int32_t)((nibble >> 2) & 1))
+                 + ((step >> 1) & -(int32_t)((nibble >> 1) & 1))
+                 + ((step >> 2) & -(int32_t)(nibble & 1));
+    int32_t sign = -(int32_t)((nibble >> 3) & 1);
+    int32_t predictor = channel->predictor + ((diff ^ sign) - sign);
+    predictor = predictor < -32768 ? -32768 : predictor;
+    predictor = predictor > 32767 ? 32767 : predictor;
+    channel->predictor = predictor;
+
+    int32_t stepIndex = channel->stepIndex + stepIndexChanges[nibble & 7];
+    stepIndex = stepIndex < 0 ? 0 : stepIndex;
+    stepIndex = stepIndex > 88 ? 88 : stepIndex;
+    channel->stepIndex = stepIndex;
+    return (int16_t)predictor;
+}
+
+void imaAdpcmDecodeBlock(const uint8_t* block, uint32_t numChannels, uint32_t numFrames, int16_t* output)
+{
+    assert(numChannels == 1 || numChannels == 2);
+    if(numFrames == 0)
+        return;
+
+    ImaAdpcmChannel channels[2];
+    for(uint32_t c = 0; c < numChannels; ++c)
+    {
+        const uint8_t* header = block + 4 * c;
+        channels[c].predictor = (int16_t)(header[0] | (header[1] << 8));
+        channels[c].stepIndex = header[2] > 88 ? 88 : header[2];
+        output[c] = (int16_t)channels[c].predictor;
+    }
+
+    // Each group is 4 bytes (8 samples) of each channel in turn
+    const uint8_t* data = block + 4 * numChannels;
+    for(uint32_t groupStart = 1; groupStart < numFrames; groupStart += 8)
+    {
+        uint32_t numFramesInGroup = numFrames - groupStart < 8 ? numFrames - groupStart : 8;
+        for(uint32_t c = 0; c < numChannels; ++c)
+        {
+            int16_t* out = output + groupStart * numChannels + c;
+            for(uint32_t i = 0; i < numFramesInGroup; ++i)
+            {
+                uint32_t nibble = (data[i / 2] >> (4 * (i & 1))) & 0xF;
+                *out = decodeNibble(&channels[c], nibble);
+                out += numChannels;
+            }
+            data += 4;
+        }
+    }
+}
+
+// Picks the nibble whose decoded value lands closest to sample,
+// and updates channel exactly the way the decoder will
+static uint32_t encodeNibble(ImaAdpcmChannel* channel, int32_t sample)
+{
+    int32_t step = stepSizes[channel->stepIndex];
+    int32_t delta = sample - channel->predictor;
+    uint32_t nibble = 0;
+    if(delta < 0) {
+        nibble = 8;
+        delta = -delta;
+    }
+    if(delta >= step) {
+        nibble |= 4;
+        delta -= step;
+    }
+    step >>= 1;
+    if(delta >= step) {
+        nibble |= 2;
+        delta -= step;
+    }
+    step >>= 1;
+    if(delta >= step)
+        nibble |= 1;
+
+    decodeNibble(channel, nibble);
+    return nibble;
+}
+
+void imaAdpcmEncodeBlock(ImaAdpcmEncoder* encoder, const int16_t* input, uint32_t numChannels,
+                         uint32_t numFrames, uint32_t numBytesPerBlock, uint8_t* block)
+{
+    assert(numChannels == 1 || numChannels == 2);
+    assert(numFrames > 0);
+    uint32_t numFramesPerBlock = imaAdpcmFramesPerBlock(numBytesPerBlock, numChannels);
+    assert(numFrames <= numFramesPerBlock);
+
+    ImaAdpcmChannel channels[2];
+    for(uint32_t c = 0; c < numChannels; ++c)
+    {
+        channels[c].predictor = input[c];
+        channels[c].stepIndex = encoder->stepIndex[c];
+        uint8_t* header = block + 4 * c;
+        header[0] = (uint8_t)input[c];
+        header[1] = (uint8_t)((uint16_t)input[c] >> 8);
+        header[2] = (uint8_t)channels[c].stepIndex;
+        header[3] = 0;
+    }
+
+    uint8_t* data = block + 4 * numChannels;
+    for(uint32_t groupStart = 1; groupStart < numFramesPerBlock; groupStart += 8)
+    {
+        for(uint32_t c = 0; c < numChannels; ++c)
+        {
+            for(uint32_t i = 0; i < 4; ++i)
+                data[i] = 0;
+            for(uint32_t i = 0; i < 8 && groupStart + i < numFramesPerBlock; ++i)
+            {
+                uint32_t frame = groupStart + i;
+                if(frame >= numFrames)
+                    frame = numFrames - 1;
+                uint32_t nibble = encodeNibble(&channels[c], input[frame * numChannels + c]);
+                data[i / 2] |= (uint8_t)(nibble << (4 * (i & 1)));
+            }
+            data += 4;
+        }
+    }
+
+    for(uint32_t c = 0; c < numChannels; ++c)
+        encoder->stepIndex[c] = channels[c].stepIndex;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+// IMA-ADPCM (WAVE_FORMAT_IMA_ADPCM) stores each sample as a 4-bit step from
+// the previous one, so clips take about a quarter of the memory of 16-bit PCM.
+// Data is split into blocks that can be decoded on their own: each block
+// starts with a 4 byte header per channel holding the first sample and the
+// step size, followed by 4 bytes of 8 samples at a time for each channel in turn
+
+// Biggest block we'll decode, so voices can keep a fixed-size decode buffer
+#define IMA_ADPCM_MAX_FRAMES_PER_BLOCK 2048
+
+inline uint32_t imaAdpcmFramesPerBlock(uint32_t numBytesPerBlock, uint32_t numChannels)
+{
+    // The header holds one frame, the rest is 2 samples per byte
+    return (numBytesPerBlock - 4 * numChannels) * 2 / numChannels + 1;
+}
+
+// Decodes the first numFrames frames of a block into output as interleaved 16-bit
+void imaAdpcmDecodeBlock(const uint8_t* block, uint32_t numChannels, uint32_t numFrames, int16_t* output);
+
+// Encoder state carried from one block to the next, for each channel
+struct ImaAdpcmEncoder {
+    int32_t stepIndex[2];
+};
+
+// Encodes numFrames of interleaved 16-bit input into one block of numBytesPerBlock.
+// If numFrames is less than a full block the rest is padded with the last frame
+void imaAdpcmEncodeBlock(ImaAdpcmEncoder* encoder, const int16_t* input, uint32_t numChannels,
+                         uint32_t numFrames, uint32_t numBytesPerBlock, uint8_t* block);
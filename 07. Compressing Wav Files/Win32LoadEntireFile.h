@@ -0,0 +1,7 @@
+
+#include <stdint.h>
+
+bool win32LoadEntireFile(const char* filename, void** data, uint32_t* numBytesRead);
+void Win32FreeFileData(void *data);
+bool win32MapEntireFile(const char* filename, void** data, uint32_t* fileSize);
+void Win32UnmapFileData(void *data);
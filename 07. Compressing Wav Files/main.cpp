@@ -0,0 +1,226 @@
+// Command line tool to compress a Wav file to IMA-ADPCM, which the mixer can
+// play directly while keeping the clip at about a quarter of the size in memory.
+// Usage: main.exe input.wav output.wav [bytesPerBlock]
+//
+// After encoding it decodes the result again to report how much quality was
+// lost (signal to noise ratio against the input) and how long decoding takes,
+// which is roughly what each playing voice costs the mixer
+
+#include <windows.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ConvertSamples.h"
+#include "ImaAdpcm.h"
+#include "LoadWavFile.h"
+#include "Win32LoadEntireFile.h"
+
+// 1024 bytes per block is 2041 mono or 1017 stereo frames per block, the usual choice
+#define DEFAULT_BYTES_PER_BLOCK 1024
+
+static void writeU32(uint8_t* dest, uint32_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+    dest[2] = (uint8_t)(value >> 16);
+    dest[3] = (uint8_t)(value >> 24);
+}
+
+static void writeU16(uint8_t* dest, uint16_t value)
+{
+    dest[0] = (uint8_t)value;
+    dest[1] = (uint8_t)(value >> 8);
+}
+
+static bool writeImaAdpcmWavFile(const char* filename, const uint8_t* blocks, uint32_t numBlocks, uint32_t numFrames,
+                                 uint16_t numChannels, uint32_t sampleRate, uint16_t numBytesPerBlock,
+                                 uint32_t loopStartFrame, uint32_t loopEndFrame)
+{
+    const uint32_t numDataBytes = numBlocks * numBytesPerBlock;
+    const uint16_t numFramesPerBlock = (uint16_t)imaAdpcmFramesPerBlock(numBytesPerBlock, numChannels);
+
+    // IMAADPCMWAVEFORMAT fmt chunk, then a fact chunk with the real
+    // number of frames since the last block is padded out
+    uint8_t header[128];
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    writeU32(header + 16, 20);
+    writeU16(header + 20, 0x11); // WAVE_FORMAT_IMA_ADPCM
+    writeU16(header + 22, numChannels);
+    writeU32(header + 24, sampleRate);
+    writeU32(header + 28, (uint32_t)((uint64_t)sampleRate * numBytesPerBlock / numFramesPerBlock));
+    writeU16(header + 32, numBytesPerBlock);
+    writeU16(header + 34, 4); // Bits per sample
+    writeU16(header + 36, 2); // Extra format bytes
+    writeU16(header + 38, numFramesPerBlock);
+    memcpy(header + 40, "fact", 4);
+    writeU32(header + 44, 4);
+    writeU32(header + 48, numFrames);
+    uint32_t headerSize = 52;
+    if(loopEndFrame)
+    {
+        // Keep the input's loop as a smpl chunk with just the one loop in it
+        memcpy(header + headerSize, "smpl", 4);
+        writeU32(header + headerSize + 4, 36 + 24);
+        memset(header + headerSize + 8, 0, 36 + 24);
+        writeU32(header + headerSize + 8 + 8, (uint32_t)(1000000000.0 / sampleRate)); // Sample period in ns
+        writeU32(header + headerSize + 8 + 12, 60); // MIDI unity note, middle C
+        writeU32(header + headerSize + 8 + 28, 1); // Number of loops
+        writeU32(header + headerSize + 8 + 36 + 8, loopStartFrame);
+        writeU32(header + headerSize + 8 + 36 + 12, loopEndFrame - 1); // The end frame is included
+        headerSize += 8 + 36 + 24;
+    }
+    memcpy(header + headerSize, "data", 4);
+    writeU32(header + headerSize + 4, numDataBytes);
+    headerSize += 8;
+    writeU32(header + 4, headerSize - 8 + numDataBytes);
+
+    HANDLE file = CreateFileA(filename, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if(file == INVALID_HANDLE_VALUE) return false;
+    DWORD numBytesWritten;
+    bool result = WriteFile(file, header, headerSize, &numBytesWritten, 0)
+               && WriteFile(file, blocks, numDataBytes, &numBytesWritten, 0);
+    CloseHandle(file);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc != 3 && argc != 4)
+    {
+        printf("Usage: %s input.wav output.wav [bytesPerBlock]\n", argv[0]);
+        return 1;
+    }
+    const char* inputFilename = argv[1];
+    const char* outputFilename = argv[2];
+    uint32_t numBytesPerBlock = argc == 4 ? (uint32_t)atoi(argv[3]) : DEFAULT_BYTES_PER_BLOCK;
+
+    void* fileBytes;
+    uint32_t fileSize;
+    if(!win32MapEntireFile(inputFilename, &fileBytes, &fileSize))
+    {
+        printf("Failed to open %s\n", inputFilename);
+        return 1;
+    }
+    AudioClip clip;
+    WavError error = parseWavFile((const uint8_t*)fileBytes, fileSize, &clip);
+    if(error != WAV_OK)
+    {
+        printf("%s: %s\n", inputFilename, wavErrorString(error));
+        return 1;
+    }
+    if(clip.sampleFormat == SAMPLE_FORMAT_IMA_ADPCM || (clip.numChannels != 1 && clip.numChannels != 2))
+    {
+        printf("%s: must be a mono or stereo PCM or float wav file\n", inputFilename);
+        return 1;
+    }
+    const uint32_t numChannels = clip.numChannels;
+    // Blocks have to be a whole number of 8 frame groups after the header
+    if(numBytesPerBlock <= 4 * numChannels || (numBytesPerBlock - 4 * numChannels) % (4 * numChannels) != 0
+       || imaAdpcmFramesPerBlock(numBytesPerBlock, numChannels) > IMA_ADPCM_MAX_FRAMES_PER_BLOCK)
+    {
+        printf("Invalid block size %u\n", numBytesPerBlock);
+        return 1;
+    }
+
+    // The encoder takes 16-bit input, so convert anything else
+    const uint32_t numFrames = clip.numSamples / numChannels;
+    const uint32_t numSamples = numFrames * numChannels;
+    int16_t* input = (int16_t*)clip.samples;
+    if(clip.sampleFormat != SAMPLE_FORMAT_PCM || clip.numBitsPerSample != 16)
+    {
+        float* floatSamples = (float*)HeapAlloc(GetProcessHeap(), 0, numSamples * sizeof(float));
+        input = (int16_t*)HeapAlloc(GetProcessHeap(), 0, numSamples * sizeof(int16_t));
+        assert(floatSamples && input);
+        convertSamplesToFloat(clip.samples, clip.sampleFormat, clip.numBitsPerSample, numSamples, floatSamples);
+        for(uint32_t i = 0; i < numSamples; ++i)
+        {
+            float sample = floatSamples[i] * 32768.f;
+            if(sample > 32767.f) sample = 32767.f;
+            if(sample < -32768.f) sample = -32768.f;
+            input[i] = (int16_t)(sample < 0 ? sample - 0.5f : sample + 0.5f);
+        }
+        HeapFree(GetProcessHeap(), 0, floatSamples);
+    }
+
+    const uint32_t numFramesPerBlock = imaAdpcmFramesPerBlock(numBytesPerBlock, numChannels);
+    const uint32_t numBlocks = (numFrames + numFramesPerBlock - 1) / numFramesPerBlock;
+    uint8_t* blocks = (uint8_t*)HeapAlloc(GetProcessHeap(), 0, (SIZE_T)numBlocks * numBytesPerBlock);
+    int16_t* decoded = (int16_t*)HeapAlloc(GetProcessHeap(), 0, (SIZE_T)numBlocks * numFramesPerBlock * numChannels * sizeof(int16_t));
+    assert(blocks && decoded);
+
+    LARGE_INTEGER ticksPerSecond, startTime, endTime;
+    QueryPerformanceFrequency(&ticksPerSecond);
+
+    QueryPerformanceCounter(&startTime);
+    ImaAdpcmEncoder encoder = {};
+    for(uint32_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+    {
+        uint32_t firstFrame = blockIndex * numFramesPerBlock;
+        uint32_t numFramesInBlock = numFrames - firstFrame < numFramesPerBlock ? numFrames - firstFrame : numFramesPerBlock;
+        imaAdpcmEncodeBlock(&encoder, input + firstFrame * numChannels, numChannels, numFramesInBlock,
+                            numBytesPerBlock, blocks + blockIndex * numBytesPerBlock);
+    }
+    QueryPerformanceCounter(&endTime);
+    double encodeSeconds = (double)(endTime.QuadPart - startTime.QuadPart) / ticksPerSecond.QuadPart;
+
+    if(!writeImaAdpcmWavFile(outputFilename, blocks, numBlocks, numFrames, (uint16_t)numChannels,
+                             clip.sampleRate, (uint16_t)numBytesPerBlock, clip.loopStartFrame, clip.loopEndFrame))
+    {
+        printf("Failed to write %s\n", outputFilename);
+        return 1;
+    }
+
+    // Decode the whole thing a block at a time like the mixer does, enough
+    // times over to get a stable timing even for short clips
+    const double MIN_BENCHMARK_SECONDS = 0.25;
+    uint32_t numDecodePasses = 0;
+    double decodeSeconds = 0.0;
+    QueryPerformanceCounter(&startTime);
+    do
+    {
+        for(uint32_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+        {
+            imaAdpcmDecodeBlock(blocks + blockIndex * numBytesPerBlock, numChannels, numFramesPerBlock,
+                                decoded + blockIndex * numFramesPerBlock * numChannels);
+        }
+        ++numDecodePasses;
+        QueryPerformanceCounter(&endTime);
+        decodeSeconds = (double)(endTime.QuadPart - startTime.QuadPart) / ticksPerSecond.QuadPart;
+    } while(decodeSeconds < MIN_BENCHMARK_SECONDS);
+    decodeSeconds /= numDecodePasses;
+
+    double signalPower = 0.0;
+    double noisePower = 0.0;
+    int32_t maxError = 0;
+    for(uint32_t i = 0; i < numSamples; ++i)
+    {
+        int32_t error = (int32_t)decoded[i] - input[i];
+        signalPower += (double)input[i] * input[i];
+        noisePower += (double)error * error;
+        if(abs(error) > maxError)
+            maxError = abs(error);
+    }
+
+    double clipSeconds = (double)numFrames / clip.sampleRate;
+    uint32_t pcmSize = numSamples * sizeof(int16_t);
+    uint32_t adpcmSize = numBlocks * numBytesPerBlock;
+    printf("%s -> %s: %u ch, %u Hz, %.2f s\n", inputFilename, outputFilename, numChannels, clip.sampleRate, clipSeconds);
+    if(clip.loopEndFrame)
+        printf("Loop: frames %u to %u\n", clip.loopStartFrame, clip.loopEndFrame);
+    printf("Size: %u bytes as 16-bit PCM, %u bytes as IMA-ADPCM (%.2f:1)\n", pcmSize, adpcmSize, (double)pcmSize / adpcmSize);
+    if(noisePower > 0.0)
+        printf("SNR: %.1f dB, max error %d\n", 10.0 * log10(signalPower / noisePower), maxError);
+    else
+        printf("SNR: lossless\n");
+    printf("Encode: %.2f ms\n", encodeSeconds * 1000.0);
+    printf("Decode: %.2f ns per frame, %.4f%% of a core per playing voice\n",
+           decodeSeconds * 1e9 / numFrames, 100.0 * decodeSeconds / clipSeconds);
+
+    return 0;
+}